@@ -0,0 +1,641 @@
+/**
+ * @file bench/bench_render.c
+ * @brief Headless render benchmark on the native Dawn backend.
+ *
+ * Renders generated scenes into an offscreen texture for a fixed number of
+ * frames and prints one CSV row per run with per frame averages of the CPU
+ * stage times, GPU time and upload volume published in WebGPUFrameStats.
+ *
+ * Scenes mix EcsBox and EcsRectangle entities over several archetypes, or
+ * only have WebGPUSphere entities with levels of detail (--spheres). In the
+ * static scene nothing changes after the first upload, in the moving scene
+ * every entity's transform is written each frame. With --transforms the
+ * entities also have a position and scale, which the moving scene writes
+ * instead, and the renderer uploads them for GPU expansion.
+ *
+ * With --kernels no scene is rendered: the batch kernels of the pack stage
+ * are timed against their scalar reference versions on one pack range, and
+ * their outputs compared. Prints one CSV row per kernel, exits with an
+ * error when a kernel doesn't match its reference.
+ *
+ * Usage: bench_render [--frames N] [--warmup N] [--threads N]
+ *                     [--format full|compact|half] [--cull] [--storage]
+ *                     [--bundles] [--transforms] [--spheres] [--sizes N,N,...]
+ *                     [--kernels]
+ */
+
+#include "private_api.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 720
+#define BENCH_TAG_COUNT 4               /* Extra archetypes per geometry type */
+#define BENCH_MAX_SIZES 16
+#define BENCH_MAX_WARMUP_FRAMES 1000    /* Give up waiting for pipelines */
+#define BENCH_KERNEL_ROWS WEBGPU_PACK_CHUNK_ROWS
+#define BENCH_KERNEL_STRIDE 80          /* Largest record, full with tag */
+
+typedef struct {
+    int32_t frames;
+    int32_t warmup;
+    int32_t threads;
+    WebGPUInstanceFormat format;
+    bool cull;
+    bool storage;
+    bool bundles;
+    bool transforms;
+    bool spheres;
+    bool kernels;
+    int32_t sizes[BENCH_MAX_SIZES];
+    int32_t size_count;
+} bench_options_t;
+
+typedef struct {
+    double frame_ms;
+    double cpu_ms[WebGPUStageCount];
+    double gpu_ms;
+    double bytes_uploaded;
+    double draw_calls;
+} bench_result_t;
+
+/* Moves the transforms of the moving scene */
+ECS_TAG_DECLARE(BenchMover);
+
+/* Tags that spread entities over more tables */
+static ecs_entity_t bench_tags[BENCH_TAG_COUNT];
+
+static float bench_time = 0.0f;
+
+static const char *format_names[] = { "full", "compact", "half" };
+static const char *stage_names[] = { "gather", "pack", "upload", "encode" };
+
+typedef enum {
+    BenchKernelSpheres,
+    BenchKernelMatrices,
+    BenchKernelAffine,
+    BenchKernelAffineHalf,
+    BenchKernelRgba8,
+    BenchKernelCount
+} bench_kernel_t;
+
+static const char *kernel_names[] = {
+    "transform_spheres", "pack_matrices", "pack_affine", "pack_affine_half", "pack_rgba8"
+};
+
+/* Inputs of the kernels, like one pack range with a quarter of it culled */
+typedef struct {
+    EcsTransform3 *transforms;
+    float *radius;
+    float *scales;
+    EcsRgb *colors;
+    int32_t *rows;
+    int32_t row_count;
+} bench_kernel_input_t;
+
+static void bench_move(ecs_iter_t *it) {
+    EcsTransform3 *transform = ecs_field(it, EcsTransform3, 0);
+
+    for (int32_t i = 0; i < it->count; i++) {
+        transform[i].value[3][1] += 0.01f * sinf(bench_time + (float)(i & 1023));
+    }
+}
+
+static void bench_move_positions(ecs_iter_t *it) {
+    EcsPosition3 *position = ecs_field(it, EcsPosition3, 0);
+
+    for (int32_t i = 0; i < it->count; i++) {
+        position[i].y += 0.01f * sinf(bench_time + (float)(i & 1023));
+    }
+}
+
+static void work_done(WGPUQueueWorkDoneStatus status, void *userdata) {
+    (void)status;
+    *(bool*)userdata = true;
+}
+
+/**
+ * Block until the GPU finished all submitted work, so frames don't queue up
+ */
+static void wait_for_gpu(WebGPURenderer *renderer) {
+    bool done = false;
+    wgpuQueueOnSubmittedWorkDone(renderer->queue, work_done, &done);
+    while (!done) {
+        wgpuInstanceProcessEvents(renderer->instance);
+    }
+}
+
+/**
+ * Create count entities of a geometry type in one table
+ */
+static void create_group(ecs_world_t *world,
+                         ecs_id_t geometry,
+                         ecs_entity_t tag,
+                         bool moving,
+                         bool trs,
+                         int32_t first,
+                         int32_t count,
+                         int32_t side) {
+    EcsTransform3 *transforms = ecs_os_malloc_n(EcsTransform3, count);
+    EcsPosition3 *positions = trs ? ecs_os_malloc_n(EcsPosition3, count) : NULL;
+    EcsScale3 *scales = trs ? ecs_os_malloc_n(EcsScale3, count) : NULL;
+    EcsRgb *colors = ecs_os_malloc_n(EcsRgb, count);
+    void *shapes = ecs_os_calloc(count * (ecs_size_t)sizeof(EcsBox));
+
+    /* Spread the scene over a volume in front of the default camera */
+    float spacing = 40.0f / (float)side;
+    for (int32_t i = 0; i < count; i++) {
+        int32_t index = first + i;
+        float x = (float)(index % side) - side * 0.5f;
+        float y = (float)((index / side) % side) - side * 0.5f;
+        float z = (float)(index / (side * side));
+
+        glm_mat4_identity(transforms[i].value);
+        glm_translate(transforms[i].value, (vec3){x * spacing, y * spacing, -5.0f - z * spacing});
+        glm_scale_uni(transforms[i].value, spacing * 0.5f);
+        if (trs) {
+            positions[i] = (EcsPosition3){ x * spacing, y * spacing, -5.0f - z * spacing };
+            scales[i] = (EcsScale3){ spacing * 0.5f, spacing * 0.5f, spacing * 0.5f };
+        }
+
+        colors[i] = (EcsRgb){
+            .r = (float)(index % 7) / 7.0f,
+            .g = 0.5f,
+            .b = (float)(index % 5) / 5.0f
+        };
+
+        if (geometry == ecs_id(EcsBox)) {
+            ((EcsBox*)shapes)[i] = (EcsBox){ 1.0f, 1.0f, 1.0f };
+        } else if (geometry == ecs_id(WebGPUSphere)) {
+            ((WebGPUSphere*)shapes)[i] = (WebGPUSphere){ 0.5f };
+        } else {
+            ((EcsRectangle*)shapes)[i] = (EcsRectangle){ 1.0f, 1.0f };
+        }
+    }
+
+    void *data[] = { transforms, colors, shapes, NULL, NULL, NULL, NULL };
+    ecs_bulk_desc_t desc = {
+        .count = count,
+        .ids = { ecs_id(EcsTransform3), ecs_id(EcsRgb), geometry, tag,
+                 moving ? BenchMover : 0 },
+        .data = data,
+    };
+
+    /* Tags have no data, so components go before them */
+    if (trs) {
+        desc.ids[3] = ecs_id(EcsPosition3);
+        desc.ids[4] = ecs_id(EcsScale3);
+        desc.ids[5] = tag;
+        desc.ids[6] = moving ? BenchMover : 0;
+        data[3] = positions;
+        data[4] = scales;
+    }
+    ecs_bulk_init(world, &desc);
+
+    ecs_os_free(transforms);
+    ecs_os_free(positions);
+    ecs_os_free(scales);
+    ecs_os_free(colors);
+    ecs_os_free(shapes);
+}
+
+/**
+ * Populate the world with count entities, half boxes and half rectangles,
+ * or only spheres
+ */
+static void create_scene(ecs_world_t *world, int32_t count, bool moving, bool spheres, bool trs) {
+    int32_t side = (int32_t)ceilf(cbrtf((float)count));
+    int32_t group_count = 2 * BENCH_TAG_COUNT;
+    int32_t first = 0;
+
+    for (int32_t g = 0; g < group_count; g++) {
+        int32_t group_size = count / group_count + (g < count % group_count);
+        ecs_id_t geometry = spheres ? ecs_id(WebGPUSphere) :
+            (g % 2 ? ecs_id(EcsRectangle) : ecs_id(EcsBox));
+        create_group(world, geometry, bench_tags[g / 2], moving, trs, first, group_size, side);
+        first += group_size;
+    }
+}
+
+/**
+ * Create a world with a headless renderer. Returns NULL if no device could
+ * be acquired.
+ */
+static ecs_world_t* create_world(const bench_options_t *options, ecs_entity_t *renderer_out) {
+    ecs_world_t *world = ecs_init();
+    FlecsSystemsWebGPUImport(world);
+
+    if (options->threads > 1) {
+        ecs_set_threads(world, options->threads);
+    }
+
+    ECS_TAG_DEFINE(world, BenchMover);
+    for (int32_t i = 0; i < BENCH_TAG_COUNT; i++) {
+        bench_tags[i] = ecs_new(world);
+    }
+
+    ECS_SYSTEM(world, bench_move, EcsOnUpdate, [inout] flecs.components.transform.Transform3,
+        BenchMover, !flecs.components.transform.Position3);
+    ECS_SYSTEM(world, bench_move_positions, EcsOnUpdate, [inout] flecs.components.transform.Position3,
+        BenchMover);
+
+    /* The renderer is added before the canvas so the init system (which
+     * expects a surface) leaves it alone */
+    ecs_entity_t e = ecs_new(world);
+    ecs_add(world, e, WebGPURenderer);
+    ecs_add(world, e, WebGPUQuery);
+    ecs_set(world, e, EcsCanvas, { .width = BENCH_WIDTH, .height = BENCH_HEIGHT });
+
+    /* The vectors and queries the render system uses are freed with the renderer */
+    WebGPURenderer *renderer = ecs_get_mut(world, e, WebGPURenderer);
+    webgpu_renderer_init(world, renderer, e, BENCH_WIDTH, BENCH_HEIGHT);
+    renderer->instance_format = options->format;
+    renderer->cpu_culling = options->cull;
+    renderer->storage_instancing = options->storage;
+    renderer->render_bundles = options->bundles;
+    renderer->gpu_transforms = options->transforms;
+
+    WGPUInstanceDescriptor instance_desc = {0};
+    renderer->instance = wgpuCreateInstance(&instance_desc);
+    if (!renderer->instance) {
+        fprintf(stderr, "bench_render: failed to create WebGPU instance\n");
+        ecs_fini(world);
+        return NULL;
+    }
+
+    /* A renderer without surface draws into an offscreen texture */
+    webgpu_renderer_request_adapter(renderer);
+    for (int32_t i = 0; i < BENCH_MAX_WARMUP_FRAMES &&
+            renderer->startup != WebGPUStartupReady &&
+            renderer->startup != WebGPUStartupFailed; i++) {
+        wgpuInstanceProcessEvents(renderer->instance);
+    }
+
+    if (renderer->startup != WebGPUStartupReady || !renderer->offscreen_view) {
+        fprintf(stderr, "bench_render: failed to acquire a device\n");
+        ecs_fini(world);
+        return NULL;
+    }
+
+    *renderer_out = e;
+    return world;
+}
+
+/**
+ * Run one scene and average the frame stats over the measured frames
+ */
+static bool run_scene(const bench_options_t *options,
+                      int32_t count,
+                      bool moving,
+                      bench_result_t *result) {
+    ecs_entity_t e = 0;
+    ecs_world_t *world = create_world(options, &e);
+    if (!world) {
+        return false;
+    }
+
+    create_scene(world, count, moving, options->spheres, options->transforms);
+    ecs_os_memset_t(result, 0, bench_result_t);
+
+    /* Pipelines compile asynchronously, warm up until the scene draws */
+    int32_t warmup = options->warmup > 0 ? options->warmup : 1;
+    int32_t drawn = 0;
+    for (int32_t i = 0; i < BENCH_MAX_WARMUP_FRAMES && drawn < warmup; i++) {
+        ecs_progress(world, 0);
+        wait_for_gpu(ecs_get_mut(world, e, WebGPURenderer));
+
+        const WebGPUFrameStats *stats = ecs_singleton_get(world, WebGPUFrameStats);
+        if (stats->draw_calls) {
+            drawn++;
+        }
+    }
+
+    if (drawn < warmup) {
+        fprintf(stderr, "bench_render: scene never drew, pipelines failed to compile\n");
+        ecs_fini(world);
+        return false;
+    }
+
+    for (int32_t f = 0; f < options->frames; f++) {
+        ecs_time_t start = {0};
+        ecs_time_measure(&start);
+
+        ecs_progress(world, 0);
+        wait_for_gpu(ecs_get_mut(world, e, WebGPURenderer));
+        bench_time += 0.016f;
+
+        result->frame_ms += ecs_time_measure(&start) * 1000.0;
+
+        const WebGPUFrameStats *stats = ecs_singleton_get(world, WebGPUFrameStats);
+        for (int32_t s = 0; s < WebGPUStageCount; s++) {
+            result->cpu_ms[s] += stats->cpu_ms[s];
+        }
+        result->gpu_ms += stats->gpu_ms;
+        result->bytes_uploaded += (double)stats->bytes_uploaded;
+        result->draw_calls += stats->draw_calls;
+    }
+
+    double frames = (double)options->frames;
+    result->frame_ms /= frames;
+    for (int32_t s = 0; s < WebGPUStageCount; s++) {
+        result->cpu_ms[s] /= frames;
+    }
+    result->gpu_ms /= frames;
+    result->bytes_uploaded /= frames;
+    result->draw_calls /= frames;
+
+    ecs_fini(world);
+    return true;
+}
+
+static void kernel_input_init(bench_kernel_input_t *in) {
+    int32_t count = BENCH_KERNEL_ROWS;
+    in->transforms = ecs_os_malloc_n(EcsTransform3, count);
+    in->radius = ecs_os_malloc_n(float, count);
+    in->scales = ecs_os_malloc_n(float, count * 3);
+    in->colors = ecs_os_malloc_n(EcsRgb, count);
+    in->rows = ecs_os_malloc_n(int32_t, count);
+    in->row_count = 0;
+
+    for (int32_t i = 0; i < count; i++) {
+        float t = (float)i;
+        glm_mat4_identity(in->transforms[i].value);
+        glm_translate(in->transforms[i].value, (vec3){ sinf(t) * 50.0f, t * 0.01f, -cosf(t) * 50.0f });
+        glm_rotate(in->transforms[i].value, t * 0.37f, (vec3){ 0.0f, 1.0f, 0.0f });
+        glm_scale(in->transforms[i].value, (vec3){ 1.0f + (float)(i % 3), 1.0f, 0.5f });
+
+        in->radius[i] = 0.5f + (float)(i % 5) * 0.25f;
+        in->scales[i * 3] = 1.0f + (float)(i % 7) * 0.5f;
+        in->scales[i * 3 + 1] = 2.0f;
+        in->scales[i * 3 + 2] = 0.25f;
+
+        /* Out of range channels exercise the clamping */
+        in->colors[i] = (EcsRgb){
+            .r = (float)(i % 17) / 14.0f - 0.1f,
+            .g = (float)(i % 11) / 10.0f,
+            .b = (float)(i % 5) / 4.0f
+        };
+
+        if (i % 4 != 3) {
+            in->rows[in->row_count++] = i;
+        }
+    }
+}
+
+static void kernel_input_fini(bench_kernel_input_t *in) {
+    ecs_os_free(in->transforms);
+    ecs_os_free(in->radius);
+    ecs_os_free(in->scales);
+    ecs_os_free(in->colors);
+    ecs_os_free(in->rows);
+}
+
+static void run_kernel(bench_kernel_t kernel, const bench_kernel_input_t *in, bool simd, uint8_t *out) {
+    int32_t count = BENCH_KERNEL_ROWS;
+    switch (kernel) {
+    case BenchKernelSpheres: {
+        float *x = (float*)out;
+        (simd ? webgpu_transform_spheres : webgpu_transform_spheres_scalar)(in->transforms,
+            in->radius, count, x, &x[count], &x[count * 2], &x[count * 3]);
+        break;
+    }
+    case BenchKernelMatrices:
+        (simd ? webgpu_pack_matrices : webgpu_pack_matrices_scalar)(out, BENCH_KERNEL_STRIDE,
+            in->transforms, in->scales, in->rows, in->row_count);
+        break;
+    case BenchKernelAffine:
+    case BenchKernelAffineHalf:
+        (simd ? webgpu_pack_affine : webgpu_pack_affine_scalar)(out, BENCH_KERNEL_STRIDE,
+            in->transforms, in->scales, in->rows, in->row_count,
+            kernel == BenchKernelAffineHalf);
+        break;
+    case BenchKernelRgba8:
+        (simd ? webgpu_pack_rgba8 : webgpu_pack_rgba8_scalar)(out, BENCH_KERNEL_STRIDE,
+            in->colors, in->rows, in->row_count);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Compare kernel outputs. Floats may differ by rounding, halves and bytes
+ * by one step.
+ */
+static bool kernel_outputs_match(bench_kernel_t kernel, const uint8_t *a, const uint8_t *b, size_t size) {
+    if (kernel == BenchKernelAffineHalf) {
+        for (size_t i = 0; i < size / sizeof(uint16_t); i++) {
+            uint16_t ha, hb;
+            memcpy(&ha, &a[i * 2], sizeof(ha));
+            memcpy(&hb, &b[i * 2], sizeof(hb));
+            if (abs((int)ha - (int)hb) > 1) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (kernel == BenchKernelRgba8) {
+        for (size_t i = 0; i < size; i++) {
+            if (abs((int)a[i] - (int)b[i]) > 1) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    for (size_t i = 0; i < size / sizeof(float); i++) {
+        float fa, fb;
+        memcpy(&fa, &a[i * 4], sizeof(fa));
+        memcpy(&fb, &b[i * 4], sizeof(fb));
+        float scale = fabsf(fa) > 1.0f ? fabsf(fa) : 1.0f;
+        if (!(fabsf(fa - fb) <= 1.0e-5f * scale)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Time every batch kernel against its scalar reference, options->frames
+ * calls each after options->warmup calls. Returns false on a mismatch.
+ */
+static bool run_kernels(const bench_options_t *options) {
+    bench_kernel_input_t in;
+    kernel_input_init(&in);
+
+    size_t size = (size_t)BENCH_KERNEL_ROWS * BENCH_KERNEL_STRIDE;
+    uint8_t *outputs[2] = { ecs_os_calloc(size), ecs_os_calloc(size) };
+    bool ok = true;
+
+    printf("kernel,rows,scalar_ns,simd_ns,speedup,match\n");
+    for (int32_t k = 0; k < BenchKernelCount; k++) {
+        double ns[2];
+        for (int32_t simd = 0; simd < 2; simd++) {
+            for (int32_t i = 0; i < options->warmup; i++) {
+                run_kernel((bench_kernel_t)k, &in, simd, outputs[simd]);
+            }
+
+            ecs_time_t start = {0};
+            ecs_time_measure(&start);
+            for (int32_t i = 0; i < options->frames; i++) {
+                run_kernel((bench_kernel_t)k, &in, simd, outputs[simd]);
+            }
+            ns[simd] = ecs_time_measure(&start) * 1.0e9 / options->frames;
+        }
+
+        bool match = kernel_outputs_match((bench_kernel_t)k, outputs[0], outputs[1], size);
+        ok = ok && match;
+        printf("%s,%d,%.0f,%.0f,%.2f,%s\n", kernel_names[k],
+            k == BenchKernelSpheres ? BENCH_KERNEL_ROWS : in.row_count,
+            ns[0], ns[1], ns[1] > 0.0 ? ns[0] / ns[1] : 0.0, match ? "yes" : "no");
+        fflush(stdout);
+    }
+
+    ecs_os_free(outputs[0]);
+    ecs_os_free(outputs[1]);
+    kernel_input_fini(&in);
+    return ok;
+}
+
+static bool parse_sizes(const char *arg, bench_options_t *options) {
+    options->size_count = 0;
+    while (*arg && options->size_count < BENCH_MAX_SIZES) {
+        char *end;
+        long size = strtol(arg, &end, 10);
+        if (end == arg || size <= 0) {
+            return false;
+        }
+        options->sizes[options->size_count++] = (int32_t)size;
+        arg = *end == ',' ? end + 1 : end;
+    }
+    return options->size_count > 0;
+}
+
+static bool parse_options(int argc, char *argv[], bench_options_t *options) {
+    *options = (bench_options_t){
+        .frames = 300,
+        .warmup = 10,
+        .threads = 1,
+        .format = WebGPUInstanceFormatFull,
+        .sizes = { 1000, 10000, 100000, 1000000 },
+        .size_count = 4,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (!strcmp(arg, "--cull")) {
+            options->cull = true;
+            continue;
+        }
+
+        if (!strcmp(arg, "--storage")) {
+            options->storage = true;
+            continue;
+        }
+
+        if (!strcmp(arg, "--bundles")) {
+            options->bundles = true;
+            continue;
+        }
+
+        /* Expansion writes into the instance storage */
+        if (!strcmp(arg, "--transforms")) {
+            options->transforms = true;
+            options->storage = true;
+            continue;
+        }
+
+        if (!strcmp(arg, "--spheres")) {
+            options->spheres = true;
+            continue;
+        }
+
+        if (!strcmp(arg, "--kernels")) {
+            options->kernels = true;
+            continue;
+        }
+
+        if (!value) {
+            return false;
+        }
+
+        if (!strcmp(arg, "--frames")) {
+            options->frames = atoi(value);
+        } else if (!strcmp(arg, "--warmup")) {
+            options->warmup = atoi(value);
+        } else if (!strcmp(arg, "--threads")) {
+            options->threads = atoi(value);
+        } else if (!strcmp(arg, "--sizes")) {
+            if (!parse_sizes(value, options)) {
+                return false;
+            }
+        } else if (!strcmp(arg, "--format")) {
+            int32_t f;
+            for (f = 0; f < 3; f++) {
+                if (!strcmp(value, format_names[f])) {
+                    break;
+                }
+            }
+            if (f == 3) {
+                return false;
+            }
+            options->format = (WebGPUInstanceFormat)f;
+        } else {
+            return false;
+        }
+        i++;
+    }
+
+    return options->frames > 0 && options->warmup >= 0;
+}
+
+int main(int argc, char *argv[]) {
+    bench_options_t options;
+    if (!parse_options(argc, argv, &options)) {
+        fprintf(stderr,
+            "usage: %s [--frames N] [--warmup N] [--threads N] "
+            "[--format full|compact|half] [--cull] [--storage] [--bundles] "
+            "[--transforms] [--spheres] [--sizes N,N,...] [--kernels]\n", argv[0]);
+        return 1;
+    }
+
+    if (options.kernels) {
+        return run_kernels(&options) ? 0 : 1;
+    }
+
+    printf("entities,scene,shapes,format,instancing,threads,frames,frame_ms");
+    for (int32_t s = 0; s < WebGPUStageCount; s++) {
+        printf(",%s_ms", stage_names[s]);
+    }
+    printf(",gpu_ms,bytes_uploaded,draw_calls\n");
+
+    int result = 0;
+    for (int32_t i = 0; i < options.size_count; i++) {
+        for (int32_t moving = 0; moving < 2; moving++) {
+            bench_result_t r;
+            if (!run_scene(&options, options.sizes[i], moving, &r)) {
+                result = 1;
+                continue;
+            }
+
+            printf("%d,%s,%s,%s,%s,%d,%d,%.3f", options.sizes[i],
+                moving ? "moving" : "static", options.spheres ? "spheres" : "mixed",
+                format_names[options.format],
+                options.transforms ? "transforms" : (options.storage ? "storage" : "vertex"),
+                options.threads,
+                options.frames, r.frame_ms);
+            for (int32_t s = 0; s < WebGPUStageCount; s++) {
+                printf(",%.3f", r.cpu_ms[s]);
+            }
+            printf(",%.3f,%.0f,%.1f\n", r.gpu_ms, r.bytes_uploaded, r.draw_calls);
+            fflush(stdout);
+        }
+    }
+
+    return result;
+}
@@ -13,6 +13,39 @@ rm -rf .bake_cache
 rm -rf bin/Em-debug/
 rm -rf web-demo/wasm/
 
+# Optional pthread variant: ./build-web.sh --threads
+# Instance packing then runs on Flecs worker threads (needs the COOP/COEP
+# headers sent by web-demo/serve.py for SharedArrayBuffer)
+# Optional debug variant: ./build-web.sh --debug keeps info tracing
+THREAD_FLAGS=""
+DEFAULT_TRACE_LEVEL=1
+for arg in "$@"; do
+    if [ "$arg" == "--threads" ]; then
+        echo "Building pthread variant..."
+        THREAD_FLAGS="-pthread -sPTHREAD_POOL_SIZE=4 -DWEBGPU_WORKER_THREADS=4"
+    elif [ "$arg" == "--debug" ]; then
+        echo "Building debug variant..."
+        DEFAULT_TRACE_LEVEL=2
+    fi
+done
+
+# Trace level: 0 off, 1 error, 2 info, 3 trace. Builds keep errors only
+# unless --debug is passed; WEBGPU_TRACE_LEVEL=3 ./build-web.sh --debug
+# traces everything, WEBGPU_TRACE_LEVEL=0 compiles all tracing out
+TRACE_FLAGS="-DWEBGPU_TRACE_LEVEL=${WEBGPU_TRACE_LEVEL:-$DEFAULT_TRACE_LEVEL}"
+
+# Expand the shader permutations with a host compiler. The expansion goes
+# to bin/, the checked in src/shaders/shader_variants.c is only regenerated
+# by the shader_variants CMake target
+echo "Generating shader variants..."
+mkdir -p bin
+cc -std=c99 -O2 -o bin/wgsl_variants tools/wgsl_variants.c && \
+    bin/wgsl_variants shaders/geometry.wgsl bin/shader_variants.c
+if [ $? -ne 0 ]; then
+    echo "Shader variant generation failed"
+    exit 1
+fi
+
 # Build the WebAssembly application with proper exports
 echo "Building WebAssembly application..."
 
@@ -22,16 +55,42 @@ mkdir -p web-demo/wasm
 # Build directly with emcc for proper web output
 emcc \
     -std=gnu99 \
+    -msimd128 \
+    $THREAD_FLAGS \
+    $TRACE_FLAGS \
     -DWEBGPU_BACKEND_EMSCRIPTEN \
     -DFLECS_STATIC \
     -I./include \
     -I/Users/Joe/bake/include \
-    src/web-main.c \
+    src/main.c \
     src/resources/resource_manager.c \
+    src/resources/pipeline_cache.c \
+    src/resources/material_cache.c \
+    src/resources/texture_cache.c \
+    src/resources/file_stream.c \
+    src/resources/resource_pool.c \
     src/math/math_utils.c \
     src/rendering/render_system.c \
+    src/rendering/gpu_culling.c \
+    src/rendering/uniforms.c \
+    src/rendering/profiler.c \
+    src/rendering/instance_storage.c \
+    src/rendering/render_targets.c \
+    src/rendering/render_queue.c \
+    src/rendering/frame_pacing.c \
+    src/rendering/render_bundles.c \
+    src/rendering/occlusion.c \
+    src/rendering/transform_expand.c \
+    src/rendering/shadows.c \
+    src/rendering/frame_graph.c \
+    src/rendering/trace.c \
     src/shaders/shader_sources.c \
+    bin/shader_variants.c \
     src/geometry/geometry.c \
+    src/geometry/mesh_registry.c \
+    src/geometry/mesh_loader.c \
+    src/geometry/primitives.c \
+    src/geometry/entity_bulk.c \
     /Users/Joe/bake/src/tower_defense/deps/flecs.c \
     /Users/Joe/bake/src/tower_defense/deps/cglm.c \
     /Users/Joe/bake/src/tower_defense/deps/flecs_components_gui.c \
@@ -41,14 +100,12 @@ emcc \
     /Users/Joe/bake/src/tower_defense/deps/flecs_components_geometry.c \
     /Users/Joe/bake/src/tower_defense/deps/flecs_systems_transform.c \
     -sUSE_WEBGPU=1 \
-    -sASYNCIFY=1 \
     -sALLOW_MEMORY_GROWTH=1 \
-    -sEXPORTED_FUNCTIONS='["_main","_flecs_webgpu_init","_flecs_webgpu_create_box","_flecs_webgpu_create_rectangle","_flecs_webgpu_delete_entity","_flecs_webgpu_clear_entities","_flecs_webgpu_step","_flecs_webgpu_get_entity_count","_flecs_webgpu_shutdown","_malloc","_free"]' \
-    -sEXPORTED_RUNTIME_METHODS='["ccall","cwrap"]' \
+    -sEXPORTED_FUNCTIONS='["_main","_flecs_webgpu_create_boxes","_flecs_webgpu_create_rectangles","_flecs_webgpu_update_entities","_flecs_webgpu_delete_entities","_flecs_webgpu_shared_transforms","_flecs_webgpu_shared_transforms_generation","_flecs_webgpu_shared_transforms_written","_flecs_webgpu_set_on_demand","_flecs_webgpu_invalidate","_webgpu_file_stream_reserve","_webgpu_file_stream_commit","_webgpu_file_stream_end","_webgpu_trace_dump","_malloc","_free"]' \
+    -sEXPORTED_RUNTIME_METHODS='["ccall","cwrap","HEAPF32","HEAPU8"]' \
     -sMODULARIZE=1 \
     -sEXPORT_NAME='FlecsWebGPU' \
     -sINVOKE_RUN=0 \
-    --embed-file shaders \
     -o web-demo/wasm/flecs-webgpu.js
 
 if [ $? -ne 0 ]; then
@@ -61,6 +61,8 @@
     typedef struct { unsigned long long id; } WGPUSampler;
     typedef struct { unsigned long long id; } WGPUTextureView;
     typedef struct { unsigned long long id; } WGPUCommandBuffer;
+    typedef struct { unsigned long long id; } WGPUComputePipeline;
+    typedef struct { unsigned long long id; } WGPUComputePassEncoder;
     
     typedef unsigned int WGPUBufferUsageFlags;
     typedef unsigned int WGPUTextureFormat;
@@ -153,7 +155,91 @@ extern "C" {
 /* Configuration */
 #define WEBGPU_MAX_INSTANCES_PER_BATCH 1000
 #define WEBGPU_MAX_LIGHTS 32
+#define WEBGPU_MAX_VIEWS 4                 /* Camera blocks in the uniform ring */
+#define WEBGPU_MAX_SHADOW_CASCADES 4       /* Cascades of the directional light's shadow */
+#define WEBGPU_SHADOW_RESOLUTION 1024      /* Default texels per cascade side */
 #define WEBGPU_SHADER_CACHE_SIZE 64
+#define WEBGPU_FRAMES_IN_FLIGHT 3          /* Instance buffer ring depth */
+#define WEBGPU_MAX_LODS 4                  /* Mesh levels of detail per geometry */
+#define WEBGPU_STREAM_BUDGET (512 * 1024)  /* Default mesh and texture bytes uploaded per frame */
+#define WEBGPU_TRACE_RING_SIZE 256         /* Trace events kept for webgpu_trace_dump */
+#define WEBGPU_FIXED_MAX_STEPS 8           /* Default fixed steps per webgpu_progress */
+
+/* Trace levels. Messages above WEBGPU_TRACE_LEVEL are compiled out, so release
+ * builds (NDEBUG) only keep errors unless the level is set explicitly. */
+#define WEBGPU_TRACE_OFF 0
+#define WEBGPU_TRACE_ERROR 1
+#define WEBGPU_TRACE_INFO 2
+#define WEBGPU_TRACE_TRACE 3
+
+#ifndef WEBGPU_TRACE_LEVEL
+#ifdef NDEBUG
+#define WEBGPU_TRACE_LEVEL WEBGPU_TRACE_ERROR
+#else
+#define WEBGPU_TRACE_LEVEL WEBGPU_TRACE_INFO
+#endif
+#endif
+
+/* Instance vertex layouts */
+typedef enum WebGPUInstanceFormat {
+    WebGPUInstanceFormatFull = 0,      // mat4 + rgb, float32 (76 bytes)
+    WebGPUInstanceFormatCompact,       // affine mat3x4 float32 + rgba8 unorm (52 bytes)
+    WebGPUInstanceFormatCompactHalf    // affine mat3x4 float16 + rgba8 unorm (28 bytes)
+} WebGPUInstanceFormat;
+
+/* GPU passes timed with timestamp queries */
+typedef enum WebGPUPass {
+    WebGPUPassCull = 0,                // Frustum cull compute pass
+    WebGPUPassMain,                    // Main render pass
+    WebGPUPassHiZ,                     // Depth pyramid compute pass (occlusion_culling)
+    WebGPUPassTransforms,              // Transform expansion compute pass (gpu_transforms)
+    WebGPUPassShadow,                  // Shadow cascade depth pass (shadow_cascades)
+    WebGPUPassCount
+} WebGPUPass;
+
+/* CPU stages of a frame timed by the renderer */
+typedef enum WebGPUStage {
+    WebGPUStageGather = 0,             // Change detection, CPU culling and batching
+    WebGPUStagePack,                   // Instance packing (worker threads)
+    WebGPUStageUpload,                 // Instance and uniform queue writes
+    WebGPUStageEncode,                 // Command encoding and submit
+    WebGPUStageCount
+} WebGPUStage;
+
+/* Renderer startup. The adapter and device requests advance it from their
+ * callbacks and the remaining steps run right after, nothing blocks. Before
+ * WebGPUStartupReady frames already prepare and pack instances and start
+ * mesh downloads, but upload and render nothing. */
+typedef enum WebGPUStartupState {
+    WebGPUStartupNone = 0,             // Adapter not requested yet
+    WebGPUStartupAdapter,              // Waiting for the adapter
+    WebGPUStartupDevice,               // Waiting for the device
+    WebGPUStartupSurface,              // Configuring the surface (or offscreen target)
+    WebGPUStartupResources,            // Creating uniforms, caches and bind groups
+    WebGPUStartupReady,                // Rendering
+    WebGPUStartupFailed                // No adapter or device
+} WebGPUStartupState;
+
+/* Buffer usage classes of the resource pool. Buffers of one class are
+ * sub-allocated from shared slabs and accounted against the memory budget. */
+typedef enum WebGPUBufferClass {
+    WebGPUBufferClassVertex = 0,       // Instance records, visible instances
+    WebGPUBufferClassIndex,            // Index arenas
+    WebGPUBufferClassUniform,          // Material and culling blocks
+    WebGPUBufferClassStorage,          // Instance storage, indirect arguments
+    WebGPUBufferClassStaging,          // Readback and query resolve (never shared)
+    WebGPUBufferClassCount
+} WebGPUBufferClass;
+
+/* Range of a GPU buffer allocated from the resource pool. Blocks of a slab
+ * share its buffer, so bind and write them at their offset. */
+typedef struct WebGPUBufferBlock {
+    WGPUBuffer buffer;
+    uint64_t offset;                   // Start of the block in buffer
+    uint64_t size;                     // Usable bytes
+    WGPUBufferUsage usage;             // Usage the block was requested with
+    struct webgpu_slab_t *slab;        // Owning slab, NULL for a dedicated buffer
+} WebGPUBufferBlock;
 
 /* Forward declarations for components */
 
@@ -173,30 +259,106 @@ typedef struct WebGPURenderer {
     uint32_t width, height;            // Current canvas dimensions
     WGPUTextureFormat surface_format;  // Surface pixel format
     
-    /* Depth buffer */
-    WGPUTexture depth_texture;         // Depth buffer texture
-    WGPUTextureView depth_texture_view; // Depth buffer view
+    /* Offscreen color target, rendered to when there is no surface */
+    WGPUTexture offscreen_texture;     // Owned by the render target pool
+    WGPUTextureView offscreen_view;
+    
+    /* Render targets */
+    struct webgpu_render_target_pool_t *targets; // Depth and MSAA targets, reused across frames
+    uint32_t sample_count;             // MSAA samples of the main pass (1 or 4), select before init
+    uint32_t resize_frame;             // Frame of the last canvas size change
     
     /* Uniform buffers */
-    WGPUBuffer camera_uniform_buffer;   // Camera view/projection matrices
-    WGPUBuffer light_uniform_buffer;    // Light direction/color/intensity
+    struct webgpu_uniforms_t *uniforms; // Camera and light blocks (dynamic offsets)
     WGPUBindGroup camera_bind_group;    // Camera bind group
     WGPUBindGroup light_bind_group;     // Light bind group
-    WGPUBindGroupLayout camera_layout;  // Camera bind group layout
-    WGPUBindGroupLayout light_layout;   // Light bind group layout
+    WGPUBindGroupLayout camera_layout;  // Camera bind group layout (owned by pipeline cache)
+    WGPUBindGroupLayout light_layout;   // Light bind group layout (owned by pipeline cache)
     
     /* Rendering queries */
     ecs_query_t *geometry_query;       // Query for renderable entities
+    ecs_query_t *view_query;           // WebGPUView entities with a canvas
+    ecs_vec_t views;                   // View entities drawn this frame, view i uses camera block i + 1
     
     /* Resource management */
     ecs_allocator_t *allocator;        // Custom allocator for GPU resources
+    struct webgpu_resource_pool_t *resources; // Deferred releases and reusable buffers
     ecs_vec_t render_batches;          // Batched rendering operations
-    WGPURenderPipeline default_pipeline; // Default geometry rendering pipeline
+    ecs_vec_t render_queue;            // Draw items of the batches, in sort key order
+    ecs_vec_t render_queue_scratch;    // Radix sort buffer of render_queue
+    struct webgpu_material_cache_t *materials; // Material bind groups by material entity
+    struct webgpu_mesh_registry_t *mesh_registry; // Shared vertex/index buffers
+    struct webgpu_pipeline_cache_t *pipeline_cache; // Pipeline variants and shared layouts
+    WebGPUInstanceFormat instance_format; // Instance layout, select before init
+    bool storage_instancing;           // Draw from one shared instance storage buffer, select before init
+    struct webgpu_instance_storage_t *instance_storage; // Shared instance records (storage instancing)
+    bool gpu_transforms;               // Upload position/rotation/scale, expanded to matrices on the GPU (storage instancing), select before init
+    struct webgpu_transform_expander_t *transform_expander; // Expansion pipeline (gpu_transforms)
+    struct webgpu_mesh_loader_t *mesh_loader; // Streams WebGPUMesh files into the mesh registry
+    struct webgpu_texture_cache_t *textures; // WebGPUTexture files in shared texture arrays
+    bool render_bundles;               // Replay batches that didn't change from render bundles, select before init
+    struct webgpu_bundle_cache_t *bundles; // Render bundles by batch (render_bundles)
+    uint32_t stream_budget;            // Mesh and texture bytes uploaded per frame, 0 for WEBGPU_STREAM_BUDGET
+    
+    /* Culling */
+    bool cpu_culling;                  // Frustum cull instances while packing (SIMD)
+    bool gpu_culling;                  // Frustum cull instances in a compute pass
+    bool occlusion_culling;            // Also cull instances hidden in the previous frame's depth (gpu_culling)
+    bool indirect_first_instance;      // Device supports indirect draws with a first instance
+    WGPUComputePipeline cull_pipeline; // Frustum culling pipeline (created on first use)
+    WGPUBindGroupLayout cull_layout;   // Frustum culling bind group layout
+    WebGPUBufferBlock cull_args;       // DrawIndexedIndirect arguments, one block per batch
+    WebGPUBufferBlock cull_params;     // Culling uniforms, one block per batch
+    bool cull_first_instance_warned;
+    struct webgpu_hiz_t *hiz;          // Previous frame's depth pyramid, created with the cull pipeline
+    
+    /* Shadows */
+    uint32_t shadow_cascades;          // Cascades of the directional light's shadow (2 to WEBGPU_MAX_SHADOW_CASCADES), 0 for none, select before init
+    uint32_t shadow_resolution;        // Texels per cascade side, 0 for WEBGPU_SHADOW_RESOLUTION
+    float shadow_distance;             // View depth the cascades cover, 0 for the camera's far plane
+    struct webgpu_shadows_t *shadows;  // Cascade cameras and atlas (shadow_cascades)
+    
+    /* Startup */
+    WebGPUStartupState startup;        // Startup step, frames render once WebGPUStartupReady
+    ecs_time_t startup_time;           // Time the adapter was requested
+    float startup_ms;                  // Adapter request to first submitted frame
     
     /* Frame state */
-    WGPUCommandEncoder command_encoder;
+    struct webgpu_frame_graph_t *frame_graph; // Passes and resources of the frame
     uint32_t frame_index;
-    bool needs_resize;
+    bool needs_resize;                 // Canvas size changed, surface not reconfigured yet
+    uint32_t surface_width;            // Size the surface is configured at, a resize bucket while resizing
+    uint32_t surface_height;
+    bool on_demand;                    // Only render frames in which something drawn changed
+    bool redraw;                       // Something drawn changed since the last rendered frame
+    uint32_t frames_skipped;           // Frames not rendered by on_demand
+    
+    /* Frame statistics */
+    uint64_t instance_bytes_uploaded;  // Instance bytes written to the GPU this frame
+    uint64_t instance_bytes_skipped;   // Instance bytes of unchanged tables this frame
+    uint32_t instances_visible;        // Instances packed for drawing this frame
+    uint32_t instances_culled;         // Instances rejected by CPU culling this frame
+    uint32_t instances_transparent;    // Instances drawn alpha blended this frame
+    uint32_t uniform_writes;           // Camera/light/material blocks written this frame
+    uint32_t draw_calls;               // Draws recorded this frame
+    uint32_t state_changes;            // Pipeline, bind group and vertex buffer binds this frame
+    uint32_t bundles_recorded;         // Render bundles recorded this frame
+    uint32_t bundles_replayed;         // Draws replayed from render bundles this frame
+    uint32_t shadow_draws;             // Draws recorded by the shadow cascades this frame
+    uint32_t passes_recorded;          // Frame graph passes recorded this frame
+    uint32_t passes_culled;            // Frame graph passes dropped, nothing used their writes
+    uint32_t transients_aliased;       // Transient resources that shared another's target or buffer
+    uint64_t mesh_bytes_streamed;      // Mesh bytes uploaded by the mesh loader this frame
+    uint32_t meshes_loading;           // WebGPUMesh files not yet resident
+    uint64_t texture_bytes_streamed;   // Texture bytes uploaded by the texture cache this frame
+    uint32_t textures_loading;         // WebGPUTexture files not yet resident
+    bool depth_attached;               // Main pass had a depth attachment this frame
+    bool instances_changed;            // A geometry's instances changed this frame, the HiZ is stale
+    
+    /* Profiling */
+    struct webgpu_profiler_t *profiler; // Timestamp queries, NULL if unsupported
+    float stage_ms[WebGPUStageCount];  // CPU time per stage this frame (WebGPUStage)
+    ecs_time_t pack_start;             // End of change detection, packing starts
 } WebGPURenderer;
 
 /* Geometry buffer management */
@@ -204,17 +366,47 @@ typedef struct WebGPUGeometry {
     /* Component type this geometry handles */
     ecs_id_t component_id;             // EcsBox, EcsRectangle, etc.
     
-    /* Static geometry buffers */
-    WGPUBuffer vertex_buffer;          // Vertex positions and normals
-    WGPUBuffer index_buffer;           // Triangle indices
+    /* Static geometry (range in the renderer's shared mesh buffers) */
+    uint32_t mesh_id;                  // Mesh registry handle of LOD 0, 0 until uploaded
     uint32_t vertex_count;
     uint32_t index_count;
+    uint32_t dims;                     // How component values scale the unit mesh
+    bool streamed;                     // Meshes come from WebGPUMesh entities, one per range
+    
+    /* Levels of detail, finest first. Instances pick one by projected size. */
+    uint32_t lod_count;                // Meshes of the geometry, 1 without LODs
+    uint32_t lod_mesh_ids[WEBGPU_MAX_LODS]; // Mesh registry handle of each LOD
+    float lod_pixels[WEBGPU_MAX_LODS]; // Smallest projected diameter (pixels) of each LOD
+    float lod_pixel_scale;             // Pixels per world unit at depth 1 ranges were packed with
+    ecs_vec_t lod_state;               // LOD of each staging slot last pack (uint8_t)
     
     /* Instance data buffers */
-    WGPUBuffer instance_buffer;        // Transform matrices and colors
+    WGPUBuffer instance_buffer;        // Ring slot bound for the current frame
+    uint64_t instance_offset;          // Offset of the ring slot in instance_buffer
+    WebGPUBufferBlock instance_ring[WEBGPU_FRAMES_IN_FLIGHT]; // Persistent per-frame instance blocks
+    struct webgpu_resource_pool_t *resources; // Pool the blocks were allocated from
     ecs_allocator_t *allocator;
-    ecs_vec_t transform_data;          // mat4 transforms (CPU)
-    ecs_vec_t color_data;             // RGB colors (CPU)
+    ecs_vec_t instance_data;           // Packed instance records (CPU staging, bytes)
+    ecs_vec_t packed_data;             // Unculled records the culled ones are copied from (cull_enabled)
+    ecs_vec_t packed_spheres;          // Bounding sphere (xyz, radius) of each packed_data record
+    WebGPUInstanceFormat instance_format; // Layout of drawn records, of instance_data unless gpu_transforms
+    bool storage_instances;            // Records carry a mesh/material word (storage instancing)
+    uint32_t storage_tag;              // Mesh/material word of LOD 0 ranges were packed for
+    uint32_t first_instance;           // First record in the renderer's instance storage
+    uint32_t storage_first[WEBGPU_FRAMES_IN_FLIGHT]; // first_instance each storage slot was written at
+    bool gpu_transforms;               // instance_data holds position/rotation/scale records
+    uint32_t expanded_first;           // first_instance the expanded records were written at
+    float cull_frustum[6][4];          // Frustum the packed ranges were culled with
+    bool cull_enabled;                 // Packed ranges are frustum culled
+    float view_plane[4];               // View depth plane ranges were sorted and LOD'd with
+    bool view_enabled;                 // view_plane is set
+    uint32_t culled_count;             // Instances culled by the last gather
+    
+    /* GPU culling output */
+    WebGPUBufferBlock visible;         // Compacted visible instances (vertex + storage)
+    WebGPUBufferBlock shadow_visible[WEBGPU_MAX_SHADOW_CASCADES]; // Instances visible to each shadow cascade
+    bool instances_changed;            // Instances were added, removed, moved or changed by the last gather
+    ecs_vec_t table_ranges;            // Instance range per matched table (archetype)
     ecs_vec_t material_data;          // Material properties (CPU)
     uint32_t instance_count;
     
@@ -226,7 +418,81 @@ typedef struct WebGPUGeometry {
     ecs_query_t *query;
 } WebGPUGeometry;
 
-/* Material properties */
+/* Procedural primitives, generated at several levels of detail. Sizes are in
+ * local units, before the entity's transform. */
+typedef struct WebGPUSphere {
+    float radius;
+} WebGPUSphere;
+
+typedef struct WebGPUCylinder {
+    float radius;
+    float height;                      // Along the y axis
+} WebGPUCylinder;
+
+typedef struct WebGPUGrid {
+    float width;                       // Along the x axis, the grid faces +y
+    float depth;                       // Along the z axis
+} WebGPUGrid;
+
+FLECS_SYSTEMS_WEBGPU_API
+extern ECS_COMPONENT_DECLARE(WebGPUSphere);
+
+FLECS_SYSTEMS_WEBGPU_API
+extern ECS_COMPONENT_DECLARE(WebGPUCylinder);
+
+FLECS_SYSTEMS_WEBGPU_API
+extern ECS_COMPONENT_DECLARE(WebGPUGrid);
+
+/* Mesh streamed from a file. Like materials, meshes are shared: a mesh
+ * entity has the WebGPUMesh and its instances inherit it (IsA). Instances
+ * are drawn once the mesh is resident; files are fetched on the web and
+ * memory mapped natively, and uploaded over several frames within the
+ * renderer's stream_budget. */
+typedef struct WebGPUMesh {
+    char *path;                        // Mesh file (.fwm), a URL on the web. Owned (copied on set)
+} WebGPUMesh;
+
+FLECS_SYSTEMS_WEBGPU_API
+extern ECS_COMPONENT_DECLARE(WebGPUMesh);
+
+/* Texture loaded from a KTX2 file. Materials reference texture entities, and
+ * textures of the same size and format are packed into one texture array.
+ * A "{format}" in the path is replaced by the best format the device
+ * supports (bc7, astc, etc2 or rgba8), so a texture can be shipped in
+ * several encodings. Uncompressed textures without mips get a generated
+ * mip chain. */
+typedef struct WebGPUTexture {
+    char *path;                        // Texture file (.ktx2), a URL on the web. Owned (copied on set)
+} WebGPUTexture;
+
+FLECS_SYSTEMS_WEBGPU_API
+extern ECS_COMPONENT_DECLARE(WebGPUTexture);
+
+/* Additional view drawn with a renderer's device and resources. Add it to an
+ * entity with its own EcsCanvas, which gives the view's size and camera.
+ * Views draw the instances the renderer uploaded this frame into their own
+ * surface and depth target, so meshes, pipelines and instance data exist
+ * once for all views. While views exist CPU culling is off, sorting and LODs
+ * follow the renderer's camera, and GPU culling only culls the renderer's
+ * own canvas. At most WEBGPU_MAX_VIEWS - 1 views are drawn. */
+typedef struct WebGPUView {
+    ecs_entity_t renderer;             // Renderer entity, 0 for any renderer
+    char *selector;                    // HTML canvas selector ("#view2"). Owned (copied on set)
+    
+    /* Runtime state, owned by the renderer */
+    WGPUSurface surface;               // Created from selector, NULL draws offscreen (native)
+    WGPUTexture offscreen_texture;     // Owned by the render target pool
+    WGPUTextureView offscreen_view;
+    uint32_t width, height;            // Size the surface is configured at
+} WebGPUView;
+
+FLECS_SYSTEMS_WEBGPU_API
+extern ECS_COMPONENT_DECLARE(WebGPUView);
+
+/* Material properties. Materials are shared: entities use a material by
+ * inheriting it from a material entity (IsA), entities without one draw with
+ * the default (white) material. Materials with a base_color alpha below 1
+ * are drawn in the transparent pass. */
 typedef struct WebGPUMaterial {
     /* PBR material properties */
     float base_color[4];               // RGBA base color
@@ -234,22 +500,185 @@ typedef struct WebGPUMaterial {
     float roughness;                   // Roughness factor [0,1]
     float emissive_factor;             // Emissive intensity
     
-    /* Texture resources */
-    WGPUTexture diffuse_texture;       // Albedo/diffuse texture
-    WGPUTexture normal_texture;        // Normal map texture
-    WGPUTexture material_texture;      // Metallic/roughness/AO texture
-    WGPUSampler texture_sampler;       // Texture sampling configuration
-    
-    /* GPU resources */
-    WGPUBindGroup material_bind_group; // Material uniform bindings
-    WGPUBuffer uniform_buffer;         // Material uniform data
+    /* Textures, entities with a WebGPUTexture (0 for none) */
+    ecs_entity_t diffuse_texture;      // Albedo/diffuse texture, multiplied with base_color
+    ecs_entity_t normal_texture;       // Normal map texture (not sampled yet)
+    ecs_entity_t material_texture;     // Metallic/roughness/AO texture (not sampled yet)
 } WebGPUMaterial;
 
+/* Tag for entities drawn alpha blended in the transparent pass, sorted back
+ * to front. Entities without it are opaque unless their material has alpha. */
+FLECS_SYSTEMS_WEBGPU_API
+extern ECS_DECLARE(WebGPUTransparent);
+
 /* Query component for dynamic geometry queries */
 typedef struct WebGPUQuery {
     ecs_query_t *query;                // Flecs query handle
 } WebGPUQuery;
 
+/* Frame statistics singleton, published by the render system every frame.
+ * GPU times come from timestamp queries and lag a few frames behind. */
+typedef struct WebGPUFrameStats {
+    bool gpu_timing;                   // Timestamp queries supported by the adapter
+    float gpu_ms;                      // GPU time of all timed passes
+    float pass_ms[WebGPUPassCount];    // GPU time per pass (WebGPUPass)
+    float cpu_ms[WebGPUStageCount];    // CPU time per stage (WebGPUStage)
+    uint32_t draw_calls;               // Draws recorded this frame
+    uint32_t instances;                // Instances drawn this frame
+    uint32_t instances_culled;         // Instances rejected by CPU culling
+    uint32_t instances_transparent;    // Instances drawn in the transparent pass
+    uint64_t bytes_uploaded;           // Instance bytes written this frame
+    uint64_t bytes_skipped;            // Instance bytes of unchanged tables
+    uint32_t uniform_writes;           // Camera/light/material blocks written this frame
+    uint32_t state_changes;            // Pipeline, bind group and vertex buffer binds
+    uint32_t bundles_recorded;         // Render bundles recorded this frame
+    uint32_t bundles_replayed;         // Draws replayed from render bundles
+    uint32_t shadow_draws;             // Draws recorded by the shadow cascades
+    uint32_t passes_recorded;          // Frame graph passes recorded
+    uint32_t passes_culled;            // Frame graph passes dropped as unused
+    uint32_t transients_aliased;       // Transient resources sharing another's memory
+    uint64_t mesh_bytes_streamed;      // Mesh file bytes uploaded this frame
+    uint32_t meshes_loading;           // WebGPUMesh files not yet resident
+    uint64_t texture_bytes_streamed;   // Texture bytes uploaded this frame
+    uint32_t textures_loading;         // WebGPUTexture files not yet resident
+    uint32_t render_targets;           // Pooled render targets alive
+    uint32_t releases_pending;         // GPU handles waiting for their frames to complete
+    uint64_t buffer_pool_bytes;        // Released buffer bytes kept for reuse
+    uint32_t frame;                    // Index of the frame
+    bool depth_test;                   // Main pass had a depth attachment
+    float startup_ms;                  // Adapter request to first submitted frame
+    bool skipped;                      // Nothing changed, the frame wasn't rendered (on_demand)
+    uint32_t frames_skipped;           // Frames not rendered since the renderer started
+    uint32_t views;                    // Views drawn this frame, the renderer's canvas included
+} WebGPUFrameStats;
+
+FLECS_SYSTEMS_WEBGPU_API
+extern ECS_COMPONENT_DECLARE(WebGPUFrameStats);
+
+/* GPU buffer memory singleton. Set budget to cap the bytes the renderer's
+ * resource pool commits; allocations that would exceed it fail after free
+ * pooled memory was given back. The byte counts are published every frame. */
+typedef struct WebGPUMemoryBudget {
+    uint64_t budget;                   // Committed bytes allowed, 0 for no limit
+    uint64_t used;                     // Bytes of live blocks and buffers
+    uint64_t committed;                // Bytes of GPU buffers created by the pool
+    uint64_t class_used[WebGPUBufferClassCount]; // used per WebGPUBufferClass
+    uint64_t class_committed[WebGPUBufferClassCount]; // committed per WebGPUBufferClass
+    uint32_t failed;                   // Allocations refused by the budget
+} WebGPUMemoryBudget;
+
+FLECS_SYSTEMS_WEBGPU_API
+extern ECS_COMPONENT_DECLARE(WebGPUMemoryBudget);
+
+/* Slot of an entity in the shared transform array. The entity's
+ * EcsTransform3 is copied from its slot when the slot is published with
+ * webgpu_shared_transforms_written. */
+typedef struct WebGPUSharedTransform {
+    int32_t slot;                      // Index in WebGPUSharedTransforms::data
+} WebGPUSharedTransform;
+
+FLECS_SYSTEMS_WEBGPU_API
+extern ECS_COMPONENT_DECLARE(WebGPUSharedTransform);
+
+/* Shared transform array singleton, written by scripts straight into the
+ * WASM heap without a call per frame. Slots are column-major 4x4 matrices
+ * (16 floats, the EcsTransform3 layout). data moves when the array grows,
+ * which any call that reserves slots may do, and generation counts the
+ * moves: scripts compare it before writing and recreate their view when it
+ * changed. */
+typedef struct WebGPUSharedTransforms {
+    float *data;                       // capacity * 16 floats. Owned
+    int32_t capacity;                  // Slots allocated
+    uint32_t generation;               // Incremented every time data moves
+    ecs_entity_t *entities;            // Entity bound to each slot, 0 if none. Owned
+    int32_t dirty_first;               // Slots [dirty_first, dirty_end) are applied next frame
+    int32_t dirty_end;
+} WebGPUSharedTransforms;
+
+FLECS_SYSTEMS_WEBGPU_API
+extern ECS_COMPONENT_DECLARE(WebGPUSharedTransforms);
+
+/* Bulk entity API, creates and updates many entities in one call. Arrays are
+ * tightly packed: transforms are 16 floats per entity (EcsTransform3 layout),
+ * colors 3 floats (EcsRgb), dims the floats of the geometry component (3 for
+ * EcsBox, 2 for EcsRectangle). Scripts pass Float32Array views of the WASM
+ * heap, so nothing is marshalled per entity. */
+
+/* Create count entities of a geometry component (e.g. ecs_id(EcsBox)) in one
+ * table. colors may be NULL for white, dims may be NULL for a size of 1 on
+ * every axis. With first_slot >= 0 entity i uses
+ * shared transform slot first_slot + i, and transforms may be NULL to start
+ * from the slots' contents. Entity ids are written to entities when not NULL.
+ * Returns the number of entities created. */
+FLECS_SYSTEMS_WEBGPU_API
+int32_t webgpu_bulk_create(ecs_world_t *world, ecs_id_t geometry, int32_t count,
+    const float *transforms, const float *colors, const float *dims,
+    int32_t first_slot, ecs_entity_t *entities);
+
+/* Set the transforms and/or colors (either may be NULL) of count entities.
+ * Entities that don't have the component aren't changed. OnSet observers
+ * run for the first entity of every run of consecutive table rows only. */
+FLECS_SYSTEMS_WEBGPU_API
+void webgpu_bulk_update(ecs_world_t *world, const ecs_entity_t *entities, int32_t count,
+    const float *transforms, const float *colors);
+
+/* Delete count entities */
+FLECS_SYSTEMS_WEBGPU_API
+void webgpu_bulk_delete(ecs_world_t *world, const ecs_entity_t *entities, int32_t count);
+
+/* Make sure the shared transform array has at least capacity slots, returns
+ * its (possibly moved) data. New slots are identity matrices. */
+FLECS_SYSTEMS_WEBGPU_API
+float* webgpu_shared_transforms_reserve(ecs_world_t *world, int32_t capacity);
+
+/* Publish that count slots from first were written, they are copied into
+ * their entities' EcsTransform3 before the next frame's instances are packed.
+ * Only published slots are applied. */
+FLECS_SYSTEMS_WEBGPU_API
+void webgpu_shared_transforms_written(ecs_world_t *world, int32_t first, int32_t count);
+
+/* Number of times the shared transform array moved, 0 before it exists */
+FLECS_SYSTEMS_WEBGPU_API
+uint32_t webgpu_shared_transforms_generation(const ecs_world_t *world);
+
+/* Phase of systems that run at a fixed rate. Systems in it are not part of
+ * the builtin pipeline, webgpu_progress runs them once for every step of
+ * elapsed time, so the simulation rate doesn't depend on the render rate. */
+FLECS_SYSTEMS_WEBGPU_API
+extern ECS_DECLARE(WebGPUFixedUpdate);
+
+/* Fixed timestep singleton, used by webgpu_progress. Set step to enable it.
+ * alpha is the fraction of a step left over after the last step, to
+ * interpolate rendered state between the previous and the current step. */
+typedef struct WebGPUFixedTimestep {
+    float step;                        // Seconds per fixed step, 0 to disable
+    uint32_t max_steps;                // Steps per progress before time is dropped, 0 for WEBGPU_FIXED_MAX_STEPS
+    uint32_t steps;                    // Steps run by the last progress
+    float alpha;                       // Leftover time in steps [0,1)
+    float accumulator;                 // Time not yet simulated (internal)
+    ecs_time_t time;                   // Time of the last progress (internal)
+    ecs_entity_t pipeline;             // Pipeline of the WebGPUFixedUpdate systems (internal)
+} WebGPUFixedTimestep;
+
+FLECS_SYSTEMS_WEBGPU_API
+extern ECS_COMPONENT_DECLARE(WebGPUFixedTimestep);
+
+/* Run the fixed steps the elapsed time (delta_time, or the measured time
+ * since the last call when 0) adds up to, then progress the world once.
+ * Use it in place of ecs_progress. */
+FLECS_SYSTEMS_WEBGPU_API
+bool webgpu_progress(ecs_world_t *world, ecs_ftime_t delta_time);
+
+/* Render the next frame of an on_demand renderer, for changes the renderer
+ * can't detect (e.g. a canvas that was cleared by the page) */
+FLECS_SYSTEMS_WEBGPU_API
+void webgpu_invalidate(ecs_world_t *world, ecs_entity_t renderer);
+
+/* Print the trace event ring, oldest event first. Exported so it can be
+ * called from the browser console (Module._webgpu_trace_dump()). */
+FLECS_SYSTEMS_WEBGPU_API
+void webgpu_trace_dump(void);
+
 /* Module import function */
 FLECS_SYSTEMS_WEBGPU_API
 void FlecsSystemsWebGPUImport(ecs_world_t *world);
@@ -0,0 +1,293 @@
+// Geometry shader for Flecs geometric primitives (vertex + fragment stage)
+//
+// This file is a template: lines starting with # are preprocessor
+// directives handled by tools/wgsl_variants.c, which expands every feature
+// permutation into src/shaders/shader_variants.c at build time.
+//
+// Features:
+//   COMPACT_INSTANCES  Instances are affine mat3x4 rows + rgba8 color
+//                      (float32 and float16 layouts), else mat4 + rgb
+//   ALPHA              Output the instance alpha instead of opaque
+//   STORAGE_INSTANCES  Instances are records in a storage buffer indexed by
+//                      instance_index (firstInstance included), decoded for
+//                      the instance_format override, else vertex attributes
+//   SHADOWS            Shade the directional light with its cascaded shadow
+//                      maps, sampled from the depth atlas in the light group
+
+struct VertexInput {
+    @location(0) position: vec3<f32>,
+    @location(1) normal: vec3<f32>,
+    @location(2) uv: vec2<f32>,
+}
+
+#ifdef STORAGE_INSTANCES
+// Record layout (WebGPUInstanceFormat), each followed by a mesh/material word:
+//   0 full:         mat4 columns f32, rgb f32             (20 words)
+//   1 compact:      mat3x4 rows f32, rgba8                (14 words)
+//   2 compact half: mat3x4 rows f16, rgba8                 (8 words)
+override instance_format: u32 = 0u;
+#else
+#ifdef COMPACT_INSTANCES
+struct InstanceInput {
+    @location(3) model_row_0: vec4<f32>,
+    @location(4) model_row_1: vec4<f32>,
+    @location(5) model_row_2: vec4<f32>,
+    @location(6) color: vec4<f32>,
+}
+#else
+struct InstanceInput {
+    @location(3) model_matrix_0: vec4<f32>,
+    @location(4) model_matrix_1: vec4<f32>,
+    @location(5) model_matrix_2: vec4<f32>,
+    @location(6) model_matrix_3: vec4<f32>,
+    @location(7) color: vec3<f32>,
+}
+#endif
+#endif
+
+struct VertexOutput {
+    @builtin(position) clip_position: vec4<f32>,
+    @location(0) world_position: vec3<f32>,
+    @location(1) world_normal: vec3<f32>,
+    @location(2) uv: vec2<f32>,
+    @location(3) color: vec4<f32>,
+}
+
+struct Camera {
+    view: mat4x4<f32>,
+    projection: mat4x4<f32>,
+    view_projection: mat4x4<f32>,
+}
+
+// Exactly 40 bytes, only f32 and vec2 members to avoid vec3 padding
+struct Light {
+    direction_x: f32,
+    direction_y: f32,
+    direction_z: f32,
+    intensity: f32,
+    color_x: f32,
+    color_y: f32,
+    color_z: f32,
+    ambient_strength: f32,
+    ambient_xy: vec2<f32>,
+}
+
+@group(0) @binding(0)
+var<uniform> camera: Camera;
+
+// Material properties, one block per material selected by a dynamic offset
+struct Material {
+    base_color: vec4<f32>,
+    metallic: f32,
+    roughness: f32,
+    emissive: f32,
+    diffuse_layer: u32,
+}
+
+@group(1) @binding(0)
+var<uniform> light: Light;
+
+#ifdef SHADOWS
+// Cascades of the directional light, each drawn into a tile of one atlas
+struct Shadows {
+    view_projection: array<mat4x4<f32>, 4>,
+    tiles: array<vec4<f32>, 4>,      // Atlas uv scale (xy) and offset (zw) of each cascade
+    splits: vec4<f32>,               // Far view depth of each cascade
+    view_plane: vec4<f32>,           // View depth of a world position
+    cascades: u32,                   // 0 while there is no camera to fit them to
+    bias: f32,
+    texel_size: vec2<f32>,           // Atlas texel in uv
+}
+
+@group(1) @binding(1)
+var<uniform> shadows: Shadows;
+
+@group(1) @binding(2)
+var shadow_atlas: texture_depth_2d;
+
+@group(1) @binding(3)
+var shadow_sampler: sampler_comparison;
+
+// Light reaching a world position, 1 outside of the cascades. Nine taps on
+// top of the 2x2 filtering of the comparison sampler, kept inside the tile.
+fn shadow_factor(world_position: vec3<f32>) -> f32 {
+    let depth = dot(shadows.view_plane.xyz, world_position) + shadows.view_plane.w;
+    var cascade = 0u;
+    while (cascade < shadows.cascades && depth > shadows.splits[cascade]) {
+        cascade++;
+    }
+    if (cascade >= shadows.cascades) {
+        return 1.0;
+    }
+    
+    let clip = shadows.view_projection[cascade] * vec4<f32>(world_position, 1.0);
+    let uv = clip.xy * vec2<f32>(0.5, -0.5) + vec2<f32>(0.5);
+    if (any(uv < vec2<f32>(0.0)) || any(uv > vec2<f32>(1.0)) || clip.z > 1.0) {
+        return 1.0;
+    }
+    
+    let tile = shadows.tiles[cascade];
+    let margin = shadows.texel_size * 1.5;
+    let center = clamp(tile.zw + uv * tile.xy, tile.zw + margin, tile.zw + tile.xy - margin);
+    let reference = clip.z - shadows.bias;
+    var lit = 0.0;
+    for (var y = -1; y <= 1; y++) {
+        for (var x = -1; x <= 1; x++) {
+            let offset = vec2<f32>(f32(x), f32(y)) * shadows.texel_size;
+            lit += textureSampleCompareLevel(shadow_atlas, shadow_sampler, center + offset, reference);
+        }
+    }
+    return lit / 9.0;
+}
+#endif
+
+@group(2) @binding(0)
+var<uniform> material: Material;
+
+// Diffuse textures of the same size and format share an array, materials
+// without one sample a white texel
+@group(2) @binding(1)
+var diffuse_maps: texture_2d_array<f32>;
+
+@group(2) @binding(2)
+var diffuse_sampler: sampler;
+
+#ifdef STORAGE_INSTANCES
+@group(3) @binding(0)
+var<storage, read> instance_words: array<u32>;
+
+fn instance_stride() -> u32 {
+    if (instance_format == 0u) {
+        return 20u;
+    }
+    if (instance_format == 1u) {
+        return 14u;
+    }
+    return 8u;
+}
+
+// Affine model matrix of a record at base as three rows
+fn instance_rows(base: u32) -> mat3x4<f32> {
+    if (instance_format == 0u) {
+        var columns: array<vec4<f32>, 4>;
+        for (var c = 0u; c < 4u; c++) {
+            columns[c] = bitcast<vec4<f32>>(vec4<u32>(
+                instance_words[base + c * 4u],
+                instance_words[base + c * 4u + 1u],
+                instance_words[base + c * 4u + 2u],
+                instance_words[base + c * 4u + 3u],
+            ));
+        }
+        return transpose(mat4x3<f32>(columns[0].xyz, columns[1].xyz, columns[2].xyz, columns[3].xyz));
+    }
+    
+    if (instance_format == 1u) {
+        var rows: array<vec4<f32>, 3>;
+        for (var r = 0u; r < 3u; r++) {
+            rows[r] = bitcast<vec4<f32>>(vec4<u32>(
+                instance_words[base + r * 4u],
+                instance_words[base + r * 4u + 1u],
+                instance_words[base + r * 4u + 2u],
+                instance_words[base + r * 4u + 3u],
+            ));
+        }
+        return mat3x4<f32>(rows[0], rows[1], rows[2]);
+    }
+    
+    var rows: array<vec4<f32>, 3>;
+    for (var r = 0u; r < 3u; r++) {
+        rows[r] = vec4<f32>(
+            unpack2x16float(instance_words[base + r * 2u]),
+            unpack2x16float(instance_words[base + r * 2u + 1u]),
+        );
+    }
+    return mat3x4<f32>(rows[0], rows[1], rows[2]);
+}
+
+fn instance_color(base: u32) -> vec4<f32> {
+    if (instance_format == 0u) {
+        return vec4<f32>(bitcast<vec3<f32>>(vec3<u32>(
+            instance_words[base + 16u],
+            instance_words[base + 17u],
+            instance_words[base + 18u],
+        )), 1.0);
+    }
+    if (instance_format == 1u) {
+        return unpack4x8unorm(instance_words[base + 12u]);
+    }
+    return unpack4x8unorm(instance_words[base + 6u]);
+}
+
+@vertex
+fn vs_main(vertex: VertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {
+    // The trailing mesh/material word is not needed to draw yet
+    let base = instance_index * instance_stride();
+    let model_matrix = transpose(instance_rows(base));
+    
+    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);
+    let world_normal = normalize(model_matrix * vec4<f32>(vertex.normal, 0.0));
+    let color = instance_color(base);
+#else
+@vertex
+fn vs_main(vertex: VertexInput, instance: InstanceInput) -> VertexOutput {
+#ifdef COMPACT_INSTANCES
+    let model_matrix = transpose(mat3x4<f32>(
+        instance.model_row_0,
+        instance.model_row_1,
+        instance.model_row_2,
+    ));
+    
+    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);
+    let world_normal = normalize(model_matrix * vec4<f32>(vertex.normal, 0.0));
+    let color = instance.color;
+#else
+    let model_matrix = mat4x4<f32>(
+        instance.model_matrix_0,
+        instance.model_matrix_1,
+        instance.model_matrix_2,
+        instance.model_matrix_3,
+    );
+    
+    let world_position = (model_matrix * vec4<f32>(vertex.position, 1.0)).xyz;
+    let world_normal = normalize((model_matrix * vec4<f32>(vertex.normal, 0.0)).xyz);
+    let color = vec4<f32>(instance.color, 1.0);
+#endif
+#endif
+    
+    var out: VertexOutput;
+    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);
+    out.world_position = world_position;
+    out.world_normal = world_normal;
+    out.uv = vertex.uv;
+    out.color = color;
+    
+    return out;
+}
+
+@fragment
+fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {
+    let normal = normalize(in.world_normal);
+    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);
+    let light_dir = normalize(-light_direction);
+    
+    // Lambertian diffuse lighting
+    let ndotl = max(dot(normal, light_dir), 0.0);
+    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);
+#ifdef SHADOWS
+    let diffuse = light_color * light.intensity * ndotl * shadow_factor(in.world_position);
+#else
+    let diffuse = light_color * light.intensity * ndotl;
+#endif
+    
+    // Combine lighting with instance, material and texture color
+    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);
+    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);
+    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;
+    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;
+    
+#ifdef ALPHA
+    return vec4<f32>(final_color, in.color.a * material.base_color.a * texel.a);
+#else
+    return vec4<f32>(final_color, 1.0);
+#endif
+}
@@ -0,0 +1,306 @@
+/**
+ * @file geometry/entity_bulk.c
+ * @brief Bulk entity creation and the shared transform array for scripts.
+ *
+ * Scripts that spawn thousands of entities pay for every call into the WASM
+ * module, so entities are created, updated and deleted in batches from
+ * packed arrays that live in the WASM heap. Entities created together go
+ * into one table with a single ecs_bulk_init. Entities can also be bound to
+ * a slot of the shared transform array, which scripts overwrite in place
+ * each frame and then publish the range of slots they wrote; a system
+ * copies only that range into EcsTransform3 before the instances are packed.
+ */
+
+#include "../private_api.h"
+
+#define TRANSFORM_FLOATS 16
+#define COLOR_FLOATS 3
+
+/**
+ * Create count entities of a geometry component in one table
+ */
+int32_t webgpu_bulk_create(ecs_world_t *world,
+                           ecs_id_t geometry,
+                           int32_t count,
+                           const float *transforms,
+                           const float *colors,
+                           const float *dims,
+                           int32_t first_slot,
+                           ecs_entity_t *entities) {
+    if (!world || !geometry || count <= 0) {
+        return 0;
+    }
+
+    const ecs_type_info_t *geometry_ti = ecs_get_type_info(world, geometry);
+    if (!geometry_ti || geometry_ti->size % sizeof(float)) {
+        ecs_err("webgpu_bulk_create: geometry must be a component of floats");
+        return 0;
+    }
+
+    WebGPUSharedTransform *slots = NULL;
+    if (first_slot >= 0) {
+        /* The slots hold the transforms from now on */
+        float *shared = webgpu_shared_transforms_reserve(world, first_slot + count);
+        float *first = &shared[(size_t)first_slot * TRANSFORM_FLOATS];
+        if (transforms) {
+            memcpy(first, transforms, (size_t)count * sizeof(EcsTransform3));
+        }
+        transforms = first;
+
+        slots = ecs_os_malloc_n(WebGPUSharedTransform, count);
+        for (int32_t i = 0; i < count; i++) {
+            slots[i].slot = first_slot + i;
+        }
+    } else if (!transforms) {
+        ecs_err("webgpu_bulk_create: transforms required for entities without a shared slot");
+        return 0;
+    }
+
+    /* Without dimensions every geometry is unit sized, a zero sized column
+     * would scale the meshes away */
+    float *unit_dims = NULL;
+    if (!dims) {
+        int32_t floats = count * (geometry_ti->size / (int32_t)sizeof(float));
+        unit_dims = ecs_os_malloc_n(float, floats);
+        for (int32_t i = 0; i < floats; i++) {
+            unit_dims[i] = 1.0f;
+        }
+        dims = unit_dims;
+    }
+
+    /* Components are copied from the arrays */
+    ecs_bulk_desc_t desc = { .count = count };
+    void *data[4] = {0};
+    int32_t id_count = 0;
+
+    desc.ids[id_count] = ecs_id(EcsTransform3);
+    data[id_count++] = (void*)transforms;
+    desc.ids[id_count] = geometry;
+    data[id_count++] = (void*)dims;
+    if (colors) {
+        desc.ids[id_count] = ecs_id(EcsRgb);
+        data[id_count++] = (void*)colors;
+    }
+    if (slots) {
+        desc.ids[id_count] = ecs_id(WebGPUSharedTransform);
+        data[id_count++] = slots;
+    }
+    desc.data = data;
+
+    const ecs_entity_t *created = ecs_bulk_init(world, &desc);
+    ecs_os_free(slots);
+    ecs_os_free(unit_dims);
+    if (!created) {
+        ecs_err("WebGPU: Failed to create %d entities", count);
+        return 0;
+    }
+
+    /* Slots find their entity without a lookup */
+    if (first_slot >= 0) {
+        WebGPUSharedTransforms *shared = ecs_singleton_get_mut(world, WebGPUSharedTransforms);
+        memcpy(&shared->entities[first_slot], created, (size_t)count * sizeof(ecs_entity_t));
+    }
+
+    /* The returned array is only valid until the next operation */
+    if (entities) {
+        memcpy(entities, created, (size_t)count * sizeof(ecs_entity_t));
+    }
+
+    return count;
+}
+
+/**
+ * Find the run of entities at the start of entities that are stored in
+ * consecutive rows of one table. A run of dead (or 0) entities has no table.
+ * Returns the length of the run.
+ */
+static int32_t entity_run(const ecs_world_t *world,
+                          const ecs_entity_t *entities,
+                          int32_t count,
+                          ecs_table_t **table,
+                          int32_t *row) {
+    const ecs_record_t *r = entities[0] && ecs_is_alive(world, entities[0]) ?
+        ecs_record_find(world, entities[0]) : NULL;
+    if (!r || !r->table) {
+        *table = NULL;
+        return 1;
+    }
+
+    *table = r->table;
+    *row = ECS_RECORD_TO_ROW(r->row);
+
+    int32_t length = 1;
+    for (; length < count; length++) {
+        ecs_entity_t e = entities[length];
+        r = e && ecs_is_alive(world, e) ? ecs_record_find(world, e) : NULL;
+        if (!r || r->table != *table || ECS_RECORD_TO_ROW(r->row) != *row + length) {
+            break;
+        }
+    }
+    return length;
+}
+
+/**
+ * Set the transforms and colors of count entities. Entities created
+ * together share a table and consecutive rows, so the arrays are copied
+ * into the columns a run of rows at a time, and each run marks its table's
+ * columns modified once. Entities bound to a shared slot get the transform
+ * written to the slot as well, so the copy from the array doesn't undo it.
+ */
+void webgpu_bulk_update(ecs_world_t *world,
+                        const ecs_entity_t *entities,
+                        int32_t count,
+                        const float *transforms,
+                        const float *colors) {
+    if (!world || !entities) {
+        return;
+    }
+
+    const WebGPUSharedTransforms *shared = ecs_singleton_get(world, WebGPUSharedTransforms);
+    for (int32_t i = 0; i < count;) {
+        ecs_table_t *table;
+        int32_t row = 0;
+        int32_t run = entity_run(world, &entities[i], count - i, &table, &row);
+        if (!table) {
+            i += run;
+            continue;
+        }
+
+        EcsTransform3 *dst = transforms ?
+            ecs_table_get_id(world, table, ecs_id(EcsTransform3), row) : NULL;
+        if (dst) {
+            const float *src = &transforms[(size_t)i * TRANSFORM_FLOATS];
+            memcpy(dst, src, (size_t)run * sizeof(EcsTransform3));
+            ecs_modified_id(world, entities[i], ecs_id(EcsTransform3));
+
+            const WebGPUSharedTransform *slots = shared ?
+                ecs_table_get_id(world, table, ecs_id(WebGPUSharedTransform), row) : NULL;
+            for (int32_t k = 0; slots && k < run; k++) {
+                if (slots[k].slot >= 0 && slots[k].slot < shared->capacity) {
+                    memcpy(&shared->data[(size_t)slots[k].slot * TRANSFORM_FLOATS],
+                        &src[(size_t)k * TRANSFORM_FLOATS], sizeof(EcsTransform3));
+                }
+            }
+        }
+
+        EcsRgb *dst_colors = colors ?
+            ecs_table_get_id(world, table, ecs_id(EcsRgb), row) : NULL;
+        if (dst_colors) {
+            memcpy(dst_colors, &colors[(size_t)i * COLOR_FLOATS], (size_t)run * sizeof(EcsRgb));
+            ecs_modified_id(world, entities[i], ecs_id(EcsRgb));
+        }
+
+        i += run;
+    }
+}
+
+/**
+ * Delete count entities
+ */
+void webgpu_bulk_delete(ecs_world_t *world, const ecs_entity_t *entities, int32_t count) {
+    if (!world || !entities) {
+        return;
+    }
+
+    for (int32_t i = 0; i < count; i++) {
+        if (ecs_is_alive(world, entities[i])) {
+            ecs_delete(world, entities[i]);
+        }
+    }
+}
+
+/**
+ * Grow the shared transform array to at least capacity slots
+ */
+float* webgpu_shared_transforms_reserve(ecs_world_t *world, int32_t capacity) {
+    WebGPUSharedTransforms *shared = ecs_singleton_ensure(world, WebGPUSharedTransforms);
+    if (capacity <= shared->capacity) {
+        return shared->data;
+    }
+
+    int32_t new_capacity = shared->capacity ? shared->capacity : 1024;
+    while (new_capacity < capacity) {
+        new_capacity *= 2;
+    }
+
+    shared->data = ecs_os_realloc_n(shared->data, float, new_capacity * TRANSFORM_FLOATS);
+    shared->entities = ecs_os_realloc_n(shared->entities, ecs_entity_t, new_capacity);
+    for (int32_t i = shared->capacity; i < new_capacity; i++) {
+        glm_mat4_identity((vec4*)&shared->data[(size_t)i * TRANSFORM_FLOATS]);
+        shared->entities[i] = 0;
+    }
+
+    ecs_trace("WebGPU: Shared transform array grew to %d slots", new_capacity);
+    shared->capacity = new_capacity;
+    shared->generation++;
+    return shared->data;
+}
+
+/**
+ * Grow the range of slots the next apply copies by count slots from first
+ */
+void webgpu_shared_transforms_written(ecs_world_t *world, int32_t first, int32_t count) {
+    WebGPUSharedTransforms *shared = ecs_singleton_get_mut(world, WebGPUSharedTransforms);
+    if (!shared || count <= 0 || first < 0) {
+        return;
+    }
+
+    int32_t end = first + count;
+    if (shared->dirty_end <= shared->dirty_first) {
+        shared->dirty_first = first;
+        shared->dirty_end = end;
+    } else {
+        shared->dirty_first = first < shared->dirty_first ? first : shared->dirty_first;
+        shared->dirty_end = end > shared->dirty_end ? end : shared->dirty_end;
+    }
+}
+
+/**
+ * Get the number of times the shared transform array moved
+ */
+uint32_t webgpu_shared_transforms_generation(const ecs_world_t *world) {
+    const WebGPUSharedTransforms *shared = ecs_singleton_get(world, WebGPUSharedTransforms);
+    return shared ? shared->generation : 0;
+}
+
+/**
+ * Copy the written range of shared transform slots into EcsTransform3.
+ * Slots bound together are consecutive rows of one table, so a run of them
+ * is one copy and marks its table modified once; tables outside the range
+ * aren't visited and their instances aren't repacked.
+ */
+void webgpu_apply_shared_transforms(ecs_iter_t *it) {
+    ecs_world_t *world = it->world;
+    WebGPUSharedTransforms *shared = ecs_singleton_get_mut(world, WebGPUSharedTransforms);
+    if (!shared || shared->dirty_end <= shared->dirty_first) {
+        return;
+    }
+
+    int32_t slot = shared->dirty_first;
+    int32_t end = shared->dirty_end < shared->capacity ? shared->dirty_end : shared->capacity;
+    shared->dirty_first = shared->dirty_end = 0;
+
+    while (slot < end) {
+        ecs_table_t *table;
+        int32_t row = 0;
+        int32_t run = entity_run(world, &shared->entities[slot], end - slot, &table, &row);
+
+        EcsTransform3 *dst = table ?
+            ecs_table_get_id(world, table, ecs_id(EcsTransform3), row) : NULL;
+        const WebGPUSharedTransform *slots = dst ?
+            ecs_table_get_id(world, table, ecs_id(WebGPUSharedTransform), row) : NULL;
+
+        /* Entities may have been rebound to other slots since */
+        int32_t bound = 0;
+        while (slots && bound < run && slots[bound].slot == slot + bound) {
+            bound++;
+        }
+        if (bound) {
+            memcpy(dst, &shared->data[(size_t)slot * TRANSFORM_FLOATS],
+                (size_t)bound * sizeof(EcsTransform3));
+            ecs_modified_id(world, shared->entities[slot], ecs_id(EcsTransform3));
+        }
+
+        slot += bound ? bound : 1;
+    }
+}
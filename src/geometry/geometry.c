@@ -71,49 +71,132 @@ const uint16_t rectangle_indices[] = {
 };
 
 /* Geometry data counts */
-const uint32_t box_vertex_count = sizeof(box_vertices) / (8 * sizeof(float));
+const uint32_t box_vertex_count = sizeof(box_vertices) / WEBGPU_BYTES_PER_VERTEX;
 const uint32_t box_index_count = sizeof(box_indices) / sizeof(uint16_t);
-const uint32_t rectangle_vertex_count = sizeof(rectangle_vertices) / (8 * sizeof(float));
+const uint32_t rectangle_vertex_count = sizeof(rectangle_vertices) / WEBGPU_BYTES_PER_VERTEX;
 const uint32_t rectangle_index_count = sizeof(rectangle_indices) / sizeof(uint16_t);
 
+/* Level of detail of a procedural primitive */
+typedef struct {
+    uint32_t segments;                /* Around the y axis, or grid cells per side */
+    uint32_t rings;                   /* Sphere only */
+    float pixels;                     /* Smallest projected diameter the level is used at */
+} primitive_lod_t;
+
+/* Primitive levels of detail, finest first. The last level has no minimum. */
+static const primitive_lod_t sphere_lods[] = {
+    { 32, 16, 96.0f }, { 16, 8, 32.0f }, { 10, 6, 12.0f }, { 6, 4, 0.0f }
+};
+
+static const primitive_lod_t cylinder_lods[] = {
+    { 32, 0, 96.0f }, { 16, 0, 32.0f }, { 8, 0, 12.0f }, { 5, 0, 0.0f }
+};
+
+static const primitive_lod_t grid_lods[] = {
+    { 32, 0, 256.0f }, { 16, 0, 96.0f }, { 4, 0, 24.0f }, { 1, 0, 0.0f }
+};
+
 /**
- * Initialize box geometry
+ * Get the level of detail table of a primitive component
  */
-void webgpu_init_box_geometry(ecs_world_t *world, WebGPUGeometry *geometry) {
-    ecs_trace("WebGPU: Initializing box geometry");
+static const primitive_lod_t* get_primitive_lods(ecs_id_t component, uint32_t *count) {
+    if (component == ecs_id(WebGPUSphere)) {
+        *count = sizeof(sphere_lods) / sizeof(sphere_lods[0]);
+        return sphere_lods;
+    }
+    
+    if (component == ecs_id(WebGPUCylinder)) {
+        *count = sizeof(cylinder_lods) / sizeof(cylinder_lods[0]);
+        return cylinder_lods;
+    }
     
-    geometry->component_id = ecs_id(EcsBox);
-    geometry->vertex_count = sizeof(box_vertices) / (8 * sizeof(float));  /* 8 floats per vertex */
-    geometry->index_count = sizeof(box_indices) / sizeof(uint16_t);
+    if (component == ecs_id(WebGPUGrid)) {
+        *count = sizeof(grid_lods) / sizeof(grid_lods[0]);
+        return grid_lods;
+    }
+    
+    *count = 0;
+    return NULL;
+}
+
+/**
+ * Create the cached query of a geometry component and the instance data
+ * vectors. Returns false if the query could not be created.
+ */
+static bool init_geometry_query(ecs_world_t *world, WebGPUGeometry *geometry, ecs_id_t component) {
+    geometry->component_id = component;
     
-    /* Create query for entities with EcsBox component */
     geometry->query = ecs_query(world, {
         .terms = {{
             .id = ecs_id(EcsTransform3),
             .inout = EcsIn
         }, {
             .id = ecs_id(EcsRgb),
-            .inout = EcsIn
+            .inout = EcsIn,
+            .oper = EcsOptional
         }, {
-            .id = ecs_id(EcsBox),
+            .id = component,
             .inout = EcsIn
-        }}
+        }, {
+            .id = ecs_id(WebGPUMaterial), /* Inherited from a material entity */
+            .inout = EcsInOutNone,
+            .oper = EcsOptional
+        }, {
+            .id = WebGPUTransparent,
+            .inout = EcsInOutNone,
+            .oper = EcsOptional
+        }, {
+            .id = ecs_id(EcsPosition3), /* Packed instead of the transform by gpu_transforms */
+            .inout = EcsIn,
+            .oper = EcsOptional
+        }, {
+            .id = ecs_id(EcsRotation3),
+            .inout = EcsIn,
+            .oper = EcsOptional
+        }, {
+            .id = ecs_id(EcsScale3),
+            .inout = EcsIn,
+            .oper = EcsOptional
+        }},
+        .cache_kind = EcsQueryCacheAuto, /* Reused every frame by the render system */
+        .flags = EcsQueryDetectChanges,  /* Only changed tables are repacked */
+        .group_by = ecs_id(WebGPUMaterial), /* Tables of a material are packed together */
+        .group_by_callback = webgpu_material_group
     });
     
     if (!geometry->query) {
-        ecs_err("WebGPU: Failed to create box geometry query");
-        return;
+        ecs_err("WebGPU: Failed to create %s geometry query", ecs_get_name(world, component));
+        return false;
     }
     
     /* Initialize instance data vectors */
     geometry->allocator = ecs_os_malloc_t(ecs_allocator_t);
     flecs_allocator_init(geometry->allocator);
     
-    ecs_vec_init_t(geometry->allocator, &geometry->transform_data, mat4, 0);
-    ecs_vec_init_t(geometry->allocator, &geometry->color_data, vec3, 0);
+    ecs_vec_init_t(geometry->allocator, &geometry->instance_data, uint8_t, 0);
+    ecs_vec_init_t(geometry->allocator, &geometry->packed_data, uint8_t, 0);
+    ecs_vec_init_t(geometry->allocator, &geometry->packed_spheres, float, 0);
+    ecs_vec_init_t(geometry->allocator, &geometry->table_ranges, webgpu_table_range_t, 0);
     ecs_vec_init_t(geometry->allocator, &geometry->material_data, float, 0);  /* Placeholder */
+    ecs_vec_init_t(geometry->allocator, &geometry->lod_state, uint8_t, 0);
     
-    ecs_trace("WebGPU: Box geometry initialized");
+    geometry->lod_count = 1;
+    return true;
+}
+
+/**
+ * Initialize box geometry
+ */
+void webgpu_init_box_geometry(ecs_world_t *world, WebGPUGeometry *geometry) {
+    ecs_trace("WebGPU: Initializing box geometry");
+    
+    geometry->vertex_count = box_vertex_count;
+    geometry->index_count = box_index_count;
+    geometry->dims = WebGPUDimsXYZ;
+    
+    if (init_geometry_query(world, geometry, ecs_id(EcsBox))) {
+        ecs_trace("WebGPU: Box geometry initialized");
+    }
 }
 
 /**
@@ -122,137 +205,910 @@ void webgpu_init_box_geometry(ecs_world_t *world, WebGPUGeometry *geometry) {
 void webgpu_init_rectangle_geometry(ecs_world_t *world, WebGPUGeometry *geometry) {
     ecs_trace("WebGPU: Initializing rectangle geometry");
     
-    geometry->component_id = ecs_id(EcsRectangle);
-    geometry->vertex_count = sizeof(rectangle_vertices) / (8 * sizeof(float));
-    geometry->index_count = sizeof(rectangle_indices) / sizeof(uint16_t);
+    geometry->vertex_count = rectangle_vertex_count;
+    geometry->index_count = rectangle_index_count;
+    geometry->dims = WebGPUDimsXY;
     
-    /* Create query for entities with EcsRectangle component */
-    geometry->query = ecs_query(world, {
-        .terms = {{
-            .id = ecs_id(EcsTransform3),
-            .inout = EcsIn
-        }, {
-            .id = ecs_id(EcsRgb),
-            .inout = EcsIn
-        }, {
-            .id = ecs_id(EcsRectangle),
-            .inout = EcsIn
-        }}
-    });
+    if (init_geometry_query(world, geometry, ecs_id(EcsRectangle))) {
+        ecs_trace("WebGPU: Rectangle geometry initialized");
+    }
+}
+
+/**
+ * Initialize the geometry of a procedural primitive (WebGPUSphere,
+ * WebGPUCylinder or WebGPUGrid) with its levels of detail. Meshes are
+ * generated when the geometry is first uploaded.
+ */
+void webgpu_init_primitive_geometry(ecs_world_t *world, WebGPUGeometry *geometry, ecs_id_t component) {
+    uint32_t lod_count;
+    const primitive_lod_t *lods = get_primitive_lods(component, &lod_count);
+    if (!lods || lod_count > WEBGPU_MAX_LODS) {
+        ecs_err("WebGPU: No levels of detail for primitive %s", ecs_get_name(world, component));
+        return;
+    }
     
-    if (!geometry->query) {
-        ecs_err("WebGPU: Failed to create rectangle geometry query");
+    if (component == ecs_id(WebGPUSphere)) {
+        geometry->dims = WebGPUDimsRadius;
+    } else if (component == ecs_id(WebGPUCylinder)) {
+        geometry->dims = WebGPUDimsRadiusHeight;
+    } else {
+        geometry->dims = WebGPUDimsXZ;
+    }
+    
+    if (!init_geometry_query(world, geometry, component)) {
         return;
     }
     
-    /* Initialize instance data vectors */
-    geometry->allocator = ecs_os_malloc_t(ecs_allocator_t);
-    flecs_allocator_init(geometry->allocator);
+    geometry->lod_count = lod_count;
+    for (uint32_t i = 0; i < lod_count; i++) {
+        geometry->lod_pixels[i] = lods[i].pixels;
+    }
+    
+    ecs_trace("WebGPU: %s geometry initialized with %u levels of detail",
+        ecs_get_name(world, component), lod_count);
+}
+
+/**
+ * Initialize the geometry of WebGPUMesh instances. Ranges draw the mesh
+ * their table inherits, once the mesh loader made it resident.
+ */
+void webgpu_init_mesh_geometry(ecs_world_t *world, WebGPUGeometry *geometry) {
+    ecs_trace("WebGPU: Initializing mesh geometry");
+    
+    geometry->dims = WebGPUDimsNone;
+    geometry->streamed = true;
+    
+    if (init_geometry_query(world, geometry, ecs_id(WebGPUMesh))) {
+        ecs_trace("WebGPU: Mesh geometry initialized");
+    }
+}
+
+/**
+ * Generate and upload the meshes of a primitive, one per level of detail
+ */
+static bool upload_primitive_meshes(WebGPURenderer *renderer, WebGPUGeometry *geometry) {
+    uint32_t lod_count;
+    const primitive_lod_t *lods = get_primitive_lods(geometry->component_id, &lod_count);
+    if (!lods || geometry->lod_count != lod_count) {
+        return false;
+    }
+    
+    ecs_vec_t vertices, indices;
+    ecs_vec_init_t(NULL, &vertices, float, 0);
+    ecs_vec_init_t(NULL, &indices, uint16_t, 0);
+    
+    bool ok = true;
+    for (uint32_t i = 0; ok && i < lod_count; i++) {
+        ecs_vec_clear(&vertices);
+        ecs_vec_clear(&indices);
+        
+        if (geometry->component_id == ecs_id(WebGPUSphere)) {
+            webgpu_generate_sphere(&vertices, &indices, lods[i].segments, lods[i].rings);
+        } else if (geometry->component_id == ecs_id(WebGPUCylinder)) {
+            webgpu_generate_cylinder(&vertices, &indices, lods[i].segments);
+        } else {
+            webgpu_generate_grid(&vertices, &indices, lods[i].segments);
+        }
+        
+        uint32_t vertex_count = (uint32_t)ecs_vec_count(&vertices) / 8;
+        uint32_t index_count = (uint32_t)ecs_vec_count(&indices);
+        geometry->lod_mesh_ids[i] = webgpu_mesh_registry_add(renderer->mesh_registry,
+            renderer->device, renderer->queue,
+            ecs_vec_first_t(&vertices, float), vertex_count,
+            ecs_vec_first_t(&indices, uint16_t), index_count);
+        ok = geometry->lod_mesh_ids[i] != 0;
+        
+        if (i == 0) {
+            geometry->vertex_count = vertex_count;
+            geometry->index_count = index_count;
+        }
+    }
+    
+    ecs_vec_fini_t(NULL, &vertices, float);
+    ecs_vec_fini_t(NULL, &indices, uint16_t);
+    return ok;
+}
+
+/**
+ * Upload the geometry's meshes into the renderer's mesh registry.
+ * Done once per geometry; returns the mesh id of LOD 0 (0 on failure).
+ */
+uint32_t webgpu_upload_geometry_mesh(WebGPURenderer *renderer, WebGPUGeometry *geometry) {
+    if (geometry->mesh_id || geometry->streamed) {
+        return geometry->mesh_id;
+    }
+    
+    if (!renderer->device || !renderer->queue) {
+        return 0;
+    }
+    
+    if (!renderer->mesh_registry) {
+        renderer->mesh_registry = webgpu_mesh_registry_create(renderer->resources);
+    }
+    
+    if (geometry->component_id == ecs_id(EcsBox)) {
+        geometry->lod_mesh_ids[0] = webgpu_mesh_registry_add(renderer->mesh_registry,
+            renderer->device, renderer->queue,
+            box_vertices, box_vertex_count, box_indices, box_index_count);
+    } else if (geometry->component_id == ecs_id(EcsRectangle)) {
+        geometry->lod_mesh_ids[0] = webgpu_mesh_registry_add(renderer->mesh_registry,
+            renderer->device, renderer->queue,
+            rectangle_vertices, rectangle_vertex_count,
+            rectangle_indices, rectangle_index_count);
+    } else if (!upload_primitive_meshes(renderer, geometry)) {
+        ecs_warn("WebGPU: No mesh for geometry component %llu",
+                (unsigned long long)geometry->component_id);
+        return 0;
+    }
+    
+    geometry->mesh_id = geometry->lod_mesh_ids[0];
+    return geometry->mesh_id;
+}
+
+/**
+ * Pack one position/rotation/scale record, expanded into a compact record by
+ * the transform shader. Angles are wrapped to [-pi, pi] so their half
+ * precision doesn't depend on how far an entity has turned.
+ */
+static void pack_transform(uint8_t *dst,
+                           const float position[3],
+                           const float rotation[3],
+                           const float scale[3],
+                           const EcsRgb *c) {
+    uint16_t halves[6];
+    for (int k = 0; k < 3; k++) {
+        float angle = rotation[k];
+        if (fabsf(angle) > GLM_PIf) {
+            angle = remainderf(angle, 2.0f * GLM_PIf);
+        }
+        halves[k] = float_to_half(angle);
+        halves[3 + k] = float_to_half(scale[k]);
+    }
+    
+    uint32_t rgba = webgpu_color_rgba8(c);
+    memcpy(dst, position, 3 * sizeof(float));
+    memcpy(dst + 3 * sizeof(float), halves, sizeof(halves));
+    memcpy(dst + 3 * sizeof(float) + sizeof(halves), &rgba, sizeof(rgba));
+}
+
+/**
+ * Decompose the rotation and scale of a transform into euler angles and
+ * scale, in the order flecs.systems.transform composes them:
+ * T * Rx * Ry * Rz * S. Shear from non-uniformly scaled parents is lost.
+ */
+static void decompose_transform(const float *m, float rotation[3], float scale[3]) {
+    for (int c = 0; c < 3; c++) {
+        const float *axis = &m[c * 4];
+        scale[c] = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    }
+    
+    /* Mirrored transforms flip the x axis */
+    float det = m[0] * (m[5] * m[10] - m[6] * m[9]) -
+        m[4] * (m[1] * m[10] - m[2] * m[9]) +
+        m[8] * (m[1] * m[6] - m[2] * m[5]);
+    if (det < 0.0f) {
+        scale[0] = -scale[0];
+    }
+    
+    /* Elements (row, column) of the rotation, m is column major */
+    float inv[3];
+    for (int c = 0; c < 3; c++) {
+        inv[c] = scale[c] != 0.0f ? 1.0f / scale[c] : 0.0f;
+    }
+    float r02 = m[8] * inv[2];
+    float r12 = m[9] * inv[2];
+    float r22 = m[10] * inv[2];
+    float r00 = m[0] * inv[0];
+    float r01 = m[4] * inv[1];
+    float r11 = m[5] * inv[1];
+    float r21 = m[6] * inv[1];
+    
+    r02 = r02 < -1.0f ? -1.0f : (r02 > 1.0f ? 1.0f : r02);
+    rotation[1] = asinf(r02);
+    if (fabsf(r02) < 0.9999f) {
+        rotation[0] = atan2f(-r12, r22);
+        rotation[2] = atan2f(-r01, r00);
+    } else {
+        /* Gimbal lock, the x and z rotations share an axis */
+        rotation[0] = atan2f(r21, r11);
+        rotation[2] = 0.0f;
+    }
+}
+
+/* Packing order of a record: by LOD, then far to near when sorted */
+typedef struct {
+    uint32_t lod;
+    float depth;
+    int32_t index;
+} record_order_t;
+
+/**
+ * Order records by LOD, then far to near. Equal records keep their packed order.
+ */
+static int compare_record_order(const void *a, const void *b) {
+    const record_order_t *ra = a;
+    const record_order_t *rb = b;
+    if (ra->lod != rb->lod) {
+        return ra->lod < rb->lod ? -1 : 1;
+    }
+    if (ra->depth != rb->depth) {
+        return ra->depth < rb->depth ? 1 : -1;
+    }
+    return ra->index - rb->index;
+}
+
+/**
+ * Reorder packed records by LOD and depth, unsorted holds count records
+ */
+static void reorder_records(uint8_t *records,
+                            uint32_t stride,
+                            record_order_t *order,
+                            int32_t count,
+                            uint8_t *unsorted) {
+    qsort(order, (size_t)count, sizeof(record_order_t), compare_record_order);
     
-    ecs_vec_init_t(geometry->allocator, &geometry->transform_data, mat4, 0);
-    ecs_vec_init_t(geometry->allocator, &geometry->color_data, vec3, 0);
-    ecs_vec_init_t(geometry->allocator, &geometry->material_data, float, 0);
+    memcpy(unsorted, records, (size_t)count * stride);
+    for (int32_t i = 0; i < count; i++) {
+        memcpy(&records[i * stride], &unsorted[order[i].index * stride], stride);
+    }
+}
+
+/**
+ * Number of floats of a geometry component
+ */
+static int32_t geometry_dims_stride(uint32_t dims) {
+    switch (dims) {
+    case WebGPUDimsXYZ: return 3;
+    case WebGPUDimsRadius: return 1;
+    case WebGPUDimsNone: return 0;
+    default: return 2;
+    }
+}
+
+/**
+ * Scale of the unit mesh for the values of a geometry component. Returns
+ * the radius of the scaled mesh's bounding sphere.
+ */
+static float geometry_scale(uint32_t dims, const float *d, float scale[3]) {
+    switch (dims) {
+    case WebGPUDimsXY:
+        scale[0] = d[0], scale[1] = d[1], scale[2] = 1.0f;
+        return 0.5f * sqrtf(d[0] * d[0] + d[1] * d[1]);
+    case WebGPUDimsXZ:
+        scale[0] = d[0], scale[1] = 1.0f, scale[2] = d[1];
+        return 0.5f * sqrtf(d[0] * d[0] + d[1] * d[1]);
+    case WebGPUDimsRadius:
+        scale[0] = scale[1] = scale[2] = 2.0f * d[0];
+        return d[0];
+    case WebGPUDimsRadiusHeight:
+        scale[0] = scale[2] = 2.0f * d[0], scale[1] = d[1];
+        return sqrtf(d[0] * d[0] + 0.25f * d[1] * d[1]);
+    default:
+        scale[0] = d[0], scale[1] = d[1], scale[2] = d[2];
+        return 0.5f * sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    }
+}
+
+/* Inputs of pack_table_instances shared by the ranges of a geometry */
+typedef struct {
+    WebGPUInstanceFormat format;
+    bool transforms;                  /* Pack position/rotation/scale records (gpu_transforms) */
+    uint32_t stride;                  /* Record stride, the format + storage tag if storage */
+    uint32_t dims;                    /* webgpu_geometry_dims_t */
+    const float *depth_plane;         /* View depth of a position, NULL without a view */
+    float pixel_scale;                /* Projected pixels per world unit at depth 1 */
+    uint32_t lod_count;
+    const float *lod_pixels;          /* Smallest projected diameter of each LOD */
+    const uint32_t *lod_meshes;       /* Mesh id of each LOD, for storage tags */
+    float mesh_radius;                /* Bounding radius of a WebGPUDimsNone mesh */
+} pack_params_t;
+
+/* Columns the instances of a range are packed from. Position/rotation/scale
+ * records read the table's own EcsPosition3, EcsRotation3 and EcsScale3 if
+ * they are its world transform, else they decompose the transforms. */
+typedef struct {
+    const EcsTransform3 *transforms;
+    const EcsPosition3 *positions;    /* NULL to read or decompose transforms */
+    const EcsRotation3 *rotations;    /* NULL without rotation */
+    const EcsScale3 *scales;          /* NULL without scale */
+} pack_source_t;
+
+/**
+ * Pack instances of one table into the interleaved instance format, reading
+ * the ECS columns directly. Writes the mean position to center, the records
+ * per LOD to lod_counts and, when not NULL, the bounding sphere of every
+ * record to spheres. Returns the number of packed instances.
+ */
+static int32_t pack_table_instances(uint8_t *dst,
+                                    const pack_params_t *params,
+                                    uint32_t material,
+                                    const pack_source_t *source,
+                                    const EcsRgb *colors,
+                                    bool shared_color,
+                                    const float *dims,
+                                    int32_t count,
+                                    bool sort,
+                                    uint8_t *lod_state,
+                                    float center[3],
+                                    uint32_t lod_counts[WEBGPU_MAX_LODS],
+                                    float *spheres,
+                                    ecs_vec_t *scratch) {
+    uint32_t stride = params->stride;
+    uint32_t format_stride = params->transforms ?
+        WEBGPU_BYTES_PER_INSTANCE_TRS : webgpu_instance_stride(params->format);
+    const EcsTransform3 *transforms = source->transforms;
+    int32_t dims_stride = geometry_dims_stride(params->dims);
+    sort = sort && params->depth_plane;
+    
+    /* Sorted records all use LOD 0, a draw per LOD would blend them out of
+     * order */
+    bool lods = params->lod_count > 1 && params->depth_plane && lod_state && !sort;
+    
+    EcsRgb white = {1.0f, 1.0f, 1.0f};
+    int32_t packed = 0;
+    uint8_t *records = dst;
+    float sum[3] = {0.0f, 0.0f, 0.0f};
+    ecs_os_memset_n(lod_counts, 0, uint32_t, WEBGPU_MAX_LODS);
+    if (count <= 0) {
+        center[0] = center[1] = center[2] = 0.0f;
+        return 0;
+    }
+    
+    /* The scratch arrays are carved out of the pack task's scratch vector,
+     * which keeps its size across ranges and frames. They are padded to
+     * whole groups of four rows. Ordered records are reordered through a
+     * copy of the records. */
+    int32_t padded = (count + 3) & ~3;
+    bool ordered = (sort || lods) && count > 1;
+    ecs_size_t floats_size = padded * 7 * ECS_SIZEOF(float);
+    ecs_size_t rows_size = count * ECS_SIZEOF(int32_t);
+    ecs_size_t order_size = ordered ? count * ECS_SIZEOF(record_order_t) : 0;
+    ecs_size_t unsorted_size = ordered ? count * (ecs_size_t)stride : 0;
+    ecs_vec_set_min_size_t(NULL, scratch, uint8_t,
+        floats_size + rows_size + order_size + unsorted_size + count);
+    
+    uint8_t *memory = ecs_vec_first_t(scratch, uint8_t);
+    float *x = (float*)memory;
+    float *y = &x[padded];
+    float *z = &y[padded];
+    float *radius = &z[padded];
+    float *scale = &radius[padded];
+    int32_t *rows = (int32_t*)&memory[floats_size];
+    record_order_t *order = ordered ? 
+        (record_order_t*)&memory[floats_size + rows_size] : NULL;
+    uint8_t *unsorted = &memory[floats_size + rows_size + order_size];
+    uint8_t *row_lods = &unsorted[unsorted_size];
     
-    ecs_trace("WebGPU: Rectangle geometry initialized");
+    /* Scale and bounding sphere of the scaled unit mesh in world space */
+    for (int32_t i = 0; i < count; i++) {
+        /* Streamed meshes are drawn at their own size */
+        if (params->dims == WebGPUDimsNone) {
+            scale[i * 3] = scale[i * 3 + 1] = scale[i * 3 + 2] = 1.0f;
+            radius[i] = params->mesh_radius;
+        } else {
+            radius[i] = geometry_scale(params->dims, &dims[i * dims_stride], &scale[i * 3]);
+        }
+    }
+    
+    /* Position/rotation/scale sources are sorted and LOD'd by their position
+     * and largest scale, without a matrix */
+    if (source->positions) {
+        for (int32_t i = 0; i < count; i++) {
+            const EcsPosition3 *p = &source->positions[i];
+            const EcsScale3 *s = source->scales ? &source->scales[i] : NULL;
+            float scale_sq = s ? glm_max(glm_max(s->x * s->x, s->y * s->y), s->z * s->z) : 1.0f;
+            x[i] = p->x;
+            y[i] = p->y;
+            z[i] = p->z;
+            radius[i] *= sqrtf(scale_sq);
+        }
+    } else {
+        webgpu_transform_spheres(transforms, radius, count, x, y, z, radius);
+    }
+    
+    for (int32_t i = count; i < padded; i++) {
+        x[i] = y[i] = z[i] = radius[i] = 0.0f;
+    }
+    
+    /* Pick the LOD and depth of the rows. Records are grouped by LOD and
+     * sorted records ordered back to front by reorder_records */
+    for (int32_t i = 0; i < padded; i += 4) {
+        uint32_t visible = count - i < 4 ? (1u << (count - i)) - 1 : 0xf;
+        
+        for (int32_t j = 0; j < 4; j++) {
+            if (!(visible & (1u << j))) {
+                continue;
+            }
+            
+            int32_t row = i + j;
+            const float position[3] = { x[row], y[row], z[row] };
+            float depth = sort || lods ? webgpu_view_depth(params->depth_plane, position) : 0.0f;
+            
+            /* Near the camera plane every instance uses LOD 0 */
+            uint32_t lod = 0;
+            if (lods && depth > 0.0f) {
+                float size = 2.0f * radius[row] * params->pixel_scale / depth;
+                lod = webgpu_select_instance_lod(params->lod_pixels, params->lod_count,
+                    size, &lod_state[row]);
+            }
+            
+            sum[0] += position[0];
+            sum[1] += position[1];
+            sum[2] += position[2];
+            if (order) {
+                order[packed].lod = lod;
+                order[packed].depth = sort ? depth : 0.0f;
+                order[packed].index = packed;
+            }
+            
+            rows[packed] = row;
+            row_lods[packed] = (uint8_t)lod;
+            lod_counts[lod]++;
+            packed++;
+        }
+    }
+    
+    /* Write the records of the visible rows */
+    if (params->transforms) {
+        for (int32_t k = 0; k < packed; k++) {
+            int32_t row = rows[k];
+            const float position[3] = { x[row], y[row], z[row] };
+            float rotation[3] = {0.0f, 0.0f, 0.0f}, world_scale[3] = {1.0f, 1.0f, 1.0f};
+            if (!source->positions) {
+                decompose_transform(&transforms[row].value[0][0], rotation, world_scale);
+            } else {
+                if (source->rotations) {
+                    memcpy(rotation, &source->rotations[row], sizeof(rotation));
+                }
+                if (source->scales) {
+                    memcpy(world_scale, &source->scales[row], sizeof(world_scale));
+                }
+            }
+            
+            /* The geometry scale is folded into the entity's scale */
+            glm_vec3_mul(world_scale, &scale[row * 3], world_scale);
+            
+            const EcsRgb *c = colors ? (shared_color ? &colors[0] : &colors[row]) : &white;
+            pack_transform(&dst[(size_t)k * stride], position, rotation, world_scale, c);
+        }
+    } else if (params->format == WebGPUInstanceFormatFull) {
+        webgpu_pack_matrices(dst, stride, transforms, scale, rows, packed);
+        for (int32_t k = 0; k < packed; k++) {
+            const EcsRgb *c = colors ? (shared_color ? &colors[0] : &colors[rows[k]]) : &white;
+            memcpy(&dst[(size_t)k * stride + 16 * sizeof(float)], c, 3 * sizeof(float));
+        }
+    } else {
+        bool half = params->format == WebGPUInstanceFormatCompactHalf;
+        uint32_t color_offset = half ? 12 * sizeof(uint16_t) : 12 * sizeof(float);
+        webgpu_pack_affine(dst, stride, transforms, scale, rows, packed, half);
+        if (colors && !shared_color) {
+            webgpu_pack_rgba8(&dst[color_offset], stride, colors, rows, packed);
+        } else {
+            uint32_t rgba = webgpu_color_rgba8(colors ? &colors[0] : &white);
+            for (int32_t k = 0; k < packed; k++) {
+                memcpy(&dst[(size_t)k * stride + color_offset], &rgba, sizeof(rgba));
+            }
+        }
+    }
+    
+    /* Storage instancing records end with the mesh/material tag */
+    if (stride > format_stride) {
+        for (int32_t k = 0; k < packed; k++) {
+            uint32_t tag = webgpu_storage_tag(params->lod_meshes[row_lods[k]], material);
+            memcpy(&dst[(size_t)k * stride + format_stride], &tag, sizeof(tag));
+        }
+    }
+    
+    if (order && packed > 1) {
+        reorder_records(records, stride, order, packed, unsorted);
+    }
+    
+    /* Bounding spheres in record order, for culling the records later */
+    for (int32_t k = 0; spheres && k < packed; k++) {
+        int32_t row = rows[order && packed > 1 ? order[k].index : k];
+        float *sphere = &spheres[k * 4];
+        sphere[0] = x[row];
+        sphere[1] = y[row];
+        sphere[2] = z[row];
+        sphere[3] = radius[row];
+    }
+    
+    float inv = packed ? 1.0f / (float)packed : 0.0f;
+    for (int k = 0; k < 3; k++) {
+        center[k] = sum[k] * inv;
+    }
+    
+    return packed;
 }
 
 /**
- * Populate geometry instance buffers from Flecs query
+ * Copy the records of a range's packed_data that are inside the frustum to
+ * its staging slots. Records keep their LOD grouping and order, so the
+ * visible records of each LOD stay adjacent. Returns whether the visible
+ * records differ from what the staging slots held.
  */
-void webgpu_populate_geometry_buffers(WebGPUGeometry *geometry, ecs_query_t *query) {
+static bool cull_range_records(uint8_t *dst,
+                               const uint8_t *records,
+                               const float *spheres,
+                               uint32_t stride,
+                               const webgpu_frustum_t *frustum,
+                               webgpu_table_range_t *range) {
+    uint32_t visible = 0;
+    uint32_t lod = 0, lod_end = range->packed_lod_counts[0];
+    uint32_t lod_counts[WEBGPU_MAX_LODS] = {0};
+    float sum[3] = {0.0f, 0.0f, 0.0f};
+    bool changed = false;
+    
+    for (uint32_t i = 0; i < range->packed; i += 4) {
+        /* Spheres past the last record may be stale, they are masked out */
+        uint32_t mask = range->packed - i < 4 ? (1u << (range->packed - i)) - 1 : 0xf;
+        float x[4], y[4], z[4], radius[4];
+        for (uint32_t j = 0; j < 4; j++) {
+            const float *sphere = &spheres[(i + (j < range->packed - i ? j : 0)) * 4];
+            x[j] = sphere[0];
+            y[j] = sphere[1];
+            z[j] = sphere[2];
+            radius[j] = sphere[3];
+        }
+        mask &= webgpu_frustum_test_spheres4(frustum, x, y, z, radius);
+        
+        for (uint32_t j = 0; j < 4 && i + j < range->packed; j++) {
+            uint32_t k = i + j;
+            while (k >= lod_end && lod + 1 < WEBGPU_MAX_LODS) {
+                lod_end += range->packed_lod_counts[++lod];
+            }
+            if (!(mask & (1u << j))) {
+                continue;
+            }
+            
+            /* Unchanged records aren't uploaded again */
+            uint8_t *to = &dst[(size_t)visible * stride];
+            const uint8_t *from = &records[(size_t)k * stride];
+            if (!changed && (visible >= range->count || memcmp(to, from, stride))) {
+                changed = true;
+            }
+            if (changed) {
+                memcpy(to, from, stride);
+            }
+            
+            sum[0] += x[j];
+            sum[1] += y[j];
+            sum[2] += z[j];
+            lod_counts[lod]++;
+            visible++;
+        }
+    }
+    
+    changed |= visible != range->count;
+    float inv = visible ? 1.0f / (float)visible : 0.0f;
+    for (int k = 0; k < 3; k++) {
+        range->center[k] = sum[k] * inv;
+    }
+    memcpy(range->lod_counts, lod_counts, sizeof(lod_counts));
+    range->count = visible;
+    return changed;
+}
+
+/**
+ * Prepare geometry instances for packing.
+ * Walks the cached query once and splits every matched table into ranges of
+ * at most WEBGPU_PACK_CHUNK_ROWS rows, each with a fixed slot in the staging
+ * data. Ranges whose table changed (or that moved) are flagged dirty for
+ * webgpu_pack_geometry_instances; unchanged ranges keep their packed data.
+ * A non-NULL frustum culls the packed records into the staging data, so a
+ * frustum change only culls the unchanged ranges again. Ranges record the
+ * id of the material their table inherits; the query groups tables by
+ * material, so the ranges of a material are adjacent. Tables tagged WebGPUTransparent or inheriting a
+ * material with alpha are transparent, and are repacked back to front when
+ * the view changes. Geometries with levels of detail repack every range
+ * when the view changes, since instances pick their LOD by projected size.
+ * Ranges of streamed geometry record the mesh their table inherits, and
+ * are repacked when it becomes resident. With gpu_transforms, ranges
+ * record whether their table's position, rotation and scale are its world
+ * transform. Must run single-threaded.
+ * Returns whether any range is dirty or was dropped.
+ */
+bool webgpu_prepare_geometry_instances(WebGPUGeometry *geometry, 
+                                       ecs_query_t *query,
+                                       const webgpu_pack_view_t *view,
+                                       webgpu_material_cache_t *materials,
+                                       webgpu_mesh_loader_t *meshes) {
     if (!query || !geometry->allocator) {
-        return;
+        return false;
     }
     
     const ecs_world_t *world = ecs_get_world(query);
     ecs_allocator_t *a = geometry->allocator;
+    bool dirty = false;
+    bool moved_any = false;
+    bool changed_any = false;
+    const webgpu_frustum_t *frustum = view ? view->frustum : NULL;
+    
+    /* Culled ranges are only valid for the frustum they were culled with.
+     * Turning culling on or off changes where ranges are packed to. */
+    bool cull_toggled = geometry->cull_enabled != (frustum != NULL);
+    bool frustum_changed = cull_toggled || (frustum && 
+        memcmp(geometry->cull_frustum, frustum->planes, sizeof(geometry->cull_frustum)));
+    if (frustum_changed) {
+        geometry->cull_enabled = frustum != NULL;
+        if (frustum) {
+            memcpy(geometry->cull_frustum, frustum->planes, sizeof(geometry->cull_frustum));
+        }
+    }
+    
+    /* Sorted records and LODs are only valid for the view they were packed with */
+    bool view_changed = view && (!geometry->view_enabled ||
+        geometry->lod_pixel_scale != view->pixel_scale ||
+        memcmp(geometry->view_plane, view->depth_plane, sizeof(geometry->view_plane)));
+    if (view_changed) {
+        geometry->view_enabled = true;
+        geometry->lod_pixel_scale = view->pixel_scale;
+        memcpy(geometry->view_plane, view->depth_plane, sizeof(geometry->view_plane));
+    }
+    bool lods = geometry->lod_count > 1;
     
-    /* Clear previous instance data */
-    ecs_vec_clear(&geometry->transform_data);
-    ecs_vec_clear(&geometry->color_data);
+    int32_t count = ecs_query_count(query).entities;
+    int32_t slot = 0;
+    int32_t range_count = 0;
     
-    /* Iterate query results and gather instance data */
     ecs_iter_t it = ecs_query_iter(world, query);
     while (ecs_query_next(&it)) {
-        EcsTransform3 *transforms = ecs_field(&it, EcsTransform3, 0);
-        EcsRgb *colors = ecs_field(&it, EcsRgb, 1);
-        void *geometry_data = ecs_field_w_size(&it, it.sizes[2], 2);
+        if (slot + it.count > count) {
+            ecs_err("WebGPU: Geometry query returned more entities than counted");
+            ecs_iter_fini(&it);
+            break;
+        }
         
-        uint32_t current_count = ecs_vec_count(&geometry->transform_data);
+        bool has_color = ecs_field_is_set(&it, 1);
+        ecs_entity_t color_source = has_color ? ecs_field_src(&it, 1) : 0;
         
-        /* Grow vectors to accommodate new instances */
-        ecs_vec_grow_t(a, &geometry->transform_data, mat4, it.count);
-        ecs_vec_grow_t(a, &geometry->color_data, vec3, it.count);
+        /* Owned materials aren't shared, those tables use the default material */
+        ecs_entity_t material_source = ecs_field_is_set(&it, 3) ? ecs_field_src(&it, 3) : 0;
+        uint32_t material = webgpu_material_cache_id(materials, material_source);
         
-        /* Copy transform matrices */
-        if (transforms) {
-            for (int i = 0; i < it.count; i++) {
-                mat4 *dst_transform = ecs_vec_get_t(&geometry->transform_data, mat4, current_count + i);
-                
-                /* Copy the entire transform matrix from EcsTransform3 */
-                glm_mat4_copy(transforms[i].value, *dst_transform);
-            }
+        bool transparent = ecs_field_is_set(&it, 4);
+        if (!transparent && material_source) {
+            const WebGPUMaterial *m = ecs_get(world, material_source, WebGPUMaterial);
+            transparent = m && m->base_color[3] < 1.0f;
         }
         
-        /* Copy colors */
-        if (colors) {
-            if (ecs_field_is_self(&it, 1)) {
-                /* Per-entity colors */
-                for (int i = 0; i < it.count; i++) {
-                    vec3 *dst_color = ecs_vec_get_t(&geometry->color_data, vec3, current_count + i);
-                    (*dst_color)[0] = colors[i].r;
-                    (*dst_color)[1] = colors[i].g;
-                    (*dst_color)[2] = colors[i].b;
-                }
-            } else {
-                /* Shared color for all entities */
-                for (int i = 0; i < it.count; i++) {
-                    vec3 *dst_color = ecs_vec_get_t(&geometry->color_data, vec3, current_count + i);
-                    (*dst_color)[0] = colors[0].r;
-                    (*dst_color)[1] = colors[0].g;
-                    (*dst_color)[2] = colors[0].b;
-                }
-            }
+        /* Meshes are shared by a mesh entity, tables owning one draw nothing */
+        uint32_t mesh_id = 0;
+        float mesh_radius = 0.0f;
+        if (geometry->streamed) {
+            mesh_id = webgpu_mesh_loader_get(meshes, world, ecs_field_src(&it, 2), &mesh_radius);
         }
         
-        /* Apply geometry-specific scaling */
-        if (geometry->component_id == ecs_id(EcsBox)) {
-            EcsBox *boxes = (EcsBox*)geometry_data;
-            for (int i = 0; i < it.count; i++) {
-                mat4 *transform = ecs_vec_get_t(&geometry->transform_data, mat4, current_count + i);
-                
-                /* Scale by box dimensions */
-                vec3 scale = {boxes[i].width, boxes[i].height, boxes[i].depth};
-                glm_scale(*transform, scale);
+        /* Position, rotation and scale are the world transform of root
+         * entities that own them and aren't transformed manually */
+        bool local_transforms = geometry->gpu_transforms &&
+            ecs_field_is_set(&it, 5) && ecs_field_is_self(&it, 5) &&
+            (!ecs_field_is_set(&it, 6) || ecs_field_is_self(&it, 6)) &&
+            (!ecs_field_is_set(&it, 7) || ecs_field_is_self(&it, 7)) &&
+            ecs_search(world, it.table, ecs_pair(EcsChildOf, EcsWildcard), NULL) == -1 &&
+            !ecs_table_has_id(world, it.table, EcsTransformManually);
+        
+        bool table_changed = ecs_iter_changed(&it);
+        bool changed = cull_toggled || ((transparent || lods) && view_changed) ||
+            table_changed;
+        changed_any |= table_changed;
+        
+        for (int32_t row = 0; row < it.count; row += WEBGPU_PACK_CHUNK_ROWS) {
+            int32_t rows = it.count - row;
+            rows = rows < WEBGPU_PACK_CHUNK_ROWS ? rows : WEBGPU_PACK_CHUNK_ROWS;
+            
+            /* Find this chunk's range, adding one for new chunks */
+            webgpu_table_range_t *range;
+            if (range_count < ecs_vec_count(&geometry->table_ranges)) {
+                range = ecs_vec_get_t(&geometry->table_ranges, webgpu_table_range_t, range_count);
+            } else {
+                range = ecs_vec_append_t(a, &geometry->table_ranges, webgpu_table_range_t);
+                ecs_os_memset_t(range, 0, webgpu_table_range_t);
             }
-        } else if (geometry->component_id == ecs_id(EcsRectangle)) {
-            EcsRectangle *rectangles = (EcsRectangle*)geometry_data;
-            for (int i = 0; i < it.count; i++) {
-                mat4 *transform = ecs_vec_get_t(&geometry->transform_data, mat4, current_count + i);
-                
-                /* Scale by rectangle dimensions */
-                vec3 scale = {rectangles[i].width, rectangles[i].height, 1.0f};
-                glm_scale(*transform, scale);
+            range_count++;
+            
+            /* A range must be repacked if it moved or its table changed */
+            bool moved = range->table != it.table || 
+                range->row_offset != (uint32_t)(it.offset + row) ||
+                range->rows != (uint32_t)rows || range->slot_offset != (uint32_t)slot ||
+                range->material != material || range->transparent != transparent ||
+                range->mesh_id != mesh_id;
+            
+            range->dirty = moved || changed;
+            range->recull = frustum != NULL && frustum_changed;
+            dirty |= range->dirty || range->recull;
+            moved_any |= moved;
+            if (range->dirty) {
+                range->table = it.table;
+                range->row_offset = (uint32_t)(it.offset + row);
+                range->rows = (uint32_t)rows;
+                range->slot_offset = (uint32_t)slot;
+                range->has_color = has_color;
+                range->color_source = color_source;
+                range->material = material;
+                range->transparent = transparent;
+                range->mesh_id = mesh_id;
+                range->mesh_radius = mesh_radius;
+                range->local_transforms = local_transforms;
             }
+            
+            slot += rows;
+        }
+    }
+    
+    /* Drop ranges of tables that are no longer matched */
+    moved_any |= range_count != ecs_vec_count(&geometry->table_ranges);
+    geometry->instances_changed = moved_any || changed_any;
+    dirty |= moved_any;
+    ecs_vec_set_count_t(a, &geometry->table_ranges, webgpu_table_range_t, range_count);
+    
+    /* One staging slot per table row, existing contents are kept */
+    int32_t stride = (int32_t)webgpu_geometry_upload_stride(geometry);
+    ecs_vec_set_count_t(a, &geometry->instance_data, uint8_t, slot * stride);
+    if (frustum) {
+        ecs_vec_set_count_t(a, &geometry->packed_data, uint8_t, slot * stride);
+        ecs_vec_set_count_t(a, &geometry->packed_spheres, float, slot * 4);
+    } else {
+        ecs_vec_fini_t(a, &geometry->packed_data, uint8_t);
+        ecs_vec_fini_t(a, &geometry->packed_spheres, float);
+    }
+    
+    /* New slots have no previous LOD */
+    if (lods) {
+        int32_t previous = ecs_vec_count(&geometry->lod_state);
+        ecs_vec_set_count_t(a, &geometry->lod_state, uint8_t, slot);
+        if (slot > previous) {
+            memset(ecs_vec_get_t(&geometry->lod_state, uint8_t, previous), 0xFF,
+                (size_t)(slot - previous));
         }
     }
     
-    geometry->instance_count = ecs_vec_count(&geometry->transform_data);
+    return dirty;
 }
 
-/* Component lifecycle functions moved to main.c */
+/**
+ * Pack the dirty ranges assigned to one pack task.
+ * Task t packs ranges t, t + task_count, ... so tasks never share memory and
+ * may run on different worker threads. Ranges read the table columns
+ * directly and write at the staging slot reserved by the prepare step.
+ * With culling, ranges are packed unculled into packed_data and their
+ * visible records copied to the staging slot; ranges flagged to recull only
+ * do the copy. scratch is the task's own scratch vector.
+ */
+void webgpu_pack_geometry_instances(const ecs_world_t *world,
+                                    WebGPUGeometry *geometry,
+                                    int32_t task,
+                                    int32_t task_count,
+                                    ecs_vec_t *scratch) {
+    webgpu_table_range_t *ranges = ecs_vec_first_t(&geometry->table_ranges, webgpu_table_range_t);
+    int32_t range_count = ecs_vec_count(&geometry->table_ranges);
+    uint8_t *instance_data = ecs_vec_first_t(&geometry->instance_data, uint8_t);
+    uint8_t *packed_data = ecs_vec_first_t(&geometry->packed_data, uint8_t);
+    float *packed_spheres = ecs_vec_first_t(&geometry->packed_spheres, float);
+    uint32_t stride = webgpu_geometry_upload_stride(geometry);
+    
+    webgpu_frustum_t frustum;
+    if (geometry->cull_enabled) {
+        memcpy(frustum.planes, geometry->cull_frustum, sizeof(frustum.planes));
+    }
+    
+    pack_params_t params = {
+        .format = geometry->instance_format,
+        .transforms = geometry->gpu_transforms,
+        .stride = stride,
+        .dims = geometry->dims,
+        .depth_plane = geometry->view_enabled ? geometry->view_plane : NULL,
+        .pixel_scale = geometry->lod_pixel_scale,
+        .lod_count = geometry->lod_count,
+        .lod_pixels = geometry->lod_pixels,
+        .lod_meshes = geometry->lod_mesh_ids,
+    };
+    
+    uint8_t *lod_state = geometry->lod_count > 1 ?
+        ecs_vec_first_t(&geometry->lod_state, uint8_t) : NULL;
+    
+    for (int32_t r = task; r < range_count; r += task_count) {
+        webgpu_table_range_t *range = &ranges[r];
+        if (!range->dirty) {
+            /* Unchanged records are only culled again */
+            if (range->recull && range->rows) {
+                range->dirty = cull_range_records(&instance_data[range->slot_offset * stride],
+                    &packed_data[range->slot_offset * stride],
+                    &packed_spheres[range->slot_offset * 4], stride, &frustum, range);
+            }
+            continue;
+        }
+        
+        /* Tables may not change between prepare and pack; if one did, the
+         * range draws nothing and is repacked next frame. Streamed ranges
+         * draw nothing until their mesh is resident. */
+        if ((uint32_t)ecs_table_count(range->table) < range->row_offset + range->rows ||
+            (geometry->streamed && !range->mesh_id)) {
+            range->rows = 0;
+            range->count = 0;
+            range->packed = 0;
+            ecs_os_memset_n(range->lod_counts, 0, uint32_t, WEBGPU_MAX_LODS);
+            continue;
+        }
+        
+        pack_source_t source = {
+            .transforms = ecs_table_get_id(world, range->table, 
+                ecs_id(EcsTransform3), (int32_t)range->row_offset)
+        };
+        if (range->local_transforms) {
+            source.positions = ecs_table_get_id(world, range->table, 
+                ecs_id(EcsPosition3), (int32_t)range->row_offset);
+            source.rotations = ecs_table_get_id(world, range->table, 
+                ecs_id(EcsRotation3), (int32_t)range->row_offset);
+            source.scales = ecs_table_get_id(world, range->table, 
+                ecs_id(EcsScale3), (int32_t)range->row_offset);
+        }
+        const float *dims = ecs_table_get_id(world, range->table, 
+            geometry->component_id, (int32_t)range->row_offset);
+        
+        const EcsRgb *colors = NULL;
+        if (range->has_color) {
+            colors = range->color_source ? 
+                ecs_get(world, range->color_source, EcsRgb) :
+                ecs_table_get_id(world, range->table, ecs_id(EcsRgb), (int32_t)range->row_offset);
+        }
+        
+        /* Streamed ranges have their own mesh */
+        pack_params_t range_params = params;
+        if (geometry->streamed) {
+            range_params.lod_meshes = &range->mesh_id;
+            range_params.mesh_radius = range->mesh_radius;
+        }
+        
+        if (!geometry->cull_enabled) {
+            range->count = (uint32_t)pack_table_instances(
+                &instance_data[range->slot_offset * stride], &range_params, range->material,
+                &source, colors, range->color_source != 0, dims, (int32_t)range->rows,
+                range->transparent, lod_state ? &lod_state[range->slot_offset] : NULL,
+                range->center, range->lod_counts, NULL, scratch);
+            continue;
+        }
+        
+        /* Culled ranges keep their unculled records for the next frustum */
+        range->packed = (uint32_t)pack_table_instances(
+            &packed_data[range->slot_offset * stride], &range_params, range->material,
+            &source, colors, range->color_source != 0, dims, (int32_t)range->rows,
+            range->transparent, lod_state ? &lod_state[range->slot_offset] : NULL,
+            range->center, range->packed_lod_counts,
+            &packed_spheres[range->slot_offset * 4], scratch);
+        cull_range_records(&instance_data[range->slot_offset * stride],
+            &packed_data[range->slot_offset * stride],
+            &packed_spheres[range->slot_offset * 4], stride, &frustum, range);
+    }
+}
 
 /**
- * System to populate geometry buffers each frame
+ * Finish packing: assign instance buffer offsets to the packed ranges.
+ * Visible instances are drawn back to back, so ranges after a range whose
+ * visible count changed move and are re-uploaded. Must run single-threaded
+ * after all pack tasks completed.
  */
-static void webgpu_populate_geometry_system(ecs_iter_t *it) {
-    WebGPUGeometry *geometry = ecs_field(it, WebGPUGeometry, 0);
+void webgpu_finish_geometry_instances(WebGPUGeometry *geometry) {
+    webgpu_table_range_t *ranges = ecs_vec_first_t(&geometry->table_ranges, webgpu_table_range_t);
+    int32_t range_count = ecs_vec_count(&geometry->table_ranges);
+    uint32_t index = 0, rows = 0;
     
-    for (int i = 0; i < it->count; i++) {
-        if (geometry[i].query) {
-            webgpu_populate_geometry_buffers(&geometry[i], geometry[i].query);
+    for (int32_t r = 0; r < range_count; r++) {
+        webgpu_table_range_t *range = &ranges[r];
+        if (range->dirty || range->offset != index) {
+            range->version++;
         }
+        
+        range->offset = index;
+        range->dirty = false;
+        index += range->count;
+        rows += range->rows;
     }
+    
+    geometry->instance_count = index;
+    geometry->culled_count = rows - index;
 }
 
-/* Geometry import moved to main.c to avoid component access issues */
\ No newline at end of file
+/* Component lifecycle functions moved to main.c */
+
+/* Geometry import moved to main.c to avoid component access issues */
@@ -0,0 +1,226 @@
+/**
+ * @file geometry/mesh_loader.c
+ * @brief Streams WebGPUMesh files into the mesh registry.
+ *
+ * A mesh file is requested the first time a table inheriting its WebGPUMesh
+ * is prepared, and read with a file stream: on the web chunks arrive while
+ * the download is in progress, natively the file is memory mapped. As soon
+ * as the header arrived the mesh is reserved in the registry, after which
+ * every frame uploads at most a budget of bytes from what was received.
+ * The mesh becomes resident, and entities using it are drawn, once all of
+ * its data was uploaded.
+ */
+
+#include "../private_api.h"
+
+/**
+ * Mark a stream as failed and close its file
+ */
+static void stream_fail(webgpu_mesh_stream_t *stream, const char *reason) {
+    if (reason) {
+        ecs_err("WebGPU: Failed to load mesh %s: %s",
+            stream->file ? stream->file->path : "(no path)", reason);
+    }
+    stream->state = WebGPUMeshStreamFailed;
+    webgpu_file_stream_close(stream->file);
+    stream->file = NULL;
+}
+
+/**
+ * Create an empty mesh loader
+ */
+webgpu_mesh_loader_t* webgpu_mesh_loader_create(void) {
+    webgpu_mesh_loader_t *loader = ecs_os_calloc_t(webgpu_mesh_loader_t);
+    ecs_vec_init_t(NULL, &loader->streams, webgpu_mesh_stream_t*, 0);
+    ecs_map_init(&loader->ids, NULL);
+    return loader;
+}
+
+/**
+ * Release the loader and close the files of its streams
+ */
+void webgpu_mesh_loader_destroy(webgpu_mesh_loader_t *loader) {
+    if (!loader) {
+        return;
+    }
+
+    webgpu_mesh_stream_t **streams = ecs_vec_first_t(&loader->streams, webgpu_mesh_stream_t*);
+    for (int32_t i = 0; i < ecs_vec_count(&loader->streams); i++) {
+        webgpu_file_stream_close(streams[i]->file);
+        ecs_os_free(streams[i]);
+    }
+
+    ecs_vec_fini_t(NULL, &loader->streams, webgpu_mesh_stream_t*);
+    ecs_map_fini(&loader->ids);
+    ecs_os_free(loader);
+}
+
+/**
+ * Get the resident mesh of a WebGPUMesh entity, starting to load its file
+ * on first use. Returns 0 while the mesh is loading or if it failed to
+ * load; radius is set to the mesh's bounding radius around its origin.
+ */
+uint32_t webgpu_mesh_loader_get(webgpu_mesh_loader_t *loader,
+                                const ecs_world_t *world,
+                                ecs_entity_t mesh,
+                                float *radius) {
+    if (!loader || !mesh) {
+        return 0;
+    }
+
+    webgpu_mesh_stream_t *stream;
+    ecs_map_val_t *index = ecs_map_get(&loader->ids, mesh);
+    if (index) {
+        stream = *ecs_vec_get_t(&loader->streams, webgpu_mesh_stream_t*, (int32_t)*index);
+    } else {
+        stream = ecs_os_calloc_t(webgpu_mesh_stream_t);
+        stream->entity = mesh;
+        ecs_map_insert(&loader->ids, mesh,
+            (ecs_map_val_t)ecs_vec_count(&loader->streams));
+        *ecs_vec_append_t(NULL, &loader->streams, webgpu_mesh_stream_t*) = stream;
+
+        /* The file is loaded once, later path changes are not picked up */
+        const WebGPUMesh *component = ecs_get(world, mesh, WebGPUMesh);
+        if (component && component->path) {
+            ecs_trace("WebGPU: Loading mesh %s", component->path);
+            stream->file = webgpu_file_stream_open(component->path);
+        } else {
+            stream_fail(stream, "no path");
+        }
+    }
+
+    if (stream->state != WebGPUMeshStreamResident) {
+        return 0;
+    }
+
+    *radius = stream->radius;
+    return stream->mesh_id;
+}
+
+/**
+ * Parse the header of a stream and reserve its mesh
+ */
+static bool stream_begin(webgpu_mesh_stream_t *stream,
+                         webgpu_mesh_registry_t *registry,
+                         WGPUDevice device,
+                         WGPUQueue queue) {
+    webgpu_mesh_file_header_t *header = &stream->header;
+    memcpy(header, stream->file->data, sizeof(*header));
+
+    if (header->magic != WEBGPU_MESH_FILE_MAGIC ||
+        (header->index_size != 2 && header->index_size != 4) ||
+        !header->vertex_count || !header->index_count) {
+        stream_fail(stream, "not a mesh file");
+        return false;
+    }
+
+    stream->size = sizeof(*header) +
+        (uint64_t)header->vertex_count * WEBGPU_BYTES_PER_VERTEX +
+        (uint64_t)header->index_count * header->index_size;
+
+    stream->mesh_id = webgpu_mesh_registry_reserve(registry, device, queue,
+        header->vertex_count, header->index_count,
+        header->index_size == 4 ? WGPUIndexFormat_Uint32 : WGPUIndexFormat_Uint16);
+    if (!stream->mesh_id) {
+        stream_fail(stream, "out of mesh memory");
+        return false;
+    }
+
+    stream->uploaded = sizeof(*header);
+    stream->state = WebGPUMeshStreamUploading;
+    return true;
+}
+
+/**
+ * Upload received data of a stream, at most budget bytes. Returns the
+ * number of bytes uploaded.
+ */
+static uint64_t stream_upload(webgpu_mesh_stream_t *stream,
+                              webgpu_mesh_registry_t *registry,
+                              WGPUQueue queue,
+                              uint64_t budget) {
+    webgpu_file_stream_t *file = stream->file;
+    uint64_t available = file->received < stream->size ? file->received : stream->size;
+    uint64_t count = available - stream->uploaded;
+    count = count < budget ? count : budget;
+
+    /* Chunks stay 4-byte aligned, only the last one may be shorter */
+    if (stream->uploaded + count != stream->size) {
+        count &= ~(uint64_t)3;
+    }
+
+    if (count) {
+        webgpu_mesh_registry_write(registry, queue, stream->mesh_id,
+            stream->uploaded - sizeof(webgpu_mesh_file_header_t),
+            file->data + stream->uploaded, (size_t)count);
+        stream->uploaded += count;
+    }
+
+    if (stream->uploaded == stream->size) {
+        const float *vertices = (const float*)(file->data + sizeof(webgpu_mesh_file_header_t));
+        webgpu_mesh_registry_finish(registry, stream->mesh_id, vertices);
+
+        const webgpu_mesh_t *mesh = webgpu_mesh_registry_get(registry, stream->mesh_id);
+        stream->radius = glm_vec3_norm((float*)mesh->bounds) + mesh->bounds[3];
+        stream->state = WebGPUMeshStreamResident;
+
+        webgpu_file_stream_close(file);
+        stream->file = NULL;
+    }
+
+    return count;
+}
+
+/**
+ * Upload the data streams received so far, at most budget bytes per frame.
+ * Streams are served in request order so the first requested meshes become
+ * resident first. Returns the number of bytes uploaded.
+ */
+uint64_t webgpu_mesh_loader_update(webgpu_mesh_loader_t *loader,
+                                   webgpu_mesh_registry_t *registry,
+                                   WGPUDevice device,
+                                   WGPUQueue queue,
+                                   uint64_t budget) {
+    if (!loader || !registry) {
+        return 0;
+    }
+
+    uint64_t uploaded = 0;
+    uint32_t loading = 0;
+    webgpu_mesh_stream_t **streams = ecs_vec_first_t(&loader->streams, webgpu_mesh_stream_t*);
+
+    for (int32_t i = 0; i < ecs_vec_count(&loader->streams); i++) {
+        webgpu_mesh_stream_t *stream = streams[i];
+
+        webgpu_file_stream_t *file = stream->file;
+        if (file && file->failed) {
+            /* The file stream reported why */
+            stream_fail(stream, NULL);
+            continue;
+        }
+
+        if (stream->state == WebGPUMeshStreamLoading &&
+            file->received >= sizeof(webgpu_mesh_file_header_t)) {
+            stream_begin(stream, registry, device, queue);
+        }
+
+        if (stream->state == WebGPUMeshStreamUploading && uploaded < budget) {
+            uploaded += stream_upload(stream, registry, queue, budget - uploaded);
+        }
+
+        /* A file that ended before all of its data arrived can't finish */
+        file = stream->file;
+        if (file && file->done && (stream->state == WebGPUMeshStreamLoading ||
+            (stream->state == WebGPUMeshStreamUploading && file->received < stream->size))) {
+            stream_fail(stream, "truncated file");
+        }
+
+        if (stream->state == WebGPUMeshStreamLoading ||
+            stream->state == WebGPUMeshStreamUploading) {
+            loading++;
+        }
+    }
+
+    loader->loading = loading;
+    return uploaded;
+}
@@ -0,0 +1,315 @@
+/**
+ * @file geometry/mesh_registry.c
+ * @brief Shared vertex/index arenas for all meshes.
+ *
+ * Every mesh is uploaded once into one vertex buffer and one index buffer
+ * (a second index buffer holds meshes with uint32 indices). Draws bind the
+ * arenas once and select a mesh with baseVertex and firstIndex, so batches
+ * don't re-bind or re-upload geometry. Meshes can be reserved first and
+ * written in chunks, which is how streamed meshes are uploaded.
+ */
+
+#include "../private_api.h"
+
+/**
+ * Grow an arena buffer, preserving its contents with a GPU-side copy
+ */
+static bool mesh_arena_grow(webgpu_mesh_registry_t *registry,
+                            WGPUDevice device,
+                            WGPUQueue queue,
+                            WGPUBuffer *buffer,
+                            uint64_t *capacity,
+                            uint64_t used,
+                            uint64_t required,
+                            WGPUBufferUsage usage) {
+    if (*buffer && *capacity >= required) {
+        return true;
+    }
+
+    uint64_t new_capacity = *capacity ? *capacity : WEBGPU_MESH_ARENA_MIN_SIZE;
+    while (new_capacity < required) {
+        new_capacity *= 2;
+    }
+
+    usage |= WGPUBufferUsage_CopyDst | WGPUBufferUsage_CopySrc;
+    WGPUBuffer new_buffer = webgpu_resource_pool_buffer(registry->resources, device,
+        new_capacity, usage);
+    if (!new_buffer) {
+        return false;
+    }
+
+    if (*buffer) {
+        if (used) {
+            WGPUCommandEncoderDescriptor encoder_desc = {
+                .label = "Mesh Arena Grow Encoder",
+            };
+            WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(device, &encoder_desc);
+            wgpuCommandEncoderCopyBufferToBuffer(encoder, *buffer, 0, new_buffer, 0, used);
+
+            WGPUCommandBufferDescriptor cmd_desc = {
+                .label = "Mesh Arena Grow Commands",
+            };
+            WGPUCommandBuffer commands = wgpuCommandEncoderFinish(encoder, &cmd_desc);
+            wgpuQueueSubmit(queue, 1, &commands);
+
+            wgpuCommandBufferRelease(commands);
+            wgpuCommandEncoderRelease(encoder);
+        }
+
+        /* Released after the copy and the frames drawing from it finished */
+        webgpu_release_buffer(registry->resources, *buffer, *capacity, usage);
+    }
+
+    ecs_trace("WebGPU: Mesh arena grown to %llu bytes", (unsigned long long)new_capacity);
+
+    *buffer = new_buffer;
+    *capacity = new_capacity;
+    return true;
+}
+
+/**
+ * Write data whose size may not be a multiple of 4 bytes
+ */
+static void mesh_arena_write(WGPUQueue queue,
+                             WGPUBuffer buffer,
+                             uint64_t offset,
+                             const void *data,
+                             size_t size) {
+    size_t aligned = size & ~(size_t)3;
+    if (aligned) {
+        wgpuQueueWriteBuffer(queue, buffer, offset, data, aligned);
+    }
+
+    if (aligned != size) {
+        uint8_t tail[4] = {0};
+        memcpy(tail, (const uint8_t*)data + aligned, size - aligned);
+        wgpuQueueWriteBuffer(queue, buffer, offset + aligned, tail, sizeof(tail));
+    }
+}
+
+/**
+ * Create an empty mesh registry. Arena buffers are created on first upload.
+ */
+webgpu_mesh_registry_t* webgpu_mesh_registry_create(webgpu_resource_pool_t *resources) {
+    webgpu_mesh_registry_t *registry = ecs_os_calloc_t(webgpu_mesh_registry_t);
+    registry->resources = resources;
+    ecs_vec_init_t(NULL, &registry->meshes, webgpu_mesh_t, 0);
+    return registry;
+}
+
+/**
+ * Release arena buffers and the registry
+ */
+void webgpu_mesh_registry_destroy(webgpu_mesh_registry_t *registry) {
+    if (!registry) {
+        return;
+    }
+
+    if (registry->vertex_buffer) {
+        wgpuBufferRelease(registry->vertex_buffer);
+    }
+
+    if (registry->index_buffer) {
+        wgpuBufferRelease(registry->index_buffer);
+    }
+
+    if (registry->index32_buffer) {
+        wgpuBufferRelease(registry->index32_buffer);
+    }
+
+    ecs_vec_fini_t(NULL, &registry->meshes, webgpu_mesh_t);
+    ecs_os_free(registry);
+}
+
+/**
+ * Reserve arena space for a mesh whose data is written later, possibly in
+ * chunks over several frames. Meshes with uint32 indices go to their own
+ * index arena. Returns a mesh id that is resident after
+ * webgpu_mesh_registry_finish, or 0 on failure.
+ */
+uint32_t webgpu_mesh_registry_reserve(webgpu_mesh_registry_t *registry,
+                                      WGPUDevice device,
+                                      WGPUQueue queue,
+                                      uint32_t vertex_count,
+                                      uint32_t index_count,
+                                      WGPUIndexFormat index_format) {
+    if (!registry || !device || !queue || vertex_count == 0 || index_count == 0 ||
+        (index_format != WGPUIndexFormat_Uint16 && index_format != WGPUIndexFormat_Uint32)) {
+        ecs_err("webgpu_mesh_registry_reserve: Invalid parameters");
+        return 0;
+    }
+
+    bool wide = index_format == WGPUIndexFormat_Uint32;
+    WGPUBuffer *index_buffer = wide ? &registry->index32_buffer : &registry->index_buffer;
+    uint64_t *index_capacity = wide ? &registry->index32_capacity : &registry->index_capacity;
+    uint64_t *index_size = wide ? &registry->index32_size : &registry->index_size;
+    uint32_t index_stride = wide ? sizeof(uint32_t) : sizeof(uint16_t);
+
+    uint64_t vertex_bytes = (uint64_t)vertex_count * WEBGPU_BYTES_PER_VERTEX;
+    uint64_t index_bytes = (uint64_t)index_count * index_stride;
+
+    /* Index ranges start 4-byte aligned so queue writes stay valid */
+    uint64_t vertex_offset = registry->vertex_size;
+    uint64_t index_offset = (*index_size + 3) & ~(uint64_t)3;
+
+    if (!mesh_arena_grow(registry, device, queue, &registry->vertex_buffer,
+            &registry->vertex_capacity, registry->vertex_size,
+            vertex_offset + vertex_bytes, WGPUBufferUsage_Vertex)) {
+        ecs_err("webgpu_mesh_registry_reserve: Failed to grow vertex arena");
+        return 0;
+    }
+
+    if (!mesh_arena_grow(registry, device, queue, index_buffer, index_capacity, *index_size,
+            index_offset + ((index_bytes + 3) & ~(uint64_t)3), WGPUBufferUsage_Index)) {
+        ecs_err("webgpu_mesh_registry_reserve: Failed to grow index arena");
+        return 0;
+    }
+
+    registry->vertex_size = vertex_offset + vertex_bytes;
+    *index_size = index_offset + index_bytes;
+
+    webgpu_mesh_t *mesh = ecs_vec_append_t(NULL, &registry->meshes, webgpu_mesh_t);
+    ecs_os_memset_t(mesh, 0, webgpu_mesh_t);
+    mesh->base_vertex = (int32_t)(vertex_offset / WEBGPU_BYTES_PER_VERTEX);
+    mesh->first_index = (uint32_t)(index_offset / index_stride);
+    mesh->vertex_count = vertex_count;
+    mesh->index_count = index_count;
+    mesh->index_format = index_format;
+
+    return (uint32_t)ecs_vec_count(&registry->meshes);
+}
+
+/**
+ * Write part of a reserved mesh. Offsets are into the mesh's data as laid
+ * out in a mesh file: the vertices, directly followed by the indices. Chunks
+ * must start 4-byte aligned; only the last chunk may have an unaligned size.
+ */
+bool webgpu_mesh_registry_write(webgpu_mesh_registry_t *registry,
+                                WGPUQueue queue,
+                                uint32_t mesh_id,
+                                uint64_t offset,
+                                const void *data,
+                                size_t size) {
+    webgpu_mesh_t *mesh = (webgpu_mesh_t*)webgpu_mesh_registry_get(registry, mesh_id);
+    if (!mesh || (offset & 3)) {
+        ecs_err("webgpu_mesh_registry_write: Invalid mesh %u or offset", mesh_id);
+        return false;
+    }
+
+    bool wide = mesh->index_format == WGPUIndexFormat_Uint32;
+    uint32_t index_stride = wide ? sizeof(uint32_t) : sizeof(uint16_t);
+    uint64_t vertex_bytes = (uint64_t)mesh->vertex_count * WEBGPU_BYTES_PER_VERTEX;
+    uint64_t index_bytes = (uint64_t)mesh->index_count * index_stride;
+    if (offset + size > vertex_bytes + index_bytes) {
+        ecs_err("webgpu_mesh_registry_write: Write past the end of mesh %u", mesh_id);
+        return false;
+    }
+
+    const uint8_t *bytes = data;
+    if (offset < vertex_bytes) {
+        size_t count = (size_t)(vertex_bytes - offset) < size ? (size_t)(vertex_bytes - offset) : size;
+        mesh_arena_write(queue, registry->vertex_buffer,
+            (uint64_t)mesh->base_vertex * WEBGPU_BYTES_PER_VERTEX + offset, bytes, count);
+        bytes += count;
+        offset += count;
+        size -= count;
+    }
+
+    if (size) {
+        mesh_arena_write(queue, wide ? registry->index32_buffer : registry->index_buffer,
+            (uint64_t)mesh->first_index * index_stride + (offset - vertex_bytes), bytes, size);
+    }
+
+    return true;
+}
+
+/**
+ * Mark a reserved mesh resident once all of its data was written. Computes
+ * the bounding sphere from the CPU copy of the vertices.
+ */
+void webgpu_mesh_registry_finish(webgpu_mesh_registry_t *registry,
+                                 uint32_t mesh_id,
+                                 const float *vertices) {
+    webgpu_mesh_t *mesh = (webgpu_mesh_t*)webgpu_mesh_registry_get(registry, mesh_id);
+    if (!mesh || !vertices) {
+        return;
+    }
+
+    uint32_t vertex_count = mesh->vertex_count;
+    
+    /* Bounding sphere around the box center, used for frustum culling */
+    vec3 min, max;
+    glm_vec3_copy((float*)&vertices[0], min);
+    glm_vec3_copy((float*)&vertices[0], max);
+    for (uint32_t i = 1; i < vertex_count; i++) {
+        const float *p = &vertices[i * WEBGPU_FLOATS_PER_VERTEX];
+        glm_vec3_minv(min, (float*)p, min);
+        glm_vec3_maxv(max, (float*)p, max);
+    }
+    
+    vec3 center;
+    glm_vec3_center(min, max, center);
+    float radius_sq = 0.0f;
+    for (uint32_t i = 0; i < vertex_count; i++) {
+        float d = glm_vec3_distance2(center, (float*)&vertices[i * WEBGPU_FLOATS_PER_VERTEX]);
+        radius_sq = d > radius_sq ? d : radius_sq;
+    }
+    glm_vec3_copy(center, mesh->bounds);
+    mesh->bounds[3] = sqrtf(radius_sq);
+    mesh->resident = true;
+
+    ecs_trace("WebGPU: Registered mesh %u (%u vertices, %u indices)",
+             mesh_id, vertex_count, mesh->index_count);
+}
+
+/**
+ * Upload a mesh with uint16 indices into the shared arenas.
+ * Returns a mesh id for webgpu_mesh_registry_get, or 0 on failure.
+ */
+uint32_t webgpu_mesh_registry_add(webgpu_mesh_registry_t *registry,
+                                  WGPUDevice device,
+                                  WGPUQueue queue,
+                                  const float *vertices,
+                                  uint32_t vertex_count,
+                                  const uint16_t *indices,
+                                  uint32_t index_count) {
+    if (!vertices || !indices) {
+        ecs_err("webgpu_mesh_registry_add: Invalid parameters");
+        return 0;
+    }
+
+    uint32_t mesh_id = webgpu_mesh_registry_reserve(registry, device, queue,
+        vertex_count, index_count, WGPUIndexFormat_Uint16);
+    if (!mesh_id) {
+        return 0;
+    }
+
+    size_t vertex_bytes = vertex_count * WEBGPU_BYTES_PER_VERTEX;
+    webgpu_mesh_registry_write(registry, queue, mesh_id, 0, vertices, vertex_bytes);
+    webgpu_mesh_registry_write(registry, queue, mesh_id, vertex_bytes,
+        indices, index_count * sizeof(uint16_t));
+    webgpu_mesh_registry_finish(registry, mesh_id, vertices);
+
+    return mesh_id;
+}
+
+/**
+ * Index arena of an index format, NULL before the first mesh using it
+ */
+WGPUBuffer webgpu_mesh_registry_index_buffer(const webgpu_mesh_registry_t *registry,
+                                             WGPUIndexFormat index_format) {
+    return index_format == WGPUIndexFormat_Uint32 ?
+        registry->index32_buffer : registry->index_buffer;
+}
+
+/**
+ * Look up a mesh by id, NULL if the id is not registered
+ */
+const webgpu_mesh_t* webgpu_mesh_registry_get(const webgpu_mesh_registry_t *registry,
+                                              uint32_t mesh_id) {
+    if (!registry || mesh_id == 0 || mesh_id > (uint32_t)ecs_vec_count(&registry->meshes)) {
+        return NULL;
+    }
+
+    return ecs_vec_get_t(&registry->meshes, webgpu_mesh_t, mesh_id - 1);
+}
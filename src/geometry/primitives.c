@@ -0,0 +1,150 @@
+/**
+ * @file geometry/primitives.c
+ * @brief Procedural sphere, cylinder and grid meshes.
+ *
+ * Meshes are generated at a requested detail, so geometries can upload one
+ * mesh per level of detail. All meshes fit the unit cube centered at the
+ * origin and wind counter clockwise when seen from outside, like the box.
+ */
+
+#include "../private_api.h"
+
+#define PI 3.14159265358979323846f
+
+/**
+ * Append a vertex: position, normal, uv
+ */
+static void add_vertex(ecs_vec_t *vertices,
+                       float x, float y, float z,
+                       float nx, float ny, float nz,
+                       float u, float v) {
+    float *out = ecs_vec_grow_t(NULL, vertices, float, 8);
+    out[0] = x;
+    out[1] = y;
+    out[2] = z;
+    out[3] = nx;
+    out[4] = ny;
+    out[5] = nz;
+    out[6] = u;
+    out[7] = v;
+}
+
+/**
+ * Append a triangle
+ */
+static void add_triangle(ecs_vec_t *indices, uint32_t a, uint32_t b, uint32_t c) {
+    uint16_t *out = ecs_vec_grow_t(NULL, indices, uint16_t, 3);
+    out[0] = (uint16_t)a;
+    out[1] = (uint16_t)b;
+    out[2] = (uint16_t)c;
+}
+
+/**
+ * Generate a UV sphere with a diameter of 1. Segments go around the y axis,
+ * rings from the top pole to the bottom pole.
+ */
+void webgpu_generate_sphere(ecs_vec_t *vertices,
+                            ecs_vec_t *indices,
+                            uint32_t segments,
+                            uint32_t rings) {
+    segments = segments < 3 ? 3 : segments;
+    rings = rings < 2 ? 2 : rings;
+
+    for (uint32_t i = 0; i <= rings; i++) {
+        float v = (float)i / (float)rings;
+        float theta = v * PI;
+        for (uint32_t j = 0; j <= segments; j++) {
+            float u = (float)j / (float)segments;
+            float phi = u * 2.0f * PI;
+            float nx = sinf(theta) * cosf(phi);
+            float ny = cosf(theta);
+            float nz = sinf(theta) * sinf(phi);
+            add_vertex(vertices, 0.5f * nx, 0.5f * ny, 0.5f * nz, nx, ny, nz, u, v);
+        }
+    }
+
+    for (uint32_t i = 0; i < rings; i++) {
+        for (uint32_t j = 0; j < segments; j++) {
+            uint32_t a = i * (segments + 1) + j;
+            uint32_t b = a + segments + 1;
+            add_triangle(indices, a, a + 1, b);
+            add_triangle(indices, a + 1, b + 1, b);
+        }
+    }
+}
+
+/**
+ * Generate a capped cylinder with a diameter and height of 1 along the y axis
+ */
+void webgpu_generate_cylinder(ecs_vec_t *vertices,
+                              ecs_vec_t *indices,
+                              uint32_t segments) {
+    segments = segments < 3 ? 3 : segments;
+
+    /* Side: a bottom and top vertex per segment edge */
+    for (uint32_t j = 0; j <= segments; j++) {
+        float u = (float)j / (float)segments;
+        float phi = u * 2.0f * PI;
+        float nx = cosf(phi), nz = sinf(phi);
+        add_vertex(vertices, 0.5f * nx, -0.5f, 0.5f * nz, nx, 0.0f, nz, u, 0.0f);
+        add_vertex(vertices, 0.5f * nx, 0.5f, 0.5f * nz, nx, 0.0f, nz, u, 1.0f);
+    }
+
+    for (uint32_t j = 0; j < segments; j++) {
+        uint32_t bottom = j * 2, top = bottom + 1;
+        add_triangle(indices, top, top + 2, bottom);
+        add_triangle(indices, top + 2, bottom + 2, bottom);
+    }
+
+    /* Caps: a center vertex and a ring with the cap's normal */
+    for (int32_t cap = 0; cap < 2; cap++) {
+        float y = cap ? 0.5f : -0.5f;
+        float ny = cap ? 1.0f : -1.0f;
+        uint32_t center = (uint32_t)(ecs_vec_count(vertices) / 8);
+        add_vertex(vertices, 0.0f, y, 0.0f, 0.0f, ny, 0.0f, 0.5f, 0.5f);
+
+        for (uint32_t j = 0; j <= segments; j++) {
+            float phi = (float)j / (float)segments * 2.0f * PI;
+            float x = cosf(phi), z = sinf(phi);
+            add_vertex(vertices, 0.5f * x, y, 0.5f * z, 0.0f, ny, 0.0f,
+                0.5f + 0.5f * x, 0.5f + 0.5f * z);
+        }
+
+        for (uint32_t j = 0; j < segments; j++) {
+            uint32_t a = center + 1 + j;
+            if (cap) {
+                add_triangle(indices, center, a + 1, a);
+            } else {
+                add_triangle(indices, center, a, a + 1);
+            }
+        }
+    }
+}
+
+/**
+ * Generate a grid of cells x cells quads, 1 by 1 in the xz plane facing +y
+ */
+void webgpu_generate_grid(ecs_vec_t *vertices,
+                          ecs_vec_t *indices,
+                          uint32_t cells) {
+    cells = cells < 1 ? 1 : cells;
+
+    for (uint32_t k = 0; k <= cells; k++) {
+        float v = (float)k / (float)cells;
+        for (uint32_t i = 0; i <= cells; i++) {
+            float u = (float)i / (float)cells;
+            add_vertex(vertices, u - 0.5f, 0.0f, v - 0.5f, 0.0f, 1.0f, 0.0f, u, v);
+        }
+    }
+
+    for (uint32_t k = 0; k < cells; k++) {
+        for (uint32_t i = 0; i < cells; i++) {
+            uint32_t v00 = k * (cells + 1) + i;
+            uint32_t v10 = v00 + 1;
+            uint32_t v01 = v00 + cells + 1;
+            uint32_t v11 = v01 + 1;
+            add_triangle(indices, v00, v01, v10);
+            add_triangle(indices, v10, v01, v11);
+        }
+    }
+}
@@ -17,10 +17,30 @@ ECS_COMPONENT_DECLARE(WebGPURenderer);
 ECS_COMPONENT_DECLARE(WebGPUGeometry);
 ECS_COMPONENT_DECLARE(WebGPUMaterial);
 ECS_COMPONENT_DECLARE(WebGPUQuery);
+ECS_COMPONENT_DECLARE(WebGPUPackTask);
+ECS_COMPONENT_DECLARE(WebGPUFrameStats);
+ECS_COMPONENT_DECLARE(WebGPUMemoryBudget);
+ECS_COMPONENT_DECLARE(WebGPUSharedTransform);
+ECS_COMPONENT_DECLARE(WebGPUSharedTransforms);
+ECS_COMPONENT_DECLARE(WebGPUFixedTimestep);
+ECS_COMPONENT_DECLARE(WebGPUSphere);
+ECS_COMPONENT_DECLARE(WebGPUCylinder);
+ECS_COMPONENT_DECLARE(WebGPUGrid);
+ECS_COMPONENT_DECLARE(WebGPUMesh);
+ECS_COMPONENT_DECLARE(WebGPUTexture);
+ECS_COMPONENT_DECLARE(WebGPUView);
 
 /* Geometry type entities */
 ECS_DECLARE(WebGPUBoxGeometry);
 ECS_DECLARE(WebGPURectangleGeometry);
+ECS_DECLARE(WebGPUSphereGeometry);
+ECS_DECLARE(WebGPUCylinderGeometry);
+ECS_DECLARE(WebGPUGridGeometry);
+ECS_DECLARE(WebGPUMeshGeometry);
+
+/* Tags */
+ECS_DECLARE(WebGPUTransparent);
+ECS_DECLARE(WebGPUFixedUpdate);
 
 /* Static renderer instance (singleton pattern) */
 static ecs_entity_t webgpu_renderer_instance = 0;
@@ -52,12 +72,6 @@ static void webgpu_device_error_callback(WGPUErrorType type, const char* message
     webgpu_error_occurred = true;
     
 #ifdef WEBGPU_BACKEND_EMSCRIPTEN
-    /* Log to browser console for debugging */
-    EM_ASM({
-        console.error('WebGPU Error:', UTF8ToString($0), UTF8ToString($1));
-        console.error('Stopping render loop due to WebGPU error');
-    }, type_str, message);
-    
     /* Cancel the Emscripten main loop to prevent further errors */
     emscripten_cancel_main_loop();
 #endif
@@ -67,248 +81,352 @@ static void webgpu_device_error_callback(WGPUErrorType type, const char* message
  * Adapter request callback
  */
 static void webgpu_adapter_callback(WGPURequestAdapterStatus status, WGPUAdapter adapter, const char* message, void* userdata) {
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('WebGPU: Adapter callback received, status:', $0);
-    }, status);
-#endif
-    
+    WebGPURenderer* renderer = (WebGPURenderer*)userdata;
     if (status != WGPURequestAdapterStatus_Success) {
         ecs_err("WebGPU: Failed to request adapter: %s", message ? message : "Unknown error");
-#ifdef __EMSCRIPTEN__
-        EM_ASM({
-            console.error('WebGPU: Adapter request failed');
-        });
-#endif
+        renderer->startup = WebGPUStartupFailed;
         return;
     }
     
-    ecs_trace("WebGPU: Adapter acquired successfully");
-    
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('WebGPU: Adapter acquired successfully, now requesting device...');
-    });
-#endif
+    webgpu_info("WebGPU: Adapter acquired, requesting device");
     
     /* Store adapter in renderer component */
-    WebGPURenderer* renderer = (WebGPURenderer*)userdata;
     renderer->adapter = adapter;
     
+    /* Optional features: GPU pass timing needs timestamp queries, culled
+     * storage instanced draws need indirect draws with a first instance,
+     * compressed textures need the formats of their compression family */
+    const WGPUFeatureName optional_features[] = {
+        WGPUFeatureName_TimestampQuery,
+        WGPUFeatureName_IndirectFirstInstance,
+        WGPUFeatureName_TextureCompressionBC,
+        WGPUFeatureName_TextureCompressionETC2,
+        WGPUFeatureName_TextureCompressionASTC
+    };
+    WGPUFeatureName features[sizeof(optional_features) / sizeof(optional_features[0])];
+    size_t feature_count = 0;
+    for (size_t i = 0; i < sizeof(optional_features) / sizeof(optional_features[0]); i++) {
+        if (wgpuAdapterHasFeature(adapter, optional_features[i])) {
+            features[feature_count++] = optional_features[i];
+        }
+    }
+    
     /* Immediately request device from adapter callback */
     WGPUDeviceDescriptor device_desc = {
         .nextInChain = NULL,
         .label = "WebGPU Device",
-        .requiredFeatureCount = 0,
-        .requiredFeatures = NULL,
+        .requiredFeatureCount = feature_count,
+        .requiredFeatures = feature_count ? features : NULL,
         .requiredLimits = NULL,
     };
     
+    renderer->startup = WebGPUStartupDevice;
     wgpuAdapterRequestDevice(adapter, &device_desc, webgpu_device_callback, userdata);
 }
 
+/**
+ * Configure a surface of the renderer (its own or a view's) with the
+ * renderer's format, so all surfaces draw with the same pipelines.
+ */
+static void webgpu_configure_surface(WebGPURenderer *renderer,
+                                     WGPUSurface surface,
+                                     uint32_t width,
+                                     uint32_t height) {
+    WGPUSurfaceConfiguration surface_config = {
+        .nextInChain = NULL,
+        .device = renderer->device,
+        .format = renderer->surface_format,
+        .usage = WGPUTextureUsage_RenderAttachment,
+        .width = width,
+        .height = height,
+        .presentMode = WGPUPresentMode_Fifo,
+        .alphaMode = WGPUCompositeAlphaMode_Auto,
+    };
+    
+    wgpuSurfaceConfigure(surface, &surface_config);
+}
+
+/**
+ * Configure the renderer's own surface at a size, if it isn't already
+ */
+static void webgpu_resize_surface(WebGPURenderer *renderer, uint32_t width, uint32_t height) {
+    if (renderer->surface_width == width && renderer->surface_height == height) {
+        return;
+    }
+    
+    webgpu_configure_surface(renderer, renderer->surface, width, height);
+    renderer->surface_width = width;
+    renderer->surface_height = height;
+}
+
+/**
+ * Get this frame's offscreen target of a renderer without surface
+ */
+static void webgpu_acquire_offscreen_target(WebGPURenderer *renderer) {
+    renderer->offscreen_view = webgpu_render_target_acquire(renderer->targets,
+        renderer->device, renderer->width, renderer->height, renderer->surface_format, 1,
+        WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_CopySrc | WGPUTextureUsage_CopyDst,
+        &renderer->offscreen_texture);
+}
+
+/**
+ * Configure the surface, or acquire the offscreen target of a renderer
+ * without one
+ */
+static void webgpu_startup_surface(WebGPURenderer *renderer) {
+    /* Depth and MSAA targets, reused across frames */
+    renderer->targets = webgpu_render_target_pool_create(renderer->resources);
+    
+    /* Passes and transients of each frame */
+    renderer->frame_graph = webgpu_frame_graph_create(renderer->resources);
+    
+    if (renderer->surface) {
+        webgpu_resize_surface(renderer, renderer->width, renderer->height);
+    } else {
+        /* Headless (benchmarks): render into an offscreen texture instead */
+        webgpu_acquire_offscreen_target(renderer);
+    }
+    
+    webgpu_info("WebGPU: Surface configured for rendering (format %d)", renderer->surface_format);
+}
+
+/**
+ * Create the GPU resources frames need. Returns false if uniforms can't be
+ * bound, the renderer can't draw without them.
+ */
+static bool webgpu_startup_resources(WebGPURenderer *renderer) {
+    WGPUDevice device = renderer->device;
+    
+    /* Texture arrays, in the best compressed format the device supports */
+    renderer->textures = webgpu_texture_cache_create(device, renderer->queue,
+        renderer->resources);
+    
+    /* Storage instancing: all geometry draws from one instance storage buffer */
+    if (renderer->storage_instancing) {
+        renderer->instance_storage = webgpu_instance_storage_create(renderer->resources);
+    }
+    
+    /* Position/rotation/scale records are expanded into the instance storage */
+    if (renderer->gpu_transforms) {
+        if (!renderer->instance_storage) {
+            ecs_warn("WebGPU: gpu_transforms needs storage instancing, uploading matrices");
+        } else {
+            renderer->transform_expander = webgpu_transform_expander_create(device);
+        }
+        renderer->gpu_transforms = renderer->transform_expander != NULL;
+    }
+    
+    /* Batches that don't change are replayed from render bundles */
+    if (renderer->render_bundles) {
+        renderer->bundles = webgpu_bundle_cache_create(renderer->resources);
+    }
+    
+    /* Create the uniform ring for camera and lighting */
+    renderer->uniforms = webgpu_uniforms_create(device);
+    if (!renderer->uniforms || !renderer->pipeline_cache) {
+        webgpu_error("WebGPU: Failed to create uniforms");
+        return false;
+    }
+    
+    /* Create bind groups. With shadows the light bind group holds the shadow
+     * atlas, and is created by the shadow pass once it has one. */
+    renderer->camera_bind_group = webgpu_create_camera_bind_group(device, renderer->camera_layout, renderer->uniforms->buffer);
+    if (!renderer->shadows) {
+        renderer->light_bind_group = webgpu_create_light_bind_group(device, renderer->light_layout, renderer->uniforms->buffer);
+    }
+    
+    if (!renderer->camera_bind_group || (!renderer->shadows && !renderer->light_bind_group)) {
+        webgpu_error("WebGPU: Failed to create uniform bind groups");
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * Run the startup steps that follow the device request. None of them wait,
+ * so they run back to back from the device callback.
+ */
+static void webgpu_startup_advance(WebGPURenderer *renderer) {
+    for (;;) {
+        switch (renderer->startup) {
+        case WebGPUStartupSurface:
+            webgpu_startup_surface(renderer);
+            renderer->startup = WebGPUStartupResources;
+            break;
+        case WebGPUStartupResources:
+            renderer->startup = webgpu_startup_resources(renderer) ?
+                WebGPUStartupReady : WebGPUStartupFailed;
+            break;
+        case WebGPUStartupReady: {
+            ecs_time_t start = renderer->startup_time;
+            webgpu_info("WebGPU: Renderer ready %.1f ms after the adapter request",
+                ecs_time_measure(&start) * 1000.0);
+            return;
+        }
+        default:
+            return;
+        }
+    }
+}
+
 /**
  * Device request callback
  */
 static void webgpu_device_callback(WGPURequestDeviceStatus status, WGPUDevice device, const char* message, void* userdata) {
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('WebGPU: Device callback received, status:', $0);
-    }, status);
-#endif
-    
+    WebGPURenderer* renderer = (WebGPURenderer*)userdata;
     if (status != WGPURequestDeviceStatus_Success) {
         ecs_err("WebGPU: Failed to request device: %s", message ? message : "Unknown error");
-#ifdef __EMSCRIPTEN__
-        EM_ASM({
-            console.error('WebGPU: Device request failed');
-        });
-#endif
+        renderer->startup = WebGPUStartupFailed;
         return;
     }
     
-    ecs_trace("WebGPU: Device acquired successfully");
-    
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('WebGPU: Device and queue acquired successfully - WebGPU pipeline ready!');
-    });
-#endif
+    webgpu_info("WebGPU: Device and queue acquired");
     
     /* Store device in renderer component and set up error callback */
-    WebGPURenderer* renderer = (WebGPURenderer*)userdata;
     renderer->device = device;
     renderer->queue = wgpuDeviceGetQueue(device);
     
     wgpuDeviceSetUncapturedErrorCallback(device, webgpu_device_error_callback, NULL);
     
-    /* Configure canvas context now that we have a device */
-#ifdef WEBGPU_BACKEND_EMSCRIPTEN
-    /* In Emscripten, we need to configure the surface format */
-    WGPUSurfaceConfiguration surface_config = {
-        .nextInChain = NULL,
-        .device = device,
-        .format = WGPUTextureFormat_BGRA8Unorm, /* Standard web format */
-        .usage = WGPUTextureUsage_RenderAttachment,
-        .width = renderer->width,
-        .height = renderer->height,
-        .presentMode = WGPUPresentMode_Fifo,
-        .alphaMode = WGPUCompositeAlphaMode_Auto,
-    };
+    /* NULL when the adapter has no timestamp queries */
+    renderer->profiler = webgpu_profiler_create(device);
     
-    wgpuSurfaceConfigure(renderer->surface, &surface_config);
+    renderer->indirect_first_instance = wgpuDeviceHasFeature(device, 
+        WGPUFeatureName_IndirectFirstInstance);
     
-    /* Create depth texture and view with extensive logging */
-    EM_ASM({
-        console.log('WebGPU: Starting depth texture creation...');
-        console.log('WebGPU: Canvas dimensions:', $0, 'x', $1);
-    }, renderer->width, renderer->height);
+    /* 4x MSAA is the only multisampled count every device supports */
+    if (renderer->sample_count > 1 && renderer->sample_count != 4) {
+        ecs_warn("WebGPU: Unsupported sample count %u, using 4", renderer->sample_count);
+        renderer->sample_count = 4;
+    } else if (!renderer->sample_count) {
+        renderer->sample_count = 1;
+    }
     
-    renderer->depth_texture = webgpu_create_depth_texture(device, renderer->width, renderer->height);
+    if (renderer->sample_count > 1) {
+        webgpu_info("WebGPU: Rendering with %ux MSAA", renderer->sample_count);
+    }
     
-    if (renderer->depth_texture) {
-        EM_ASM({
-            console.log('WebGPU: ✓ Depth texture created successfully');
-            console.log('WebGPU: Depth texture handle:', $0);
-        }, (uint32_t)(uintptr_t)renderer->depth_texture);
-        
-        renderer->depth_texture_view = webgpu_create_depth_texture_view(renderer->depth_texture);
-        
-        if (renderer->depth_texture_view) {
-            EM_ASM({
-                console.log('WebGPU: ✓ Depth texture view created successfully');
-                console.log('WebGPU: Depth texture view handle:', $0);
-            }, (uint32_t)(uintptr_t)renderer->depth_texture_view);
-        } else {
-            EM_ASM({
-                console.error('WebGPU: ✗ Failed to create depth texture view');
-            });
+    /* The pipeline key needs the surface format */
+    if (renderer->surface) {
+        renderer->surface_format = wgpuSurfaceGetPreferredFormat(renderer->surface, renderer->adapter);
+        if (renderer->surface_format == WGPUTextureFormat_Undefined) {
+            renderer->surface_format = WGPUTextureFormat_BGRA8Unorm; /* Standard web format */
         }
     } else {
-        EM_ASM({
-            console.error('WebGPU: ✗ Failed to create depth texture');
-            console.error('WebGPU: Device handle:', $0);
-            console.error('WebGPU: Canvas dimensions:', $1, 'x', $2);
-        }, (uint32_t)(uintptr_t)device, renderer->width, renderer->height);
+        renderer->surface_format = WGPUTextureFormat_RGBA8Unorm;
     }
     
-    /* Create uniform buffers for camera and lighting */
-    EM_ASM({
-        console.log('WebGPU: Creating uniform buffers...');
-    });
-    
-    renderer->camera_uniform_buffer = webgpu_create_camera_uniform_buffer(device);
-    renderer->light_uniform_buffer = webgpu_create_light_uniform_buffer(device);
+    /* Shader modules and pipelines come first, so the browser compiles them
+     * while the rest of startup runs. Batches draw once theirs is ready. */
+    if (renderer->shadow_cascades) {
+        renderer->shadow_cascades = renderer->shadow_cascades < 2 ? 2 :
+            renderer->shadow_cascades > WEBGPU_MAX_SHADOW_CASCADES ?
+                WEBGPU_MAX_SHADOW_CASCADES : renderer->shadow_cascades;
+        renderer->shadows = webgpu_shadows_create(device, renderer->shadow_cascades);
+        if (!renderer->shadows) {
+            ecs_warn("WebGPU: Failed to create shadow state, rendering without shadows");
+            renderer->shadow_cascades = 0;
+        }
+    }
     
-    if (renderer->camera_uniform_buffer && renderer->light_uniform_buffer) {
-        EM_ASM({
-            console.log('WebGPU: ✓ Uniform buffers created successfully');
-            console.log('WebGPU: Camera buffer:', $0);
-            console.log('WebGPU: Light buffer:', $1);
-        }, (uint32_t)(uintptr_t)renderer->camera_uniform_buffer, 
-           (uint32_t)(uintptr_t)renderer->light_uniform_buffer);
+    renderer->pipeline_cache = webgpu_pipeline_cache_create(device, renderer->shadows != NULL);
+    if (renderer->pipeline_cache) {
+        renderer->camera_layout = renderer->pipeline_cache->camera_layout;
+        renderer->light_layout = renderer->pipeline_cache->light_layout;
         
-        /* Create shaders and pipeline to get bind group layouts */
-        const char *vertex_source = basic_vertex_shader_source;
-        const char *fragment_source = basic_fragment_shader_source;
-        
-        WGPUShaderModule vertex_shader = webgpu_create_shader_module(device, vertex_source);
-        WGPUShaderModule fragment_shader = webgpu_create_shader_module(device, fragment_source);
-        
-        if (vertex_shader && fragment_shader) {
-            renderer->default_pipeline = webgpu_create_geometry_pipeline(device, vertex_shader, fragment_shader);
-            
-            if (renderer->default_pipeline) {
-                EM_ASM({
-                    console.log('WebGPU: ✓ Default render pipeline created');
-                });
-                
-                /* Extract bind group layouts from pipeline - Note: This is a simplified approach */
-                /* In a real implementation, we'd create layouts separately and reuse them */
-                /* For now, we'll create bind group layouts inline */
-                
-                /* Create camera bind group layout */
-                WGPUBindGroupLayoutEntry camera_layout_entries[] = {
-                    {
-                        .binding = 0,
-                        .visibility = WGPUShaderStage_Vertex,
-                        .buffer = {
-                            .type = WGPUBufferBindingType_Uniform,
-                            .hasDynamicOffset = false,
-                            .minBindingSize = sizeof(mat4) * 3,
-                        },
-                    }
-                };
-                
-                WGPUBindGroupLayoutDescriptor camera_layout_desc = {
-                    .label = "Camera Bind Group Layout",
-                    .entryCount = 1,
-                    .entries = camera_layout_entries,
-                };
-                
-                renderer->camera_layout = wgpuDeviceCreateBindGroupLayout(device, &camera_layout_desc);
-                
-                /* Create light bind group layout */
-                WGPUBindGroupLayoutEntry light_layout_entries[] = {
-                    {
-                        .binding = 0,
-                        .visibility = WGPUShaderStage_Fragment,
-                        .buffer = {
-                            .type = WGPUBufferBindingType_Uniform,
-                            .hasDynamicOffset = false,
-                            .minBindingSize = 40, /* Matches our 40-byte Light struct */
-                        },
-                    }
-                };
-                
-                WGPUBindGroupLayoutDescriptor light_layout_desc = {
-                    .label = "Light Bind Group Layout",
-                    .entryCount = 1,
-                    .entries = light_layout_entries,
-                };
-                
-                renderer->light_layout = wgpuDeviceCreateBindGroupLayout(device, &light_layout_desc);
-                
-                /* Create bind groups */
-                renderer->camera_bind_group = webgpu_create_camera_bind_group(device, renderer->camera_layout, renderer->camera_uniform_buffer);
-                renderer->light_bind_group = webgpu_create_light_bind_group(device, renderer->light_layout, renderer->light_uniform_buffer);
-                
-                if (renderer->camera_bind_group && renderer->light_bind_group) {
-                    EM_ASM({
-                        console.log('WebGPU: ✓ Uniform buffer bind groups created successfully');
-                        console.log('WebGPU: Camera bind group:', $0);
-                        console.log('WebGPU: Light bind group:', $1);
-                    }, (uint32_t)(uintptr_t)renderer->camera_bind_group,
-                       (uint32_t)(uintptr_t)renderer->light_bind_group);
-                } else {
-                    EM_ASM({
-                        console.error('WebGPU: ✗ Failed to create uniform buffer bind groups');
-                    });
-                }
-            } else {
-                EM_ASM({
-                    console.error('WebGPU: ✗ Failed to create render pipeline');
-                });
-            }
-            
-            /* Clean up shader modules */
-            wgpuShaderModuleRelease(vertex_shader);
-            wgpuShaderModuleRelease(fragment_shader);
-        } else {
-            EM_ASM({
-                console.error('WebGPU: ✗ Failed to create shader modules');
-            });
+        webgpu_pipeline_key_t key;
+        webgpu_pipeline_key_init(&key, renderer);
+        webgpu_pipeline_cache_get(renderer->pipeline_cache, &key, NULL);
+        webgpu_pipeline_key_transparent(&key);
+        webgpu_pipeline_cache_get(renderer->pipeline_cache, &key, NULL);
+        if (renderer->shadows) {
+            webgpu_pipeline_key_init(&key, renderer);
+            webgpu_pipeline_key_shadow_caster(&key);
+            webgpu_pipeline_cache_get(renderer->pipeline_cache, &key, NULL);
         }
-    } else {
-        EM_ASM({
-            console.error('WebGPU: ✗ Failed to create uniform buffers');
-        });
     }
     
-    EM_ASM({
-        console.log('WebGPU: Surface configured for rendering');
+    renderer->startup = WebGPUStartupSurface;
+    webgpu_startup_advance(renderer);
+}
+
+/**
+ * Request an adapter for a renderer with an instance, which starts the
+ * startup state machine. The device and GPU resources are created from the
+ * adapter and device callbacks; a renderer without surface draws into an
+ * offscreen target. CPU side caches are created right away, so instances
+ * are packed and mesh files download while the requests are in flight.
+ */
+void webgpu_renderer_request_adapter(WebGPURenderer *renderer) {
+    webgpu_info("WebGPU: Requesting adapter");
+    ecs_os_get_time(&renderer->startup_time);
+    
+    /* Deferred release of GPU handles and reuse of released buffers */
+    if (!renderer->resources) {
+        renderer->resources = webgpu_create_resource_pool(renderer->allocator);
+    }
+    
+    /* Material bind groups, cached by material entity */
+    if (!renderer->materials) {
+        renderer->materials = webgpu_material_cache_create(renderer->resources);
+    }
+    
+    /* Streams WebGPUMesh files into the mesh registry */
+    if (!renderer->mesh_loader) {
+        renderer->mesh_loader = webgpu_mesh_loader_create();
+    }
+    
+    WGPURequestAdapterOptions adapter_options = {
+        .nextInChain = NULL,
+        .compatibleSurface = renderer->surface,
+        .powerPreference = WGPUPowerPreference_HighPerformance,
+        .forceFallbackAdapter = false,
+    };
+    
+    renderer->startup = WebGPUStartupAdapter;
+    wgpuInstanceRequestAdapter(renderer->instance, &adapter_options, 
+                              webgpu_adapter_callback, renderer);
+}
+
+/**
+ * Set up the CPU side of a renderer for a canvas: its allocator, the vectors
+ * allocated from it and its queries, which the renderer's destructor frees.
+ * Renderers added by hand (demo, benchmarks) call this instead of waiting
+ * for webgpu_init_renderer.
+ */
+void webgpu_renderer_init(ecs_world_t *world,
+                          WebGPURenderer *renderer,
+                          ecs_entity_t canvas_entity,
+                          uint32_t width,
+                          uint32_t height) {
+    renderer->canvas_entity = canvas_entity;
+    renderer->width = width;
+    renderer->height = height;
+    if (renderer->allocator) {
+        return;
+    }
+    
+    renderer->allocator = ecs_os_malloc_t(ecs_allocator_t);
+    flecs_allocator_init(renderer->allocator);
+    
+    ecs_vec_init_t(renderer->allocator, &renderer->render_batches, webgpu_render_batch_t, 0);
+    ecs_vec_init_t(renderer->allocator, &renderer->render_queue, webgpu_draw_item_t, 0);
+    ecs_vec_init_t(renderer->allocator, &renderer->render_queue_scratch, webgpu_draw_item_t, 0);
+    ecs_vec_init_t(renderer->allocator, &renderer->views, ecs_entity_t, 0);
+    
+    /* Create geometry query for renderable entities */
+    renderer->geometry_query = ecs_query(world, {
+        .terms = { { .id = ecs_id(EcsTransform3) } }
+    });
+    
+    /* Extra canvases drawn with this renderer's device and resources */
+    renderer->view_query = ecs_query(world, {
+        .terms = {
+            { .id = ecs_id(WebGPUView), .inout = EcsIn },
+            { .id = ecs_id(EcsCanvas), .inout = EcsIn }
+        }
     });
-#endif
 }
 
 /**
@@ -319,24 +437,9 @@ static void webgpu_init_renderer(ecs_iter_t *it) {
     WebGPURenderer *renderer = ecs_field(it, WebGPURenderer, 0);
     EcsCanvas *canvas = ecs_field(it, EcsCanvas, 1);
     
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('WebGPU: Initializing renderer');
-    });
-#endif
-    
     for (int i = 0; i < it->count; i++) {
-        /* Initialize allocator */
-        renderer[i].allocator = ecs_os_malloc_t(ecs_allocator_t);
-        flecs_allocator_init(renderer[i].allocator);
-        
-        /* Store canvas reference */
-        renderer[i].canvas_entity = it->entities[i];
-        renderer[i].width = canvas[i].width;
-        renderer[i].height = canvas[i].height;
-        
-        /* Initialize render batches vector */
-        ecs_vec_init_t(renderer[i].allocator, &renderer[i].render_batches, webgpu_render_batch_t, 0);
+        webgpu_renderer_init(world, &renderer[i], it->entities[i],
+            canvas[i].width, canvas[i].height);
         
         /* Create WebGPU instance */
         WGPUInstanceDescriptor instance_desc = {
@@ -345,28 +448,15 @@ static void webgpu_init_renderer(ecs_iter_t *it) {
         
 #ifdef WEBGPU_BACKEND_EMSCRIPTEN
         renderer[i].instance = wgpuCreateInstance(NULL);
-        EM_ASM({
-            console.log('WebGPU: Instance creation attempted');
-        });
 #else
         renderer[i].instance = wgpuCreateInstance(&instance_desc);
 #endif
         
         if (!renderer[i].instance) {
-#ifdef __EMSCRIPTEN__
-            EM_ASM({
-                console.log('WebGPU: Failed to create instance');
-            });
-#endif
+            webgpu_error("WebGPU: Failed to create instance");
             continue;
         }
         
-#ifdef __EMSCRIPTEN__
-        EM_ASM({
-            console.log('WebGPU: Instance created successfully');
-        });
-#endif
-        
         /* Create surface from canvas */
 #ifdef WEBGPU_BACKEND_EMSCRIPTEN
         WGPUSurfaceDescriptorFromCanvasHTMLSelector canvas_desc = {
@@ -390,30 +480,292 @@ static void webgpu_init_renderer(ecs_iter_t *it) {
 #endif
         
         /* Request WebGPU adapter asynchronously */
-        EM_ASM({
-            console.log('WebGPU: Requesting adapter asynchronously...');
-        });
+        webgpu_renderer_request_adapter(&renderer[i]);
         
-        WGPURequestAdapterOptions adapter_options = {
-            .nextInChain = NULL,
-            .compatibleSurface = renderer[i].surface,
-            .powerPreference = WGPUPowerPreference_HighPerformance,
-            .forceFallbackAdapter = false,
+        ecs_trace("WebGPU: Renderer initialization complete");
+    }
+    
+    /* Disable system after first run */
+    ecs_enable(world, it->system, false);
+}
+
+/**
+ * Begin a render pass into frame targets, cleared to the background.
+ * Multisampled attachments are only read by the resolve, so they are never
+ * stored.
+ */
+static WGPURenderPassEncoder webgpu_begin_render_pass(WGPUCommandEncoder encoder,
+                                                      const webgpu_frame_targets_t *targets,
+                                                      const char *label,
+                                                      const WGPURenderPassTimestampWrites *timestamps) {
+    bool multisampled = targets->samples > 1;
+    WGPURenderPassColorAttachment color_attachment = {
+        .view = targets->color,
+        .resolveTarget = targets->resolve,
+        .loadOp = WGPULoadOp_Clear,
+        .storeOp = multisampled ? WGPUStoreOp_Discard : WGPUStoreOp_Store,
+        .clearValue = { 0.1f, 0.2f, 0.3f, 1.0f }, /* Dark blue background */
+        .depthSlice = -1, /* Required for 2D textures - Emscripten treats -1 as undefined */
+    };
+    
+    WGPURenderPassDepthStencilAttachment depth_attachment = {
+        .view = targets->depth,
+        .depthClearValue = 1.0f,
+        .depthLoadOp = WGPULoadOp_Clear,
+        .depthStoreOp = multisampled ? WGPUStoreOp_Discard : WGPUStoreOp_Store,
+        /* No stencil operations for depth-only texture (Depth24Plus format) */
+        .stencilClearValue = 0,
+        .stencilLoadOp = WGPULoadOp_Undefined,
+        .stencilStoreOp = WGPUStoreOp_Undefined,
+    };
+    
+    WGPURenderPassDescriptor render_pass_desc = {
+        .label = label,
+        .colorAttachmentCount = 1,
+        .colorAttachments = &color_attachment,
+        .depthStencilAttachment = targets->depth ? &depth_attachment : NULL,
+        .timestampWrites = timestamps,
+    };
+    
+    return wgpuCommandEncoderBeginRenderPass(encoder, &render_pass_desc);
+}
+
+/**
+ * Get this frame's back buffer of a view, creating its surface on first use
+ * and configuring it at the size of the view's canvas. Views without a
+ * surface draw into an offscreen target. Returns NULL if the view can't
+ * draw this frame.
+ */
+static WGPUTextureView webgpu_view_back_buffer(WebGPURenderer *renderer,
+                                               WebGPUView *view,
+                                               const EcsCanvas *canvas,
+                                               WGPUTexture *texture) {
+    uint32_t width = canvas->width > 0 ? (uint32_t)canvas->width : 0;
+    uint32_t height = canvas->height > 0 ? (uint32_t)canvas->height : 0;
+    if (!width || !height) {
+        return NULL;
+    }
+    
+#ifdef WEBGPU_BACKEND_EMSCRIPTEN
+    if (!view->surface && view->selector) {
+        WGPUSurfaceDescriptorFromCanvasHTMLSelector canvas_desc = {
+            .chain = {
+                .next = NULL,
+                .sType = WGPUSType_SurfaceDescriptorFromCanvasHTMLSelector,
+            },
+            .selector = view->selector,
         };
         
-        wgpuInstanceRequestAdapter(renderer[i].instance, &adapter_options, 
-                                  webgpu_adapter_callback, &renderer[i]);
+        WGPUSurfaceDescriptor surface_desc = {
+            .nextInChain = (WGPUChainedStruct*)&canvas_desc,
+            .label = "WebGPU View Surface",
+        };
         
-        /* Create geometry query for renderable entities */
-        renderer[i].geometry_query = ecs_query(world, {
-            .terms = { { .id = ecs_id(EcsTransform3) } }
-        });
+        view->surface = wgpuInstanceCreateSurface(renderer->instance, &surface_desc);
+        view->width = view->height = 0;
+        if (!view->surface) {
+            /* Not retried every frame, the view draws offscreen */
+            ecs_warn("WebGPU: Failed to create surface for view canvas %s", view->selector);
+            ecs_os_free(view->selector);
+            view->selector = NULL;
+        }
+    }
+#endif
+    
+    if (!view->surface) {
+        view->width = width;
+        view->height = height;
+        view->offscreen_view = webgpu_render_target_acquire(renderer->targets,
+            renderer->device, width, height, renderer->surface_format, 1,
+            WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_CopySrc | WGPUTextureUsage_CopyDst,
+            &view->offscreen_texture);
+        *texture = view->offscreen_texture;
+        return view->offscreen_view;
+    }
+    
+    /* Views are reconfigured right away, they have no resize buckets */
+    if (view->width != width || view->height != height) {
+        webgpu_configure_surface(renderer, view->surface, width, height);
+        view->width = width;
+        view->height = height;
+    }
+    
+    WGPUSurfaceTexture surface_texture;
+    wgpuSurfaceGetCurrentTexture(view->surface, &surface_texture);
+    if (surface_texture.status != WGPUSurfaceGetCurrentTextureStatus_Success) {
+        ecs_warn("WebGPU: Failed to get current view surface texture");
+        return NULL;
+    }
+    
+    *texture = surface_texture.texture;
+    return wgpuTextureCreateView(surface_texture.texture, NULL);
+}
+
+/**
+ * Draw this frame's batches into the renderer's views, after its own pass,
+ * recording into the frame's encoder.
+ * The batches and their uploaded instances are shared, views only differ in
+ * camera block and targets. Back buffers of view surfaces are returned in
+ * surfaces and back_buffers, to be presented and released once the frame
+ * was submitted. Returns the number of returned back buffers.
+ */
+static int32_t webgpu_render_views(ecs_world_t *world,
+                                   WebGPURenderer *renderer,
+                                   WGPUCommandEncoder encoder,
+                                   WGPUSurface surfaces[WEBGPU_MAX_VIEWS],
+                                   WGPUTextureView back_buffers[WEBGPU_MAX_VIEWS]) {
+    int32_t count = ecs_vec_count(&renderer->views);
+    ecs_entity_t *entities = ecs_vec_first_t(&renderer->views, ecs_entity_t);
+    int32_t presented = 0;
+    
+    for (int32_t i = 0; i < count && i + 1 < WEBGPU_MAX_VIEWS; i++) {
+        WebGPUView *view = ecs_get_mut(world, entities[i], WebGPUView);
+        const EcsCanvas *canvas = ecs_get(world, entities[i], EcsCanvas);
+        if (!view || !canvas) {
+            continue;
+        }
         
-        ecs_trace("WebGPU: Renderer initialization complete");
+        WGPUTexture texture = NULL;
+        WGPUTextureView back_buffer = webgpu_view_back_buffer(renderer, view, canvas, &texture);
+        if (!back_buffer) {
+            continue;
+        }
+        
+        webgpu_frame_targets_t targets;
+        if (webgpu_frame_targets_acquire(renderer, texture, back_buffer, &targets)) {
+            WGPURenderPassEncoder render_pass = webgpu_begin_render_pass(encoder, &targets,
+                "WebGPU View Render Pass", NULL);
+            webgpu_execute_render_batches(renderer, render_pass, (uint32_t)i + 1, &targets);
+            wgpuRenderPassEncoderEnd(render_pass);
+            wgpuRenderPassEncoderRelease(render_pass);
+        } else {
+            ecs_warn("WebGPU: Failed to acquire view render targets");
+        }
+        
+        if (view->surface) {
+            surfaces[presented] = view->surface;
+            back_buffers[presented] = back_buffer;
+            presented++;
+        }
     }
     
-    /* Disable system after first run */
-    ecs_enable(world, it->system, false);
+    return presented;
+}
+
+/* State the passes of a frame share */
+typedef struct {
+    ecs_world_t *world;
+    WGPUTexture back_buffer;
+    WGPUTextureView back_buffer_view;
+    webgpu_frame_targets_t targets;
+    int32_t shadow_atlas;              /* Frame graph texture, -1 without shadows */
+    WGPUSurface view_surfaces[WEBGPU_MAX_VIEWS];
+    WGPUTextureView view_buffers[WEBGPU_MAX_VIEWS];
+    int32_t view_count;                /* Back buffers of views to present */
+} webgpu_frame_t;
+
+/* Passes of the frame graph, ctx is the frame's webgpu_frame_t */
+static void webgpu_pass_transforms(WebGPURenderer *renderer, WGPUCommandEncoder encoder, void *ctx) {
+    (void)ctx;
+    webgpu_expand_transforms(renderer, encoder);
+}
+
+static void webgpu_pass_cull(WebGPURenderer *renderer, WGPUCommandEncoder encoder, void *ctx) {
+    (void)ctx;
+    webgpu_cull_render_batches(renderer, encoder);
+}
+
+static void webgpu_pass_shadows(WebGPURenderer *renderer, WGPUCommandEncoder encoder, void *ctx) {
+    webgpu_frame_t *frame = ctx;
+    webgpu_render_shadows(renderer, encoder,
+        webgpu_frame_graph_view(renderer->frame_graph, frame->shadow_atlas));
+}
+
+static void webgpu_pass_main(WebGPURenderer *renderer, WGPUCommandEncoder encoder, void *ctx) {
+    webgpu_frame_t *frame = ctx;
+    WGPURenderPassEncoder render_pass = webgpu_begin_render_pass(encoder, &frame->targets,
+        "WebGPU Main Render Pass", webgpu_profile_render_pass(renderer, WebGPUPassMain));
+    webgpu_execute_render_batches(renderer, render_pass, 0, &frame->targets);
+    wgpuRenderPassEncoderEnd(render_pass);
+    wgpuRenderPassEncoderRelease(render_pass);
+}
+
+static void webgpu_pass_hiz(WebGPURenderer *renderer, WGPUCommandEncoder encoder, void *ctx) {
+    webgpu_frame_t *frame = ctx;
+    webgpu_hiz_build(renderer, encoder, &frame->targets);
+}
+
+static void webgpu_pass_views(WebGPURenderer *renderer, WGPUCommandEncoder encoder, void *ctx) {
+    webgpu_frame_t *frame = ctx;
+    frame->view_count = webgpu_render_views(frame->world, renderer, encoder,
+        frame->view_surfaces, frame->view_buffers);
+}
+
+/**
+ * Declare the passes of a frame and the resources they read and write.
+ * Instance records and culled draws are spread over many buffers, so they
+ * are tracked as one resource each without a handle.
+ */
+static void webgpu_declare_frame(WebGPURenderer *renderer, webgpu_frame_t *frame) {
+    webgpu_frame_graph_t *graph = renderer->frame_graph;
+    webgpu_frame_graph_begin(graph);
+    
+    int32_t instances = webgpu_frame_graph_import_buffer(graph, "Instances", NULL);
+    int32_t draws = webgpu_frame_graph_import_buffer(graph, "Culled Draws", NULL);
+    int32_t color = webgpu_frame_graph_import_texture(graph, "Back Buffer",
+        frame->back_buffer, frame->back_buffer_view);
+    int32_t depth = webgpu_frame_graph_import_texture(graph, "Depth", NULL, frame->targets.depth);
+    webgpu_frame_graph_output(graph, color);
+    
+    /* Built from this frame's depth, tested against by the next frame */
+    int32_t hiz = -1;
+    if (renderer->occlusion_culling && renderer->gpu_culling) {
+        hiz = webgpu_frame_graph_import_texture(graph, "HiZ", NULL, NULL);
+        webgpu_frame_graph_output(graph, hiz);
+    }
+    
+    int32_t pass = webgpu_frame_graph_pass(graph, "Transform Expand", webgpu_pass_transforms, frame);
+    webgpu_frame_graph_write(graph, pass, instances);
+    
+    pass = webgpu_frame_graph_pass(graph, "Frustum Cull", webgpu_pass_cull, frame);
+    webgpu_frame_graph_read(graph, pass, instances);
+    webgpu_frame_graph_read_history(graph, pass, hiz);
+    webgpu_frame_graph_write(graph, pass, draws);
+    
+    frame->shadow_atlas = -1;
+    if (renderer->shadows) {
+        uint32_t width, height;
+        webgpu_shadow_atlas_size(renderer, &width, &height);
+        frame->shadow_atlas = webgpu_frame_graph_texture(graph, "Shadow Atlas", width, height,
+            WEBGPU_DEPTH_FORMAT, 1, WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_TextureBinding);
+        
+        pass = webgpu_frame_graph_pass(graph, "Shadow Cascades", webgpu_pass_shadows, frame);
+        webgpu_frame_graph_read(graph, pass, instances);
+        webgpu_frame_graph_read(graph, pass, draws);
+        webgpu_frame_graph_write(graph, pass, frame->shadow_atlas);
+    }
+    
+    pass = webgpu_frame_graph_pass(graph, "Main", webgpu_pass_main, frame);
+    webgpu_frame_graph_read(graph, pass, instances);
+    webgpu_frame_graph_read(graph, pass, draws);
+    webgpu_frame_graph_read(graph, pass, frame->shadow_atlas);
+    webgpu_frame_graph_write(graph, pass, color);
+    webgpu_frame_graph_write(graph, pass, depth);
+    
+    if (hiz >= 0) {
+        pass = webgpu_frame_graph_pass(graph, "HiZ", webgpu_pass_hiz, frame);
+        webgpu_frame_graph_read(graph, pass, depth);
+        webgpu_frame_graph_write(graph, pass, hiz);
+    }
+    
+    /* Views present to their own surfaces */
+    if (ecs_vec_count(&renderer->views)) {
+        pass = webgpu_frame_graph_pass(graph, "Views", webgpu_pass_views, frame);
+        webgpu_frame_graph_read(graph, pass, instances);
+        webgpu_frame_graph_read(graph, pass, draws);
+        webgpu_frame_graph_read(graph, pass, frame->shadow_atlas);
+        webgpu_frame_graph_side_effects(graph, pass);
+    }
 }
 
 /**
@@ -425,15 +777,17 @@ static void webgpu_render_system(ecs_iter_t *it) {
     WebGPUQuery *query = ecs_field(it, WebGPUQuery, 1);
     
     if (it->count > 1) {
-        ecs_err("WebGPU: Multiple renderer instances not supported");
+        ecs_err("WebGPU: Multiple renderers not supported, add WebGPUView to extra canvases");
         return;
     }
     
-    if (!renderer->device) {
-        /* Device not ready yet */
+    if (renderer->startup != WebGPUStartupReady) {
+        /* Adapter or device requests still in flight */
         return;
     }
     
+    webgpu_trace_set_frame(renderer->frame_index);
+    
     /* Exit early if WebGPU error occurred to prevent infinite error loop */
     if (webgpu_error_occurred) {
         ecs_err("WebGPU: Stopping render loop due to previous error");
@@ -446,103 +800,144 @@ static void webgpu_render_system(ecs_iter_t *it) {
         renderer->width = canvas->width;
         renderer->height = canvas->height;
         renderer->needs_resize = true;
+        renderer->resize_frame = renderer->frame_index;
         ecs_trace("WebGPU: Canvas resize detected: %dx%d", renderer->width, renderer->height);
     }
     
-    /* Get current surface texture (modern WebGPU approach) */
-    WGPUSurfaceTexture surface_texture;
-    wgpuSurfaceGetCurrentTexture(renderer->surface, &surface_texture);
-    if (surface_texture.status != WGPUSurfaceGetCurrentTextureStatus_Success) {
-        ecs_warn("WebGPU: Failed to get current surface texture");
+    /* Until the size settled the surface is configured at the canvas size
+     * rounded up to a bucket, which the canvas scales down, so a resize drag
+     * only reconfigures it and reallocates attachments per bucket */
+    if (renderer->needs_resize) {
+        bool settled = renderer->frame_index - renderer->resize_frame >=
+            WEBGPU_RESIZE_DEBOUNCE_FRAMES;
+        uint32_t width = renderer->width, height = renderer->height;
+        if (!settled) {
+            width = webgpu_target_bucket(width);
+            height = webgpu_target_bucket(height);
+        }
+        if (renderer->surface) {
+            webgpu_resize_surface(renderer, width, height);
+        }
+        if (settled) {
+            renderer->needs_resize = false;
+            renderer->redraw = true;
+            ecs_trace("WebGPU: Surface resized to %ux%u", renderer->width, renderer->height);
+        }
+    }
+    
+    /* Free the handles of frames the GPU finished, then release targets
+     * that went unused */
+    webgpu_resource_pool_begin(renderer->resources);
+    webgpu_render_target_pool_begin(renderer->targets);
+    
+    /* Packing ran on the worker threads since change detection finished */
+    if (renderer->pack_start.sec || renderer->pack_start.nanosec) {
+        webgpu_stage_time(renderer, WebGPUStagePack, &renderer->pack_start);
+        renderer->pack_start = (ecs_time_t){0};
+    }
+    
+    /* Without changes an on-demand renderer acquires and submits nothing,
+     * the canvas keeps showing the last presented frame */
+    if (!webgpu_frame_needed(world, renderer)) {
+        renderer->frames_skipped++;
+        webgpu_publish_frame_stats(world, renderer, true);
+        ecs_os_memset_n(renderer->stage_ms, 0, float, WebGPUStageCount);
         return;
     }
+    renderer->redraw = false;
+    
+    ecs_time_t stage_start = {0};
+    ecs_time_measure(&stage_start);
+    
+    /* Get current surface texture (modern WebGPU approach) */
+    WGPUTexture back_buffer_texture = NULL;
+    WGPUTextureView back_buffer = NULL;
+    if (renderer->surface) {
+        WGPUSurfaceTexture surface_texture;
+        wgpuSurfaceGetCurrentTexture(renderer->surface, &surface_texture);
+        if (surface_texture.status != WGPUSurfaceGetCurrentTextureStatus_Success) {
+            ecs_warn("WebGPU: Failed to get current surface texture");
+            return;
+        }
+        
+        back_buffer_texture = surface_texture.texture;
+        back_buffer = wgpuTextureCreateView(surface_texture.texture, NULL);
+    } else {
+        /* Headless targets have no surface to reconfigure, they follow the
+         * renderer size right away */
+        webgpu_acquire_offscreen_target(renderer);
+        back_buffer_texture = renderer->offscreen_texture;
+        back_buffer = renderer->offscreen_view;
+    }
     
-    WGPUTextureView back_buffer = wgpuTextureCreateView(surface_texture.texture, NULL);
     if (!back_buffer) {
         ecs_warn("WebGPU: Failed to create texture view");
         return;
     }
     
-    /* Begin command encoding */
-    WGPUCommandEncoderDescriptor encoder_desc = {
-        .label = "WebGPU Frame Command Encoder",
-    };
-    renderer->command_encoder = wgpuDeviceCreateCommandEncoder(renderer->device, &encoder_desc);
-    
-    /* Begin render pass */
-    WGPURenderPassColorAttachment color_attachment = {
-        .view = back_buffer,
-        .loadOp = WGPULoadOp_Clear,
-        .storeOp = WGPUStoreOp_Store,
-        .clearValue = { 0.1f, 0.2f, 0.3f, 1.0f }, /* Dark blue background */
-        .depthSlice = -1, /* Required for 2D textures - Emscripten treats -1 as undefined */
-    };
-    
-    WGPURenderPassDepthStencilAttachment depth_attachment = {
-        .view = renderer->depth_texture_view,
-        .depthClearValue = 1.0f,
-        .depthLoadOp = WGPULoadOp_Clear,
-        .depthStoreOp = WGPUStoreOp_Store,
-        /* No stencil operations for depth-only texture (Depth24Plus format) */
-        .stencilClearValue = 0,
-        .stencilLoadOp = WGPULoadOp_Undefined,
-        .stencilStoreOp = WGPUStoreOp_Undefined,
+    webgpu_frame_t frame = {
+        .world = world,
+        .back_buffer = back_buffer_texture,
+        .back_buffer_view = back_buffer,
     };
-    
-    /* Log depth attachment status before render pass creation */
-    bool has_depth_attachment = renderer->depth_texture_view != NULL;
-    
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('WebGPU: Creating render pass...');
-        console.log('WebGPU: Depth texture view available:', $0 ? 'YES' : 'NO');
-        if ($0) {
-            console.log('WebGPU: Depth texture view handle:', $1);
-            console.log('WebGPU: ✓ Render pass will include depth stencil attachment');
-            console.log('WebGPU: Depth operations: Clear(1.0) -> Store');
-            console.log('WebGPU: Stencil operations: DISABLED (depth-only texture)');
-        } else {
-            console.warn('WebGPU: ⚠ Render pass will NOT include depth stencil attachment');
+    if (!webgpu_frame_targets_acquire(renderer, back_buffer_texture, back_buffer, &frame.targets)) {
+        ecs_warn("WebGPU: Failed to acquire render targets");
+        if (renderer->surface) {
+            wgpuTextureViewRelease(back_buffer);
         }
-    }, has_depth_attachment, (uint32_t)(uintptr_t)renderer->depth_texture_view);
-#endif
-    
-    WGPURenderPassDescriptor render_pass_desc = {
-        .label = "WebGPU Main Render Pass",
-        .colorAttachmentCount = 1,
-        .colorAttachments = &color_attachment,
-        .depthStencilAttachment = has_depth_attachment ? &depth_attachment : NULL,
-    };
-    
-    WGPURenderPassEncoder render_pass = wgpuCommandEncoderBeginRenderPass(renderer->command_encoder, &render_pass_desc);
+        return;
+    }
     
-    /* Gather and render geometry batches */
+    /* Gather the batches the passes draw */
+    webgpu_profile_frame_start(renderer);
+    webgpu_stage_time(renderer, WebGPUStageEncode, &stage_start);
     webgpu_gather_geometry_batches(world, renderer, query->query);
-    webgpu_execute_render_batches(renderer, render_pass);
-    
-    /* End render pass */
-    wgpuRenderPassEncoderEnd(render_pass);
+    ecs_time_measure(&stage_start);
+    
+    /* Reported through WebGPUFrameStats::depth_test */
+    renderer->depth_attached = frame.targets.depth != NULL;
+    
+    /* Record and submit the frame's passes */
+    webgpu_declare_frame(renderer, &frame);
+    bool submitted = webgpu_frame_graph_compile(renderer, renderer->frame_graph) &&
+        webgpu_frame_graph_execute(renderer, renderer->frame_graph);
+    ecs_vec_clear(&renderer->render_batches);
+    ecs_vec_clear(&renderer->render_queue);
+    
+    if (!submitted) {
+        ecs_warn("WebGPU: Failed to record the frame");
+        if (renderer->surface) {
+            wgpuTextureViewRelease(back_buffer);
+        }
+        return;
+    }
     
-    /* Submit commands */
-    WGPUCommandBufferDescriptor cmd_buffer_desc = {
-        .label = "WebGPU Frame Commands",
-    };
-    WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(renderer->command_encoder, &cmd_buffer_desc);
-    wgpuQueueSubmit(renderer->queue, 1, &command_buffer);
+    if (!renderer->frame_index) {
+        ecs_time_t start = renderer->startup_time;
+        renderer->startup_ms = (float)(ecs_time_measure(&start) * 1000.0);
+    }
     
     /* Present frame - Skip for Emscripten as it's handled automatically */
+    if (renderer->surface) {
 #ifndef __EMSCRIPTEN__
-    wgpuSurfacePresent(renderer->surface);
+        wgpuSurfacePresent(renderer->surface);
 #else
-    /* Emscripten handles presentation automatically with requestAnimationFrame */
+        /* Emscripten handles presentation automatically with requestAnimationFrame */
+#endif
+        wgpuTextureViewRelease(back_buffer);
+    }
+    
+    for (int32_t v = 0; v < frame.view_count; v++) {
+#ifndef __EMSCRIPTEN__
+        wgpuSurfacePresent(frame.view_surfaces[v]);
 #endif
+        wgpuTextureViewRelease(frame.view_buffers[v]);
+    }
     
-    /* Cleanup */
-    wgpuTextureViewRelease(back_buffer);
-    wgpuCommandBufferRelease(command_buffer);
-    wgpuRenderPassEncoderRelease(render_pass);
-    wgpuCommandEncoderRelease(renderer->command_encoder);
+    webgpu_stage_time(renderer, WebGPUStageEncode, &stage_start);
     
+    webgpu_publish_frame_stats(world, renderer, false);
+    ecs_os_memset_n(renderer->stage_ms, 0, float, WebGPUStageCount);
     renderer->frame_index++;
 }
 
@@ -554,8 +949,31 @@ ECS_CTOR(WebGPURenderer, ptr, {
 })
 
 ECS_DTOR(WebGPURenderer, ptr, {
+    webgpu_mesh_registry_destroy(ptr->mesh_registry);
+    webgpu_pipeline_cache_destroy(ptr->pipeline_cache);
+    webgpu_uniforms_destroy(ptr->uniforms);
+    webgpu_profiler_destroy(ptr->profiler);
+    webgpu_instance_storage_destroy(ptr->instance_storage);
+    webgpu_transform_expander_destroy(ptr->transform_expander);
+    webgpu_material_cache_destroy(ptr->materials);
+    webgpu_mesh_loader_destroy(ptr->mesh_loader);
+    webgpu_texture_cache_destroy(ptr->textures);
+    webgpu_render_target_pool_destroy(ptr->targets);
+    webgpu_bundle_cache_destroy(ptr->bundles);
+    webgpu_hiz_destroy(ptr->hiz);
+    webgpu_shadows_destroy(ptr->shadows);
+    webgpu_frame_graph_destroy(ptr->frame_graph);
+    webgpu_buffer_free(ptr->resources, &ptr->cull_args);
+    webgpu_buffer_free(ptr->resources, &ptr->cull_params);
+    
+    /* After everything that releases to it, before the allocator */
+    webgpu_destroy_resource_pool(ptr->resources);
+    
     if (ptr->allocator) {
         ecs_vec_fini_t(ptr->allocator, &ptr->render_batches, webgpu_render_batch_t);
+        ecs_vec_fini_t(ptr->allocator, &ptr->render_queue, webgpu_draw_item_t);
+        ecs_vec_fini_t(ptr->allocator, &ptr->render_queue_scratch, webgpu_draw_item_t);
+        ecs_vec_fini_t(ptr->allocator, &ptr->views, ecs_entity_t);
         flecs_allocator_fini(ptr->allocator);
         ecs_os_free(ptr->allocator);
     }
@@ -564,12 +982,16 @@ ECS_DTOR(WebGPURenderer, ptr, {
         ecs_query_fini(ptr->geometry_query);
     }
     
-    if (ptr->depth_texture_view) {
-        wgpuTextureViewRelease(ptr->depth_texture_view);
+    if (ptr->view_query) {
+        ecs_query_fini(ptr->view_query);
+    }
+    
+    if (ptr->cull_pipeline) {
+        wgpuComputePipelineRelease(ptr->cull_pipeline);
     }
     
-    if (ptr->depth_texture) {
-        wgpuTextureRelease(ptr->depth_texture);
+    if (ptr->cull_layout) {
+        wgpuBindGroupLayoutRelease(ptr->cull_layout);
     }
     
     if (ptr->surface) {
@@ -602,9 +1024,12 @@ ECS_CTOR(WebGPUGeometry, ptr, {
 
 ECS_DTOR(WebGPUGeometry, ptr, {
     if (ptr->allocator) {
-        ecs_vec_fini_t(ptr->allocator, &ptr->transform_data, mat4);
-        ecs_vec_fini_t(ptr->allocator, &ptr->color_data, vec3);
+        ecs_vec_fini_t(ptr->allocator, &ptr->instance_data, uint8_t);
+        ecs_vec_fini_t(ptr->allocator, &ptr->packed_data, uint8_t);
+        ecs_vec_fini_t(ptr->allocator, &ptr->packed_spheres, float);
+        ecs_vec_fini_t(ptr->allocator, &ptr->table_ranges, webgpu_table_range_t);
         ecs_vec_fini_t(ptr->allocator, &ptr->material_data, float);
+        ecs_vec_fini_t(ptr->allocator, &ptr->lod_state, uint8_t);
         flecs_allocator_fini(ptr->allocator);
         ecs_os_free(ptr->allocator);
     }
@@ -613,25 +1038,142 @@ ECS_DTOR(WebGPUGeometry, ptr, {
         ecs_query_fini(ptr->query);
     }
     
-    if (ptr->vertex_buffer != NULL) {
-        wgpuBufferRelease(ptr->vertex_buffer);
+    /* instance_buffer aliases a ring slot, only the ring owns blocks */
+    for (int32_t i = 0; i < WEBGPU_FRAMES_IN_FLIGHT; i++) {
+        webgpu_buffer_free(ptr->resources, &ptr->instance_ring[i]);
     }
     
-    if (ptr->index_buffer != NULL) {
-        wgpuBufferRelease(ptr->index_buffer);
-    }
-    
-    if (ptr->instance_buffer != NULL) {
-        wgpuBufferRelease(ptr->instance_buffer);
+    webgpu_buffer_free(ptr->resources, &ptr->visible);
+    for (int32_t i = 0; i < WEBGPU_MAX_SHADOW_CASCADES; i++) {
+        webgpu_buffer_free(ptr->resources, &ptr->shadow_visible[i]);
     }
+    webgpu_resource_pool_drop(ptr->resources);
     
     if (ptr->pipeline != NULL) {
         wgpuRenderPipelineRelease(ptr->pipeline);
     }
-    
-    if (ptr->bind_group != NULL) {
-        wgpuBindGroupRelease(ptr->bind_group);
+    
+    if (ptr->bind_group != NULL) {
+        wgpuBindGroupRelease(ptr->bind_group);
+    }
+})
+
+/**
+ * WebGPUMesh component lifecycle functions, the component owns its path
+ */
+ECS_CTOR(WebGPUMesh, ptr, {
+    ptr->path = NULL;
+})
+
+ECS_DTOR(WebGPUMesh, ptr, {
+    ecs_os_free(ptr->path);
+})
+
+ECS_COPY(WebGPUMesh, dst, src, {
+    ecs_os_free(dst->path);
+    dst->path = ecs_os_strdup(src->path);
+})
+
+ECS_MOVE(WebGPUMesh, dst, src, {
+    ecs_os_free(dst->path);
+    dst->path = src->path;
+    src->path = NULL;
+})
+
+/**
+ * WebGPUTexture component lifecycle functions, the component owns its path
+ */
+ECS_CTOR(WebGPUTexture, ptr, {
+    ptr->path = NULL;
+})
+
+ECS_DTOR(WebGPUTexture, ptr, {
+    ecs_os_free(ptr->path);
+})
+
+ECS_COPY(WebGPUTexture, dst, src, {
+    ecs_os_free(dst->path);
+    dst->path = ecs_os_strdup(src->path);
+})
+
+ECS_MOVE(WebGPUTexture, dst, src, {
+    ecs_os_free(dst->path);
+    dst->path = src->path;
+    src->path = NULL;
+})
+
+/**
+ * WebGPUView component lifecycle functions, the component owns its selector
+ * and surface. Copies get the selector, and a surface of their own.
+ */
+ECS_CTOR(WebGPUView, ptr, {
+    ecs_os_memset_t(ptr, 0, WebGPUView);
+})
+
+ECS_DTOR(WebGPUView, ptr, {
+    ecs_os_free(ptr->selector);
+    if (ptr->surface) {
+        wgpuSurfaceRelease(ptr->surface);
+    }
+})
+
+ECS_COPY(WebGPUView, dst, src, {
+    ecs_os_free(dst->selector);
+    if (dst->surface) {
+        wgpuSurfaceRelease(dst->surface);
+    }
+    ecs_os_memset_t(dst, 0, WebGPUView);
+    dst->renderer = src->renderer;
+    dst->selector = ecs_os_strdup(src->selector);
+})
+
+ECS_MOVE(WebGPUView, dst, src, {
+    ecs_os_free(dst->selector);
+    if (dst->surface) {
+        wgpuSurfaceRelease(dst->surface);
     }
+    *dst = *src;
+    ecs_os_memset_t(src, 0, WebGPUView);
+})
+
+/**
+ * WebGPUSharedTransforms lifecycle functions, the singleton owns its array
+ */
+ECS_CTOR(WebGPUSharedTransforms, ptr, {
+    ptr->data = NULL;
+    ptr->capacity = 0;
+    ptr->generation = 0;
+    ptr->entities = NULL;
+    ptr->dirty_first = ptr->dirty_end = 0;
+})
+
+ECS_DTOR(WebGPUSharedTransforms, ptr, {
+    ecs_os_free(ptr->data);
+    ecs_os_free(ptr->entities);
+})
+
+ECS_MOVE(WebGPUSharedTransforms, dst, src, {
+    ecs_os_free(dst->data);
+    ecs_os_free(dst->entities);
+    *dst = *src;
+    src->data = NULL;
+    src->entities = NULL;
+    src->capacity = 0;
+})
+
+ECS_CTOR(WebGPUPackTask, ptr, {
+    ptr->index = 0;
+    ecs_vec_init_t(NULL, &ptr->scratch, uint8_t, 0);
+})
+
+ECS_DTOR(WebGPUPackTask, ptr, {
+    ecs_vec_fini_t(NULL, &ptr->scratch, uint8_t);
+})
+
+ECS_MOVE(WebGPUPackTask, dst, src, {
+    ecs_vec_fini_t(NULL, &dst->scratch, uint8_t);
+    *dst = *src;
+    ecs_vec_init_t(NULL, &src->scratch, uint8_t, 0);
 })
 
 /**
@@ -655,6 +1197,163 @@ void FlecsSystemsWebGPUImport(ecs_world_t *world) {
     ECS_COMPONENT_DEFINE(world, WebGPUGeometry);
     ECS_COMPONENT_DEFINE(world, WebGPUMaterial);
     ECS_COMPONENT_DEFINE(world, WebGPUQuery);
+    ECS_COMPONENT_DEFINE(world, WebGPUFrameStats);
+    ECS_COMPONENT_DEFINE(world, WebGPUMemoryBudget);
+    
+    /* Procedural primitives, with reflection so they can be set from scripts */
+    ECS_COMPONENT_DEFINE(world, WebGPUSphere);
+    ECS_COMPONENT_DEFINE(world, WebGPUCylinder);
+    ECS_COMPONENT_DEFINE(world, WebGPUGrid);
+    
+    ecs_struct(world, {
+        .entity = ecs_id(WebGPUSphere),
+        .members = {
+            { .name = "radius", .type = ecs_id(ecs_f32_t) }
+        }
+    });
+    
+    ecs_struct(world, {
+        .entity = ecs_id(WebGPUCylinder),
+        .members = {
+            { .name = "radius", .type = ecs_id(ecs_f32_t) },
+            { .name = "height", .type = ecs_id(ecs_f32_t) }
+        }
+    });
+    
+    ecs_struct(world, {
+        .entity = ecs_id(WebGPUGrid),
+        .members = {
+            { .name = "width", .type = ecs_id(ecs_f32_t) },
+            { .name = "depth", .type = ecs_id(ecs_f32_t) }
+        }
+    });
+    
+    /* Streamed meshes are shared like materials, instances inherit them */
+    ECS_COMPONENT_DEFINE(world, WebGPUMesh);
+    ecs_set_hooks(world, WebGPUMesh, {
+        .ctor = ecs_ctor(WebGPUMesh),
+        .dtor = ecs_dtor(WebGPUMesh),
+        .copy = ecs_copy(WebGPUMesh),
+        .move = ecs_move(WebGPUMesh)
+    });
+    ecs_struct(world, {
+        .entity = ecs_id(WebGPUMesh),
+        .members = {
+            { .name = "path", .type = ecs_id(ecs_string_t) }
+        }
+    });
+    ecs_add_pair(world, ecs_id(WebGPUMesh), EcsOnInstantiate, EcsInherit);
+    
+    /* Textures are referenced by materials */
+    ECS_COMPONENT_DEFINE(world, WebGPUTexture);
+    ecs_set_hooks(world, WebGPUTexture, {
+        .ctor = ecs_ctor(WebGPUTexture),
+        .dtor = ecs_dtor(WebGPUTexture),
+        .copy = ecs_copy(WebGPUTexture),
+        .move = ecs_move(WebGPUTexture)
+    });
+    ecs_struct(world, {
+        .entity = ecs_id(WebGPUTexture),
+        .members = {
+            { .name = "path", .type = ecs_id(ecs_string_t) }
+        }
+    });
+    
+    /* Views draw extra canvases with a renderer's resources */
+    ECS_COMPONENT_DEFINE(world, WebGPUView);
+    ecs_set_hooks(world, WebGPUView, {
+        .ctor = ecs_ctor(WebGPUView),
+        .dtor = ecs_dtor(WebGPUView),
+        .copy = ecs_copy(WebGPUView),
+        .move = ecs_move(WebGPUView)
+    });
+    ecs_struct(world, {
+        .entity = ecs_id(WebGPUView),
+        .members = {
+            { .name = "renderer", .type = ecs_id(ecs_entity_t) },
+            { .name = "selector", .type = ecs_id(ecs_string_t) }
+        }
+    });
+    
+    /* Reflection, so frame stats show up in the explorer */
+    ecs_struct(world, {
+        .entity = ecs_id(WebGPUFrameStats),
+        .members = {
+            { .name = "gpu_timing", .type = ecs_id(ecs_bool_t) },
+            { .name = "gpu_ms", .type = ecs_id(ecs_f32_t) },
+            { .name = "pass_ms", .type = ecs_id(ecs_f32_t), .count = WebGPUPassCount },
+            { .name = "cpu_ms", .type = ecs_id(ecs_f32_t), .count = WebGPUStageCount },
+            { .name = "draw_calls", .type = ecs_id(ecs_u32_t) },
+            { .name = "instances", .type = ecs_id(ecs_u32_t) },
+            { .name = "instances_culled", .type = ecs_id(ecs_u32_t) },
+            { .name = "instances_transparent", .type = ecs_id(ecs_u32_t) },
+            { .name = "bytes_uploaded", .type = ecs_id(ecs_u64_t) },
+            { .name = "bytes_skipped", .type = ecs_id(ecs_u64_t) },
+            { .name = "uniform_writes", .type = ecs_id(ecs_u32_t) },
+            { .name = "state_changes", .type = ecs_id(ecs_u32_t) },
+            { .name = "bundles_recorded", .type = ecs_id(ecs_u32_t) },
+            { .name = "bundles_replayed", .type = ecs_id(ecs_u32_t) },
+            { .name = "shadow_draws", .type = ecs_id(ecs_u32_t) },
+            { .name = "passes_recorded", .type = ecs_id(ecs_u32_t) },
+            { .name = "passes_culled", .type = ecs_id(ecs_u32_t) },
+            { .name = "transients_aliased", .type = ecs_id(ecs_u32_t) },
+            { .name = "mesh_bytes_streamed", .type = ecs_id(ecs_u64_t) },
+            { .name = "meshes_loading", .type = ecs_id(ecs_u32_t) },
+            { .name = "texture_bytes_streamed", .type = ecs_id(ecs_u64_t) },
+            { .name = "textures_loading", .type = ecs_id(ecs_u32_t) },
+            { .name = "render_targets", .type = ecs_id(ecs_u32_t) },
+            { .name = "releases_pending", .type = ecs_id(ecs_u32_t) },
+            { .name = "buffer_pool_bytes", .type = ecs_id(ecs_u64_t) },
+            { .name = "frame", .type = ecs_id(ecs_u32_t) },
+            { .name = "depth_test", .type = ecs_id(ecs_bool_t) },
+            { .name = "startup_ms", .type = ecs_id(ecs_f32_t) },
+            { .name = "skipped", .type = ecs_id(ecs_bool_t) },
+            { .name = "frames_skipped", .type = ecs_id(ecs_u32_t) },
+            { .name = "views", .type = ecs_id(ecs_u32_t) }
+        }
+    });
+    ecs_singleton_add(world, WebGPUFrameStats);
+    
+    ecs_struct(world, {
+        .entity = ecs_id(WebGPUMemoryBudget),
+        .members = {
+            { .name = "budget", .type = ecs_id(ecs_u64_t) },
+            { .name = "used", .type = ecs_id(ecs_u64_t) },
+            { .name = "committed", .type = ecs_id(ecs_u64_t) },
+            { .name = "class_used", .type = ecs_id(ecs_u64_t), .count = WebGPUBufferClassCount },
+            { .name = "class_committed", .type = ecs_id(ecs_u64_t), .count = WebGPUBufferClassCount },
+            { .name = "failed", .type = ecs_id(ecs_u32_t) }
+        }
+    });
+    ecs_singleton_add(world, WebGPUMemoryBudget);
+    
+    /* Bulk entity API and the shared transform array scripts write into */
+    ECS_COMPONENT_DEFINE(world, WebGPUSharedTransform);
+    ECS_COMPONENT_DEFINE(world, WebGPUSharedTransforms);
+    ecs_set_hooks(world, WebGPUSharedTransforms, {
+        .ctor = ecs_ctor(WebGPUSharedTransforms),
+        .dtor = ecs_dtor(WebGPUSharedTransforms),
+        .move = ecs_move(WebGPUSharedTransforms)
+    });
+    ecs_struct(world, {
+        .entity = ecs_id(WebGPUSharedTransform),
+        .members = {
+            { .name = "slot", .type = ecs_id(ecs_i32_t) }
+        }
+    });
+    
+    /* Fixed timestep systems run from their own pipeline, see webgpu_progress */
+    ECS_TAG_DEFINE(world, WebGPUFixedUpdate);
+    ECS_COMPONENT_DEFINE(world, WebGPUFixedTimestep);
+    ecs_singleton_set(world, WebGPUFixedTimestep, {
+        .pipeline = ecs_pipeline(world, {
+            .query.terms = {
+                { .id = EcsSystem },
+                { .id = ecs_dependson(WebGPUFixedUpdate) },
+                { .id = EcsDisabled, .src.id = EcsUp, .trav = EcsChildOf, .oper = EcsNot }
+            }
+        })
+    });
     
     /* Set component hooks */
     ecs_set_hooks(world, WebGPURenderer, {
@@ -662,16 +1361,52 @@ void FlecsSystemsWebGPUImport(ecs_world_t *world) {
         .dtor = ecs_dtor(WebGPURenderer)
     });
     
-    /* Initialize renderer system */
+    /* Initialize renderer system, canvases with a WebGPUView are views of it */
     ECS_SYSTEM(world, webgpu_init_renderer, EcsOnLoad,
         [out] !WebGPURenderer, 
-        [in] flecs.components.gui.Canvas);
+        [in] flecs.components.gui.Canvas,
+        !WebGPUView);
         
     ecs_system(world, {
         .entity = webgpu_init_renderer,
         .immediate = true  /* Need direct world access for query creation */
     });
     
+    /* Instance packing: serial change detection, then packing spread over
+     * worker threads (see ecs_set_threads) */
+    ECS_COMPONENT_DEFINE(world, WebGPUPackTask);
+    ecs_set_hooks(world, WebGPUPackTask, {
+        .ctor = ecs_ctor(WebGPUPackTask),
+        .dtor = ecs_dtor(WebGPUPackTask),
+        .move = ecs_move(WebGPUPackTask)
+    });
+    for (int32_t i = 0; i < WEBGPU_PACK_TASKS; i++) {
+        ecs_ensure(world, ecs_new(world), WebGPUPackTask)->index = i;
+    }
+    
+    /* Published shared transform slots, before packing sees which tables
+     * changed. Immediate, so the tables are marked modified right away. */
+    ECS_SYSTEM(world, webgpu_apply_shared_transforms, EcsPreStore, 0);
+    ecs_system(world, {
+        .entity = webgpu_apply_shared_transforms,
+        .immediate = true
+    });
+    
+    /* Camera and light uniforms, before packing so culling sees this frame's camera */
+    ECS_SYSTEM(world, webgpu_update_uniforms, EcsPreStore,
+        [inout] WebGPURenderer);
+    
+    ECS_SYSTEM(world, webgpu_prepare_instances, EcsPreStore,
+        [inout] WebGPURenderer);
+    
+    ECS_SYSTEM(world, webgpu_pack_instances, EcsPreStore,
+        [inout] WebGPUPackTask);
+    
+    ecs_system(world, {
+        .entity = webgpu_pack_instances,
+        .multi_threaded = true
+    });
+    
     /* Main rendering system */
     ECS_SYSTEM(world, webgpu_render_system, EcsOnStore,
         [in] WebGPURenderer, 
@@ -694,178 +1429,36 @@ void FlecsSystemsWebGPUImport(ecs_world_t *world) {
     /* Create geometry type entities */
     ECS_ENTITY_DEFINE(world, WebGPUBoxGeometry, WebGPUGeometry);
     ECS_ENTITY_DEFINE(world, WebGPURectangleGeometry, WebGPUGeometry);
+    ECS_ENTITY_DEFINE(world, WebGPUSphereGeometry, WebGPUGeometry);
+    ECS_ENTITY_DEFINE(world, WebGPUCylinderGeometry, WebGPUGeometry);
+    ECS_ENTITY_DEFINE(world, WebGPUGridGeometry, WebGPUGeometry);
+    ECS_ENTITY_DEFINE(world, WebGPUMeshGeometry, WebGPUGeometry);
     
-    /* Import material subsystem */
+    /* Import material subsystem, geometry queries inherit materials */
     webgpu_material_import(world);
+    ECS_TAG_DEFINE(world, WebGPUTransparent);
+    
+    /* Geometry entities own the persistent per-type instance buffers */
+    webgpu_init_box_geometry(world, ecs_get_mut(world, WebGPUBoxGeometry, WebGPUGeometry));
+    webgpu_init_rectangle_geometry(world, ecs_get_mut(world, WebGPURectangleGeometry, WebGPUGeometry));
+    webgpu_init_primitive_geometry(world, ecs_get_mut(world, WebGPUSphereGeometry, WebGPUGeometry),
+        ecs_id(WebGPUSphere));
+    webgpu_init_primitive_geometry(world, ecs_get_mut(world, WebGPUCylinderGeometry, WebGPUGeometry),
+        ecs_id(WebGPUCylinder));
+    webgpu_init_primitive_geometry(world, ecs_get_mut(world, WebGPUGridGeometry, WebGPUGeometry),
+        ecs_id(WebGPUGrid));
+    webgpu_init_mesh_geometry(world, ecs_get_mut(world, WebGPUMeshGeometry, WebGPUGeometry));
     
     /* Module import completed */
 }
 
-/* Forward declarations for helper functions */
-static WGPUBuffer create_instance_buffer(WGPUDevice device, 
-                                       const EcsTransform3 *transforms,
-                                       const EcsRgb *colors,
-                                       uint32_t count);
-static bool get_geometry_buffers(ecs_world_t *world,
-                                WebGPURenderer *renderer,
-                                ecs_id_t geometry_type,
-                                WGPUBuffer *vertex_buffer,
-                                WGPUBuffer *index_buffer,
-                                uint32_t *vertex_count,
-                                uint32_t *index_count);
-static WGPURenderPipeline create_geometry_pipeline(WebGPURenderer *renderer);
-
-/* Duplicate functions removed - implementations now in render_system.c */
-
-
-/**
- * Create instance data buffer for a batch of entities
- */
-static WGPUBuffer create_instance_buffer(WGPUDevice device, 
-                                       const EcsTransform3 *transforms,
-                                       const EcsRgb *colors,
-                                       uint32_t count) {
-    if (!device || count == 0) {
-        return (WGPUBuffer){0};
-    }
-    
-    size_t buffer_size = count * 19 * sizeof(float); /* 16 + 3 floats per instance */
-    float *instance_data = ecs_os_malloc(buffer_size);
-    if (!instance_data) {
-        ecs_err("Failed to allocate instance data buffer");
-        return (WGPUBuffer){0};
-    }
-    
-    /* Pack transform matrices and colors into instance buffer */
-    for (uint32_t i = 0; i < count; i++) {
-        float *dst = &instance_data[i * 19]; /* 16 + 3 floats per instance */
-        
-        /* Transform matrix (16 floats) */
-        if (transforms) {
-            /* Copy the existing transform matrix directly */
-            memcpy(dst, transforms[i].value, 16 * sizeof(float));
-        } else {
-            /* Identity matrix */
-            mat4 identity;
-            glm_mat4_identity(identity);
-            memcpy(dst, identity, 16 * sizeof(float));
-        }
-        
-        /* Color (3 floats) */
-        if (colors) {
-            dst[16] = colors[i].r;
-            dst[17] = colors[i].g;
-            dst[18] = colors[i].b;
-        } else {
-            /* Default white color */
-            dst[16] = 1.0f;
-            dst[17] = 1.0f;
-            dst[18] = 1.0f;
-        }
-    }
-    
-    /* Create GPU buffer using resource manager function */
-    extern WGPUBuffer webgpu_create_buffer(WGPUDevice device, size_t size, WGPUBufferUsage usage, const void *data);
-    WGPUBuffer buffer = webgpu_create_buffer(device, buffer_size, 
-        WGPUBufferUsage_Vertex | WGPUBufferUsage_CopyDst, instance_data);
-    
-    ecs_os_free(instance_data);
-    return buffer;
-}
-
-/**
- * Get geometry buffers for a specific geometry type
- */
-static bool get_geometry_buffers(ecs_world_t *world,
-                                WebGPURenderer *renderer,
-                                ecs_id_t geometry_type,
-                                WGPUBuffer *vertex_buffer,
-                                WGPUBuffer *index_buffer,
-                                uint32_t *vertex_count,
-                                uint32_t *index_count) {
-    
-    extern WGPUBuffer webgpu_create_buffer(WGPUDevice device, size_t size, WGPUBufferUsage usage, const void *data);
-    
-    if (geometry_type == ecs_id(EcsBox)) {
-        /* Box geometry from geometry.c */
-        extern const float box_vertices[];
-        extern const uint16_t box_indices[];
-        extern const uint32_t box_vertex_count;
-        extern const uint32_t box_index_count;
-        
-        *vertex_buffer = webgpu_create_buffer(renderer->device,
-            box_vertex_count * 8 * sizeof(float), /* pos(3) + normal(3) + uv(2) */
-            WGPUBufferUsage_Vertex, box_vertices);
-            
-        *index_buffer = webgpu_create_buffer(renderer->device,
-            box_index_count * sizeof(uint16_t),
-            WGPUBufferUsage_Index, box_indices);
-            
-        *vertex_count = box_vertex_count;
-        *index_count = box_index_count;
-        return true;
-    }
-    
-    if (geometry_type == ecs_id(EcsRectangle)) {
-        /* Rectangle geometry from geometry.c */
-        extern const float rectangle_vertices[];
-        extern const uint16_t rectangle_indices[];
-        extern const uint32_t rectangle_vertex_count;
-        extern const uint32_t rectangle_index_count;
-        
-        *vertex_buffer = webgpu_create_buffer(renderer->device,
-            rectangle_vertex_count * 8 * sizeof(float),
-            WGPUBufferUsage_Vertex, rectangle_vertices);
-            
-        *index_buffer = webgpu_create_buffer(renderer->device,
-            rectangle_index_count * sizeof(uint16_t),
-            WGPUBufferUsage_Index, rectangle_indices);
-            
-        *vertex_count = rectangle_vertex_count;
-        *index_count = rectangle_index_count;
-        return true;
-    }
-    
-    ecs_warn("WebGPU: Unsupported geometry type: %s", ecs_get_name(world, geometry_type));
-    return false;
-}
-
-/**
- * Create render pipeline for geometry type
- */
-static WGPURenderPipeline create_geometry_pipeline(WebGPURenderer *renderer) {
-    /* Load embedded shaders */
-    extern const char *basic_vertex_shader_source;
-    extern const char *basic_fragment_shader_source;
-    extern WGPUShaderModule webgpu_create_shader_module(WGPUDevice device, const char *wgsl_source);
-    extern WGPURenderPipeline webgpu_create_geometry_pipeline(WGPUDevice device, WGPUShaderModule vertex_shader, WGPUShaderModule fragment_shader);
-    
-    /* Create shader modules */
-    WGPUShaderModule vertex_shader = webgpu_create_shader_module(
-        renderer->device, basic_vertex_shader_source);
-    WGPUShaderModule fragment_shader = webgpu_create_shader_module(
-        renderer->device, basic_fragment_shader_source);
-    
-    if (!vertex_shader || !fragment_shader) {
-        ecs_err("WebGPU: Failed to create shader modules");
-        return NULL;
-    }
-    
-    /* Create pipeline */
-    WGPURenderPipeline pipeline = webgpu_create_geometry_pipeline(
-        renderer->device, vertex_shader, fragment_shader);
-    
-    /* Cleanup shader modules */
-    wgpuShaderModuleRelease(vertex_shader);
-    wgpuShaderModuleRelease(fragment_shader);
-    
-    return pipeline;
-}
-
 /* ============================================================================
  * DEMO APPLICATION CODE
  * ============================================================================ */
 
+/* Executables that embed the module (benchmarks) define WEBGPU_NO_DEMO */
+#ifndef WEBGPU_NO_DEMO
+
 /* Global state for demo */
 static ecs_world_t *g_world = NULL;
 static ecs_entity_t g_renderer = 0;
@@ -878,68 +1471,15 @@ static void main_loop(void);
  * Main loop function for Emscripten
  */
 static void main_loop(void) {
-    static bool first_run = true;
-    static int frame_count = 0;
-    
-    if (first_run) {
-#ifdef __EMSCRIPTEN__
-        EM_ASM({
-            console.log('Main loop: First run starting');
-        });
-#endif
-        first_run = false;
-    }
-    
-    frame_count++;
-    
     if (!g_world) {
-#ifdef __EMSCRIPTEN__
-        EM_ASM({
-            console.log('Main loop: No world, canceling loop');
-        });
-#endif
+        webgpu_error("Main loop: No world, canceling loop");
         emscripten_cancel_main_loop();
         return;
     }
     
-    /* Wrap ECS progress in try-catch style error handling */
-    bool progress_success = false;
-    
-#ifdef __EMSCRIPTEN__
-    /* Use Emscripten's exception handling */
-    EM_ASM({
-        try {
-            Module.ecs_progress_safe = true;
-        } catch(e) {
-            Module.ecs_progress_safe = false;
-            console.error('Pre-progress error:', e);
-        }
-    });
-#endif
-    
-    /* Run the ECS frame with error checking */
-    bool should_continue = false;
-    
-    /* Simple error boundary */
-    if (g_world) {
-        should_continue = ecs_progress(g_world, 0);
-        progress_success = true;
-        
-        if (frame_count % 60 == 0) {
-#ifdef __EMSCRIPTEN__
-            EM_ASM({
-                console.log('Frame:', $0, 'ECS running normally');
-            }, frame_count);
-#endif
-        }
-    }
-    
-    if (!should_continue || !progress_success) {
-#ifdef __EMSCRIPTEN__
-        EM_ASM({
-            console.log('ECS progress stopping: continue=', $0, 'success=', $1);
-        }, should_continue, progress_success);
-#endif
+    /* Frame progress is published in WebGPUFrameStats instead of logged */
+    if (!webgpu_progress(g_world, 0)) {
+        webgpu_info("Main loop: ECS progress stopped");
         emscripten_cancel_main_loop();
     }
 }
@@ -954,87 +1494,39 @@ static void demo_init() {
         return;
     }
     
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('Flecs world created successfully');
-    });
-#endif
-    
     /* Import WebGPU systems */
     FlecsSystemsWebGPUImport(g_world);
     
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('WebGPU systems imported successfully');
-    });
-#endif
-
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('About to create renderer entity');
-    });
+#ifdef WEBGPU_WORKER_THREADS
+    /* Spread instance packing over worker threads */
+    ecs_set_threads(g_world, WEBGPU_WORKER_THREADS);
 #endif
     
+    webgpu_trace("Demo: WebGPU systems imported");
+    
     /* Create renderer entity with canvas component */
     g_renderer = ecs_new(g_world);
     
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('Renderer entity created, adding EcsCanvas');
-    });
-#endif
-    
     ecs_set(g_world, g_renderer, EcsCanvas, {
         .width = 1024,
         .height = 600
     });
     
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('EcsCanvas added, adding WebGPURenderer');
-    });
-#endif
-    
     ecs_add(g_world, g_renderer, WebGPURenderer);
-    
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('WebGPURenderer added, adding WebGPUQuery');
-    });
-#endif
-    
     ecs_add(g_world, g_renderer, WebGPUQuery);
     
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('Renderer entity created');
-    });
-#endif
+    webgpu_trace("Demo: Renderer entity created");
     
     /* Manually trigger renderer initialization for web */
     const EcsCanvas *canvas = ecs_get(g_world, g_renderer, EcsCanvas);
     WebGPURenderer *renderer = ecs_get_mut(g_world, g_renderer, WebGPURenderer);
     if (canvas && renderer) {
-#ifdef __EMSCRIPTEN__
-        EM_ASM({
-            console.log('Attempting manual WebGPU initialization');
-        });
-#endif
-        
         /* Simple WebGPU initialization */
-        renderer->width = canvas->width;
-        renderer->height = canvas->height;
-        renderer->canvas_entity = g_renderer;
+        webgpu_renderer_init(g_world, renderer, g_renderer, canvas->width, canvas->height);
         
         /* Try to create WebGPU instance */
         renderer->instance = wgpuCreateInstance(NULL);
         if (renderer->instance) {
-#ifdef __EMSCRIPTEN__
-            EM_ASM({
-                console.log('WebGPU instance created successfully');
-            });
-#endif
-            
             /* Create surface for web canvas */
             WGPUSurfaceDescriptorFromCanvasHTMLSelector canvas_desc = {
                 .chain = {
@@ -1050,42 +1542,16 @@ static void demo_init() {
             };
             
             renderer->surface = wgpuInstanceCreateSurface(renderer->instance, &surface_desc);
-            if (renderer->surface) {
-#ifdef __EMSCRIPTEN__
-                EM_ASM({
-                    console.log('WebGPU surface created successfully');
-                });
-#endif
-            } else {
-#ifdef __EMSCRIPTEN__
-                EM_ASM({
-                    console.log('Failed to create WebGPU surface');
-                });
-#endif
+            if (!renderer->surface) {
+                webgpu_error("WebGPU: Failed to create surface");
             }
         } else {
-#ifdef __EMSCRIPTEN__
-            EM_ASM({
-                console.log('Failed to create WebGPU instance');
-            });
-#endif
+            webgpu_error("WebGPU: Failed to create instance");
         }
         
         /* Now request WebGPU adapter */
         if (renderer->instance && renderer->surface) {
-            EM_ASM({
-                console.log('WebGPU: Requesting adapter from manual init...');
-            });
-            
-            WGPURequestAdapterOptions adapter_options = {
-                .nextInChain = NULL,
-                .compatibleSurface = renderer->surface,
-                .powerPreference = WGPUPowerPreference_HighPerformance,
-                .forceFallbackAdapter = false,
-            };
-            
-            wgpuInstanceRequestAdapter(renderer->instance, &adapter_options, 
-                                      webgpu_adapter_callback, renderer);
+            webgpu_renderer_request_adapter(renderer);
         }
         
         ecs_modified(g_world, g_renderer, WebGPURenderer);
@@ -1094,11 +1560,7 @@ static void demo_init() {
     /* Create some demo entities */
     demo_create_scene();
     
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('Demo scene created with 5 entities');
-    });
-#endif
+    webgpu_trace("Demo: Scene created");
 }
 
 /**
@@ -1138,23 +1600,16 @@ static void demo_create_scene() {
 /* Deferred main loop setup for safer Emscripten integration */
 static void setup_main_loop_deferred() {
 #ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('Deferred: Setting up main loop');
-    });
-    
     if (!g_world) {
-        EM_ASM({
-            console.error('Deferred: No world available for main loop');
-        });
+        webgpu_error("Deferred: No world available for main loop");
         return;
     }
     
-    /* Set target FPS */
-    ecs_set_target_fps(g_world, 60);
+    /* No target FPS, requestAnimationFrame paces frames. Flecs would sleep
+     * between frames, which blocks the browser's main thread. */
     
     /* Use setTimeout to defer the actual main loop setup */
     EM_ASM({
-        console.log('Deferred: Starting main loop with timeout');
         setTimeout(function() {
             try {
                 Module._setup_emscripten_main_loop();
@@ -1170,16 +1625,90 @@ static void setup_main_loop_deferred() {
 #ifdef __EMSCRIPTEN__
 EMSCRIPTEN_KEEPALIVE
 void setup_emscripten_main_loop() {
-    EM_ASM({
-        console.log('Setting up Emscripten main loop from JavaScript');
-    });
-    
-    /* This is the actual main loop setup */
-    emscripten_set_main_loop(main_loop, 0, 1);
+    webgpu_info("Main loop: Starting");
     
-    EM_ASM({
-        console.log('Main loop setup complete');
-    });
+    /* Called from JavaScript, there is no C stack to keep alive, so the loop
+     * doesn't simulate an infinite loop (which unwinds by throwing) */
+    emscripten_set_main_loop(main_loop, 0, 0);
+}
+
+/**
+ * Bulk entry points for scripts, see webgpu_bulk_create. Pointers are
+ * offsets in the WASM heap (HEAPF32 views for the float arrays, a
+ * BigUint64Array view for entity ids).
+ */
+EMSCRIPTEN_KEEPALIVE
+int32_t flecs_webgpu_create_boxes(int32_t count, const float *transforms, const float *colors,
+                                  const float *dims, int32_t first_slot,
+                                  ecs_entity_t *entities) {
+    return webgpu_bulk_create(g_world, ecs_id(EcsBox), count, transforms, colors,
+        dims, first_slot, entities);
+}
+
+EMSCRIPTEN_KEEPALIVE
+int32_t flecs_webgpu_create_rectangles(int32_t count, const float *transforms, const float *colors,
+                                       const float *dims, int32_t first_slot,
+                                       ecs_entity_t *entities) {
+    return webgpu_bulk_create(g_world, ecs_id(EcsRectangle), count, transforms, colors,
+        dims, first_slot, entities);
+}
+
+EMSCRIPTEN_KEEPALIVE
+void flecs_webgpu_update_entities(const ecs_entity_t *entities, int32_t count,
+                                  const float *transforms, const float *colors) {
+    webgpu_bulk_update(g_world, entities, count, transforms, colors);
+}
+
+EMSCRIPTEN_KEEPALIVE
+void flecs_webgpu_delete_entities(const ecs_entity_t *entities, int32_t count) {
+    webgpu_bulk_delete(g_world, entities, count);
+}
+
+/**
+ * Reserve shared transform slots, returns the array to write them to. Call
+ * it again (and recreate the view) after growing it or the heap.
+ */
+EMSCRIPTEN_KEEPALIVE
+float* flecs_webgpu_shared_transforms(int32_t capacity) {
+    return g_world ? webgpu_shared_transforms_reserve(g_world, capacity) : NULL;
+}
+
+/**
+ * Publish written shared transform slots, only those are applied
+ */
+EMSCRIPTEN_KEEPALIVE
+void flecs_webgpu_shared_transforms_written(int32_t first, int32_t count) {
+    if (g_world) {
+        webgpu_shared_transforms_written(g_world, first, count);
+    }
+}
+
+/**
+ * Moves of the shared transform array so far. A view created at another
+ * generation points at freed memory and must be recreated before writing.
+ */
+EMSCRIPTEN_KEEPALIVE
+uint32_t flecs_webgpu_shared_transforms_generation(void) {
+    return g_world ? webgpu_shared_transforms_generation(g_world) : 0;
+}
+
+/**
+ * Only render frames in which something changed. Pages that draw over the
+ * canvas themselves call flecs_webgpu_invalidate to get a new frame.
+ */
+EMSCRIPTEN_KEEPALIVE
+void flecs_webgpu_set_on_demand(bool on_demand) {
+    WebGPURenderer *renderer = g_world && g_renderer ?
+        ecs_get_mut(g_world, g_renderer, WebGPURenderer) : NULL;
+    if (renderer) {
+        renderer->on_demand = on_demand;
+        renderer->redraw = true;
+    }
+}
+
+EMSCRIPTEN_KEEPALIVE
+void flecs_webgpu_invalidate(void) {
+    webgpu_invalidate(g_world, g_renderer);
 }
 #endif
 
@@ -1187,42 +1716,24 @@ void setup_emscripten_main_loop() {
  * Main application entry point - like tower_defense
  */
 int main() {
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('Main function starting (WebAssembly)');
-    });
-#endif
-    
     /* Initialize the demo */
     demo_init();
     
     if (!g_world) {
-#ifdef __EMSCRIPTEN__
-        EM_ASM({
-            console.error('Failed to initialize engine: no world created');
-        });
-#endif
+        webgpu_error("Failed to initialize engine: no world created");
         return -1;
     }
     
 #ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('Demo initialized successfully, setting up main loop');
-    });
-    
     /* For Emscripten, defer the main loop setup to avoid unwind issues */
     setup_main_loop_deferred();
     
-    EM_ASM({
-        console.log('Main function completed, main loop will start asynchronously');
-    });
-    
     return 0;
 #else
     /* Native application loop */
     ecs_set_target_fps(g_world, 60);
     
-    while (ecs_progress(g_world, 0)) {
+    while (webgpu_progress(g_world, 0)) {
         /* Continue until quit */
     }
     
@@ -1230,4 +1741,6 @@ int main() {
     ecs_fini(g_world);
     return 0;
 #endif
-}
\ No newline at end of file
+}
+
+#endif /* WEBGPU_NO_DEMO */
@@ -5,6 +5,130 @@
 
 #include "../private_api.h"
 
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/* Four lane float vectors for the batch kernels. Without them the batch
+ * kernels are their scalar reference versions. */
+#if defined(__wasm_simd128__)
+#define WEBGPU_SIMD4
+typedef v128_t simd4_t;
+#define simd4_load(p) wasm_v128_load(p)
+#define simd4_store(p, v) wasm_v128_store(p, v)
+#define simd4_set1(s) wasm_f32x4_splat(s)
+#define simd4_set(a, b, c, d) wasm_f32x4_make(a, b, c, d)
+#define simd4_add(a, b) wasm_f32x4_add(a, b)
+#define simd4_mul(a, b) wasm_f32x4_mul(a, b)
+#define simd4_min(a, b) wasm_f32x4_min(a, b)
+#define simd4_max(a, b) wasm_f32x4_max(a, b)
+#define simd4_sqrt(a) wasm_f32x4_sqrt(a)
+
+static inline void simd4_transpose(simd4_t *a, simd4_t *b, simd4_t *c, simd4_t *d) {
+    v128_t ab_lo = wasm_i32x4_shuffle(*a, *b, 0, 4, 1, 5);
+    v128_t cd_lo = wasm_i32x4_shuffle(*c, *d, 0, 4, 1, 5);
+    v128_t ab_hi = wasm_i32x4_shuffle(*a, *b, 2, 6, 3, 7);
+    v128_t cd_hi = wasm_i32x4_shuffle(*c, *d, 2, 6, 3, 7);
+    *a = wasm_i32x4_shuffle(ab_lo, cd_lo, 0, 1, 4, 5);
+    *b = wasm_i32x4_shuffle(ab_lo, cd_lo, 2, 3, 6, 7);
+    *c = wasm_i32x4_shuffle(ab_hi, cd_hi, 0, 1, 4, 5);
+    *d = wasm_i32x4_shuffle(ab_hi, cd_hi, 2, 3, 6, 7);
+}
+
+/* Lanes in [0, 255] to the bytes of a little endian word */
+static inline uint32_t simd4_to_unorm8(simd4_t v) {
+    v128_t words = wasm_i32x4_trunc_sat_f32x4(v);
+    v128_t shorts = wasm_u16x8_narrow_i32x4(words, words);
+    v128_t bytes = wasm_u8x16_narrow_i16x8(shorts, shorts);
+    return (uint32_t)wasm_i32x4_extract_lane(bytes, 0);
+}
+#elif defined(__SSE2__)
+#define WEBGPU_SIMD4
+typedef __m128 simd4_t;
+#define simd4_load(p) _mm_loadu_ps(p)
+#define simd4_store(p, v) _mm_storeu_ps(p, v)
+#define simd4_set1(s) _mm_set1_ps(s)
+#define simd4_set(a, b, c, d) _mm_setr_ps(a, b, c, d)
+#define simd4_add(a, b) _mm_add_ps(a, b)
+#define simd4_mul(a, b) _mm_mul_ps(a, b)
+#define simd4_min(a, b) _mm_min_ps(a, b)
+#define simd4_max(a, b) _mm_max_ps(a, b)
+#define simd4_sqrt(a) _mm_sqrt_ps(a)
+
+static inline void simd4_transpose(simd4_t *a, simd4_t *b, simd4_t *c, simd4_t *d) {
+    _MM_TRANSPOSE4_PS(*a, *b, *c, *d);
+}
+
+static inline uint32_t simd4_to_unorm8(simd4_t v) {
+    __m128i words = _mm_cvttps_epi32(v);
+    __m128i shorts = _mm_packs_epi32(words, words);
+    return (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(shorts, shorts));
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define WEBGPU_SIMD4
+typedef float32x4_t simd4_t;
+#define simd4_load(p) vld1q_f32(p)
+#define simd4_store(p, v) vst1q_f32(p, v)
+#define simd4_set1(s) vdupq_n_f32(s)
+#define simd4_add(a, b) vaddq_f32(a, b)
+#define simd4_mul(a, b) vmulq_f32(a, b)
+#define simd4_min(a, b) vminq_f32(a, b)
+#define simd4_max(a, b) vmaxq_f32(a, b)
+#define simd4_sqrt(a) vsqrtq_f32(a)
+
+static inline simd4_t simd4_set(float a, float b, float c, float d) {
+    const float lanes[4] = {a, b, c, d};
+    return vld1q_f32(lanes);
+}
+
+static inline void simd4_transpose(simd4_t *a, simd4_t *b, simd4_t *c, simd4_t *d) {
+    float64x2_t ab_even = vreinterpretq_f64_f32(vtrn1q_f32(*a, *b));
+    float64x2_t ab_odd = vreinterpretq_f64_f32(vtrn2q_f32(*a, *b));
+    float64x2_t cd_even = vreinterpretq_f64_f32(vtrn1q_f32(*c, *d));
+    float64x2_t cd_odd = vreinterpretq_f64_f32(vtrn2q_f32(*c, *d));
+    *a = vreinterpretq_f32_f64(vtrn1q_f64(ab_even, cd_even));
+    *b = vreinterpretq_f32_f64(vtrn1q_f64(ab_odd, cd_odd));
+    *c = vreinterpretq_f32_f64(vtrn2q_f64(ab_even, cd_even));
+    *d = vreinterpretq_f32_f64(vtrn2q_f64(ab_odd, cd_odd));
+}
+
+static inline uint32_t simd4_to_unorm8(simd4_t v) {
+    uint16x4_t shorts = vmovn_u32(vcvtq_u32_f32(v));
+    uint8x8_t bytes = vmovn_u16(vcombine_u16(shorts, shorts));
+    return vget_lane_u32(vreinterpret_u32_u8(bytes), 0);
+}
+#endif
+
+#if defined(WEBGPU_SIMD4)
+/**
+ * Store four lanes as half floats. WASM SIMD has no half conversion, there
+ * the lanes are converted one at a time.
+ */
+static inline void simd4_store_half(uint16_t *dst, simd4_t v) {
+#if defined(__F16C__)
+    _mm_storel_epi64((__m128i*)dst, _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    vst1_u16(dst, vreinterpret_u16_f16(vcvt_f16_f32(v)));
+#else
+    float lanes[4];
+    simd4_store(lanes, v);
+    for (int k = 0; k < 4; k++) {
+        dst[k] = float_to_half(lanes[k]);
+    }
+#endif
+}
+#endif
+
 /**
  * Set matrix to identity
  */
@@ -58,4 +182,404 @@ void vec3_add(vec3 dst, const vec3 a, const vec3 b) {
     dst[0] = a[0] + b[0];
     dst[1] = a[1] + b[1];
     dst[2] = a[2] + b[2];
-}
\ No newline at end of file
+}
+
+/**
+ * Convert float to IEEE half precision (round to nearest even)
+ */
+uint16_t float_to_half(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t exponent = (bits >> 23) & 0xff;
+    uint32_t mantissa = bits & 0x7fffff;
+    
+    /* NaN and infinity */
+    if (exponent == 0xff) {
+        return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    }
+    
+    int32_t half_exponent = (int32_t)exponent - 127 + 15;
+    
+    /* Overflow saturates to infinity */
+    if (half_exponent >= 0x1f) {
+        return (uint16_t)(sign | 0x7c00);
+    }
+    
+    /* Subnormal or zero */
+    if (half_exponent <= 0) {
+        if (half_exponent < -10) {
+            return (uint16_t)sign;
+        }
+        mantissa |= 0x800000;
+        uint32_t shift = (uint32_t)(14 - half_exponent);
+        uint32_t half_mantissa = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half_mantissa & 1))) {
+            half_mantissa++;
+        }
+        return (uint16_t)(sign | half_mantissa);
+    }
+    
+    uint32_t half = sign | ((uint32_t)half_exponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+        half++; /* May carry into the exponent, which rounds up correctly */
+    }
+    return (uint16_t)half;
+}
+
+/**
+ * Extract normalized frustum planes from a view projection matrix.
+ * Planes follow WebGPU clip space (0 <= z <= w) and point inwards.
+ */
+void webgpu_frustum_from_matrix(webgpu_frustum_t *frustum, mat4 m) {
+    for (int i = 0; i < 3; i++) {
+        for (int c = 0; c < 4; c++) {
+            frustum->planes[i * 2][c] = m[c][3] + m[c][i];
+            frustum->planes[i * 2 + 1][c] = m[c][3] - m[c][i];
+        }
+    }
+    
+    /* Near plane is z >= 0 rather than z >= -w */
+    for (int c = 0; c < 4; c++) {
+        frustum->planes[4][c] = m[c][2];
+    }
+    
+    for (int i = 0; i < 6; i++) {
+        float *p = frustum->planes[i];
+        float length = sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        if (length > 0.0f) {
+            p[0] /= length;
+            p[1] /= length;
+            p[2] /= length;
+            p[3] /= length;
+        }
+    }
+}
+
+/**
+ * Extract the plane that gives the view depth (distance along the view
+ * direction) of a world space point from a right handed view matrix.
+ */
+void webgpu_view_depth_plane(float plane[4], mat4 view) {
+    for (int c = 0; c < 4; c++) {
+        plane[c] = -view[c][2];
+    }
+}
+
+/**
+ * Test four bounding spheres against a frustum.
+ * Returns a mask with bit i set when sphere i is at least partially inside.
+ */
+uint32_t webgpu_frustum_test_spheres4(const webgpu_frustum_t *frustum, 
+                                      const float x[4], 
+                                      const float y[4], 
+                                      const float z[4], 
+                                      const float radius[4]) {
+    uint32_t mask = 0xf;
+    
+#if defined(__wasm_simd128__)
+    v128_t vx = wasm_v128_load(x);
+    v128_t vy = wasm_v128_load(y);
+    v128_t vz = wasm_v128_load(z);
+    v128_t neg_r = wasm_f32x4_neg(wasm_v128_load(radius));
+    for (int i = 0; i < 6 && mask; i++) {
+        const float *p = frustum->planes[i];
+        v128_t d = wasm_f32x4_add(
+            wasm_f32x4_add(wasm_f32x4_mul(vx, wasm_f32x4_splat(p[0])),
+                           wasm_f32x4_mul(vy, wasm_f32x4_splat(p[1]))),
+            wasm_f32x4_add(wasm_f32x4_mul(vz, wasm_f32x4_splat(p[2])),
+                           wasm_f32x4_splat(p[3])));
+        mask &= wasm_i32x4_bitmask(wasm_f32x4_ge(d, neg_r));
+    }
+#elif defined(__SSE__)
+    __m128 vx = _mm_loadu_ps(x);
+    __m128 vy = _mm_loadu_ps(y);
+    __m128 vz = _mm_loadu_ps(z);
+    __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius));
+    for (int i = 0; i < 6 && mask; i++) {
+        const float *p = frustum->planes[i];
+        __m128 d = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(p[0])), _mm_mul_ps(vy, _mm_set1_ps(p[1]))),
+            _mm_add_ps(_mm_mul_ps(vz, _mm_set1_ps(p[2])), _mm_set1_ps(p[3])));
+        mask &= (uint32_t)_mm_movemask_ps(_mm_cmpge_ps(d, neg_r));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    static const uint32_t lane_bits[4] = {1, 2, 4, 8};
+    uint32x4_t bits = vld1q_u32(lane_bits);
+    float32x4_t vx = vld1q_f32(x);
+    float32x4_t vy = vld1q_f32(y);
+    float32x4_t vz = vld1q_f32(z);
+    float32x4_t neg_r = vnegq_f32(vld1q_f32(radius));
+    for (int i = 0; i < 6 && mask; i++) {
+        const float *p = frustum->planes[i];
+        float32x4_t d = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(
+            vdupq_n_f32(p[3]), vx, p[0]), vy, p[1]), vz, p[2]);
+        mask &= vaddvq_u32(vandq_u32(vcgeq_f32(d, neg_r), bits));
+    }
+#else
+    for (int i = 0; i < 6 && mask; i++) {
+        const float *p = frustum->planes[i];
+        for (int j = 0; j < 4; j++) {
+            float d = p[0] * x[j] + p[1] * y[j] + p[2] * z[j] + p[3];
+            if (d < -radius[j]) {
+                mask &= ~(1u << j);
+            }
+        }
+    }
+#endif
+    
+    return mask;
+}
+
+/**
+ * Convert a color channel to unorm8
+ */
+static uint32_t color_to_unorm8(float value) {
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (uint32_t)(value * 255.0f + 0.5f);
+}
+
+/**
+ * Convert a color to rgba8 with opaque alpha
+ */
+uint32_t webgpu_color_rgba8(const EcsRgb *c) {
+    return color_to_unorm8(c->r) | (color_to_unorm8(c->g) << 8) |
+        (color_to_unorm8(c->b) << 16) | (255u << 24);
+}
+
+/*
+ * Batch kernels. Each has a scalar reference version that the SIMD version
+ * must match, which the kernel benchmarks in bench_render check.
+ */
+
+/**
+ * World space bounding spheres of scaled transforms: the center is the
+ * translation, the radius is scaled by the longest axis. The outputs may
+ * alias radius.
+ */
+void webgpu_transform_spheres_scalar(const EcsTransform3 *transforms,
+                                     const float *radius,
+                                     int32_t count,
+                                     float *x,
+                                     float *y,
+                                     float *z,
+                                     float *world_radius) {
+    for (int32_t i = 0; i < count; i++) {
+        const float *m = &transforms[i].value[0][0];
+        float scale_sq = 0.0f;
+        for (int c = 0; c < 3; c++) {
+            const float *axis = &m[c * 4];
+            float len_sq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+            scale_sq = len_sq > scale_sq ? len_sq : scale_sq;
+        }
+        
+        x[i] = m[12];
+        y[i] = m[13];
+        z[i] = m[14];
+        world_radius[i] = radius[i] * sqrtf(scale_sq);
+    }
+}
+
+void webgpu_transform_spheres(const EcsTransform3 *transforms,
+                              const float *radius,
+                              int32_t count,
+                              float *x,
+                              float *y,
+                              float *z,
+                              float *world_radius) {
+    int32_t i = 0;
+    
+#if defined(WEBGPU_SIMD4)
+    /* Transposed columns of four transforms hold one component per lane */
+    for (; i + 4 <= count; i += 4) {
+        const float *m0 = &transforms[i].value[0][0];
+        const float *m1 = &transforms[i + 1].value[0][0];
+        const float *m2 = &transforms[i + 2].value[0][0];
+        const float *m3 = &transforms[i + 3].value[0][0];
+        
+        simd4_t scale_sq = simd4_set1(0.0f);
+        for (int c = 0; c < 3; c++) {
+            simd4_t ax = simd4_load(&m0[c * 4]);
+            simd4_t ay = simd4_load(&m1[c * 4]);
+            simd4_t az = simd4_load(&m2[c * 4]);
+            simd4_t aw = simd4_load(&m3[c * 4]);
+            simd4_transpose(&ax, &ay, &az, &aw);
+            simd4_t len_sq = simd4_add(simd4_add(simd4_mul(ax, ax), simd4_mul(ay, ay)),
+                simd4_mul(az, az));
+            scale_sq = simd4_max(scale_sq, len_sq);
+        }
+        
+        simd4_t tx = simd4_load(&m0[12]);
+        simd4_t ty = simd4_load(&m1[12]);
+        simd4_t tz = simd4_load(&m2[12]);
+        simd4_t tw = simd4_load(&m3[12]);
+        simd4_transpose(&tx, &ty, &tz, &tw);
+        
+        simd4_t r = simd4_mul(simd4_load(&radius[i]), simd4_sqrt(scale_sq));
+        simd4_store(&x[i], tx);
+        simd4_store(&y[i], ty);
+        simd4_store(&z[i], tz);
+        simd4_store(&world_radius[i], r);
+    }
+#endif
+    
+    webgpu_transform_spheres_scalar(&transforms[i], &radius[i], count - i,
+        &x[i], &y[i], &z[i], &world_radius[i]);
+}
+
+/**
+ * Write the full instance matrices of rows, columns 0..2 scaled by the
+ * row's three scales, one record every stride bytes
+ */
+void webgpu_pack_matrices_scalar(uint8_t *dst,
+                                 uint32_t stride,
+                                 const EcsTransform3 *transforms,
+                                 const float *scales,
+                                 const int32_t *rows,
+                                 int32_t count) {
+    for (int32_t i = 0; i < count; i++) {
+        const float *m = &transforms[rows[i]].value[0][0];
+        const float *s = &scales[rows[i] * 3];
+        float out[16];
+        for (int j = 0; j < 4; j++) {
+            out[j] = m[j] * s[0];
+            out[4 + j] = m[4 + j] * s[1];
+            out[8 + j] = m[8 + j] * s[2];
+            out[12 + j] = m[12 + j];
+        }
+        memcpy(dst + (size_t)i * stride, out, sizeof(out));
+    }
+}
+
+void webgpu_pack_matrices(uint8_t *dst,
+                          uint32_t stride,
+                          const EcsTransform3 *transforms,
+                          const float *scales,
+                          const int32_t *rows,
+                          int32_t count) {
+#if defined(WEBGPU_SIMD4)
+    for (int32_t i = 0; i < count; i++) {
+        const float *m = &transforms[rows[i]].value[0][0];
+        const float *s = &scales[rows[i] * 3];
+        float *out = (float*)(dst + (size_t)i * stride);
+        simd4_store(&out[0], simd4_mul(simd4_load(&m[0]), simd4_set1(s[0])));
+        simd4_store(&out[4], simd4_mul(simd4_load(&m[4]), simd4_set1(s[1])));
+        simd4_store(&out[8], simd4_mul(simd4_load(&m[8]), simd4_set1(s[2])));
+        simd4_store(&out[12], simd4_load(&m[12]));
+    }
+#else
+    webgpu_pack_matrices_scalar(dst, stride, transforms, scales, rows, count);
+#endif
+}
+
+/**
+ * Write the three affine rows of the scaled instance matrices of rows as
+ * floats, or as half floats with half set, one record every stride bytes.
+ * The last row is always 0,0,0,1 and isn't written.
+ */
+void webgpu_pack_affine_scalar(uint8_t *dst,
+                               uint32_t stride,
+                               const EcsTransform3 *transforms,
+                               const float *scales,
+                               const int32_t *rows,
+                               int32_t count,
+                               bool half) {
+    for (int32_t i = 0; i < count; i++) {
+        const float *m = &transforms[rows[i]].value[0][0];
+        const float *s = &scales[rows[i] * 3];
+        float out[12];
+        for (int r = 0; r < 3; r++) {
+            out[r * 4 + 0] = m[r] * s[0];
+            out[r * 4 + 1] = m[4 + r] * s[1];
+            out[r * 4 + 2] = m[8 + r] * s[2];
+            out[r * 4 + 3] = m[12 + r];
+        }
+        
+        uint8_t *record = dst + (size_t)i * stride;
+        if (half) {
+            uint16_t halves[12];
+            for (int k = 0; k < 12; k++) {
+                halves[k] = float_to_half(out[k]);
+            }
+            memcpy(record, halves, sizeof(halves));
+        } else {
+            memcpy(record, out, sizeof(out));
+        }
+    }
+}
+
+void webgpu_pack_affine(uint8_t *dst,
+                        uint32_t stride,
+                        const EcsTransform3 *transforms,
+                        const float *scales,
+                        const int32_t *rows,
+                        int32_t count,
+                        bool half) {
+#if defined(WEBGPU_SIMD4)
+    /* Rows of the matrix are the transposed scaled columns */
+    for (int32_t i = 0; i < count; i++) {
+        const float *m = &transforms[rows[i]].value[0][0];
+        const float *s = &scales[rows[i] * 3];
+        simd4_t r0 = simd4_mul(simd4_load(&m[0]), simd4_set1(s[0]));
+        simd4_t r1 = simd4_mul(simd4_load(&m[4]), simd4_set1(s[1]));
+        simd4_t r2 = simd4_mul(simd4_load(&m[8]), simd4_set1(s[2]));
+        simd4_t r3 = simd4_load(&m[12]);
+        simd4_transpose(&r0, &r1, &r2, &r3);
+        
+        uint8_t *record = dst + (size_t)i * stride;
+        if (half) {
+            uint16_t *out = (uint16_t*)record;
+            simd4_store_half(&out[0], r0);
+            simd4_store_half(&out[4], r1);
+            simd4_store_half(&out[8], r2);
+        } else {
+            float *out = (float*)record;
+            simd4_store(&out[0], r0);
+            simd4_store(&out[4], r1);
+            simd4_store(&out[8], r2);
+        }
+    }
+#else
+    webgpu_pack_affine_scalar(dst, stride, transforms, scales, rows, count, half);
+#endif
+}
+
+/**
+ * Write the colors of rows as rgba8 with opaque alpha, one word every
+ * stride bytes
+ */
+void webgpu_pack_rgba8_scalar(uint8_t *dst,
+                              uint32_t stride,
+                              const EcsRgb *colors,
+                              const int32_t *rows,
+                              int32_t count) {
+    for (int32_t i = 0; i < count; i++) {
+        uint32_t rgba = webgpu_color_rgba8(&colors[rows[i]]);
+        memcpy(dst + (size_t)i * stride, &rgba, sizeof(rgba));
+    }
+}
+
+void webgpu_pack_rgba8(uint8_t *dst,
+                       uint32_t stride,
+                       const EcsRgb *colors,
+                       const int32_t *rows,
+                       int32_t count) {
+#if defined(WEBGPU_SIMD4)
+    simd4_t lo = simd4_set1(0.0f);
+    simd4_t hi = simd4_set1(1.0f);
+    simd4_t unorm = simd4_set1(255.0f);
+    simd4_t round = simd4_set1(0.5f);
+    for (int32_t i = 0; i < count; i++) {
+        const EcsRgb *c = &colors[rows[i]];
+        simd4_t v = simd4_min(simd4_max(simd4_set(c->r, c->g, c->b, 1.0f), lo), hi);
+        uint32_t rgba = simd4_to_unorm8(simd4_add(simd4_mul(v, unorm), round));
+        memcpy(dst + (size_t)i * stride, &rgba, sizeof(rgba));
+    }
+#else
+    webgpu_pack_rgba8_scalar(dst, stride, colors, rows, count);
+#endif
+}
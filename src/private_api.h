@@ -29,77 +29,923 @@ typedef struct {
     ecs_id_t geometry_type;           /* Component ID (EcsBox, EcsRectangle, etc.) */
     uint32_t instance_count;          /* Number of instances in this batch */
     
-    /* Component data arrays */
-    EcsTransform3 *transforms;        /* Transform matrices */
-    EcsRgb *colors;                  /* Instance colors */
     void *geometry_data;             /* Geometry-specific data */
     
     /* GPU resources */
     WGPURenderPipeline pipeline;      /* Graphics pipeline */
-    WGPUBindGroup bind_group;        /* Resource bindings */
-    WGPUBuffer vertex_buffer;        /* Static vertex data */
-    WGPUBuffer index_buffer;         /* Static index data */
+    WGPUBindGroup bind_group;        /* Material bind group (group 2) */
+    uint32_t material_offset;        /* Dynamic offset of the material block */
     WGPUBuffer instance_buffer;      /* Instance data */
+    uint64_t instance_offset;        /* Start of the instance records in instance_buffer */
+    uint32_t first_instance;         /* First record in instance_buffer */
+    uint32_t material;               /* Material id in the material cache */
+    bool transparent;                /* Alpha blended, keeps its record order */
+    uint64_t sort_key;               /* Position in the render queue (webgpu_sort_key) */
+    
+    /* Mesh range in the shared mesh registry buffers */
+    int32_t base_vertex;
+    uint32_t first_index;
     uint32_t vertex_count;
     uint32_t index_count;
+    uint32_t index_format;           /* WGPUIndexFormat, selects the index arena */
+    float bounds[4];                 /* Mesh bounding sphere (center, radius) */
+    
+    /* GPU culling */
+    struct WebGPUGeometry *geometry;  /* Owner of the instance data */
+    WGPUBuffer indirect_buffer;       /* Set when the batch draws indirect */
+    uint64_t indirect_offset;         /* Offset of the batch's arguments */
+    WGPUBuffer unculled_buffer;       /* instance_buffer before culling, drawn by other views */
+    uint64_t unculled_offset;
 } webgpu_render_batch_t;
 
-/* Resource management */
+/* Render queue entry: a batch and its sort key. The queue is radix sorted
+ * every frame so consecutive draws share as much state as possible. */
 typedef struct {
-    ecs_allocator_t *allocator;
-    ecs_vec_t buffers;              /* WGPUBuffer pool */
-    ecs_vec_t textures;             /* WGPUTexture pool */
-    ecs_vec_t pipelines;            /* WGPURenderPipeline cache */
-} webgpu_resource_pool_t;
+    uint64_t key;
+    int32_t batch;                    /* Index in render_batches */
+} webgpu_draw_item_t;
+
+/* Instance range of one matched table (archetype), or of a chunk of a large
+ * one, in a geometry's instance buffer. Ranges are repacked only when Flecs
+ * change detection reports the table changed, and uploaded only to ring
+ * slots that hold an older version. */
+typedef struct {
+    const ecs_table_t *table;         /* Table the range was packed from */
+    uint32_t row_offset;              /* First table row of the range */
+    uint32_t rows;                    /* Table rows covered by the range */
+    uint32_t slot_offset;             /* First instance slot in the staging data */
+    uint32_t offset;                  /* First instance in the instance buffer */
+    uint32_t count;                   /* Number of packed (visible) instances */
+    uint32_t lod_counts[WEBGPU_MAX_LODS]; /* Packed instances of each LOD, stored in LOD order */
+    uint32_t packed;                  /* Unculled records in the geometry's packed_data */
+    uint32_t packed_lod_counts[WEBGPU_MAX_LODS]; /* Unculled records of each LOD */
+    uint32_t material;                /* Material id of the table in the material cache */
+    bool transparent;                 /* Drawn in the transparent pass, packed back to front */
+    float center[3];                  /* Mean position of the packed instances */
+    uint32_t mesh_id;                 /* Resident mesh of a streamed geometry, 0 draws nothing */
+    float mesh_radius;                /* Bounding radius of that mesh around its origin */
+    bool local_transforms;            /* Owns position/rotation/scale that are its world transform */
+    uint32_t version;                 /* Bumped whenever the packed data changes */
+    uint32_t uploaded[WEBGPU_FRAMES_IN_FLIGHT]; /* Version in each ring slot */
+    
+    /* Pack job, set by the prepare step */
+    bool dirty;                       /* Repack this frame */
+    bool recull;                      /* Cull the packed records again, the frustum changed */
+    bool has_color;                   /* Table has an EcsRgb (owned or shared) */
+    ecs_entity_t color_source;        /* Entity of a shared color, 0 if owned */
+} webgpu_table_range_t;
+
+/* How the values of a geometry component scale its unit mesh */
+typedef enum {
+    WebGPUDimsXYZ = 0,                /* width, height, depth (EcsBox) */
+    WebGPUDimsXY,                     /* width, height of a mesh flat in z (EcsRectangle) */
+    WebGPUDimsXZ,                     /* width, depth of a mesh flat in y (WebGPUGrid) */
+    WebGPUDimsRadius,                 /* radius (WebGPUSphere) */
+    WebGPUDimsRadiusHeight,           /* radius, height along y (WebGPUCylinder) */
+    WebGPUDimsNone                    /* Meshes are drawn at their own size (WebGPUMesh) */
+} webgpu_geometry_dims_t;
+
+/* Pack job entities, spread over worker threads by a multi_threaded system */
+typedef struct {
+    int32_t index;                    /* Task index in [0, WEBGPU_PACK_TASKS) */
+    ecs_vec_t scratch;                /* Culling and sorting scratch, heap allocated (worker threads) */
+} WebGPUPackTask;
+
+/* View frustum as six inward facing planes (normal xyz, distance w) */
+typedef struct {
+    float planes[6][4];
+} webgpu_frustum_t;
+
+/* View that instances are packed for */
+typedef struct {
+    const webgpu_frustum_t *frustum;  /* Cull instances against, NULL to pack all */
+    float depth_plane[4];             /* View depth of a point (webgpu_view_depth_plane) */
+    float pixel_scale;                /* Projected pixels per world unit at depth 1 */
+} webgpu_pack_view_t;
+
+/* Mesh handle: a range in the shared vertex/index arenas */
+typedef struct {
+    int32_t base_vertex;              /* First vertex in the vertex arena */
+    uint32_t first_index;             /* First index in the index arena */
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t index_format;            /* WGPUIndexFormat_Uint16 or WGPUIndexFormat_Uint32 */
+    bool resident;                    /* All data written, bounds are valid */
+    float bounds[4];                  /* Bounding sphere: center xyz, radius */
+} webgpu_mesh_t;
+
+/* Mesh registry: one vertex and one index buffer shared by all meshes */
+typedef struct webgpu_mesh_registry_t {
+    WGPUBuffer vertex_buffer;         /* Shared vertex arena */
+    WGPUBuffer index_buffer;          /* Shared index arena (uint16) */
+    WGPUBuffer index32_buffer;        /* Index arena of meshes with uint32 indices */
+    uint64_t vertex_capacity;         /* Allocated bytes */
+    uint64_t index_capacity;
+    uint64_t index32_capacity;
+    uint64_t vertex_size;             /* Used bytes */
+    uint64_t index_size;
+    uint64_t index32_size;
+    ecs_vec_t meshes;                 /* webgpu_mesh_t, indexed by mesh id - 1 */
+    struct webgpu_resource_pool_t *resources; /* Receives arenas replaced by a grow */
+} webgpu_mesh_registry_t;
+
+/* Engine mesh file (.fwm): this header, then vertex_count vertices of
+ * WEBGPU_FLOATS_PER_VERTEX floats, then index_count indices of index_size
+ * bytes. Values are little endian, the layout of the mesh arenas. */
+typedef struct {
+    uint32_t magic;                   /* WEBGPU_MESH_FILE_MAGIC */
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t index_size;              /* 2 (uint16) or 4 (uint32) */
+} webgpu_mesh_file_header_t;
+
+/* File read into memory as it arrives. On the web the file is fetched with
+ * a streaming reader, natively it is memory mapped. */
+typedef struct {
+    char *path;                       /* File path, a URL on the web */
+    uint8_t *data;                    /* File contents received so far */
+    uint64_t capacity;                /* Allocated bytes of data (fetched files) */
+    uint64_t received;                /* Bytes of data available */
+    bool mapped;                      /* data is a read-only file mapping */
+    bool done;                        /* All bytes received (or the load failed) */
+    bool failed;                      /* The file could not be read */
+    bool fetching;                    /* A fetch writes into data */
+    bool cancelled;                   /* Closed, freed when the fetch ends */
+} webgpu_file_stream_t;
+
+/* Load state of a streamed mesh */
+typedef enum {
+    WebGPUMeshStreamLoading = 0,      /* Waiting for the file header */
+    WebGPUMeshStreamUploading,        /* Mesh reserved, data uploaded as it arrives */
+    WebGPUMeshStreamResident,
+    WebGPUMeshStreamFailed
+} webgpu_mesh_stream_state_t;
+
+/* File of one WebGPUMesh entity, streamed into the mesh registry */
+typedef struct {
+    ecs_entity_t entity;              /* Mesh entity */
+    webgpu_file_stream_t *file;       /* Open until the mesh is resident */
+    int32_t state;                    /* webgpu_mesh_stream_state_t */
+    uint64_t size;                    /* Expected file size, 0 until known */
+    uint64_t uploaded;                /* Bytes of the file written to the mesh arenas */
+    webgpu_mesh_file_header_t header;
+    uint32_t mesh_id;                 /* Reserved mesh, resident once uploaded */
+    float radius;                     /* Bounding radius around the mesh origin */
+} webgpu_mesh_stream_t;
+
+/* Mesh loader: streams mesh files over several frames within a byte budget */
+typedef struct webgpu_mesh_loader_t {
+    ecs_vec_t streams;                /* webgpu_mesh_stream_t*, indexed by ids */
+    ecs_map_t ids;                    /* Mesh entity -> index in streams */
+    uint32_t loading;                 /* Streams that are not resident yet */
+} webgpu_mesh_loader_t;
+
+/* Texture container (.ktx2) header, followed by the level index */
+typedef struct {
+    uint8_t identifier[12];           /* "\xABKTX 20\xBB\r\n\x1A\n" */
+    uint32_t vk_format;               /* VkFormat, 0 for Basis supercompressed data */
+    uint32_t type_size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t layer_count;
+    uint32_t face_count;
+    uint32_t level_count;             /* 0 asks for a generated mip chain */
+    uint32_t supercompression;        /* 0 none, 1 BasisLZ, 2 zstd, 3 zlib */
+    uint32_t dfd_offset;
+    uint32_t dfd_length;
+    uint32_t kvd_offset;
+    uint32_t kvd_length;
+    uint64_t sgd_offset;
+    uint64_t sgd_length;
+} webgpu_ktx2_header_t;
+
+/* Level index entry of a .ktx2 file, level 0 (the largest) first */
+typedef struct {
+    uint64_t offset;                  /* From the start of the file */
+    uint64_t length;
+    uint64_t uncompressed_length;
+} webgpu_ktx2_level_t;
+
+/* Same-sized textures of one format, as layers of a texture_2d_array.
+ * Materials sampling layers of one array share its bind group. */
+typedef struct {
+    WGPUTextureFormat format;
+    uint32_t width, height;
+    uint32_t mip_levels;
+    bool generate_mips;               /* Mips are rendered from level 0 */
+    uint32_t layers;                  /* Used layers */
+    uint32_t capacity;                /* Allocated layers */
+    WGPUTexture texture;
+    WGPUTextureView view;             /* texture_2d_array view of all layers */
+    uint32_t version;                 /* Bumped when the texture was reallocated */
+} webgpu_texture_array_t;
+
+/* Load state of a WebGPUTexture */
+typedef enum {
+    WebGPUTextureLoading = 0,         /* Waiting for the whole file */
+    WebGPUTextureResident,
+    WebGPUTextureFailed
+} webgpu_texture_state_t;
+
+/* File of one WebGPUTexture entity, uploaded into a layer of an array */
+typedef struct {
+    ecs_entity_t entity;              /* Texture entity */
+    webgpu_file_stream_t *file;       /* Open until the texture is resident */
+    int32_t state;                    /* webgpu_texture_state_t */
+    int32_t array;                    /* Texture array, valid once resident */
+    uint32_t layer;                   /* Layer in that array */
+} webgpu_texture_entry_t;
+
+/* Texture cache: texture arrays and the files loaded into them */
+typedef struct webgpu_texture_cache_t {
+    ecs_vec_t arrays;                 /* webgpu_texture_array_t, array 0 is a white 1x1 */
+    ecs_vec_t textures;               /* webgpu_texture_entry_t*, indexed by ids */
+    ecs_map_t ids;                    /* Texture entity -> index in textures */
+    WGPUSampler sampler;              /* Shared by all materials: linear, repeat, mipmapped */
+    const char *compression;          /* Replaces {format} in texture paths */
+    uint32_t loading;                 /* Textures that are not resident yet */
+    struct webgpu_resource_pool_t *resources; /* Receives arrays replaced by a grow */
+
+    /* Mip generation: renders each level from the one above it */
+    WGPUShaderModule mip_module;
+    WGPUBindGroupLayout mip_layout;
+    WGPURenderPipeline mip_pipelines[2]; /* RGBA8Unorm, RGBA8UnormSrgb */
+    WGPUSampler mip_sampler;
+} webgpu_texture_cache_t;
+
+/* View uniform block and the camera state it was computed from */
+typedef struct {
+    EcsCamera camera;                 /* Source of the last upload */
+    uint32_t width, height;           /* Canvas size of the last upload */
+    bool valid;                       /* Uploaded at least once */
+    mat4 view;                        /* CPU copy of the uploaded matrices */
+    mat4 projection;
+    mat4 view_projection;
+} webgpu_view_uniform_t;
 
-/* Shader cache entry */
+/* Light uniform block source state */
+typedef struct {
+    EcsDirectionalLight light;        /* Source of the last upload */
+    EcsRgb ambient;
+    bool valid;
+} webgpu_light_state_t;
+
+/* Uniform ring: view blocks followed by light blocks, shadow cascade camera
+ * blocks and the shadow block in one buffer, bound with dynamic offsets.
+ * Blocks are only written when their source changes. */
+typedef struct webgpu_uniforms_t {
+    WGPUBuffer buffer;
+    webgpu_view_uniform_t views[WEBGPU_MAX_VIEWS];
+    webgpu_light_state_t lights[WEBGPU_MAX_LIGHTS];
+    uint32_t writes;                  /* Blocks written this frame */
+} webgpu_uniforms_t;
+
+/* Shadow uniform block, must match Shadows in the geometry shader. The
+ * shader's arrays hold WEBGPU_MAX_SHADOW_CASCADES (4) entries. */
+typedef struct {
+    float view_projection[WEBGPU_MAX_SHADOW_CASCADES][16];
+    float tiles[WEBGPU_MAX_SHADOW_CASCADES][4]; /* Atlas uv scale and offset of each cascade */
+    float splits[WEBGPU_MAX_SHADOW_CASCADES]; /* Far view depth of each cascade */
+    float view_plane[4];              /* View depth plane of the renderer's camera */
+    uint32_t cascades;                /* Cascades in use, 0 until there is a camera */
+    float bias;
+    float texel_size[2];              /* Atlas texel in uv */
+} webgpu_shadow_uniform_t;
+
+/* Cascaded shadow maps of the directional light. The view depth up to the
+ * shadow distance is split into cascades, each fitted with an orthographic
+ * camera along the light and drawn into a tile of one depth atlas from the
+ * render target pool. Cascade cameras are blocks of the uniform ring, GPU
+ * culling culls every cascade into its own indirect arguments and visible
+ * records. */
+typedef struct webgpu_shadows_t {
+    uint32_t cascades;                /* Cascades drawn, 2 to WEBGPU_MAX_SHADOW_CASCADES */
+    webgpu_shadow_uniform_t uniform;  /* Source of the last upload */
+    bool valid;                       /* Uploaded at least once */
+    WGPUSampler sampler;              /* Comparison sampler of the atlas */
+    WGPUTextureView atlas_view;       /* Atlas the light bind group was created with */
+    WGPUBindGroup empty_group;        /* Unused groups of the storage caster layout */
+    bool culled;                      /* Cascades have culled draw arguments this frame */
+    uint64_t args_stride;             /* Bytes between the argument blocks of two cascades */
+} webgpu_shadows_t;
+
+/* Readback slot of the timestamp ring */
+typedef enum {
+    WebGPUReadbackFree = 0,
+    WebGPUReadbackCopied,             /* Copy encoded, map after submit */
+    WebGPUReadbackMapping             /* wgpuBufferMapAsync in flight */
+} webgpu_readback_state_t;
+
+typedef struct {
+    WGPUBuffer buffer;                /* MapRead | CopyDst */
+    webgpu_readback_state_t state;
+    uint32_t pass_mask;               /* Passes with timestamps in this slot */
+    struct webgpu_profiler_t *profiler;
+} webgpu_readback_slot_t;
+
+/* GPU profiler: two timestamps per pass, resolved into a ring of readback
+ * buffers that are mapped asynchronously so the CPU never waits. */
+typedef struct webgpu_profiler_t {
+    WGPUQuerySet query_set;           /* 2 * WebGPUPassCount timestamps */
+    WGPUBuffer resolve_buffer;        /* QueryResolve | CopySrc */
+    webgpu_readback_slot_t slots[WEBGPU_FRAMES_IN_FLIGHT];
+    webgpu_readback_slot_t *frame_slot; /* Slot of the frame being recorded, NULL if not timed */
+    uint32_t frame_mask;              /* Passes timed in the frame being recorded */
+    WGPURenderPassTimestampWrites render_writes;
+    WGPUComputePassTimestampWrites compute_writes;
+    float pass_ms[WebGPUPassCount];   /* Last resolved results */
+    int32_t mapping;                  /* Slots with a map in flight */
+    bool destroyed;                   /* Freed by the last map callback */
+} webgpu_profiler_t;
+
+/* Pooled render target. Targets are reused while their key (size, format,
+ * sample count, usage) is requested every frame, and destroyed once unused
+ * for longer than the frames that may still be in flight. */
+typedef struct {
+    WGPUTexture texture;
+    WGPUTextureView view;
+    uint32_t width, height;
+    WGPUTextureFormat format;
+    uint32_t samples;
+    WGPUTextureUsage usage;
+    uint64_t last_used;               /* Pool frame the target was last acquired in */
+} webgpu_render_target_t;
+
+typedef struct webgpu_render_target_pool_t {
+    ecs_vec_t targets;                /* webgpu_render_target_t */
+    uint64_t frame;                   /* Advanced by webgpu_render_target_pool_begin */
+    struct webgpu_resource_pool_t *resources; /* Receives evicted targets */
+} webgpu_render_target_pool_t;
+
+/* Attachments of the main pass for one frame, the size of the back buffer.
+ * The pass draws into the back buffer, or resolves into it. */
+typedef struct {
+    WGPUTextureView color;            /* Color attachment */
+    WGPUTextureView resolve;          /* Resolve target of a multisampled color, else NULL */
+    WGPUTextureView depth;            /* NULL if the depth target could not be created */
+    uint32_t width, height;           /* Back buffer size */
+    uint32_t samples;                 /* Sample count of color and depth */
+    bool depth_sampled;               /* Depth has TextureBinding usage, read by the HiZ pass */
+} webgpu_frame_targets_t;
+
+#define WEBGPU_GRAPH_MAX_PASSES 32
+#define WEBGPU_GRAPH_MAX_RESOURCES 32 /* Bits of a pass's reads and writes */
+
+/* Kinds of frame graph resources */
+typedef enum {
+    WebGPUGraphTexture,
+    WebGPUGraphBuffer
+} webgpu_graph_resource_kind_t;
+
+/* Resource of the frame graph. Imported resources are owned outside the
+ * graph (back buffers, persistent buffers), transient ones are created by
+ * the graph for the passes between their first and last use and share a
+ * target or buffer with transients of the same description whose lifetimes
+ * don't overlap. */
+typedef struct {
+    const char *name;
+    webgpu_graph_resource_kind_t kind;
+    bool imported;
+    bool output;                      /* Used after the frame, keeps its writers */
+    uint32_t width, height;           /* Transient textures */
+    WGPUTextureFormat format;
+    uint32_t samples;
+    uint32_t usage;                   /* WGPUTextureUsage or WGPUBufferUsage */
+    uint64_t size;                    /* Transient buffers */
+    WGPUTexture texture;              /* Set by the import or by the compile */
+    WGPUTextureView view;
+    WebGPUBufferBlock block;          /* Imported buffers */
+    int32_t first, last;              /* Execution order of the first and last use */
+    int32_t physical;                 /* Shared target or buffer of a transient */
+} webgpu_graph_resource_t;
+
+typedef void (*webgpu_graph_execute_t)(
+    struct WebGPURenderer *renderer,
+    WGPUCommandEncoder encoder,
+    void *ctx);
+
+/* Pass of the frame graph. reads and writes are bitsets of resources; a
+ * history read sees the contents of the previous frame, so it doesn't
+ * order the pass after the resource's writers. */
 typedef struct {
     const char *name;
-    WGPUShaderModule vertex_module;
-    WGPUShaderModule fragment_module;
+    webgpu_graph_execute_t execute;
+    void *ctx;
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t history;
+    bool side_effects;                /* Kept even if nothing reads its writes */
+    bool culled;                      /* Set by the compile */
+} webgpu_graph_pass_t;
+
+/* Frame graph: passes declare the resources they read and write, the
+ * compile orders them, drops the passes whose writes are never used and
+ * aliases transients, and the execute records the frame into one command
+ * buffer and submits it once. Rebuilt every frame. */
+typedef struct webgpu_frame_graph_t {
+    webgpu_graph_pass_t passes[WEBGPU_GRAPH_MAX_PASSES];
+    webgpu_graph_resource_t resources[WEBGPU_GRAPH_MAX_RESOURCES];
+    int32_t order[WEBGPU_GRAPH_MAX_PASSES]; /* Passes that run, in execution order */
+    int32_t pass_count;
+    int32_t resource_count;
+    int32_t order_count;
+    int32_t physical_count;           /* Targets and buffers backing the transients */
+    WebGPUBufferBlock buffers[WEBGPU_GRAPH_MAX_RESOURCES]; /* Physical transient buffers */
+    struct webgpu_resource_pool_t *pool; /* Transient buffers are allocated from it */
+    bool compiled;
+} webgpu_frame_graph_t;
+
+/* Hierarchical depth of the previous frame, for occlusion culling. Level 0
+ * is half the drawn region, each texel holds the farthest depth of the 2x2
+ * texels below it. The cull pass projects instances with the camera of that
+ * frame, so the test doesn't depend on this frame's size or camera. */
+#define WEBGPU_HIZ_MAX_LEVELS 16
+#define WEBGPU_HIZ_WORKGROUP_SIZE 8   /* Must match @workgroup_size in the HiZ shader */
+
+typedef struct webgpu_hiz_t {
+    WGPUTexture texture;              /* R32Float pyramid, NULL until the first build */
+    WGPUTextureView view;             /* All levels, read by the cull pass */
+    WGPUTextureView level_views[WEBGPU_HIZ_MAX_LEVELS];
+    WGPUBindGroup level_groups[WEBGPU_HIZ_MAX_LEVELS]; /* Level i - 1 into level i */
+    uint32_t width, height;           /* Size of level 0 */
+    uint32_t levels;
+    WGPUTexture empty_texture;        /* Bound in place of the pyramid while it's not valid */
+    WGPUTextureView empty_view;
+    WGPUShaderModule module;          /* Created with the first build */
+    WGPUBindGroupLayout depth_layout;
+    WGPUBindGroupLayout reduce_layout;
+    WGPUComputePipeline depth_pipeline;
+    WGPUComputePipeline reduce_pipeline;
+    bool valid;                       /* Pyramid holds the depth of frame */
+    bool msaa_warned;
+    uint32_t frame;                   /* Renderer frame the pyramid was built in */
+    uint32_t region[2];               /* Drawn region of that frame, in depth texels */
+    mat4 view_projection;             /* Camera of that frame */
+    vec3 camera_position;
+    struct webgpu_resource_pool_t *resources; /* Replaced pyramids are released to */
+} webgpu_hiz_t;
+
+/* Everything a batch's draw records, in the order a render bundle sets it.
+ * Zeroed before it's filled, so states compare with memcmp. */
+typedef struct {
     WGPURenderPipeline pipeline;
+    WGPUBindGroup camera;             /* Group 0, at camera_offset */
+    uint32_t camera_offset;
+    WGPUBindGroup light;              /* Group 1, at light_offset */
+    uint32_t light_offset;
+    WGPUBindGroup material;           /* Group 2, at material_offset */
+    uint32_t material_offset;
+    WGPUBindGroup instance_group;     /* Group 3 with storage instancing, else NULL */
+    WGPUBuffer instance_buffer;       /* Vertex buffer 1 without storage instancing */
+    uint64_t instance_offset;
+    WGPUBuffer vertex_buffer;         /* Vertex buffer 0, the mesh registry vertices */
+    WGPUBuffer index_buffer;
+    uint32_t index_format;
+    uint32_t index_count;
+    uint32_t instance_count;
+    uint32_t first_index;
+    int32_t base_vertex;
+    uint32_t first_instance;
+    WGPUBuffer indirect_buffer;       /* Draws indirect when set */
+    uint64_t indirect_offset;
+    uint32_t color_format;            /* Attachments of the pass the bundle runs in */
+    uint32_t depth_format;
+    uint32_t samples;
+} webgpu_bundle_state_t;
+
+/* Cached bundle of one batch. Batches are rebuilt every frame, entries are
+ * found again by a key of what identifies a batch (geometry, material, mesh,
+ * ring slot). */
+typedef struct {
+    uint64_t key;
+    webgpu_bundle_state_t state;      /* State the batch drew with when last used */
+    WGPURenderBundle bundle;          /* Recorded once the same state was drawn twice */
+    uint32_t frame;                   /* Last frame the entry was used */
+} webgpu_bundle_entry_t;
+
+/* Render bundle cache. A batch that draws with the same state as the last
+ * frame that used its ring slot is replayed from a bundle; batches that
+ * changed are drawn directly, so per frame changes don't re-record bundles
+ * every frame. Entries unused for WEBGPU_BUNDLE_EVICT_FRAMES are evicted. */
+#define WEBGPU_BUNDLE_EVICT_FRAMES (2 * WEBGPU_FRAMES_IN_FLIGHT)
+
+typedef struct webgpu_bundle_cache_t {
+    ecs_vec_t entries;                /* webgpu_bundle_entry_t* */
+    ecs_map_t keys;                   /* Batch key -> webgpu_bundle_entry_t* */
+    ecs_vec_t replay;                 /* WGPURenderBundle, queued bundles not yet executed */
+    uint32_t frame;                   /* Frame of the last begin */
+    uint32_t recorded;                /* Bundles recorded this frame */
+    uint32_t replayed;                /* Batches replayed from bundles this frame */
+    struct webgpu_resource_pool_t *resources; /* Replaced bundles are released to */
+} webgpu_bundle_cache_t;
+
+/* Shared instance storage: the records of every geometry in one storage
+ * buffer per ring slot, drawn with firstInstance. GPU culling compacts into
+ * the visible buffer at the same record offsets, and into one shadow buffer
+ * per shadow cascade. With gpu_transforms the
+ * ring slots hold position/rotation/scale records, which are expanded into
+ * the expanded buffer that batches draw from. Bind groups are cached per
+ * buffer and recreated after a buffer grew. */
+#define WEBGPU_INSTANCE_STORAGE_VISIBLE WEBGPU_FRAMES_IN_FLIGHT
+#define WEBGPU_INSTANCE_STORAGE_EXPANDED (WEBGPU_FRAMES_IN_FLIGHT + 1)
+#define WEBGPU_INSTANCE_STORAGE_SHADOW (WEBGPU_FRAMES_IN_FLIGHT + 2)  /* First cascade */
+#define WEBGPU_INSTANCE_STORAGE_BLOCKS (WEBGPU_FRAMES_IN_FLIGHT + 2 + WEBGPU_MAX_SHADOW_CASCADES)
+
+typedef struct webgpu_instance_storage_t {
+    WebGPUBufferBlock blocks[WEBGPU_INSTANCE_STORAGE_BLOCKS]; /* Ring slots, visible, expanded, shadow */
+    bool reallocated[WEBGPU_INSTANCE_STORAGE_BLOCKS]; /* Grown by the last reserve */
+    WGPUBindGroup bind_groups[WEBGPU_INSTANCE_STORAGE_BLOCKS]; /* NULL until used or after growing */
+    struct webgpu_resource_pool_t *resources; /* Buffers are allocated from and released to */
+} webgpu_instance_storage_t;
+
+/* Expansion of position/rotation/scale records (gpu_transforms) into the
+ * compact records pipelines draw. Records of all geometries are contiguous
+ * in both buffers, so one dispatch expands the records of every geometry
+ * that uploaded this frame. */
+#define WEBGPU_TRANSFORM_WORKGROUP_SIZE 64  /* Must match @workgroup_size in the transform shader */
+
+typedef struct webgpu_transform_expander_t {
+    WGPUBindGroupLayout layout;
+    WGPUComputePipeline pipeline;
+    WGPUBuffer params;                /* Uniforms of the dispatch */
+    WGPUBuffer source;                /* Ring slot block uploaded this frame */
+    uint64_t source_offset;
+    uint32_t first, end;              /* Records to expand this frame, empty if equal */
+} webgpu_transform_expander_t;
+
+/* Material uniform block, must match Material in the geometry shader */
+typedef struct {
+    float base_color[4];
+    float metallic;
+    float roughness;
+    float emissive_factor;
+    uint32_t diffuse_layer;           /* Layer of the diffuse texture in its array */
+} webgpu_material_uniform_t;
+
+/* GPU state of one material entity */
+typedef struct {
+    ecs_entity_t entity;              /* Material entity, 0 for the default material */
+    webgpu_material_uniform_t uniform; /* Source of the last upload */
+    bool valid;                       /* Uploaded at least once */
+} webgpu_material_entry_t;
+
+/* Bind group shared by the materials that sample one texture array */
+typedef struct {
+    WGPUBindGroup bind_group;         /* Group 2 of the geometry pipelines */
+    uint32_t version;                 /* Version of the array it was created for */
+} webgpu_material_bind_group_t;
+
+/* Material cache: ids, uniform blocks and bind groups of material entities.
+ * Ids are stable for the lifetime of the renderer, so they can be baked into
+ * sort keys and instance records. All blocks live in one uniform buffer and
+ * are selected with a dynamic offset; blocks are only written when a
+ * material changed. */
+typedef struct webgpu_material_cache_t {
+    ecs_vec_t entries;                /* webgpu_material_entry_t, indexed by material id */
+    ecs_map_t ids;                    /* Material entity -> material id */
+    WebGPUBufferBlock block;          /* Uniform blocks WEBGPU_UNIFORM_ALIGNMENT apart, by material id */
+    ecs_vec_t bind_groups;            /* webgpu_material_bind_group_t, indexed by texture array */
+    uint32_t writes;                  /* Blocks written this frame */
+    struct webgpu_resource_pool_t *resources; /* Buffer and bind groups are released to */
+    bool full_warned;
+} webgpu_material_cache_t;
+
+/* Kinds of GPU handles released through the resource pool */
+typedef enum {
+    WebGPUReleaseBuffer,
+    WebGPUReleaseTexture,
+    WebGPUReleaseTextureView,
+    WebGPUReleaseBindGroup,
+    WebGPUReleaseRenderPipeline,
+    WebGPUReleaseRenderBundle,
+    WebGPUReleaseBlock              /* Handle is the slab of the block */
+} webgpu_release_kind_t;
+
+/* GPU handle waiting for the frames that may use it to complete */
+typedef struct {
+    void *handle;
+    webgpu_release_kind_t kind;
+    uint32_t frame;                 /* First frame submitted after the release */
+    uint64_t offset;                /* Blocks only */
+    uint64_t size;                  /* Buffers and blocks only */
+    WGPUBufferUsage usage;
+} webgpu_pending_release_t;
+
+/* Slab: one buffer of a usage class carved into blocks of one power of two
+ * size, WEBGPU_SLAB_MIN_ORDER aligned so blocks can be bound at any offset */
+#define WEBGPU_SLAB_SIZE (1024 * 1024)
+#define WEBGPU_SLAB_MIN_ORDER 8     /* 256 bytes, the uniform and storage offset alignment */
+#define WEBGPU_SLAB_MAX_ORDER 18    /* Larger allocations get a dedicated buffer */
+#define WEBGPU_SLAB_WORDS ((WEBGPU_SLAB_SIZE >> WEBGPU_SLAB_MIN_ORDER) / 64)
+
+typedef struct webgpu_slab_t {
+    WGPUBuffer buffer;
+    WebGPUBufferClass buffer_class;
+    uint32_t order;                 /* Blocks are 1 << order bytes */
+    uint32_t block_count;
+    uint32_t used_count;
+    uint32_t frame;                 /* Frame it became empty */
+    uint64_t used[WEBGPU_SLAB_WORDS]; /* Bit per allocated or pending block */
+} webgpu_slab_t;
+
+/* Free buffer kept for reuse */
+typedef struct {
+    WGPUBuffer buffer;
+    uint64_t size;
+    WGPUBufferUsage usage;
+    uint32_t frame;                 /* Frame it was returned to the pool */
+} webgpu_pooled_buffer_t;
+
+/* Submitted-work-done callback of a frame */
+typedef struct {
+    struct webgpu_resource_pool_t *pool;
+    uint32_t frame;
+    bool waiting;
+} webgpu_work_done_t;
+
+/* Resource management: handles released by the renderer are kept until the
+ * GPU finished the frames that may still use them, then freed in bulk.
+ * Released buffers go back to a pool that buffer allocations draw from. */
+typedef struct webgpu_resource_pool_t {
+    ecs_allocator_t *allocator;
+    ecs_vec_t slabs;                /* webgpu_slab_t* */
+    ecs_vec_t buffers;              /* webgpu_pooled_buffer_t, free for reuse */
+    ecs_vec_t pending;              /* webgpu_pending_release_t, in release order */
+    uint64_t pooled_bytes;          /* Size of all buffers in the pool */
+    uint64_t used[WebGPUBufferClassCount]; /* Bytes of live blocks and dedicated buffers */
+    uint64_t committed[WebGPUBufferClassCount]; /* Bytes of slabs and dedicated buffers */
+    uint64_t budget;                /* Committed bytes allowed, 0 for no limit */
+    uint32_t failed;                /* Allocations refused by the budget */
+    bool budget_warned;
+    uint32_t frame;                 /* Frame the next submit belongs to */
+    uint32_t completed;             /* Frames before this one finished on the GPU */
+    webgpu_work_done_t work_done[WEBGPU_FRAMES_IN_FLIGHT + 1];
+    int32_t waiting;                /* Callbacks still to come */
+    int32_t refs;                   /* Geometries holding blocks, besides the renderer */
+    bool destroyed;                 /* Freed once callbacks and refs are gone */
+} webgpu_resource_pool_t;
+
+/* Color blending of a pipeline variant. Alpha blended pipelines test depth
+ * but don't write it, so they must draw after all opaque geometry. */
+typedef enum {
+    WebGPUBlendOpaque = 0,
+    WebGPUBlendAlpha
+} webgpu_blend_mode_t;
+
+/* Geometry shader features, one bit each. Every combination is expanded
+ * from shaders/geometry.wgsl by tools/wgsl_variants.c at build time. */
+typedef enum {
+    WebGPUShaderCompactInstances = 1 << 0, /* Affine mat3x4 + rgba8 instances */
+    WebGPUShaderAlpha = 1 << 1,            /* Output instance alpha */
+    WebGPUShaderStorageInstances = 1 << 2, /* Instances read from a storage buffer */
+    WebGPUShaderShadows = 1 << 3           /* Cascaded shadows of the directional light */
+} webgpu_shader_feature_t;
+
+/* Compiled shader module of one variant */
+typedef struct {
+    uint32_t variant;                 /* webgpu_shader_feature_t flags */
+    WGPUShaderModule module;          /* vs_main and fs_main */
+} webgpu_shader_module_entry_t;
+
+/* Everything that changes a geometry pipeline descriptor. Keys are hashed
+ * and compared bytewise, initialize them with webgpu_pipeline_key_init. */
+typedef struct {
+    WGPUTextureFormat color_format;   /* Render target format */
+    WGPUTextureFormat depth_format;
+    uint32_t blend_mode;              /* webgpu_blend_mode_t */
+    uint32_t cull_mode;               /* WGPUCullMode */
+    uint32_t instance_format;         /* WebGPUInstanceFormat */
+    uint32_t shader_variant;          /* webgpu_shader_feature_t flags */
+    uint32_t sample_count;            /* MSAA samples of the color and depth targets */
+    uint32_t depth_only;              /* Shadow caster: no fragment stage, depth biased */
+} webgpu_pipeline_key_t;
+
+/* Shader cache entry: one compiled pipeline variant */
+typedef struct {
+    uint64_t hash;                    /* Hash of key */
+    webgpu_pipeline_key_t key;
+    WGPURenderPipeline pipeline;      /* NULL until compiled */
+    bool pending;                     /* Async compile in flight */
+    bool failed;                      /* Compile failed, not retried */
+    struct webgpu_pipeline_cache_t *cache; /* Owner, NULL if destroyed while pending */
 } webgpu_shader_cache_entry_t;
 
+/* Pipeline cache: compiled variants and the layouts they share */
+typedef struct webgpu_pipeline_cache_t {
+    WGPUDevice device;
+    WGPUBindGroupLayout camera_layout;
+    WGPUBindGroupLayout light_layout;
+    WGPUBindGroupLayout material_layout; /* Material block, texture array and sampler */
+    WGPUBindGroupLayout instance_layout; /* Read-only instance storage */
+    WGPUPipelineLayout geometry_layout; /* camera + light + material */
+    WGPUPipelineLayout storage_layout; /* camera + light + material + instance storage */
+    WGPUBindGroupLayout empty_layout; /* Groups shadow casters don't use (shadows) */
+    WGPUPipelineLayout caster_layout; /* camera (shadows) */
+    WGPUPipelineLayout caster_storage_layout; /* camera + empty + empty + instance storage (shadows) */
+    ecs_vec_t entries;                /* webgpu_shader_cache_entry_t*, at most WEBGPU_SHADER_CACHE_SIZE */
+    ecs_vec_t modules;                /* webgpu_shader_module_entry_t, compiled once per variant */
+    bool full_warned;
+} webgpu_pipeline_cache_t;
+
 /* Forward declarations */
 struct WebGPURenderer;
 struct WebGPUGeometry;
 
+/* Components and entities defined by the module (main.c) */
+extern ECS_COMPONENT_DECLARE(WebGPURenderer);
+extern ECS_COMPONENT_DECLARE(WebGPUQuery);
+extern ECS_COMPONENT_DECLARE(WebGPUMaterial);
+extern ECS_COMPONENT_DECLARE(WebGPUGeometry);
+extern ECS_COMPONENT_DECLARE(WebGPUPackTask);
+extern ECS_DECLARE(WebGPUBoxGeometry);
+extern ECS_DECLARE(WebGPURectangleGeometry);
+extern ECS_DECLARE(WebGPUSphereGeometry);
+extern ECS_DECLARE(WebGPUCylinderGeometry);
+extern ECS_DECLARE(WebGPUGridGeometry);
+extern ECS_DECLARE(WebGPUMeshGeometry);
+
 /* Internal API functions */
 
 /* Geometry management */
 void webgpu_geometry_import(ecs_world_t *world);
 void webgpu_init_box_geometry(ecs_world_t *world, struct WebGPUGeometry *geometry);
 void webgpu_init_rectangle_geometry(ecs_world_t *world, struct WebGPUGeometry *geometry);
-void webgpu_populate_geometry_buffers(struct WebGPUGeometry *geometry, ecs_query_t *query);
+void webgpu_init_primitive_geometry(ecs_world_t *world, struct WebGPUGeometry *geometry, ecs_id_t component);
+void webgpu_init_mesh_geometry(ecs_world_t *world, struct WebGPUGeometry *geometry);
+bool webgpu_prepare_geometry_instances(struct WebGPUGeometry *geometry, ecs_query_t *query, const webgpu_pack_view_t *view, webgpu_material_cache_t *materials, webgpu_mesh_loader_t *meshes);
+void webgpu_pack_geometry_instances(const ecs_world_t *world, struct WebGPUGeometry *geometry, int32_t task, int32_t task_count, ecs_vec_t *scratch);
+void webgpu_finish_geometry_instances(struct WebGPUGeometry *geometry);
+uint32_t webgpu_upload_geometry_mesh(struct WebGPURenderer *renderer, struct WebGPUGeometry *geometry);
+
+/* Procedural meshes of unit size, vertices are WEBGPU_BYTES_PER_VERTEX */
+void webgpu_generate_sphere(ecs_vec_t *vertices, ecs_vec_t *indices, uint32_t segments, uint32_t rings);
+void webgpu_generate_cylinder(ecs_vec_t *vertices, ecs_vec_t *indices, uint32_t segments);
+void webgpu_generate_grid(ecs_vec_t *vertices, ecs_vec_t *indices, uint32_t cells);
+
+/* Mesh registry */
+webgpu_mesh_registry_t* webgpu_mesh_registry_create(webgpu_resource_pool_t *resources);
+void webgpu_mesh_registry_destroy(webgpu_mesh_registry_t *registry);
+uint32_t webgpu_mesh_registry_add(webgpu_mesh_registry_t *registry, WGPUDevice device, WGPUQueue queue, const float *vertices, uint32_t vertex_count, const uint16_t *indices, uint32_t index_count);
+uint32_t webgpu_mesh_registry_reserve(webgpu_mesh_registry_t *registry, WGPUDevice device, WGPUQueue queue, uint32_t vertex_count, uint32_t index_count, WGPUIndexFormat index_format);
+bool webgpu_mesh_registry_write(webgpu_mesh_registry_t *registry, WGPUQueue queue, uint32_t mesh_id, uint64_t offset, const void *data, size_t size);
+void webgpu_mesh_registry_finish(webgpu_mesh_registry_t *registry, uint32_t mesh_id, const float *vertices);
+const webgpu_mesh_t* webgpu_mesh_registry_get(const webgpu_mesh_registry_t *registry, uint32_t mesh_id);
+WGPUBuffer webgpu_mesh_registry_index_buffer(const webgpu_mesh_registry_t *registry, WGPUIndexFormat index_format);
+
+/* Mesh loader */
+webgpu_mesh_loader_t* webgpu_mesh_loader_create(void);
+void webgpu_mesh_loader_destroy(webgpu_mesh_loader_t *loader);
+uint32_t webgpu_mesh_loader_get(webgpu_mesh_loader_t *loader, const ecs_world_t *world, ecs_entity_t mesh, float *radius);
+uint64_t webgpu_mesh_loader_update(webgpu_mesh_loader_t *loader, webgpu_mesh_registry_t *registry, WGPUDevice device, WGPUQueue queue, uint64_t budget);
+
+/* File streams */
+webgpu_file_stream_t* webgpu_file_stream_open(const char *path);
+void webgpu_file_stream_close(webgpu_file_stream_t *stream);
+
+/* Texture cache */
+webgpu_texture_cache_t* webgpu_texture_cache_create(WGPUDevice device, WGPUQueue queue, webgpu_resource_pool_t *resources);
+void webgpu_texture_cache_destroy(webgpu_texture_cache_t *cache);
+bool webgpu_texture_cache_get(webgpu_texture_cache_t *cache, const ecs_world_t *world, ecs_entity_t texture, int32_t *array, uint32_t *layer);
+const webgpu_texture_array_t* webgpu_texture_cache_array(const webgpu_texture_cache_t *cache, int32_t array);
+uint64_t webgpu_texture_cache_update(webgpu_texture_cache_t *cache, WGPUDevice device, WGPUQueue queue, uint64_t budget);
 
 /* Material system */
 void webgpu_material_import(ecs_world_t *world);
-void webgpu_create_default_material(ecs_world_t *world, struct WebGPUMaterial *material);
+uint64_t webgpu_material_group(ecs_world_t *world, ecs_table_t *table, ecs_id_t id, void *ctx);
+webgpu_material_cache_t* webgpu_material_cache_create(webgpu_resource_pool_t *resources);
+void webgpu_material_cache_destroy(webgpu_material_cache_t *cache);
+uint32_t webgpu_material_cache_id(webgpu_material_cache_t *cache, ecs_entity_t material);
+WGPUBindGroup webgpu_material_cache_bind_group(webgpu_material_cache_t *cache, const ecs_world_t *world, WGPUDevice device, WGPUQueue queue, WGPUBindGroupLayout layout, webgpu_texture_cache_t *textures, uint32_t id, uint32_t *offset);
+bool webgpu_material_cache_changed(const webgpu_material_cache_t *cache, const ecs_world_t *world, webgpu_texture_cache_t *textures);
 
 /* Rendering pipeline */
+void webgpu_prepare_instances(ecs_iter_t *it);
+void webgpu_pack_instances(ecs_iter_t *it);
+void webgpu_apply_shared_transforms(ecs_iter_t *it);
 void webgpu_gather_geometry_batches(ecs_world_t *world, struct WebGPURenderer *renderer, ecs_query_t *query);
-void webgpu_execute_render_batches(struct WebGPURenderer *renderer, WGPURenderPassEncoder render_pass);
+void webgpu_execute_render_batches(struct WebGPURenderer *renderer, WGPURenderPassEncoder render_pass, uint32_t view, const webgpu_frame_targets_t *targets);
+void webgpu_render_queue_sort(ecs_allocator_t *allocator, ecs_vec_t *queue, ecs_vec_t *scratch);
+
+/* Instance storage */
+webgpu_instance_storage_t* webgpu_instance_storage_create(webgpu_resource_pool_t *resources);
+void webgpu_instance_storage_destroy(webgpu_instance_storage_t *storage);
+const WebGPUBufferBlock* webgpu_instance_storage_reserve(webgpu_instance_storage_t *storage, WGPUDevice device, int32_t index, uint64_t size);
+WGPUBindGroup webgpu_instance_storage_bind_group(webgpu_instance_storage_t *storage, WGPUDevice device, WGPUBindGroupLayout layout, WGPUBuffer buffer, uint64_t offset);
+
+/* GPU culling */
+void webgpu_cull_render_batches(struct WebGPURenderer *renderer, WGPUCommandEncoder encoder);
+
+/* GPU transforms */
+webgpu_transform_expander_t* webgpu_transform_expander_create(WGPUDevice device);
+void webgpu_transform_expander_destroy(webgpu_transform_expander_t *expander);
+WGPUBuffer webgpu_transform_expander_add(struct WebGPURenderer *renderer, struct WebGPUGeometry *geometry, bool uploaded);
+void webgpu_expand_transforms(struct WebGPURenderer *renderer, WGPUCommandEncoder encoder);
+
+/* Shadows */
+webgpu_shadows_t* webgpu_shadows_create(WGPUDevice device, uint32_t cascades);
+void webgpu_shadows_destroy(webgpu_shadows_t *shadows);
+void webgpu_update_shadows(struct WebGPURenderer *renderer);
+const WebGPUBufferBlock* webgpu_shadow_visible_block(struct WebGPURenderer *renderer, struct WebGPUGeometry *geometry, uint32_t cascade);
+void webgpu_shadow_atlas_size(const struct WebGPURenderer *renderer, uint32_t *width, uint32_t *height);
+void webgpu_render_shadows(struct WebGPURenderer *renderer, WGPUCommandEncoder encoder, WGPUTextureView atlas);
 
 /* Resource management */
 webgpu_resource_pool_t* webgpu_create_resource_pool(ecs_allocator_t *allocator);
 void webgpu_destroy_resource_pool(webgpu_resource_pool_t *pool);
+void webgpu_resource_pool_begin(webgpu_resource_pool_t *pool);
+void webgpu_resource_pool_submitted(webgpu_resource_pool_t *pool, WGPUQueue queue, uint32_t frame);
+void webgpu_resource_pool_keep(webgpu_resource_pool_t *pool);
+void webgpu_resource_pool_drop(webgpu_resource_pool_t *pool);
+bool webgpu_buffer_alloc(webgpu_resource_pool_t *pool, WGPUDevice device, uint64_t size, WGPUBufferUsage usage, WebGPUBufferBlock *block);
+void webgpu_buffer_free(webgpu_resource_pool_t *pool, WebGPUBufferBlock *block);
+WGPUBuffer webgpu_resource_pool_buffer(webgpu_resource_pool_t *pool, WGPUDevice device, uint64_t size, WGPUBufferUsage usage);
+void webgpu_release_buffer(webgpu_resource_pool_t *pool, WGPUBuffer buffer, uint64_t size, WGPUBufferUsage usage);
+void webgpu_release_texture(webgpu_resource_pool_t *pool, WGPUTexture texture);
+void webgpu_release_texture_view(webgpu_resource_pool_t *pool, WGPUTextureView view);
+void webgpu_release_bind_group(webgpu_resource_pool_t *pool, WGPUBindGroup bind_group);
+void webgpu_release_render_pipeline(webgpu_resource_pool_t *pool, WGPURenderPipeline pipeline);
+void webgpu_release_render_bundle(webgpu_resource_pool_t *pool, WGPURenderBundle bundle);
 WGPUBuffer webgpu_create_buffer(WGPUDevice device, size_t size, WGPUBufferUsage usage, const void *data);
 void webgpu_update_buffer(WGPUDevice device, WGPUQueue queue, WGPUBuffer buffer, const void *data, size_t size, size_t offset);
+bool webgpu_ensure_buffer_capacity(WGPUDevice device, webgpu_resource_pool_t *pool, WebGPUBufferBlock *block, uint64_t size, WGPUBufferUsage usage);
 WGPUTexture webgpu_create_texture_2d(WGPUDevice device, uint32_t width, uint32_t height, WGPUTextureFormat format);
+WGPUTexture webgpu_create_texture_array(WGPUDevice device, uint32_t width, uint32_t height, uint32_t layers, uint32_t mip_levels, WGPUTextureFormat format, WGPUTextureUsage usage);
+WGPUTexture webgpu_create_color_target(WGPUDevice device, uint32_t width, uint32_t height, WGPUTextureFormat format);
 WGPUTexture webgpu_create_depth_texture(WGPUDevice device, uint32_t width, uint32_t height);
 WGPUTextureView webgpu_create_depth_texture_view(WGPUTexture depth_texture);
-WGPURenderPipeline webgpu_create_geometry_pipeline(WGPUDevice device, WGPUShaderModule vertex_shader, WGPUShaderModule fragment_shader);
-WGPUBuffer webgpu_create_camera_uniform_buffer(WGPUDevice device);
-WGPUBuffer webgpu_create_light_uniform_buffer(WGPUDevice device);
+WGPURenderPipeline webgpu_create_geometry_pipeline(WGPUDevice device, WGPUPipelineLayout layout, WGPUShaderModule vertex_shader, WGPUShaderModule fragment_shader, const webgpu_pipeline_key_t *key, WGPUCreateRenderPipelineAsyncCallback callback, void *userdata);
 WGPUBindGroup webgpu_create_camera_bind_group(WGPUDevice device, WGPUBindGroupLayout layout, WGPUBuffer uniform_buffer);
 WGPUBindGroup webgpu_create_light_bind_group(WGPUDevice device, WGPUBindGroupLayout layout, WGPUBuffer uniform_buffer);
 
+/* Render targets */
+webgpu_render_target_pool_t* webgpu_render_target_pool_create(webgpu_resource_pool_t *resources);
+void webgpu_render_target_pool_destroy(webgpu_render_target_pool_t *pool);
+void webgpu_render_target_pool_begin(webgpu_render_target_pool_t *pool);
+WGPUTextureView webgpu_render_target_acquire(webgpu_render_target_pool_t *pool, WGPUDevice device, uint32_t width, uint32_t height, WGPUTextureFormat format, uint32_t samples, WGPUTextureUsage usage, WGPUTexture *texture);
+uint32_t webgpu_target_bucket(uint32_t size);
+bool webgpu_frame_targets_acquire(struct WebGPURenderer *renderer, WGPUTexture back_buffer, WGPUTextureView back_buffer_view, webgpu_frame_targets_t *targets);
+
+/* Frame graph */
+webgpu_frame_graph_t* webgpu_frame_graph_create(webgpu_resource_pool_t *resources);
+void webgpu_frame_graph_destroy(webgpu_frame_graph_t *graph);
+void webgpu_frame_graph_begin(webgpu_frame_graph_t *graph);
+int32_t webgpu_frame_graph_import_texture(webgpu_frame_graph_t *graph, const char *name, WGPUTexture texture, WGPUTextureView view);
+int32_t webgpu_frame_graph_import_buffer(webgpu_frame_graph_t *graph, const char *name, WGPUBuffer buffer);
+int32_t webgpu_frame_graph_texture(webgpu_frame_graph_t *graph, const char *name, uint32_t width, uint32_t height, WGPUTextureFormat format, uint32_t samples, WGPUTextureUsage usage);
+int32_t webgpu_frame_graph_buffer(webgpu_frame_graph_t *graph, const char *name, uint64_t size, WGPUBufferUsage usage);
+void webgpu_frame_graph_output(webgpu_frame_graph_t *graph, int32_t resource);
+int32_t webgpu_frame_graph_pass(webgpu_frame_graph_t *graph, const char *name, webgpu_graph_execute_t execute, void *ctx);
+void webgpu_frame_graph_read(webgpu_frame_graph_t *graph, int32_t pass, int32_t resource);
+void webgpu_frame_graph_read_history(webgpu_frame_graph_t *graph, int32_t pass, int32_t resource);
+void webgpu_frame_graph_write(webgpu_frame_graph_t *graph, int32_t pass, int32_t resource);
+void webgpu_frame_graph_side_effects(webgpu_frame_graph_t *graph, int32_t pass);
+bool webgpu_frame_graph_compile(struct WebGPURenderer *renderer, webgpu_frame_graph_t *graph);
+WGPUTextureView webgpu_frame_graph_view(const webgpu_frame_graph_t *graph, int32_t resource);
+const WebGPUBufferBlock* webgpu_frame_graph_block(const webgpu_frame_graph_t *graph, int32_t resource);
+bool webgpu_frame_graph_execute(struct WebGPURenderer *renderer, webgpu_frame_graph_t *graph);
+
+/* Occlusion culling */
+webgpu_hiz_t* webgpu_hiz_create(WGPUDevice device, webgpu_resource_pool_t *resources);
+void webgpu_hiz_destroy(webgpu_hiz_t *hiz);
+void webgpu_hiz_build(struct WebGPURenderer *renderer, WGPUCommandEncoder encoder, const webgpu_frame_targets_t *targets);
+bool webgpu_hiz_usable(const webgpu_hiz_t *hiz, const struct WebGPURenderer *renderer);
+WGPUTextureView webgpu_hiz_view(const webgpu_hiz_t *hiz, const struct WebGPURenderer *renderer);
+
+/* Render bundles */
+webgpu_bundle_cache_t* webgpu_bundle_cache_create(webgpu_resource_pool_t *resources);
+void webgpu_bundle_cache_destroy(webgpu_bundle_cache_t *cache);
+void webgpu_bundle_cache_begin(webgpu_bundle_cache_t *cache, uint32_t frame);
+uint64_t webgpu_bundle_key(const webgpu_render_batch_t *batch, uint32_t slot);
+bool webgpu_bundle_cache_draw(webgpu_bundle_cache_t *cache, WGPUDevice device, uint64_t key, const webgpu_bundle_state_t *state);
+bool webgpu_bundle_cache_execute(webgpu_bundle_cache_t *cache, WGPURenderPassEncoder render_pass);
+
+/* Camera and light uniforms */
+webgpu_uniforms_t* webgpu_uniforms_create(WGPUDevice device);
+void webgpu_uniforms_destroy(webgpu_uniforms_t *uniforms);
+const webgpu_view_uniform_t* webgpu_uniforms_get_view(const webgpu_uniforms_t *uniforms, uint32_t index);
+void webgpu_update_uniforms(ecs_iter_t *it);
+
+/* Pipeline cache */
+webgpu_pipeline_cache_t* webgpu_pipeline_cache_create(WGPUDevice device, bool shadows);
+void webgpu_pipeline_cache_destroy(webgpu_pipeline_cache_t *cache);
+void webgpu_pipeline_key_init(webgpu_pipeline_key_t *key, const struct WebGPURenderer *renderer);
+void webgpu_pipeline_key_transparent(webgpu_pipeline_key_t *key);
+void webgpu_pipeline_key_shadow_caster(webgpu_pipeline_key_t *key);
+WGPURenderPipeline webgpu_pipeline_cache_get(webgpu_pipeline_cache_t *cache, const webgpu_pipeline_key_t *key, uint32_t *id);
+
 /* Shader utilities */
 WGPUShaderModule webgpu_create_shader_module(WGPUDevice device, const char *wgsl_source);
 
 /* Shader sources (embedded) */
-extern const char *basic_vertex_shader_source;
-extern const char *basic_fragment_shader_source;
+extern const char *cull_compute_shader_source;
+extern const char *mip_shader_source;
+extern const char *hiz_shader_source;
+extern const char *transform_shader_source;
+
+/* Geometry shader permutations (generated shader_variants.c) */
+extern const uint32_t webgpu_shader_variant_count;
+extern const char *webgpu_shader_variant_sources[];
 
 /* Math utilities */
 void mat4_identity(mat4 m);
@@ -109,6 +955,22 @@ void mat4_scale(mat4 m, float x, float y, float z);
 void mat4_perspective(mat4 m, float fov, float aspect, float near, float far);
 void vec3_copy(vec3 dst, const vec3 src);
 void vec3_add(vec3 dst, const vec3 a, const vec3 b);
+uint16_t float_to_half(float value);
+void webgpu_frustum_from_matrix(webgpu_frustum_t *frustum, mat4 view_projection);
+void webgpu_view_depth_plane(float plane[4], mat4 view);
+uint32_t webgpu_frustum_test_spheres4(const webgpu_frustum_t *frustum, const float x[4], const float y[4], const float z[4], const float radius[4]);
+uint32_t webgpu_color_rgba8(const EcsRgb *c);
+
+/* Batch kernels, SIMD where available. The _scalar versions are the
+ * reference the SIMD versions must match. Scales are three floats per row. */
+void webgpu_transform_spheres(const EcsTransform3 *transforms, const float *radius, int32_t count, float *x, float *y, float *z, float *world_radius);
+void webgpu_transform_spheres_scalar(const EcsTransform3 *transforms, const float *radius, int32_t count, float *x, float *y, float *z, float *world_radius);
+void webgpu_pack_matrices(uint8_t *dst, uint32_t stride, const EcsTransform3 *transforms, const float *scales, const int32_t *rows, int32_t count);
+void webgpu_pack_matrices_scalar(uint8_t *dst, uint32_t stride, const EcsTransform3 *transforms, const float *scales, const int32_t *rows, int32_t count);
+void webgpu_pack_affine(uint8_t *dst, uint32_t stride, const EcsTransform3 *transforms, const float *scales, const int32_t *rows, int32_t count, bool half);
+void webgpu_pack_affine_scalar(uint8_t *dst, uint32_t stride, const EcsTransform3 *transforms, const float *scales, const int32_t *rows, int32_t count, bool half);
+void webgpu_pack_rgba8(uint8_t *dst, uint32_t stride, const EcsRgb *colors, const int32_t *rows, int32_t count);
+void webgpu_pack_rgba8_scalar(uint8_t *dst, uint32_t stride, const EcsRgb *colors, const int32_t *rows, int32_t count);
 
 /* Platform-specific helpers */
 #ifdef WEBGPU_BACKEND_EMSCRIPTEN
@@ -116,18 +978,218 @@ void webgpu_setup_canvas_resize_callback(ecs_entity_t canvas_entity);
 void webgpu_update_canvas_size(ecs_world_t *world, ecs_entity_t canvas_entity);
 #endif
 
+/* Renderer setup */
+void webgpu_renderer_init(ecs_world_t *world, struct WebGPURenderer *renderer, ecs_entity_t canvas_entity, uint32_t width, uint32_t height);
+void webgpu_renderer_request_adapter(struct WebGPURenderer *renderer);
+
 /* Debug and profiling */
-#ifdef WEBGPU_BACKEND_EMSCRIPTEN
-void webgpu_profile_frame_start(const char* frame_name);
-void webgpu_profile_frame_end(const char* frame_name);
+webgpu_profiler_t* webgpu_profiler_create(WGPUDevice device);
+void webgpu_profiler_destroy(webgpu_profiler_t *profiler);
+void webgpu_profile_frame_start(struct WebGPURenderer *renderer);
+void webgpu_profile_frame_end(struct WebGPURenderer *renderer, WGPUCommandEncoder encoder);
+const WGPURenderPassTimestampWrites* webgpu_profile_render_pass(struct WebGPURenderer *renderer, WebGPUPass pass);
+const WGPUComputePassTimestampWrites* webgpu_profile_compute_pass(struct WebGPURenderer *renderer, WebGPUPass pass);
+void webgpu_publish_frame_stats(ecs_world_t *world, const struct WebGPURenderer *renderer, bool skipped);
+
+/* Frame pacing */
+bool webgpu_frame_needed(const ecs_world_t *world, struct WebGPURenderer *renderer);
+
+/* Tracing. Events are logged and recorded in the trace ring; levels above
+ * WEBGPU_TRACE_LEVEL expand to nothing, arguments included. */
+#if WEBGPU_TRACE_LEVEL > WEBGPU_TRACE_OFF
+void webgpu_trace_(int32_t level, const char *file, int32_t line, const char *fmt, ...);
+void webgpu_trace_set_frame(uint32_t frame);
 #else
-#define webgpu_profile_frame_start(name) do {} while(0)
-#define webgpu_profile_frame_end(name) do {} while(0)
+#define webgpu_trace_set_frame(frame) ((void)0)
+#endif
+
+#if WEBGPU_TRACE_LEVEL >= WEBGPU_TRACE_ERROR
+#define webgpu_error(...) webgpu_trace_(WEBGPU_TRACE_ERROR, __FILE__, __LINE__, __VA_ARGS__)
+#else
+#define webgpu_error(...) ((void)0)
+#endif
+
+#if WEBGPU_TRACE_LEVEL >= WEBGPU_TRACE_INFO
+#define webgpu_info(...) webgpu_trace_(WEBGPU_TRACE_INFO, __FILE__, __LINE__, __VA_ARGS__)
+#else
+#define webgpu_info(...) ((void)0)
+#endif
+
+#if WEBGPU_TRACE_LEVEL >= WEBGPU_TRACE_TRACE
+#define webgpu_trace(...) webgpu_trace_(WEBGPU_TRACE_TRACE, __FILE__, __LINE__, __VA_ARGS__)
+#else
+#define webgpu_trace(...) ((void)0)
 #endif
 
 /* Constants */
-#define WEBGPU_BYTES_PER_VERTEX (3 * sizeof(float))  /* Position only for now */
+#define WEBGPU_FLOATS_PER_VERTEX 8  /* position(3) + normal(3) + uv(2) */
+#define WEBGPU_BYTES_PER_VERTEX (WEBGPU_FLOATS_PER_VERTEX * sizeof(float))
+#define WEBGPU_DEPTH_FORMAT WGPUTextureFormat_Depth24Plus
+#define WEBGPU_TARGET_BUCKET 128  /* Surfaces of a resize round up to multiples of this */
+#define WEBGPU_RESIZE_DEBOUNCE_FRAMES 8  /* Frames without size change that end a resize */
 #define WEBGPU_BYTES_PER_INSTANCE (16 * sizeof(float) + 3 * sizeof(float))  /* mat4 + rgb */
+#define WEBGPU_BYTES_PER_INSTANCE_COMPACT (12 * sizeof(float) + sizeof(uint32_t))  /* mat3x4 + rgba8 */
+#define WEBGPU_BYTES_PER_INSTANCE_HALF (12 * sizeof(uint16_t) + sizeof(uint32_t))  /* mat3x4 f16 + rgba8 */
+#define WEBGPU_BYTES_PER_INSTANCE_TRS (3 * sizeof(float) + 6 * sizeof(uint16_t) + sizeof(uint32_t))  /* position + f16 euler and scale + rgba8 */
+#define WEBGPU_BYTES_PER_STORAGE_TAG sizeof(uint32_t)  /* mesh id (16) + material index (16) */
+#define WEBGPU_MIN_INSTANCE_BUFFER_SIZE (64 * WEBGPU_BYTES_PER_INSTANCE)  /* First ring slot allocation */
+#define WEBGPU_MESH_ARENA_MIN_SIZE (64 * 1024)  /* First mesh arena allocation (bytes) */
+#define WEBGPU_BUFFER_POOL_BYTES (64 * 1024 * 1024)  /* Free buffer bytes kept for reuse */
+#define WEBGPU_BUFFER_POOL_FRAMES 120  /* Frames a free buffer or empty slab is kept */
+#define WEBGPU_MESH_FILE_MAGIC 0x314D5746  /* "FWM1" in a little endian mesh file */
+#define WEBGPU_PACK_TASKS 16  /* Pack jobs the instance ranges are spread over */
+#define WEBGPU_PACK_CHUNK_ROWS 4096  /* Large tables are split into ranges of this size */
+#define WEBGPU_LOD_HYSTERESIS 0.15f  /* Relative size margin before an instance switches LOD */
+#define WEBGPU_CULL_WORKGROUP_SIZE 64  /* Must match @workgroup_size in the cull shader */
+#define WEBGPU_UNIFORM_ALIGNMENT 256  /* minUniformBufferOffsetAlignment default */
+#define WEBGPU_MAX_TEXTURE_LAYERS 256  /* maxTextureArrayLayers default */
+#define WEBGPU_CAMERA_UNIFORM_SIZE (3 * sizeof(mat4))  /* view, projection, view_projection */
+#define WEBGPU_LIGHT_UNIFORM_SIZE 40  /* Light struct in the shader */
+#define WEBGPU_SHADOW_UNIFORM_SIZE sizeof(webgpu_shadow_uniform_t)  /* Shadows struct in the shader */
+#define WEBGPU_SHADOW_SPLIT_LAMBDA 0.75f  /* Blend of logarithmic (1) and even (0) cascade splits */
+#define WEBGPU_SHADOW_DEPTH_BIAS 0.0005f  /* Subtracted from the depth a shadow is tested with */
+#define WEBGPU_MAX_MATERIALS 0xFFFF  /* Material ids fit the sort key and instance tag */
+
+/* Render queue passes, drawn in this order */
+typedef enum {
+    WebGPUQueueOpaque = 0,            /* State sorted, near to far within equal state */
+    WebGPUQueueTransparent = 1        /* Far to near */
+} webgpu_queue_pass_t;
+
+/* Render queue sort key, most significant field first:
+ *   pass (4) | pipeline (12) | material (16) | mesh (16) | depth (16)
+ * Transparent keys put the inverted depth right after the pass, so they
+ * sort back to front before state:
+ *   pass (4) | ~depth (16) | pipeline (12) | material (16) | mesh (16) */
+#define WEBGPU_SORT_PASS_SHIFT 60
+#define WEBGPU_SORT_PIPELINE_SHIFT 48
+#define WEBGPU_SORT_MATERIAL_SHIFT 32
+#define WEBGPU_SORT_MESH_SHIFT 16
+#define WEBGPU_SORT_TRANSPARENT_DEPTH_SHIFT 44
+#define WEBGPU_SORT_TRANSPARENT_PIPELINE_SHIFT 32
+#define WEBGPU_SORT_TRANSPARENT_MATERIAL_SHIFT 16
+
+static inline uint64_t webgpu_sort_key(uint32_t pass, uint32_t pipeline,
+                                       uint32_t material, uint32_t mesh, uint32_t depth) {
+    if (pass == WebGPUQueueTransparent) {
+        return ((uint64_t)(pass & 0xF) << WEBGPU_SORT_PASS_SHIFT) |
+            ((uint64_t)(~depth & 0xFFFF) << WEBGPU_SORT_TRANSPARENT_DEPTH_SHIFT) |
+            ((uint64_t)(pipeline & 0xFFF) << WEBGPU_SORT_TRANSPARENT_PIPELINE_SHIFT) |
+            ((uint64_t)(material & 0xFFFF) << WEBGPU_SORT_TRANSPARENT_MATERIAL_SHIFT) |
+            (uint64_t)(mesh & 0xFFFF);
+    }
+    
+    return ((uint64_t)(pass & 0xF) << WEBGPU_SORT_PASS_SHIFT) |
+        ((uint64_t)(pipeline & 0xFFF) << WEBGPU_SORT_PIPELINE_SHIFT) |
+        ((uint64_t)(material & 0xFFFF) << WEBGPU_SORT_MATERIAL_SHIFT) |
+        ((uint64_t)(mesh & 0xFFFF) << WEBGPU_SORT_MESH_SHIFT) |
+        (uint64_t)(depth & 0xFFFF);
+}
+
+/* Quantize a view depth to 16 bits for sort keys. Keeps the exponent and the
+ * top mantissa bits of the float, so precision is relative to the distance
+ * and the order is preserved. */
+static inline uint32_t webgpu_sort_depth(float depth) {
+    if (!(depth > 0.0f)) {
+        return 0;
+    }
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    return (bits >> 15) & 0xFFFF;
+}
+
+/* View depth of a world space point, for a plane built by webgpu_view_depth_plane */
+static inline float webgpu_view_depth(const float plane[4], const float point[3]) {
+    return plane[0] * point[0] + plane[1] * point[1] + plane[2] * point[2] + plane[3];
+}
+
+/* Finest LOD whose minimum size, scaled by margin, is below a projected size */
+static inline uint32_t webgpu_select_lod(const float *pixels, uint32_t count,
+                                         float size, float margin) {
+    uint32_t lod = 0;
+    while (lod + 1 < count && size < pixels[lod] * margin) {
+        lod++;
+    }
+    return lod;
+}
+
+/* LOD of an instance by its projected diameter. An instance only leaves its
+ * previous LOD (state) once the size is past the threshold by
+ * WEBGPU_LOD_HYSTERESIS, so instances near a threshold don't pop. */
+static inline uint32_t webgpu_select_instance_lod(const float *pixels, uint32_t count,
+                                                  float size, uint8_t *state) {
+    uint32_t lod = webgpu_select_lod(pixels, count, size, 1.0f);
+    uint32_t previous = *state;
+    if (previous < count && previous != lod) {
+        /* Thresholds raised by the margin pick a coarser or equal LOD,
+         * lowered ones a finer or equal LOD. Moving finer takes the raised
+         * thresholds, moving coarser the lowered ones. */
+        uint32_t coarser = webgpu_select_lod(pixels, count, size, 1.0f + WEBGPU_LOD_HYSTERESIS);
+        uint32_t finer = webgpu_select_lod(pixels, count, size, 1.0f - WEBGPU_LOD_HYSTERESIS);
+        lod = coarser < previous ? coarser : (finer > previous ? finer : previous);
+    }
+    *state = (uint8_t)lod;
+    return lod;
+}
+
+/* Offset of a view's camera block in the uniform ring */
+static inline uint32_t webgpu_view_uniform_offset(uint32_t view) {
+    return view * WEBGPU_UNIFORM_ALIGNMENT;
+}
+
+/* Offset of a light block in the uniform ring, after all view blocks */
+static inline uint32_t webgpu_light_uniform_offset(uint32_t light) {
+    return (WEBGPU_MAX_VIEWS + light) * WEBGPU_UNIFORM_ALIGNMENT;
+}
+
+/* Offset of a shadow cascade's camera block, after all light blocks */
+static inline uint32_t webgpu_cascade_uniform_offset(uint32_t cascade) {
+    return (WEBGPU_MAX_VIEWS + WEBGPU_MAX_LIGHTS + cascade) * WEBGPU_UNIFORM_ALIGNMENT;
+}
+
+/* Offset of the shadow block, the last block of the uniform ring */
+static inline uint32_t webgpu_shadow_uniform_offset(void) {
+    return webgpu_cascade_uniform_offset(WEBGPU_MAX_SHADOW_CASCADES);
+}
+
+/* Add the time since start to a CPU stage and restart the measurement */
+static inline void webgpu_stage_time(struct WebGPURenderer *renderer, WebGPUStage stage, ecs_time_t *start) {
+    renderer->stage_ms[stage] += (float)(ecs_time_measure(start) * 1000.0);
+}
+
+/* Bytes per instance record for an instance format */
+static inline uint32_t webgpu_instance_stride(WebGPUInstanceFormat format) {
+    switch (format) {
+    case WebGPUInstanceFormatCompact: return WEBGPU_BYTES_PER_INSTANCE_COMPACT;
+    case WebGPUInstanceFormatCompactHalf: return WEBGPU_BYTES_PER_INSTANCE_HALF;
+    default: return WEBGPU_BYTES_PER_INSTANCE;
+    }
+}
+
+/* Mesh/material word of a storage instance record */
+static inline uint32_t webgpu_storage_tag(uint32_t mesh_id, uint32_t material) {
+    return (mesh_id & 0xFFFF) | (material << 16);
+}
+
+/* Bytes per drawn record of a geometry, storage records end with a tag */
+static inline uint32_t webgpu_geometry_stride(const struct WebGPUGeometry *geometry) {
+    return webgpu_instance_stride(geometry->instance_format) +
+        (geometry->storage_instances ? WEBGPU_BYTES_PER_STORAGE_TAG : 0);
+}
+
+/* Bytes per packed and uploaded record of a geometry, which differ from the
+ * drawn records when they are expanded on the GPU */
+static inline uint32_t webgpu_geometry_upload_stride(const struct WebGPUGeometry *geometry) {
+    return geometry->gpu_transforms ?
+        WEBGPU_BYTES_PER_INSTANCE_TRS + WEBGPU_BYTES_PER_STORAGE_TAG :
+        webgpu_geometry_stride(geometry);
+}
+
+/* Layout of the records pipelines draw, expanded records are compact */
+static inline WebGPUInstanceFormat webgpu_draw_instance_format(const struct WebGPURenderer *renderer) {
+    return renderer->gpu_transforms && renderer->storage_instancing ?
+        WebGPUInstanceFormatCompact : renderer->instance_format;
+}
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,565 @@
+/**
+ * @file rendering/frame_graph.c
+ * @brief Frame graph: passes ordered, culled and aliased by what they access.
+ *
+ * The render system declares the frame every frame: the resources it uses
+ * and the passes that read and write them. A pass that reads a resource
+ * runs after the passes added before it that write it, or after all its
+ * writers if none was added before it, and before the passes added later
+ * that overwrite it. Passes that write the same resource run in the order
+ * they were added. Reads of the previous frame's contents (the HiZ the cull
+ * pass tests against) are history reads, which don't order anything.
+ *
+ * Passes whose writes are neither read by a pass that runs nor outputs of
+ * the frame are dropped, unless they have side effects. Transient textures
+ * and buffers live from their first to their last use; transients of the
+ * same description whose lifetimes don't overlap share one pooled target or
+ * buffer. The frame is recorded into one encoder and submitted once.
+ */
+
+#include "../private_api.h"
+
+/**
+ * Create a frame graph. Transient buffers are allocated from resources.
+ */
+webgpu_frame_graph_t* webgpu_frame_graph_create(webgpu_resource_pool_t *resources) {
+    webgpu_frame_graph_t *graph = ecs_os_calloc_t(webgpu_frame_graph_t);
+    graph->pool = resources;
+    return graph;
+}
+
+/**
+ * Return the transient buffers of the last compile to the resource pool
+ */
+static void release_transients(webgpu_frame_graph_t *graph) {
+    for (int32_t i = 0; i < graph->physical_count; i++) {
+        webgpu_buffer_free(graph->pool, &graph->buffers[i]);
+    }
+    graph->physical_count = 0;
+}
+
+/**
+ * Release the graph. Transient targets belong to the render target pool.
+ */
+void webgpu_frame_graph_destroy(webgpu_frame_graph_t *graph) {
+    if (!graph) {
+        return;
+    }
+
+    release_transients(graph);
+    ecs_os_free(graph);
+}
+
+/**
+ * Start declaring a frame, dropping the passes and resources of the last
+ */
+void webgpu_frame_graph_begin(webgpu_frame_graph_t *graph) {
+    release_transients(graph);
+    graph->pass_count = 0;
+    graph->resource_count = 0;
+    graph->order_count = 0;
+    graph->compiled = false;
+}
+
+/**
+ * Add a resource, -1 if the graph is full
+ */
+static int32_t add_resource(webgpu_frame_graph_t *graph,
+                            const char *name,
+                            webgpu_graph_resource_kind_t kind) {
+    if (graph->resource_count >= WEBGPU_GRAPH_MAX_RESOURCES) {
+        ecs_err("WebGPU: Frame graph can't hold resource %s (max %d)",
+            name, WEBGPU_GRAPH_MAX_RESOURCES);
+        return -1;
+    }
+
+    graph->resources[graph->resource_count] = (webgpu_graph_resource_t){
+        .name = name,
+        .kind = kind,
+        .first = -1,
+        .last = -1,
+        .physical = -1,
+    };
+    return graph->resource_count++;
+}
+
+/**
+ * Import a texture owned outside the graph, such as a back buffer
+ */
+int32_t webgpu_frame_graph_import_texture(webgpu_frame_graph_t *graph,
+                                          const char *name,
+                                          WGPUTexture texture,
+                                          WGPUTextureView view) {
+    int32_t resource = add_resource(graph, name, WebGPUGraphTexture);
+    if (resource >= 0) {
+        graph->resources[resource].imported = true;
+        graph->resources[resource].texture = texture;
+        graph->resources[resource].view = view;
+    }
+    return resource;
+}
+
+/**
+ * Import a buffer owned outside the graph. The buffer may be NULL for state
+ * that is only tracked, like records spread over several buffers.
+ */
+int32_t webgpu_frame_graph_import_buffer(webgpu_frame_graph_t *graph,
+                                         const char *name,
+                                         WGPUBuffer buffer) {
+    int32_t resource = add_resource(graph, name, WebGPUGraphBuffer);
+    if (resource >= 0) {
+        graph->resources[resource].imported = true;
+        graph->resources[resource].block.buffer = buffer;
+    }
+    return resource;
+}
+
+/**
+ * Declare a transient texture, created by the compile if a pass that runs
+ * uses it
+ */
+int32_t webgpu_frame_graph_texture(webgpu_frame_graph_t *graph,
+                                   const char *name,
+                                   uint32_t width,
+                                   uint32_t height,
+                                   WGPUTextureFormat format,
+                                   uint32_t samples,
+                                   WGPUTextureUsage usage) {
+    int32_t resource = add_resource(graph, name, WebGPUGraphTexture);
+    if (resource >= 0) {
+        webgpu_graph_resource_t *texture = &graph->resources[resource];
+        texture->width = width;
+        texture->height = height;
+        texture->format = format;
+        texture->samples = samples ? samples : 1;
+        texture->usage = (uint32_t)usage;
+    }
+    return resource;
+}
+
+/**
+ * Declare a transient buffer, allocated by the compile if a pass that runs
+ * uses it. Contents are undefined until a pass writes them.
+ */
+int32_t webgpu_frame_graph_buffer(webgpu_frame_graph_t *graph,
+                                  const char *name,
+                                  uint64_t size,
+                                  WGPUBufferUsage usage) {
+    int32_t resource = add_resource(graph, name, WebGPUGraphBuffer);
+    if (resource >= 0) {
+        graph->resources[resource].size = size;
+        graph->resources[resource].usage = (uint32_t)usage;
+    }
+    return resource;
+}
+
+/**
+ * Mark a resource as used after the frame, which keeps the passes that
+ * write it
+ */
+void webgpu_frame_graph_output(webgpu_frame_graph_t *graph, int32_t resource) {
+    if (resource >= 0 && resource < graph->resource_count) {
+        graph->resources[resource].output = true;
+    }
+}
+
+/**
+ * Add a pass, -1 if the graph is full. execute records the pass into the
+ * frame's encoder.
+ */
+int32_t webgpu_frame_graph_pass(webgpu_frame_graph_t *graph,
+                                const char *name,
+                                webgpu_graph_execute_t execute,
+                                void *ctx) {
+    if (graph->pass_count >= WEBGPU_GRAPH_MAX_PASSES) {
+        ecs_err("WebGPU: Frame graph can't hold pass %s (max %d)",
+            name, WEBGPU_GRAPH_MAX_PASSES);
+        return -1;
+    }
+
+    graph->passes[graph->pass_count] = (webgpu_graph_pass_t){
+        .name = name,
+        .execute = execute,
+        .ctx = ctx,
+    };
+    return graph->pass_count++;
+}
+
+/**
+ * Bit of a resource in the access sets of a pass, 0 if either is invalid
+ */
+static uint32_t access_bit(const webgpu_frame_graph_t *graph, int32_t pass, int32_t resource) {
+    if (pass < 0 || pass >= graph->pass_count ||
+        resource < 0 || resource >= graph->resource_count) {
+        return 0;
+    }
+    return 1u << resource;
+}
+
+/**
+ * Declare that a pass reads a resource this frame
+ */
+void webgpu_frame_graph_read(webgpu_frame_graph_t *graph, int32_t pass, int32_t resource) {
+    uint32_t bit = access_bit(graph, pass, resource);
+    if (bit) {
+        graph->passes[pass].reads |= bit;
+    }
+}
+
+/**
+ * Declare that a pass reads what a resource held at the end of the previous
+ * frame. Transients don't outlive their frame and can't be read this way.
+ */
+void webgpu_frame_graph_read_history(webgpu_frame_graph_t *graph, int32_t pass, int32_t resource) {
+    uint32_t bit = access_bit(graph, pass, resource);
+    if (!bit) {
+        return;
+    }
+
+    if (!graph->resources[resource].imported) {
+        ecs_err("WebGPU: Frame graph history read of transient %s",
+            graph->resources[resource].name);
+        return;
+    }
+    graph->passes[pass].history |= bit;
+}
+
+/**
+ * Declare that a pass writes a resource
+ */
+void webgpu_frame_graph_write(webgpu_frame_graph_t *graph, int32_t pass, int32_t resource) {
+    uint32_t bit = access_bit(graph, pass, resource);
+    if (bit) {
+        graph->passes[pass].writes |= bit;
+    }
+}
+
+/**
+ * Keep a pass even if nothing reads what it writes, e.g. a pass presenting
+ * to another surface
+ */
+void webgpu_frame_graph_side_effects(webgpu_frame_graph_t *graph, int32_t pass) {
+    if (pass >= 0 && pass < graph->pass_count) {
+        graph->passes[pass].side_effects = true;
+    }
+}
+
+/**
+ * Sort the passes by their dependencies, the earliest added ready pass
+ * first. Returns false if the dependencies form a cycle.
+ */
+static bool sort_passes(webgpu_frame_graph_t *graph, int32_t *sorted) {
+    int32_t count = graph->pass_count;
+    uint32_t depends[WEBGPU_GRAPH_MAX_PASSES] = {0};
+
+    /* Writes in the order passes were added */
+    for (int32_t b = 0; b < count; b++) {
+        for (int32_t a = 0; a < b; a++) {
+            if (graph->passes[b].writes & graph->passes[a].writes) {
+                depends[b] |= 1u << a;
+            }
+        }
+    }
+
+    for (int32_t r = 0; r < graph->resource_count; r++) {
+        uint32_t bit = 1u << r;
+        uint32_t writers = 0;
+        for (int32_t p = 0; p < count; p++) {
+            if (graph->passes[p].writes & bit) {
+                writers |= 1u << p;
+            }
+        }
+
+        for (int32_t b = 0; b < count; b++) {
+            const webgpu_graph_pass_t *reader = &graph->passes[b];
+            if (!(reader->reads & ~reader->writes & bit)) {
+                continue;
+            }
+
+            /* Read after write: a pass reads what the writers added before
+             * it left, or what all writers leave if it was added first */
+            uint32_t before = writers & ((1u << b) - 1);
+            uint32_t sources = before ? before : writers;
+            depends[b] |= sources;
+
+            /* Write after read: later writers overwrite, or alias, what the
+             * reader reads and wait for it */
+            for (int32_t a = b + 1; a < count; a++) {
+                if ((writers & ~sources) & (1u << a)) {
+                    depends[a] |= 1u << b;
+                }
+            }
+        }
+    }
+
+    uint32_t emitted = 0;
+    for (int32_t n = 0; n < count; n++) {
+        int32_t next = -1;
+        for (int32_t p = 0; p < count; p++) {
+            if (!(emitted & (1u << p)) && !(depends[p] & ~emitted)) {
+                next = p;
+                break;
+            }
+        }
+
+        if (next < 0) {
+            for (int32_t p = 0; p < count; p++) {
+                if (!(emitted & (1u << p))) {
+                    ecs_err("WebGPU: Frame graph has a dependency cycle through pass %s",
+                        graph->passes[p].name);
+                    break;
+                }
+            }
+            return false;
+        }
+
+        emitted |= 1u << next;
+        sorted[n] = next;
+    }
+
+    return true;
+}
+
+/**
+ * Mark the passes none of whose writes are used as culled
+ */
+static void cull_passes(webgpu_frame_graph_t *graph) {
+    uint32_t needed = 0;
+    for (int32_t r = 0; r < graph->resource_count; r++) {
+        if (graph->resources[r].output) {
+            needed |= 1u << r;
+        }
+    }
+
+    for (int32_t p = 0; p < graph->pass_count; p++) {
+        graph->passes[p].culled = true;
+    }
+
+    /* History reads may point at later passes, so iterate to a fixpoint */
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int32_t p = 0; p < graph->pass_count; p++) {
+            webgpu_graph_pass_t *pass = &graph->passes[p];
+            if (!pass->culled || (!pass->side_effects && !(pass->writes & needed))) {
+                continue;
+            }
+
+            pass->culled = false;
+            needed |= pass->reads | pass->history;
+            changed = true;
+        }
+    }
+}
+
+/**
+ * Whether a transient can take over the target or buffer of another
+ */
+static bool transient_compatible(const webgpu_graph_resource_t *a,
+                                 const webgpu_graph_resource_t *b) {
+    if (a->kind != b->kind || a->usage != b->usage) {
+        return false;
+    }
+
+    if (a->kind == WebGPUGraphBuffer) {
+        return true;
+    }
+
+    return a->width == b->width && a->height == b->height &&
+        a->format == b->format && a->samples == b->samples;
+}
+
+/**
+ * Assign the transients used by passes that run to shared targets and
+ * buffers, and create those. Returns the number of transients used.
+ */
+static int32_t alias_transients(WebGPURenderer *renderer, webgpu_frame_graph_t *graph) {
+    int32_t owners[WEBGPU_GRAPH_MAX_RESOURCES];
+    int32_t transients = 0;
+
+    /* Assign transients in the order their lifetimes begin */
+    for (int32_t position = 0; position < graph->order_count; position++) {
+        for (int32_t r = 0; r < graph->resource_count; r++) {
+            webgpu_graph_resource_t *resource = &graph->resources[r];
+            if (resource->imported || resource->first != position) {
+                continue;
+            }
+            transients++;
+
+            int32_t physical = -1;
+            for (int32_t i = 0; i < graph->physical_count && physical < 0; i++) {
+                webgpu_graph_resource_t *owner = &graph->resources[owners[i]];
+                if (owner->last < resource->first && transient_compatible(owner, resource)) {
+                    physical = i;
+                }
+            }
+
+            if (physical < 0) {
+                physical = graph->physical_count++;
+            } else {
+                webgpu_graph_resource_t *owner = &graph->resources[owners[physical]];
+                resource->size = resource->size > owner->size ? resource->size : owner->size;
+            }
+
+            /* The latest user holds the lifetime and size of the physical */
+            owners[physical] = r;
+            resource->physical = physical;
+        }
+    }
+
+    for (int32_t i = 0; i < graph->physical_count; i++) {
+        webgpu_graph_resource_t *owner = &graph->resources[owners[i]];
+        graph->buffers[i] = (WebGPUBufferBlock){0};
+        WGPUTexture texture = NULL;
+        WGPUTextureView view = NULL;
+
+        if (owner->kind == WebGPUGraphTexture) {
+            view = webgpu_render_target_acquire(renderer->targets, renderer->device,
+                owner->width, owner->height, owner->format, owner->samples,
+                (WGPUTextureUsage)owner->usage, &texture);
+            if (!view) {
+                ecs_warn("WebGPU: Failed to create frame graph texture %s", owner->name);
+            }
+        } else if (!webgpu_buffer_alloc(renderer->resources, renderer->device, owner->size,
+                (WGPUBufferUsage)owner->usage, &graph->buffers[i])) {
+            ecs_warn("WebGPU: Failed to allocate frame graph buffer %s", owner->name);
+        }
+
+        for (int32_t r = 0; r < graph->resource_count; r++) {
+            webgpu_graph_resource_t *resource = &graph->resources[r];
+            if (!resource->imported && resource->physical == i) {
+                resource->texture = texture;
+                resource->view = view;
+            }
+        }
+    }
+
+    return transients;
+}
+
+/**
+ * Order the passes, drop the unused ones and create the transients. Must be
+ * called after the frame was declared and before it's executed.
+ */
+bool webgpu_frame_graph_compile(WebGPURenderer *renderer, webgpu_frame_graph_t *graph) {
+    release_transients(graph);
+    graph->order_count = 0;
+    graph->compiled = false;
+
+    int32_t sorted[WEBGPU_GRAPH_MAX_PASSES];
+    if (!sort_passes(graph, sorted)) {
+        return false;
+    }
+
+    cull_passes(graph);
+
+    for (int32_t r = 0; r < graph->resource_count; r++) {
+        graph->resources[r].first = graph->resources[r].last = -1;
+        graph->resources[r].physical = -1;
+    }
+
+    for (int32_t i = 0; i < graph->pass_count; i++) {
+        const webgpu_graph_pass_t *pass = &graph->passes[sorted[i]];
+        if (pass->culled) {
+            continue;
+        }
+
+        int32_t position = graph->order_count++;
+        graph->order[position] = sorted[i];
+
+        uint32_t used = pass->reads | pass->writes | pass->history;
+        for (int32_t r = 0; r < graph->resource_count; r++) {
+            if (!(used & (1u << r))) {
+                continue;
+            }
+
+            webgpu_graph_resource_t *resource = &graph->resources[r];
+            if (resource->first < 0) {
+                resource->first = position;
+            }
+            resource->last = position;
+        }
+    }
+
+    int32_t transients = alias_transients(renderer, graph);
+    renderer->passes_recorded = (uint32_t)graph->order_count;
+    renderer->passes_culled = (uint32_t)(graph->pass_count - graph->order_count);
+    renderer->transients_aliased = (uint32_t)(transients - graph->physical_count);
+    graph->compiled = true;
+    return true;
+}
+
+/**
+ * Get the view of a texture resource, NULL for transients that weren't
+ * created
+ */
+WGPUTextureView webgpu_frame_graph_view(const webgpu_frame_graph_t *graph, int32_t resource) {
+    if (resource < 0 || resource >= graph->resource_count) {
+        return NULL;
+    }
+    return graph->resources[resource].view;
+}
+
+/**
+ * Get the block of a buffer resource, NULL for transients that weren't
+ * allocated
+ */
+const WebGPUBufferBlock* webgpu_frame_graph_block(const webgpu_frame_graph_t *graph, int32_t resource) {
+    if (resource < 0 || resource >= graph->resource_count) {
+        return NULL;
+    }
+
+    const webgpu_graph_resource_t *buffer = &graph->resources[resource];
+    if (buffer->imported) {
+        return &buffer->block;
+    }
+
+    if (buffer->physical < 0 || !graph->buffers[buffer->physical].buffer) {
+        return NULL;
+    }
+    return &graph->buffers[buffer->physical];
+}
+
+/**
+ * Record the passes that run into one command buffer and submit it,
+ * resolving the frame's timestamps at the end. Transient buffers go back to
+ * the resource pool, which reuses them once the GPU finished the frame.
+ */
+bool webgpu_frame_graph_execute(WebGPURenderer *renderer, webgpu_frame_graph_t *graph) {
+    if (!graph->compiled) {
+        return false;
+    }
+    graph->compiled = false;
+
+    WGPUCommandEncoderDescriptor encoder_desc = {
+        .label = "WebGPU Frame Command Encoder",
+    };
+    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(renderer->device, &encoder_desc);
+    if (!encoder) {
+        ecs_err("WebGPU: Failed to create frame command encoder");
+        release_transients(graph);
+        return false;
+    }
+
+    for (int32_t i = 0; i < graph->order_count; i++) {
+        const webgpu_graph_pass_t *pass = &graph->passes[graph->order[i]];
+        if (pass->execute) {
+            pass->execute(renderer, encoder, pass->ctx);
+        }
+    }
+    webgpu_profile_frame_end(renderer, encoder);
+
+    WGPUCommandBufferDescriptor cmd_buffer_desc = {
+        .label = "WebGPU Frame Commands",
+    };
+    WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(encoder, &cmd_buffer_desc);
+    wgpuQueueSubmit(renderer->queue, 1, &command_buffer);
+
+    /* Released before the frame is marked submitted, so they wait for it */
+    release_transients(graph);
+    webgpu_resource_pool_submitted(renderer->resources, renderer->queue, renderer->frame_index);
+
+    wgpuCommandBufferRelease(command_buffer);
+    wgpuCommandEncoderRelease(encoder);
+    return true;
+}
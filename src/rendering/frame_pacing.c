@@ -0,0 +1,93 @@
+/**
+ * @file rendering/frame_pacing.c
+ * @brief On-demand rendering and the fixed timestep simulation.
+ *
+ * An on-demand renderer only renders a frame when something it draws
+ * changed: the systems that detect changes for uploads (uniforms, instance
+ * packing, streaming) set the renderer's redraw flag, and materials are
+ * compared against their uniform blocks. Frames without changes acquire no
+ * surface texture and submit nothing, the canvas keeps the last frame.
+ *
+ * The fixed timestep runs the systems of the WebGPUFixedUpdate phase from
+ * their own pipeline, once for every step of elapsed time, before the world
+ * progresses. Simulation state changed by a step is picked up by change
+ * detection like any other change.
+ */
+
+#include "../private_api.h"
+
+/**
+ * Check whether a renderer must render this frame
+ */
+bool webgpu_frame_needed(const ecs_world_t *world, WebGPURenderer *renderer) {
+    if (!renderer->on_demand || renderer->redraw || !renderer->frame_index) {
+        return true;
+    }
+
+    /* The surface is reconfigured by a frame once the size settled */
+    if (renderer->needs_resize) {
+        return true;
+    }
+
+    return webgpu_material_cache_changed(renderer->materials, world, renderer->textures);
+}
+
+/**
+ * Render the next frame of an on-demand renderer
+ */
+void webgpu_invalidate(ecs_world_t *world, ecs_entity_t renderer) {
+    if (!world || !renderer) {
+        return;
+    }
+
+    WebGPURenderer *ptr = ecs_get_mut(world, renderer, WebGPURenderer);
+    if (ptr) {
+        ptr->redraw = true;
+    }
+}
+
+/**
+ * Run the fixed steps of the elapsed time, then progress the world
+ */
+bool webgpu_progress(ecs_world_t *world, ecs_ftime_t delta_time) {
+    const WebGPUFixedTimestep *fixed = ecs_singleton_get(world, WebGPUFixedTimestep);
+    if (!fixed || fixed->step <= 0.0f || !fixed->pipeline) {
+        return ecs_progress(world, delta_time);
+    }
+
+    /* Steps may change the singleton, work on a copy */
+    WebGPUFixedTimestep state = *fixed;
+
+    bool first = !state.time.sec && !state.time.nanosec;
+    float elapsed = (float)ecs_time_measure(&state.time);
+    if (delta_time > 0) {
+        elapsed = (float)delta_time;
+    } else if (first) {
+        elapsed = 0.0f;
+    }
+
+    uint32_t max_steps = state.max_steps ? state.max_steps : WEBGPU_FIXED_MAX_STEPS;
+    state.accumulator += elapsed;
+    state.steps = 0;
+    while (state.accumulator >= state.step && state.steps < max_steps) {
+        ecs_run_pipeline(world, state.pipeline, state.step);
+        state.accumulator -= state.step;
+        state.steps++;
+    }
+
+    /* Time the simulation can't catch up with is dropped, rather than making
+     * every later frame slower */
+    if (state.accumulator >= state.step) {
+        state.accumulator = 0.0f;
+    }
+    state.alpha = state.accumulator / state.step;
+
+    WebGPUFixedTimestep *dst = ecs_singleton_ensure(world, WebGPUFixedTimestep);
+    dst->steps = state.steps;
+    dst->alpha = state.alpha;
+    dst->accumulator = state.accumulator;
+    dst->time = state.time;
+    ecs_singleton_modified(world, WebGPUFixedTimestep);
+
+    return ecs_progress(world, delta_time);
+}
@@ -0,0 +1,462 @@
+/**
+ * @file rendering/gpu_culling.c
+ * @brief GPU frustum culling with indirect draws.
+ *
+ * A compute pass tests every instance of a batch against the camera frustum
+ * and compacts the visible instance records into a per-geometry buffer. The
+ * visible count is written straight into the batch's block of DrawIndexedIndirect
+ * arguments, so batches draw only what is on screen without any CPU readback.
+ *
+ * With occlusion_culling, instances are also tested against the HiZ of the
+ * previous frame. An instance hidden there may have come into view since, so
+ * the test errs towards drawing: spheres grow by the distance the camera
+ * moved, and on frames in which the instances of any geometry were added,
+ * deleted, moved or transformed nothing is tested, since the previous depth
+ * may hold occluders that are no longer there.
+ *
+ * With shadows, every batch is culled once more for each shadow cascade,
+ * against the cascade's camera and without occlusion, into the cascade's
+ * visible block and through its own block of arguments. Cascade argument
+ * blocks follow the camera's, batch_count blocks apart.
+ */
+
+#include "../private_api.h"
+
+/* Uniforms of the cull shader, must match CullParams */
+typedef struct {
+    float bounds[4];
+    uint32_t instance_count;
+    uint32_t stride_words;
+    uint32_t format;
+    uint32_t first_instance;
+    float occlusion_view_projection[16];
+    float region[2];
+    uint32_t hiz_levels;
+    uint32_t occlusion;
+    float margin;
+    uint32_t padding[3];
+} webgpu_cull_params_t;
+
+/* DrawIndexedIndirect arguments, must match DrawArgs */
+typedef struct {
+    uint32_t index_count;
+    uint32_t instance_count;
+    uint32_t first_index;
+    int32_t base_vertex;
+    uint32_t first_instance;
+} webgpu_draw_indexed_args_t;
+
+/**
+ * Create the culling compute pipeline and its bind group layout
+ */
+static bool create_cull_pipeline(WebGPURenderer *renderer) {
+    WGPUBindGroupLayoutEntry entries[] = {
+        /* Camera */
+        {
+            .binding = 0,
+            .visibility = WGPUShaderStage_Compute,
+            .buffer = {
+                .type = WGPUBufferBindingType_Uniform,
+                .minBindingSize = WEBGPU_CAMERA_UNIFORM_SIZE,
+            },
+        },
+        /* Cull params */
+        {
+            .binding = 1,
+            .visibility = WGPUShaderStage_Compute,
+            .buffer = {
+                .type = WGPUBufferBindingType_Uniform,
+                .minBindingSize = sizeof(webgpu_cull_params_t),
+            },
+        },
+        /* Source instances */
+        {
+            .binding = 2,
+            .visibility = WGPUShaderStage_Compute,
+            .buffer = {
+                .type = WGPUBufferBindingType_ReadOnlyStorage,
+            },
+        },
+        /* Visible instances */
+        {
+            .binding = 3,
+            .visibility = WGPUShaderStage_Compute,
+            .buffer = {
+                .type = WGPUBufferBindingType_Storage,
+            },
+        },
+        /* Draw arguments */
+        {
+            .binding = 4,
+            .visibility = WGPUShaderStage_Compute,
+            .buffer = {
+                .type = WGPUBufferBindingType_Storage,
+                .minBindingSize = sizeof(webgpu_draw_indexed_args_t),
+            },
+        },
+        /* HiZ of the previous frame */
+        {
+            .binding = 5,
+            .visibility = WGPUShaderStage_Compute,
+            .texture = {
+                .sampleType = WGPUTextureSampleType_UnfilterableFloat,
+                .viewDimension = WGPUTextureViewDimension_2D,
+            },
+        }
+    };
+
+    /* Holds the texture bound while there is no HiZ */
+    if (!renderer->hiz) {
+        renderer->hiz = webgpu_hiz_create(renderer->device, renderer->resources);
+    }
+    if (!renderer->hiz) {
+        return false;
+    }
+
+    WGPUBindGroupLayoutDescriptor layout_desc = {
+        .label = "Cull Bind Group Layout",
+        .entryCount = 6,
+        .entries = entries,
+    };
+
+    renderer->cull_layout = wgpuDeviceCreateBindGroupLayout(renderer->device, &layout_desc);
+    if (!renderer->cull_layout) {
+        ecs_err("WebGPU: Failed to create cull bind group layout");
+        return false;
+    }
+
+    WGPUPipelineLayoutDescriptor pipeline_layout_desc = {
+        .label = "Cull Pipeline Layout",
+        .bindGroupLayoutCount = 1,
+        .bindGroupLayouts = &renderer->cull_layout,
+    };
+
+    WGPUPipelineLayout pipeline_layout = wgpuDeviceCreatePipelineLayout(
+        renderer->device, &pipeline_layout_desc);
+
+    WGPUShaderModule shader = webgpu_create_shader_module(
+        renderer->device, cull_compute_shader_source);
+    if (!shader) {
+        wgpuPipelineLayoutRelease(pipeline_layout);
+        return false;
+    }
+
+    WGPUComputePipelineDescriptor pipeline_desc = {
+        .label = "Frustum Cull Pipeline",
+        .layout = pipeline_layout,
+        .compute = {
+            .module = shader,
+            .entryPoint = "cs_main",
+        },
+    };
+
+    renderer->cull_pipeline = wgpuDeviceCreateComputePipeline(renderer->device, &pipeline_desc);
+
+    wgpuShaderModuleRelease(shader);
+    wgpuPipelineLayoutRelease(pipeline_layout);
+
+    if (!renderer->cull_pipeline) {
+        ecs_err("WebGPU: Failed to create frustum cull pipeline");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Make sure the renderer's argument and parameter blocks hold a slot for
+ * each of count batches
+ */
+static bool ensure_cull_blocks(WebGPURenderer *renderer, int32_t count) {
+    uint64_t size = (uint64_t)count * WEBGPU_UNIFORM_ALIGNMENT;
+
+    if (!webgpu_ensure_buffer_capacity(renderer->device, renderer->resources,
+            &renderer->cull_args, size,
+            WGPUBufferUsage_Indirect | WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst)) {
+        return false;
+    }
+
+    return webgpu_ensure_buffer_capacity(renderer->device, renderer->resources,
+        &renderer->cull_params, size,
+        WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst);
+}
+
+/**
+ * Whether a batch can be culled. Indirect draws with a non-zero first
+ * instance need the indirect-first-instance feature. Transparent batches
+ * are not culled, compaction doesn't keep their back to front order.
+ */
+static bool batch_cullable(WebGPURenderer *renderer, const webgpu_render_batch_t *batch) {
+    if (!batch->geometry || !batch->instance_buffer || !batch->instance_count ||
+        batch->transparent) {
+        return false;
+    }
+
+    if (batch->first_instance && !renderer->indirect_first_instance) {
+        if (!renderer->cull_first_instance_warned) {
+            ecs_warn("WebGPU: Device lacks indirect-first-instance, drawing some batches unculled");
+            renderer->cull_first_instance_warned = true;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Cull one batch against the camera block at camera_offset. Resets the
+ * batch's arguments at args_block, the shader accumulates instance_count.
+ */
+static bool dispatch_cull(WebGPURenderer *renderer,
+                          WGPUComputePassEncoder pass,
+                          const webgpu_render_batch_t *batch,
+                          uint64_t camera_offset,
+                          uint64_t params_block,
+                          uint64_t args_block,
+                          const WebGPUBufferBlock *visible,
+                          WGPUTextureView hiz_view) {
+    /* Blocks are bound from their start, records are indexed from first_instance */
+    uint32_t stride = webgpu_geometry_stride(batch->geometry);
+    uint64_t instance_bytes = (uint64_t)(batch->first_instance + batch->instance_count) * stride;
+    const WebGPUBufferBlock *cull_args = &renderer->cull_args;
+    const WebGPUBufferBlock *cull_params = &renderer->cull_params;
+
+    webgpu_draw_indexed_args_t args = {
+        .index_count = batch->index_count,
+        .first_index = batch->first_index,
+        .base_vertex = batch->base_vertex,
+        .first_instance = batch->first_instance,
+    };
+    wgpuQueueWriteBuffer(renderer->queue, cull_args->buffer, cull_args->offset + args_block,
+        &args, sizeof(args));
+
+    WGPUBindGroupEntry entries[] = {
+        { .binding = 0, .buffer = renderer->uniforms->buffer,
+          .offset = camera_offset, .size = WEBGPU_CAMERA_UNIFORM_SIZE },
+        { .binding = 1, .buffer = cull_params->buffer,
+          .offset = cull_params->offset + params_block, .size = sizeof(webgpu_cull_params_t) },
+        { .binding = 2, .buffer = batch->instance_buffer,
+          .offset = batch->instance_offset, .size = instance_bytes },
+        { .binding = 3, .buffer = visible->buffer,
+          .offset = visible->offset, .size = instance_bytes },
+        { .binding = 4, .buffer = cull_args->buffer,
+          .offset = cull_args->offset + args_block, .size = sizeof(args) },
+        { .binding = 5, .textureView = hiz_view },
+    };
+
+    WGPUBindGroupDescriptor bind_group_desc = {
+        .label = "Cull Bind Group",
+        .layout = renderer->cull_layout,
+        .entryCount = 6,
+        .entries = entries,
+    };
+
+    WGPUBindGroup bind_group = wgpuDeviceCreateBindGroup(renderer->device, &bind_group_desc);
+    if (!bind_group) {
+        ecs_warn("WebGPU: Failed to create cull bind group, drawing unculled");
+        return false;
+    }
+
+    wgpuComputePassEncoderSetBindGroup(pass, 0, bind_group, 0, NULL);
+    wgpuComputePassEncoderDispatchWorkgroups(pass,
+        (batch->instance_count + WEBGPU_CULL_WORKGROUP_SIZE - 1) / WEBGPU_CULL_WORKGROUP_SIZE, 1, 1);
+
+    /* Encoded commands keep the bind group alive */
+    wgpuBindGroupRelease(bind_group);
+    return true;
+}
+
+/**
+ * Make sure each cascade has room for the visible records of the batches.
+ * Returns the number of cascades to cull for, 0 if there is no room.
+ */
+static uint32_t ensure_shadow_visible(WebGPURenderer *renderer,
+                                      uint32_t cascades,
+                                      uint64_t storage_visible_size) {
+    webgpu_instance_storage_t *storage = renderer->instance_storage;
+    webgpu_render_batch_t *batches = ecs_vec_first_t(&renderer->render_batches, webgpu_render_batch_t);
+    int32_t batch_count = ecs_vec_count(&renderer->render_batches);
+
+    for (uint32_t c = 0; c < cascades; c++) {
+        if (storage) {
+            if (storage_visible_size && !webgpu_instance_storage_reserve(storage, renderer->device,
+                    WEBGPU_INSTANCE_STORAGE_SHADOW + (int32_t)c, storage_visible_size)) {
+                ecs_warn("WebGPU: Failed to allocate shadow instance storage, casting unculled");
+                return 0;
+            }
+            continue;
+        }
+
+        for (int32_t i = 0; i < batch_count; i++) {
+            webgpu_render_batch_t *batch = &batches[i];
+            if (!batch_cullable(renderer, batch)) {
+                continue;
+            }
+
+            uint64_t end = (uint64_t)(batch->first_instance + batch->instance_count) *
+                webgpu_geometry_stride(batch->geometry);
+            if (!webgpu_ensure_buffer_capacity(renderer->device, batch->geometry->resources,
+                    &batch->geometry->shadow_visible[c], end,
+                    WGPUBufferUsage_Vertex | WGPUBufferUsage_Storage)) {
+                ecs_warn("WebGPU: Failed to allocate shadow visible buffer, casting unculled");
+                return 0;
+            }
+        }
+    }
+
+    return cascades;
+}
+
+/**
+ * Record the frustum culling compute pass for all batches. Must be called
+ * after the batches are gathered and before the render pass begins. Batches
+ * that were culled draw their visible records through their block of
+ * indirect arguments; batches that could not be culled keep their direct
+ * draw. Visible records keep the first instance they have in the source
+ * buffer, so batches of one geometry compact into disjoint ranges.
+ */
+void webgpu_cull_render_batches(WebGPURenderer *renderer, WGPUCommandEncoder encoder) {
+    webgpu_shadows_t *shadows = renderer->shadows;
+    if (shadows) {
+        shadows->culled = false;
+    }
+
+    if (!renderer->gpu_culling || !renderer->uniforms ||
+        !ecs_vec_count(&renderer->render_batches)) {
+        return;
+    }
+
+    if (!renderer->cull_pipeline && !create_cull_pipeline(renderer)) {
+        /* Don't retry every frame */
+        renderer->gpu_culling = false;
+        return;
+    }
+
+    webgpu_render_batch_t *batches = ecs_vec_first_t(&renderer->render_batches, webgpu_render_batch_t);
+    int32_t batch_count = ecs_vec_count(&renderer->render_batches);
+    uint32_t cascades = shadows ? shadows->uniform.cascades : 0;
+
+    /* Argument blocks for the camera and each cascade, the cascades share
+     * one parameter block */
+    if (!ensure_cull_blocks(renderer, batch_count * (1 + (int32_t)cascades))) {
+        ecs_warn("WebGPU: Failed to allocate cull buffers, drawing unculled");
+        return;
+    }
+
+    /* Size the visible blocks up front, growing one frees the old block */
+    webgpu_instance_storage_t *storage = renderer->instance_storage;
+    uint64_t storage_visible_size = 0;
+
+    /* Occlusion test against the previous frame's HiZ, with its camera */
+    webgpu_hiz_t *hiz = renderer->hiz;
+    bool occlusion = webgpu_hiz_usable(hiz, renderer);
+    const webgpu_view_uniform_t *view = webgpu_uniforms_get_view(renderer->uniforms, 0);
+    occlusion &= view != NULL && !renderer->instances_changed;
+    float margin = occlusion ?
+        glm_vec3_distance((float*)view->camera.position, hiz->camera_position) : 0.0f;
+    for (int32_t i = 0; i < batch_count; i++) {
+        webgpu_render_batch_t *batch = &batches[i];
+        if (!batch_cullable(renderer, batch)) {
+            continue;
+        }
+
+        uint64_t end = (uint64_t)(batch->first_instance + batch->instance_count) *
+            webgpu_geometry_stride(batch->geometry);
+        if (storage) {
+            storage_visible_size = end > storage_visible_size ? end : storage_visible_size;
+        } else if (!webgpu_ensure_buffer_capacity(renderer->device, batch->geometry->resources,
+                &batch->geometry->visible, end,
+                WGPUBufferUsage_Vertex | WGPUBufferUsage_Storage)) {
+            ecs_warn("WebGPU: Failed to allocate visible instance buffer, drawing unculled");
+            return;
+        }
+    }
+
+    const WebGPUBufferBlock *storage_visible = NULL;
+    if (storage && storage_visible_size) {
+        storage_visible = webgpu_instance_storage_reserve(storage, renderer->device,
+            WEBGPU_INSTANCE_STORAGE_VISIBLE, storage_visible_size);
+        if (!storage_visible) {
+            ecs_warn("WebGPU: Failed to allocate visible instance storage, drawing unculled");
+            return;
+        }
+    }
+
+    cascades = ensure_shadow_visible(renderer, cascades, storage_visible_size);
+    uint64_t cascade_stride = (uint64_t)batch_count * WEBGPU_UNIFORM_ALIGNMENT;
+    bool cascades_culled = cascades != 0;
+
+    WGPUComputePassDescriptor pass_desc = {
+        .label = "Frustum Cull Pass",
+        .timestampWrites = webgpu_profile_compute_pass(renderer, WebGPUPassCull),
+    };
+    WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &pass_desc);
+    wgpuComputePassEncoderSetPipeline(pass, renderer->cull_pipeline);
+    WGPUTextureView hiz_view = webgpu_hiz_view(hiz, renderer);
+
+    for (int32_t i = 0; i < batch_count; i++) {
+        webgpu_render_batch_t *batch = &batches[i];
+        if (!batch_cullable(renderer, batch)) {
+            continue;
+        }
+
+        WebGPUGeometry *geometry = batch->geometry;
+        uint64_t block = (uint64_t)i * WEBGPU_UNIFORM_ALIGNMENT;
+        const WebGPUBufferBlock *visible = storage ? storage_visible : &geometry->visible;
+        const WebGPUBufferBlock *cull_params = &renderer->cull_params;
+
+        webgpu_cull_params_t params = {
+            .instance_count = batch->instance_count,
+            .stride_words = webgpu_geometry_stride(geometry) / sizeof(uint32_t),
+            .format = (uint32_t)geometry->instance_format,
+            .first_instance = batch->first_instance,
+            .occlusion = occlusion,
+        };
+        memcpy(params.bounds, batch->bounds, sizeof(params.bounds));
+        if (params.occlusion) {
+            memcpy(params.occlusion_view_projection, hiz->view_projection, sizeof(mat4));
+            params.region[0] = (float)hiz->region[0];
+            params.region[1] = (float)hiz->region[1];
+            params.hiz_levels = hiz->levels;
+            params.margin = margin;
+        }
+        wgpuQueueWriteBuffer(renderer->queue, cull_params->buffer, cull_params->offset + block,
+            &params, sizeof(params));
+
+        if (!dispatch_cull(renderer, pass, batch, webgpu_view_uniform_offset(0),
+                block, block, visible, hiz_view)) {
+            continue;
+        }
+
+        /* The HiZ is of the camera's view, cascades only test their frustum */
+        if (cascades) {
+            uint64_t cascade_params = block + cascade_stride;
+            params.occlusion = 0;
+            wgpuQueueWriteBuffer(renderer->queue, cull_params->buffer,
+                cull_params->offset + cascade_params, &params, sizeof(params));
+        }
+
+        for (uint32_t c = 0; c < cascades; c++) {
+            cascades_culled &= dispatch_cull(renderer, pass, batch,
+                webgpu_cascade_uniform_offset(c), block + cascade_stride,
+                block + (c + 1) * cascade_stride,
+                webgpu_shadow_visible_block(renderer, geometry, c), hiz_view);
+        }
+
+        batch->unculled_buffer = batch->instance_buffer;
+        batch->unculled_offset = batch->instance_offset;
+        batch->instance_buffer = visible->buffer;
+        batch->instance_offset = visible->offset;
+        batch->indirect_buffer = renderer->cull_args.buffer;
+        batch->indirect_offset = renderer->cull_args.offset + block;
+    }
+
+    wgpuComputePassEncoderEnd(pass);
+    wgpuComputePassEncoderRelease(pass);
+
+    /* A cascade that failed to cull casts all records of every batch */
+    if (shadows) {
+        shadows->culled = cascades_culled;
+        shadows->args_stride = cascade_stride;
+    }
+}
@@ -0,0 +1,125 @@
+/**
+ * @file rendering/instance_storage.c
+ * @brief Shared instance storage buffers for storage instancing.
+ *
+ * With storage instancing the records of all geometry types are written to
+ * one storage buffer per ring slot, each geometry at its own first instance.
+ * Shaders index the buffer with @builtin(instance_index), which includes the
+ * draw's firstInstance, so batches only differ in their draw arguments and
+ * the render pass binds the buffer once instead of a vertex buffer per batch.
+ */
+
+#include "../private_api.h"
+
+/**
+ * Create empty instance storage, buffers are allocated from the resource
+ * pool on first reserve
+ */
+webgpu_instance_storage_t* webgpu_instance_storage_create(webgpu_resource_pool_t *resources) {
+    webgpu_instance_storage_t *storage = ecs_os_calloc_t(webgpu_instance_storage_t);
+    storage->resources = resources;
+    return storage;
+}
+
+/**
+ * Release the storage buffers and their bind groups
+ */
+void webgpu_instance_storage_destroy(webgpu_instance_storage_t *storage) {
+    if (!storage) {
+        return;
+    }
+
+    for (int32_t i = 0; i < WEBGPU_INSTANCE_STORAGE_BLOCKS; i++) {
+        if (storage->bind_groups[i]) {
+            wgpuBindGroupRelease(storage->bind_groups[i]);
+        }
+        webgpu_buffer_free(storage->resources, &storage->blocks[i]);
+    }
+
+    ecs_os_free(storage);
+}
+
+/**
+ * Make sure a ring slot (or the visible or expanded buffer) holds at least
+ * size bytes.
+ * A block that had to grow lost its contents, which is flagged in
+ * storage->reallocated until the next reserve of the same index.
+ */
+const WebGPUBufferBlock* webgpu_instance_storage_reserve(webgpu_instance_storage_t *storage,
+                                           WGPUDevice device,
+                                           int32_t index,
+                                           uint64_t size) {
+    if (index < 0 || index >= WEBGPU_INSTANCE_STORAGE_BLOCKS) {
+        ecs_err("webgpu_instance_storage_reserve: Invalid buffer index %d", index);
+        return NULL;
+    }
+
+    /* The visible and expanded buffers are only written by compute shaders */
+    WGPUBufferUsage usage = index >= WEBGPU_INSTANCE_STORAGE_VISIBLE ?
+        WGPUBufferUsage_Storage : WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
+
+    WebGPUBufferBlock *block = &storage->blocks[index];
+    WebGPUBufferBlock previous = *block;
+    if (!webgpu_ensure_buffer_capacity(device, storage->resources, block, size, usage)) {
+        ecs_err("WebGPU: Failed to allocate instance storage (%llu bytes)",
+                (unsigned long long)size);
+        return NULL;
+    }
+
+    storage->reallocated[index] = block->buffer != previous.buffer ||
+        block->offset != previous.offset || block->size != previous.size;
+
+    /* Handles may be reused, so drop the bind group of a grown block */
+    if (storage->reallocated[index] && storage->bind_groups[index]) {
+        webgpu_release_bind_group(storage->resources, storage->bind_groups[index]);
+        storage->bind_groups[index] = NULL;
+    }
+    return block;
+}
+
+/**
+ * Get the bind group for the storage block at buffer and offset. Bind groups
+ * are cached until their block is reallocated by a reserve.
+ */
+WGPUBindGroup webgpu_instance_storage_bind_group(webgpu_instance_storage_t *storage,
+                                                 WGPUDevice device,
+                                                 WGPUBindGroupLayout layout,
+                                                 WGPUBuffer buffer,
+                                                 uint64_t offset) {
+    if (!buffer || !layout) {
+        return NULL;
+    }
+
+    for (int32_t i = 0; i < WEBGPU_INSTANCE_STORAGE_BLOCKS; i++) {
+        const WebGPUBufferBlock *block = &storage->blocks[i];
+        if (block->buffer != buffer || block->offset != offset) {
+            continue;
+        }
+
+        if (storage->bind_groups[i]) {
+            return storage->bind_groups[i];
+        }
+
+        WGPUBindGroupEntry entry = {
+            .binding = 0,
+            .buffer = buffer,
+            .offset = offset,
+            .size = block->size,
+        };
+
+        WGPUBindGroupDescriptor bind_group_desc = {
+            .label = "Instance Storage Bind Group",
+            .layout = layout,
+            .entryCount = 1,
+            .entries = &entry,
+        };
+
+        storage->bind_groups[i] = wgpuDeviceCreateBindGroup(device, &bind_group_desc);
+        if (!storage->bind_groups[i]) {
+            ecs_err("WebGPU: Failed to create instance storage bind group");
+        }
+        return storage->bind_groups[i];
+    }
+
+    return NULL;
+}
@@ -0,0 +1,415 @@
+/**
+ * @file rendering/occlusion.c
+ * @brief Depth pyramid (HiZ) of the previous frame for occlusion culling.
+ *
+ * After the main pass, a compute pass reduces its depth buffer into a
+ * pyramid of R32Float levels that each keep the farthest depth of the
+ * texels below them. The next frame's cull pass projects instance bounds
+ * with the camera the pyramid was built with, picks the level at which the
+ * bounds cover at most 2x2 texels and rejects instances whose nearest depth
+ * is behind all of them.
+ *
+ * The depth must be single sampled to be read, with MSAA the cull pass only
+ * tests the frustum.
+ */
+
+#include "../private_api.h"
+
+/**
+ * Create the HiZ state. The pyramid and its pipelines are created by the
+ * first build, until then the cull pass binds a 1x1 placeholder.
+ */
+webgpu_hiz_t* webgpu_hiz_create(WGPUDevice device, webgpu_resource_pool_t *resources) {
+    webgpu_hiz_t *hiz = ecs_os_calloc_t(webgpu_hiz_t);
+    hiz->resources = resources;
+
+    WGPUTextureDescriptor texture_desc = {
+        .label = "Empty HiZ",
+        .usage = WGPUTextureUsage_TextureBinding,
+        .dimension = WGPUTextureDimension_2D,
+        .size = { .width = 1, .height = 1, .depthOrArrayLayers = 1 },
+        .format = WGPUTextureFormat_R32Float,
+        .mipLevelCount = 1,
+        .sampleCount = 1,
+    };
+
+    hiz->empty_texture = wgpuDeviceCreateTexture(device, &texture_desc);
+    hiz->empty_view = hiz->empty_texture ? wgpuTextureCreateView(hiz->empty_texture, NULL) : NULL;
+    if (!hiz->empty_view) {
+        ecs_err("WebGPU: Failed to create HiZ placeholder texture");
+        webgpu_hiz_destroy(hiz);
+        return NULL;
+    }
+
+    return hiz;
+}
+
+/**
+ * Release the pyramid levels to the resource pool
+ */
+static void hiz_release_pyramid(webgpu_hiz_t *hiz, webgpu_resource_pool_t *resources) {
+    for (uint32_t i = 0; i < hiz->levels; i++) {
+        webgpu_release_bind_group(resources, hiz->level_groups[i]);
+        webgpu_release_texture_view(resources, hiz->level_views[i]);
+    }
+    webgpu_release_texture_view(resources, hiz->view);
+    webgpu_release_texture(resources, hiz->texture);
+
+    ecs_os_memset_n(hiz->level_groups, 0, WGPUBindGroup, WEBGPU_HIZ_MAX_LEVELS);
+    ecs_os_memset_n(hiz->level_views, 0, WGPUTextureView, WEBGPU_HIZ_MAX_LEVELS);
+    hiz->view = NULL;
+    hiz->texture = NULL;
+    hiz->levels = 0;
+    hiz->width = 0;
+    hiz->height = 0;
+    hiz->valid = false;
+}
+
+/**
+ * Release the pyramid, its pipelines and the HiZ state
+ */
+void webgpu_hiz_destroy(webgpu_hiz_t *hiz) {
+    if (!hiz) {
+        return;
+    }
+
+    hiz_release_pyramid(hiz, NULL);
+
+    if (hiz->depth_pipeline) {
+        wgpuComputePipelineRelease(hiz->depth_pipeline);
+    }
+
+    if (hiz->reduce_pipeline) {
+        wgpuComputePipelineRelease(hiz->reduce_pipeline);
+    }
+
+    if (hiz->depth_layout) {
+        wgpuBindGroupLayoutRelease(hiz->depth_layout);
+    }
+
+    if (hiz->reduce_layout) {
+        wgpuBindGroupLayoutRelease(hiz->reduce_layout);
+    }
+
+    if (hiz->module) {
+        wgpuShaderModuleRelease(hiz->module);
+    }
+
+    if (hiz->empty_view) {
+        wgpuTextureViewRelease(hiz->empty_view);
+    }
+
+    if (hiz->empty_texture) {
+        wgpuTextureRelease(hiz->empty_texture);
+    }
+
+    ecs_os_free(hiz);
+}
+
+/**
+ * Create a HiZ compute pipeline with its own bind group layout
+ */
+static WGPUComputePipeline hiz_pipeline(WGPUDevice device,
+                                        WGPUShaderModule module,
+                                        const char *entry_point,
+                                        const WGPUBindGroupLayoutEntry *entries,
+                                        WGPUBindGroupLayout *layout) {
+    WGPUBindGroupLayoutDescriptor layout_desc = {
+        .label = "HiZ Bind Group Layout",
+        .entryCount = 2,
+        .entries = entries,
+    };
+
+    *layout = wgpuDeviceCreateBindGroupLayout(device, &layout_desc);
+    if (!*layout) {
+        return NULL;
+    }
+
+    WGPUPipelineLayoutDescriptor pipeline_layout_desc = {
+        .label = "HiZ Pipeline Layout",
+        .bindGroupLayoutCount = 1,
+        .bindGroupLayouts = layout,
+    };
+
+    WGPUPipelineLayout pipeline_layout = wgpuDeviceCreatePipelineLayout(device, &pipeline_layout_desc);
+
+    WGPUComputePipelineDescriptor pipeline_desc = {
+        .label = "HiZ Pipeline",
+        .layout = pipeline_layout,
+        .compute = {
+            .module = module,
+            .entryPoint = entry_point,
+        },
+    };
+
+    WGPUComputePipeline pipeline = wgpuDeviceCreateComputePipeline(device, &pipeline_desc);
+    wgpuPipelineLayoutRelease(pipeline_layout);
+    return pipeline;
+}
+
+/**
+ * Create the depth and reduce pipelines
+ */
+static bool hiz_create_pipelines(webgpu_hiz_t *hiz, WGPUDevice device) {
+    hiz->module = webgpu_create_shader_module(device, hiz_shader_source);
+    if (!hiz->module) {
+        return false;
+    }
+
+    WGPUBindGroupLayoutEntry destination = {
+        .binding = 1,
+        .visibility = WGPUShaderStage_Compute,
+        .storageTexture = {
+            .access = WGPUStorageTextureAccess_WriteOnly,
+            .format = WGPUTextureFormat_R32Float,
+            .viewDimension = WGPUTextureViewDimension_2D,
+        },
+    };
+
+    WGPUBindGroupLayoutEntry depth_entries[] = {
+        destination,
+        {
+            .binding = 2,
+            .visibility = WGPUShaderStage_Compute,
+            .texture = {
+                .sampleType = WGPUTextureSampleType_Depth,
+                .viewDimension = WGPUTextureViewDimension_2D,
+            },
+        }
+    };
+
+    WGPUBindGroupLayoutEntry reduce_entries[] = {
+        {
+            .binding = 0,
+            .visibility = WGPUShaderStage_Compute,
+            .texture = {
+                .sampleType = WGPUTextureSampleType_UnfilterableFloat,
+                .viewDimension = WGPUTextureViewDimension_2D,
+            },
+        },
+        destination
+    };
+
+    hiz->depth_pipeline = hiz_pipeline(device, hiz->module, "cs_depth",
+        depth_entries, &hiz->depth_layout);
+    hiz->reduce_pipeline = hiz_pipeline(device, hiz->module, "cs_reduce",
+        reduce_entries, &hiz->reduce_layout);
+    if (!hiz->depth_pipeline || !hiz->reduce_pipeline) {
+        ecs_err("WebGPU: Failed to create HiZ pipelines");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Make sure the pyramid has a level 0 of width x height. While the canvas
+ * is resized a larger pyramid is kept, and new ones are rounded up like the
+ * render targets. Texels past the region are never tested.
+ */
+static bool hiz_ensure_pyramid(webgpu_hiz_t *hiz,
+                               WGPUDevice device,
+                               uint32_t width,
+                               uint32_t height,
+                               bool resizing) {
+    if (hiz->texture && hiz->width == width && hiz->height == height) {
+        return true;
+    }
+
+    if (resizing) {
+        if (hiz->texture && hiz->width >= width && hiz->height >= height) {
+            return true;
+        }
+
+        uint32_t bucket = WEBGPU_TARGET_BUCKET / 2;
+        width = (width + bucket - 1) / bucket * bucket;
+        height = (height + bucket - 1) / bucket * bucket;
+    }
+
+    /* Levels of the frame in flight are released once it completed */
+    hiz_release_pyramid(hiz, hiz->resources);
+
+    uint32_t levels = 1;
+    for (uint32_t size = width > height ? width : height; size > 1; size >>= 1) {
+        levels++;
+    }
+    levels = levels < WEBGPU_HIZ_MAX_LEVELS ? levels : WEBGPU_HIZ_MAX_LEVELS;
+
+    WGPUTextureDescriptor texture_desc = {
+        .label = "HiZ",
+        .usage = WGPUTextureUsage_StorageBinding | WGPUTextureUsage_TextureBinding,
+        .dimension = WGPUTextureDimension_2D,
+        .size = { .width = width, .height = height, .depthOrArrayLayers = 1 },
+        .format = WGPUTextureFormat_R32Float,
+        .mipLevelCount = levels,
+        .sampleCount = 1,
+    };
+
+    hiz->texture = wgpuDeviceCreateTexture(device, &texture_desc);
+    if (!hiz->texture) {
+        ecs_err("WebGPU: Failed to create %ux%u HiZ", width, height);
+        return false;
+    }
+
+    hiz->view = wgpuTextureCreateView(hiz->texture, NULL);
+    hiz->width = width;
+    hiz->height = height;
+    hiz->levels = levels;
+
+    bool ok = hiz->view != NULL;
+    for (uint32_t i = 0; ok && i < levels; i++) {
+        WGPUTextureViewDescriptor view_desc = {
+            .label = "HiZ Level",
+            .format = WGPUTextureFormat_R32Float,
+            .dimension = WGPUTextureViewDimension_2D,
+            .baseMipLevel = i,
+            .mipLevelCount = 1,
+            .baseArrayLayer = 0,
+            .arrayLayerCount = 1,
+            .aspect = WGPUTextureAspect_All,
+        };
+        hiz->level_views[i] = wgpuTextureCreateView(hiz->texture, &view_desc);
+        ok = hiz->level_views[i] != NULL;
+
+        /* Level 0 reads the depth of the frame, bound when it's built */
+        if (ok && i) {
+            WGPUBindGroupEntry entries[] = {
+                { .binding = 0, .textureView = hiz->level_views[i - 1] },
+                { .binding = 1, .textureView = hiz->level_views[i] },
+            };
+            WGPUBindGroupDescriptor bind_group_desc = {
+                .label = "HiZ Reduce Bind Group",
+                .layout = hiz->reduce_layout,
+                .entryCount = 2,
+                .entries = entries,
+            };
+            hiz->level_groups[i] = wgpuDeviceCreateBindGroup(device, &bind_group_desc);
+            ok = hiz->level_groups[i] != NULL;
+        }
+    }
+
+    if (!ok) {
+        ecs_err("WebGPU: Failed to create HiZ level views");
+        hiz_release_pyramid(hiz, hiz->resources);
+        return false;
+    }
+
+    ecs_trace("WebGPU: Created %ux%u HiZ with %u levels", width, height, levels);
+    return true;
+}
+
+/**
+ * Build the pyramid from the depth of the main pass. Must be recorded after
+ * the pass ended, in the same frame.
+ */
+void webgpu_hiz_build(WebGPURenderer *renderer,
+                      WGPUCommandEncoder encoder,
+                      const webgpu_frame_targets_t *targets) {
+    webgpu_hiz_t *hiz = renderer->hiz;
+    if (!hiz) {
+        return;
+    }
+
+    hiz->valid = false;
+    if (!renderer->occlusion_culling || !renderer->gpu_culling) {
+        return;
+    }
+
+    if (targets->samples > 1) {
+        if (!hiz->msaa_warned) {
+            ecs_warn("WebGPU: Occlusion culling needs a single sampled depth buffer, "
+                "culling the frustum only with MSAA");
+            hiz->msaa_warned = true;
+        }
+        return;
+    }
+
+    /* The first frame after enabling has a depth target that can't be read */
+    const webgpu_view_uniform_t *view = webgpu_uniforms_get_view(renderer->uniforms, 0);
+    if (!targets->depth || !targets->depth_sampled || !view) {
+        return;
+    }
+
+    WGPUDevice device = renderer->device;
+    if (!hiz->depth_pipeline && !hiz_create_pipelines(hiz, device)) {
+        /* Don't retry every frame */
+        renderer->occlusion_culling = false;
+        return;
+    }
+
+    if (!hiz_ensure_pyramid(hiz, device, (targets->width + 1) / 2,
+            (targets->height + 1) / 2, renderer->needs_resize)) {
+        return;
+    }
+    uint32_t width = hiz->width, height = hiz->height;
+
+    WGPUBindGroupEntry entries[] = {
+        { .binding = 1, .textureView = hiz->level_views[0] },
+        { .binding = 2, .textureView = targets->depth },
+    };
+    WGPUBindGroupDescriptor bind_group_desc = {
+        .label = "HiZ Depth Bind Group",
+        .layout = hiz->depth_layout,
+        .entryCount = 2,
+        .entries = entries,
+    };
+    WGPUBindGroup depth_group = wgpuDeviceCreateBindGroup(device, &bind_group_desc);
+    if (!depth_group) {
+        ecs_warn("WebGPU: Failed to create HiZ depth bind group");
+        return;
+    }
+
+    WGPUComputePassDescriptor pass_desc = {
+        .label = "HiZ Pass",
+        .timestampWrites = webgpu_profile_compute_pass(renderer, WebGPUPassHiZ),
+    };
+    WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &pass_desc);
+
+    uint32_t group = WEBGPU_HIZ_WORKGROUP_SIZE;
+    wgpuComputePassEncoderSetPipeline(pass, hiz->depth_pipeline);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, depth_group, 0, NULL);
+    wgpuComputePassEncoderDispatchWorkgroups(pass,
+        (width + group - 1) / group, (height + group - 1) / group, 1);
+
+    wgpuComputePassEncoderSetPipeline(pass, hiz->reduce_pipeline);
+    for (uint32_t i = 1; i < hiz->levels; i++) {
+        uint32_t level_width = width >> i ? width >> i : 1;
+        uint32_t level_height = height >> i ? height >> i : 1;
+        wgpuComputePassEncoderSetBindGroup(pass, 0, hiz->level_groups[i], 0, NULL);
+        wgpuComputePassEncoderDispatchWorkgroups(pass,
+            (level_width + group - 1) / group, (level_height + group - 1) / group, 1);
+    }
+
+    wgpuComputePassEncoderEnd(pass);
+    wgpuComputePassEncoderRelease(pass);
+
+    /* Encoded commands keep the bind group alive */
+    wgpuBindGroupRelease(depth_group);
+
+    /* The next frame tests against this frame's camera and region */
+    hiz->valid = true;
+    hiz->frame = renderer->frame_index;
+    hiz->region[0] = targets->width;
+    hiz->region[1] = targets->height;
+    glm_mat4_copy((vec4*)view->view_projection, hiz->view_projection);
+    glm_vec3_copy((float*)view->camera.position, hiz->camera_position);
+}
+
+/**
+ * Whether the pyramid holds the depth of the frame before the current one
+ */
+bool webgpu_hiz_usable(const webgpu_hiz_t *hiz, const WebGPURenderer *renderer) {
+    return hiz && renderer->occlusion_culling && hiz->valid &&
+        hiz->frame + 1 == renderer->frame_index;
+}
+
+/**
+ * View the cull pass binds, the placeholder while the pyramid isn't usable
+ */
+WGPUTextureView webgpu_hiz_view(const webgpu_hiz_t *hiz, const WebGPURenderer *renderer) {
+    if (!hiz) {
+        return NULL;
+    }
+
+    return webgpu_hiz_usable(hiz, renderer) ? hiz->view : hiz->empty_view;
+}
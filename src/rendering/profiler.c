@@ -0,0 +1,290 @@
+/**
+ * @file rendering/profiler.c
+ * @brief GPU pass timing with timestamp queries, published as frame stats.
+ *
+ * Passes write a timestamp at their beginning and end. At the end of a frame
+ * the query set is resolved and copied into a readback buffer from a small
+ * ring, which is mapped asynchronously once the frame was submitted. Results
+ * arrive a few frames late, but recording never waits on the GPU.
+ */
+
+#include "../private_api.h"
+
+#define TIMESTAMP_COUNT (2 * WebGPUPassCount)
+#define TIMESTAMP_BYTES (TIMESTAMP_COUNT * sizeof(uint64_t))
+
+/**
+ * Read the resolved timestamps of a slot into pass times
+ */
+static void readback_mapped(WGPUBufferMapAsyncStatus status, void *userdata) {
+    webgpu_readback_slot_t *slot = userdata;
+    webgpu_profiler_t *profiler = slot->profiler;
+    profiler->mapping--;
+
+    if (profiler->destroyed) {
+        if (!profiler->mapping) {
+            ecs_os_free(profiler);
+        }
+        return;
+    }
+
+    if (status == WGPUBufferMapAsyncStatus_Success) {
+        const uint64_t *timestamps = wgpuBufferGetConstMappedRange(
+            slot->buffer, 0, TIMESTAMP_BYTES);
+        if (timestamps) {
+            for (int32_t pass = 0; pass < WebGPUPassCount; pass++) {
+                if (!(slot->pass_mask & (1u << pass))) {
+                    profiler->pass_ms[pass] = 0.0f;
+                    continue;
+                }
+
+                uint64_t begin = timestamps[pass * 2];
+                uint64_t end = timestamps[pass * 2 + 1];
+                profiler->pass_ms[pass] = end > begin ? (float)(end - begin) / 1.0e6f : 0.0f;
+            }
+        }
+        wgpuBufferUnmap(slot->buffer);
+    } else {
+        ecs_warn("WebGPU: Timestamp readback failed (status %d)", status);
+    }
+
+    slot->state = WebGPUReadbackFree;
+}
+
+/**
+ * Create a profiler. The device must have the timestamp-query feature.
+ */
+webgpu_profiler_t* webgpu_profiler_create(WGPUDevice device) {
+    if (!device || !wgpuDeviceHasFeature(device, WGPUFeatureName_TimestampQuery)) {
+        return NULL;
+    }
+
+    webgpu_profiler_t *profiler = ecs_os_calloc_t(webgpu_profiler_t);
+
+    WGPUQuerySetDescriptor query_desc = {
+        .label = "Pass Timestamps",
+        .type = WGPUQueryType_Timestamp,
+        .count = TIMESTAMP_COUNT,
+    };
+    profiler->query_set = wgpuDeviceCreateQuerySet(device, &query_desc);
+
+    profiler->resolve_buffer = webgpu_create_buffer(device, TIMESTAMP_BYTES,
+        WGPUBufferUsage_QueryResolve | WGPUBufferUsage_CopySrc, NULL);
+
+    bool ok = profiler->query_set && profiler->resolve_buffer;
+    for (int32_t i = 0; ok && i < WEBGPU_FRAMES_IN_FLIGHT; i++) {
+        profiler->slots[i].profiler = profiler;
+        profiler->slots[i].buffer = webgpu_create_buffer(device, TIMESTAMP_BYTES,
+            WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst, NULL);
+        ok = profiler->slots[i].buffer != NULL;
+    }
+
+    if (!ok) {
+        ecs_warn("WebGPU: Failed to create timestamp queries, GPU timing disabled");
+        webgpu_profiler_destroy(profiler);
+        return NULL;
+    }
+
+    ecs_trace("WebGPU: GPU pass timing enabled");
+    return profiler;
+}
+
+/**
+ * Release the profiler. With maps in flight the struct is freed by the last
+ * map callback.
+ */
+void webgpu_profiler_destroy(webgpu_profiler_t *profiler) {
+    if (!profiler) {
+        return;
+    }
+
+    for (int32_t i = 0; i < WEBGPU_FRAMES_IN_FLIGHT; i++) {
+        if (profiler->slots[i].buffer) {
+            wgpuBufferRelease(profiler->slots[i].buffer);
+        }
+    }
+
+    if (profiler->resolve_buffer) {
+        wgpuBufferRelease(profiler->resolve_buffer);
+    }
+
+    if (profiler->query_set) {
+        wgpuQuerySetRelease(profiler->query_set);
+    }
+
+    if (profiler->mapping) {
+        profiler->destroyed = true;
+        return;
+    }
+
+    ecs_os_free(profiler);
+}
+
+/**
+ * Start recording a frame. Maps the slots copied by earlier (now submitted)
+ * frames and picks a free slot for this one; when none is free the frame is
+ * not timed.
+ */
+void webgpu_profile_frame_start(WebGPURenderer *renderer) {
+    webgpu_profiler_t *profiler = renderer->profiler;
+    if (!profiler) {
+        return;
+    }
+
+    profiler->frame_slot = NULL;
+    profiler->frame_mask = 0;
+
+    for (int32_t i = 0; i < WEBGPU_FRAMES_IN_FLIGHT; i++) {
+        webgpu_readback_slot_t *slot = &profiler->slots[i];
+        if (slot->state == WebGPUReadbackCopied) {
+            slot->state = WebGPUReadbackMapping;
+            profiler->mapping++;
+            wgpuBufferMapAsync(slot->buffer, WGPUMapMode_Read, 0, TIMESTAMP_BYTES,
+                readback_mapped, slot);
+        } else if (slot->state == WebGPUReadbackFree && !profiler->frame_slot) {
+            profiler->frame_slot = slot;
+        }
+    }
+}
+
+/**
+ * Resolve the timestamps of the frame into its readback slot. Must be called
+ * after the last timed pass and before the encoder is finished.
+ */
+void webgpu_profile_frame_end(WebGPURenderer *renderer, WGPUCommandEncoder encoder) {
+    webgpu_profiler_t *profiler = renderer->profiler;
+    if (!profiler || !profiler->frame_slot || !profiler->frame_mask) {
+        return;
+    }
+
+    webgpu_readback_slot_t *slot = profiler->frame_slot;
+    wgpuCommandEncoderResolveQuerySet(encoder, profiler->query_set, 0, TIMESTAMP_COUNT,
+        profiler->resolve_buffer, 0);
+    wgpuCommandEncoderCopyBufferToBuffer(encoder, profiler->resolve_buffer, 0,
+        slot->buffer, 0, TIMESTAMP_BYTES);
+
+    slot->pass_mask = profiler->frame_mask;
+    slot->state = WebGPUReadbackCopied;
+    profiler->frame_slot = NULL;
+}
+
+/**
+ * Mark a pass as timed this frame, returns its timestamp query indices
+ */
+static bool profile_pass(webgpu_profiler_t *profiler, WebGPUPass pass,
+                         uint32_t *begin, uint32_t *end) {
+    if (!profiler || !profiler->frame_slot || pass >= WebGPUPassCount) {
+        return false;
+    }
+
+    profiler->frame_mask |= 1u << pass;
+    *begin = (uint32_t)pass * 2;
+    *end = (uint32_t)pass * 2 + 1;
+    return true;
+}
+
+/**
+ * Timestamp writes for a render pass descriptor, NULL if the pass isn't timed
+ */
+const WGPURenderPassTimestampWrites* webgpu_profile_render_pass(WebGPURenderer *renderer,
+                                                                WebGPUPass pass) {
+    webgpu_profiler_t *profiler = renderer->profiler;
+    uint32_t begin, end;
+    if (!profile_pass(profiler, pass, &begin, &end)) {
+        return NULL;
+    }
+
+    profiler->render_writes = (WGPURenderPassTimestampWrites){
+        .querySet = profiler->query_set,
+        .beginningOfPassWriteIndex = begin,
+        .endOfPassWriteIndex = end,
+    };
+    return &profiler->render_writes;
+}
+
+/**
+ * Timestamp writes for a compute pass descriptor, NULL if the pass isn't timed
+ */
+const WGPUComputePassTimestampWrites* webgpu_profile_compute_pass(WebGPURenderer *renderer,
+                                                                  WebGPUPass pass) {
+    webgpu_profiler_t *profiler = renderer->profiler;
+    uint32_t begin, end;
+    if (!profile_pass(profiler, pass, &begin, &end)) {
+        return NULL;
+    }
+
+    profiler->compute_writes = (WGPUComputePassTimestampWrites){
+        .querySet = profiler->query_set,
+        .beginningOfPassWriteIndex = begin,
+        .endOfPassWriteIndex = end,
+    };
+    return &profiler->compute_writes;
+}
+
+/**
+ * Publish the renderer's frame statistics to the WebGPUFrameStats singleton,
+ * and exchange the memory budget and byte counts with WebGPUMemoryBudget.
+ * Skipped frames report the counts of the last rendered frame.
+ */
+void webgpu_publish_frame_stats(ecs_world_t *world, const WebGPURenderer *renderer, bool skipped) {
+    WebGPUFrameStats stats = {
+        .gpu_timing = renderer->profiler != NULL,
+        .draw_calls = renderer->draw_calls,
+        .instances = renderer->instances_visible,
+        .instances_culled = renderer->instances_culled,
+        .instances_transparent = renderer->instances_transparent,
+        .bytes_uploaded = renderer->instance_bytes_uploaded,
+        .bytes_skipped = renderer->instance_bytes_skipped,
+        .uniform_writes = renderer->uniform_writes,
+        .state_changes = renderer->state_changes,
+        .bundles_recorded = renderer->bundles_recorded,
+        .bundles_replayed = renderer->bundles_replayed,
+        .shadow_draws = renderer->shadow_draws,
+        .passes_recorded = renderer->passes_recorded,
+        .passes_culled = renderer->passes_culled,
+        .transients_aliased = renderer->transients_aliased,
+        .mesh_bytes_streamed = renderer->mesh_bytes_streamed,
+        .meshes_loading = renderer->meshes_loading,
+        .texture_bytes_streamed = renderer->texture_bytes_streamed,
+        .textures_loading = renderer->textures_loading,
+        .render_targets = renderer->targets ?
+            (uint32_t)ecs_vec_count(&renderer->targets->targets) : 0,
+        .releases_pending = renderer->resources ?
+            (uint32_t)ecs_vec_count(&renderer->resources->pending) : 0,
+        .buffer_pool_bytes = renderer->resources ? renderer->resources->pooled_bytes : 0,
+        .frame = renderer->frame_index,
+        .depth_test = renderer->depth_attached,
+        .startup_ms = renderer->startup_ms,
+        .skipped = skipped,
+        .frames_skipped = renderer->frames_skipped,
+        .views = skipped ? 0 : 1 + (uint32_t)ecs_vec_count(&renderer->views),
+    };
+
+    memcpy(stats.cpu_ms, renderer->stage_ms, sizeof(stats.cpu_ms));
+    
+    if (renderer->profiler) {
+        for (int32_t pass = 0; pass < WebGPUPassCount; pass++) {
+            stats.pass_ms[pass] = renderer->profiler->pass_ms[pass];
+            stats.gpu_ms += stats.pass_ms[pass];
+        }
+    }
+
+    ecs_singleton_set_ptr(world, WebGPUFrameStats, &stats);
+    
+    /* The budget is an input, the byte counts are outputs */
+    webgpu_resource_pool_t *pool = renderer->resources;
+    if (pool) {
+        WebGPUMemoryBudget *memory = ecs_singleton_ensure(world, WebGPUMemoryBudget);
+        pool->budget = memory->budget;
+        memory->used = 0;
+        memory->committed = 0;
+        for (int32_t i = 0; i < WebGPUBufferClassCount; i++) {
+            memory->class_used[i] = pool->used[i];
+            memory->class_committed[i] = pool->committed[i];
+            memory->used += pool->used[i];
+            memory->committed += pool->committed[i];
+        }
+        memory->failed = pool->failed;
+        ecs_singleton_modified(world, WebGPUMemoryBudget);
+    }
+}
@@ -0,0 +1,256 @@
+/**
+ * @file rendering/render_bundles.c
+ * @brief Render bundles of batches that draw the same way frame after frame.
+ *
+ * Batches are rebuilt every frame, so a batch's bundle is found again by a
+ * key of what identifies the batch: its geometry, material, mesh range, the
+ * instance ring slot of the frame and the view it draws in. The state the
+ * batch draws with is compared against the state its bundle was recorded
+ * with. A batch drawn with the same state twice is recorded into a bundle
+ * and replayed from then on; a batch whose buffers, pipeline, offsets or
+ * instance count changed drops its bundle and draws directly until it
+ * settles again.
+ *
+ * Each ring slot has its own instance offsets and each view its own camera
+ * block, so bundles are kept per slot and view: a static batch needs
+ * WEBGPU_FRAMES_IN_FLIGHT bundles in every view.
+ */
+
+#include "../private_api.h"
+
+#define BUNDLE_KEY_PROBES 8
+
+/**
+ * Create a render bundle cache
+ */
+webgpu_bundle_cache_t* webgpu_bundle_cache_create(webgpu_resource_pool_t *resources) {
+    webgpu_bundle_cache_t *cache = ecs_os_calloc_t(webgpu_bundle_cache_t);
+    ecs_vec_init_t(NULL, &cache->entries, webgpu_bundle_entry_t*, 0);
+    ecs_vec_init_t(NULL, &cache->replay, WGPURenderBundle, 0);
+    ecs_map_init(&cache->keys, NULL);
+    cache->resources = resources;
+    return cache;
+}
+
+/**
+ * Release a bundle. Bundles may still be in a submitted frame, so they go
+ * through the resource pool.
+ */
+static void bundle_release(webgpu_bundle_cache_t *cache, webgpu_bundle_entry_t *entry) {
+    if (!entry->bundle) {
+        return;
+    }
+
+    if (cache->resources) {
+        webgpu_release_render_bundle(cache->resources, entry->bundle);
+    } else {
+        wgpuRenderBundleRelease(entry->bundle);
+    }
+    entry->bundle = NULL;
+}
+
+/**
+ * Release all bundles and the cache
+ */
+void webgpu_bundle_cache_destroy(webgpu_bundle_cache_t *cache) {
+    if (!cache) {
+        return;
+    }
+
+    int32_t count = ecs_vec_count(&cache->entries);
+    webgpu_bundle_entry_t **entries = ecs_vec_first_t(&cache->entries, webgpu_bundle_entry_t*);
+    for (int32_t i = 0; i < count; i++) {
+        bundle_release(cache, entries[i]);
+        ecs_os_free(entries[i]);
+    }
+
+    ecs_vec_fini_t(NULL, &cache->entries, webgpu_bundle_entry_t*);
+    ecs_vec_fini_t(NULL, &cache->replay, WGPURenderBundle);
+    ecs_map_fini(&cache->keys);
+    ecs_os_free(cache);
+}
+
+/**
+ * Start a frame. Evicts the bundles of batches that weren't drawn for
+ * WEBGPU_BUNDLE_EVICT_FRAMES frames.
+ */
+void webgpu_bundle_cache_begin(webgpu_bundle_cache_t *cache, uint32_t frame) {
+    if (!cache) {
+        return;
+    }
+
+    cache->frame = frame;
+    cache->recorded = 0;
+    cache->replayed = 0;
+    ecs_vec_clear(&cache->replay);
+
+    int32_t i = 0;
+    while (i < ecs_vec_count(&cache->entries)) {
+        webgpu_bundle_entry_t *entry = ecs_vec_get_t(&cache->entries, webgpu_bundle_entry_t*, i)[0];
+        if (frame - entry->frame <= WEBGPU_BUNDLE_EVICT_FRAMES) {
+            i++;
+            continue;
+        }
+
+        bundle_release(cache, entry);
+        ecs_map_remove(&cache->keys, entry->key);
+        ecs_os_free(entry);
+        ecs_vec_remove_t(&cache->entries, webgpu_bundle_entry_t*, i);
+    }
+}
+
+/**
+ * Key of a batch, stable across the frames that use the same ring slot.
+ * slot combines the ring slot with the view.
+ */
+uint64_t webgpu_bundle_key(const webgpu_render_batch_t *batch, uint32_t slot) {
+    uint64_t values[] = {
+        (uint64_t)(uintptr_t)batch->geometry,
+        batch->geometry_type,
+        batch->material,
+        batch->first_index,
+        (uint64_t)(uint32_t)batch->base_vertex,
+        batch->index_format,
+        batch->transparent,
+        slot
+    };
+
+    const uint8_t *bytes = (const uint8_t*)values;
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < sizeof(values); i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    /* Zero is not a valid map key */
+    return hash ? hash : 1;
+}
+
+/**
+ * Record the draw of a state into a bundle
+ */
+static WGPURenderBundle bundle_record(WGPUDevice device, const webgpu_bundle_state_t *state) {
+    WGPUTextureFormat color_format = (WGPUTextureFormat)state->color_format;
+    WGPURenderBundleEncoderDescriptor encoder_desc = {
+        .label = "WebGPU Batch Bundle",
+        .colorFormatCount = 1,
+        .colorFormats = &color_format,
+        .depthStencilFormat = (WGPUTextureFormat)state->depth_format,
+        .sampleCount = state->samples,
+    };
+
+    WGPURenderBundleEncoder encoder = wgpuDeviceCreateRenderBundleEncoder(device, &encoder_desc);
+    if (!encoder) {
+        return NULL;
+    }
+
+    /* Bundles don't inherit the state of the pass, everything is set */
+    wgpuRenderBundleEncoderSetPipeline(encoder, state->pipeline);
+    wgpuRenderBundleEncoderSetBindGroup(encoder, 0, state->camera, 1, &state->camera_offset);
+    wgpuRenderBundleEncoderSetBindGroup(encoder, 1, state->light, 1, &state->light_offset);
+    wgpuRenderBundleEncoderSetBindGroup(encoder, 2, state->material, 1, &state->material_offset);
+    wgpuRenderBundleEncoderSetVertexBuffer(encoder, 0, state->vertex_buffer, 0, WGPU_WHOLE_SIZE);
+    if (state->instance_group) {
+        wgpuRenderBundleEncoderSetBindGroup(encoder, 3, state->instance_group, 0, NULL);
+    } else {
+        wgpuRenderBundleEncoderSetVertexBuffer(encoder, 1, state->instance_buffer,
+            state->instance_offset, WGPU_WHOLE_SIZE);
+    }
+    wgpuRenderBundleEncoderSetIndexBuffer(encoder, state->index_buffer,
+        (WGPUIndexFormat)state->index_format, 0, WGPU_WHOLE_SIZE);
+
+    if (state->indirect_buffer) {
+        wgpuRenderBundleEncoderDrawIndexedIndirect(encoder, state->indirect_buffer,
+            state->indirect_offset);
+    } else {
+        wgpuRenderBundleEncoderDrawIndexed(encoder, state->index_count, state->instance_count,
+            state->first_index, state->base_vertex, state->first_instance);
+    }
+
+    WGPURenderBundleDescriptor bundle_desc = {
+        .label = "WebGPU Batch Bundle",
+    };
+    WGPURenderBundle bundle = wgpuRenderBundleEncoderFinish(encoder, &bundle_desc);
+    wgpuRenderBundleEncoderRelease(encoder);
+    return bundle;
+}
+
+/**
+ * Find the entry of a key that wasn't used yet this frame. Batches with the
+ * same key in one frame probe the following keys, in the same order every
+ * frame.
+ */
+static webgpu_bundle_entry_t* bundle_entry(webgpu_bundle_cache_t *cache, uint64_t key) {
+    for (int32_t probe = 0; probe < BUNDLE_KEY_PROBES; probe++, key = key * 31 + 1) {
+        if (!key) {
+            key = 1;
+        }
+
+        webgpu_bundle_entry_t *entry = ecs_map_get_ptr(&cache->keys, key);
+        if (!entry) {
+            entry = ecs_os_calloc_t(webgpu_bundle_entry_t);
+            entry->key = key;
+            ecs_map_insert_ptr(&cache->keys, key, entry);
+            ecs_vec_append_t(NULL, &cache->entries, webgpu_bundle_entry_t*)[0] = entry;
+            return entry;
+        }
+
+        if (entry->frame != cache->frame) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Queue the bundle of a batch for replay. Returns false if the batch must be
+ * drawn directly. The bundle is recorded the second frame a batch draws with
+ * the same state.
+ */
+bool webgpu_bundle_cache_draw(webgpu_bundle_cache_t *cache,
+                              WGPUDevice device,
+                              uint64_t key,
+                              const webgpu_bundle_state_t *state) {
+    webgpu_bundle_entry_t *entry = bundle_entry(cache, key);
+    if (!entry) {
+        return false;
+    }
+
+    /* New entries have a zero state, which no batch draws with */
+    entry->frame = cache->frame;
+    if (memcmp(&entry->state, state, sizeof(webgpu_bundle_state_t))) {
+        /* New or changed batch, draw it directly until it settles */
+        bundle_release(cache, entry);
+        entry->state = *state;
+        return false;
+    }
+
+    if (!entry->bundle) {
+        entry->bundle = bundle_record(device, state);
+        if (!entry->bundle) {
+            return false;
+        }
+        cache->recorded++;
+    }
+
+    ecs_vec_append_t(NULL, &cache->replay, WGPURenderBundle)[0] = entry->bundle;
+    cache->replayed++;
+    return true;
+}
+
+/**
+ * Execute the queued bundles. Returns true if any ran, which resets the pass
+ * state set before them.
+ */
+bool webgpu_bundle_cache_execute(webgpu_bundle_cache_t *cache, WGPURenderPassEncoder render_pass) {
+    int32_t count = cache ? ecs_vec_count(&cache->replay) : 0;
+    if (!count) {
+        return false;
+    }
+
+    wgpuRenderPassEncoderExecuteBundles(render_pass, (size_t)count,
+        ecs_vec_first_t(&cache->replay, WGPURenderBundle));
+    ecs_vec_clear(&cache->replay);
+    return true;
+}
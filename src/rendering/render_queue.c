@@ -0,0 +1,72 @@
+/**
+ * @file rendering/render_queue.c
+ * @brief Radix sort of the render queue by 64-bit sort key.
+ *
+ * Draw items are sorted by pass, pipeline, material, mesh and depth (see
+ * webgpu_sort_key), so the render pass only changes state where a field of
+ * the key changes. The sort is a stable LSD radix sort over the key bytes;
+ * bytes that are the same for every item are skipped, which makes the
+ * common case of few pipelines and materials a handful of counting passes.
+ */
+
+#include "../private_api.h"
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES (64 / RADIX_BITS)
+
+/**
+ * Sort the draw items of a queue by key. Scratch must use the same element
+ * type and allocator, it is resized as needed.
+ */
+void webgpu_render_queue_sort(ecs_allocator_t *allocator, ecs_vec_t *queue, ecs_vec_t *scratch) {
+    int32_t count = ecs_vec_count(queue);
+    if (count < 2) {
+        return;
+    }
+
+    ecs_vec_set_count_t(allocator, scratch, webgpu_draw_item_t, count);
+    webgpu_draw_item_t *src = ecs_vec_first_t(queue, webgpu_draw_item_t);
+    webgpu_draw_item_t *dst = ecs_vec_first_t(scratch, webgpu_draw_item_t);
+
+    /* Histograms of all passes in one read of the keys */
+    uint32_t histograms[RADIX_PASSES][RADIX_BUCKETS] = {{0}};
+    for (int32_t i = 0; i < count; i++) {
+        uint64_t key = src[i].key;
+        for (int32_t pass = 0; pass < RADIX_PASSES; pass++) {
+            histograms[pass][(key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+        }
+    }
+
+    int32_t swaps = 0;
+    for (int32_t pass = 0; pass < RADIX_PASSES; pass++) {
+        uint32_t *histogram = histograms[pass];
+        uint32_t shift = (uint32_t)pass * RADIX_BITS;
+
+        /* All items share this byte, the pass would not move anything */
+        if (histogram[(src[0].key >> shift) & (RADIX_BUCKETS - 1)] == (uint32_t)count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (int32_t b = 0; b < RADIX_BUCKETS; b++) {
+            uint32_t bucket_count = histogram[b];
+            histogram[b] = offset;
+            offset += bucket_count;
+        }
+
+        for (int32_t i = 0; i < count; i++) {
+            dst[histogram[(src[i].key >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];
+        }
+
+        webgpu_draw_item_t *tmp = src;
+        src = dst;
+        dst = tmp;
+        swaps++;
+    }
+
+    /* After an odd number of passes the result is in scratch */
+    if (swaps & 1) {
+        ecs_os_memcpy_n(ecs_vec_first_t(queue, webgpu_draw_item_t), src, webgpu_draw_item_t, count);
+    }
+}
@@ -6,146 +6,267 @@
 #include "../private_api.h"
 
 /**
- * Create instance data buffer for a batch of entities
+ * Upload packed instance data into the geometry's instance buffer ring. Each
+ * frame writes a different ring slot so the CPU never overwrites data the GPU
+ * may still be reading. Only table ranges newer than the slot's copy are
+ * written; adjacent stale ranges are merged into one queue write. With
+ * storage instancing the ring slot is the renderer's shared instance storage,
+ * reserved by the gather, and records start at the geometry's first instance.
+ * Ring slots are blocks that may share a buffer, so the slot's offset is
+ * stored with the buffer. Position/rotation/scale records are uploaded as
+ * packed, the transform pass expands them.
  */
-static WGPUBuffer create_instance_buffer(WGPUDevice device, 
-                                       const EcsTransform3 *transforms,
-                                       const EcsRgb *colors,
-                                       uint32_t count) {
-    if (!device || count == 0) {
+static WGPUBuffer write_instance_buffer(WebGPURenderer *renderer,
+                                        WebGPUGeometry *geometry) {
+    uint32_t count = geometry->instance_count;
+    if (!renderer->device || !renderer->queue || count == 0) {
         return (WGPUBuffer){0};
     }
     
-    size_t buffer_size = count * WEBGPU_BYTES_PER_INSTANCE;
-    float *instance_data = ecs_os_malloc(buffer_size);
-    if (!instance_data) {
-        ecs_err("Failed to allocate instance data buffer");
-        return (WGPUBuffer){0};
-    }
+    size_t stride = webgpu_geometry_upload_stride(geometry);
+    size_t buffer_size = count * stride;
     
-    /* Pack transform matrices and colors into instance buffer */
-    for (uint32_t i = 0; i < count; i++) {
-        float *dst = &instance_data[i * 19]; /* 16 + 3 floats per instance */
-        
-        /* Transform matrix (16 floats) */
-        if (transforms) {
-            /* Convert EcsTransform3 to 4x4 matrix */
-            mat4 transform_matrix;
-            mat4_identity(transform_matrix);
-            /* Copy the existing transform matrix */
-            glm_mat4_copy(transforms[i].value, transform_matrix);
-            memcpy(dst, transform_matrix, 16 * sizeof(float));
-        } else {
-            /* Identity matrix */
-            mat4 identity;
-            mat4_identity(identity);
-            memcpy(dst, identity, 16 * sizeof(float));
+    /* Instances were packed straight from table columns by the pack tasks */
+    uint8_t *instance_data = ecs_vec_first_t(&geometry->instance_data, uint8_t);
+    
+    uint32_t slot = renderer->frame_index % WEBGPU_FRAMES_IN_FLIGHT;
+    webgpu_instance_storage_t *storage = renderer->instance_storage;
+    const WebGPUBufferBlock *block;
+    uint64_t base = 0;
+    bool reallocated;
+    
+    if (storage) {
+        /* Records of a geometry that moved in the storage are re-uploaded */
+        base = (uint64_t)geometry->first_instance * stride;
+        block = &storage->blocks[slot];
+        if (!block->buffer || block->size < base + buffer_size) {
+            return (WGPUBuffer){0};
+        }
+        reallocated = storage->reallocated[slot] ||
+            geometry->storage_first[slot] != geometry->first_instance;
+        geometry->storage_first[slot] = geometry->first_instance;
+    } else {
+        /* The geometry frees its blocks to the pool it allocated them from */
+        if (!geometry->resources) {
+            geometry->resources = renderer->resources;
+            webgpu_resource_pool_keep(geometry->resources);
         }
         
-        /* Color (3 floats) */
-        if (colors) {
-            dst[16] = colors[i].r;
-            dst[17] = colors[i].g;
-            dst[18] = colors[i].b;
-        } else {
-            /* Default white color */
-            dst[16] = 1.0f;
-            dst[17] = 1.0f;
-            dst[18] = 1.0f;
+        /* Pick this frame's ring slot, growing it by doubling if needed */
+        WebGPUBufferBlock *ring = &geometry->instance_ring[slot];
+        WebGPUBufferBlock previous = *ring;
+        if (!webgpu_ensure_buffer_capacity(renderer->device, geometry->resources, ring,
+                buffer_size, WGPUBufferUsage_Vertex | WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst)) {
+            ecs_err("WebGPU: Failed to allocate instance buffer (%zu bytes)", buffer_size);
+            return (WGPUBuffer){0};
         }
+        
+        /* A reallocated slot lost its contents and needs every range */
+        block = ring;
+        reallocated = ring->buffer != previous.buffer || ring->offset != previous.offset;
     }
     
-    /* Create GPU buffer */
-    WGPUBuffer buffer = webgpu_create_buffer(device, buffer_size, 
-        WGPUBufferUsage_Vertex | WGPUBufferUsage_CopyDst, instance_data);
+    WGPUBuffer buffer = block->buffer;
+    base += block->offset;
+    
+    webgpu_table_range_t *ranges = ecs_vec_first_t(&geometry->table_ranges, webgpu_table_range_t);
+    int32_t range_count = ecs_vec_count(&geometry->table_ranges);
+    uint32_t write_start = 0, write_source = 0, write_count = 0;
     
-    ecs_os_free(instance_data);
-    return buffer;
+    for (int32_t r = 0; r <= range_count; r++) {
+        webgpu_table_range_t *range = r < range_count ? &ranges[r] : NULL;
+        bool stale = range && (reallocated || range->uploaded[slot] != range->version);
+        
+        /* Runs can only be merged while contiguous in staging and on the GPU */
+        bool contiguous = stale && write_count && 
+            range->offset == write_start + write_count &&
+            range->slot_offset == write_source + write_count;
+        
+        /* Flush the current run of stale ranges */
+        if (write_count && !contiguous) {
+            size_t write_size = write_count * stride;
+            wgpuQueueWriteBuffer(renderer->queue, buffer, base + write_start * stride,
+                &instance_data[write_source * stride], write_size);
+            renderer->instance_bytes_uploaded += write_size;
+            write_count = 0;
+        }
+        
+        if (stale) {
+            range->uploaded[slot] = range->version;
+            
+            if (!write_count) {
+                write_start = range->offset;
+                write_source = range->slot_offset;
+            }
+            write_count += range->count;
+        } else if (range) {
+            renderer->instance_bytes_skipped += range->count * stride;
+        }
+    }
+    
+    geometry->instance_buffer = buffer;
+    geometry->instance_offset = block->offset;
+    geometry->instance_count = count;
+    return geometry->instance_buffer;
 }
 
+/* Geometry components rendered by the module */
+#define GEOMETRY_TYPES { ecs_id(EcsBox), ecs_id(EcsRectangle), \
+    ecs_id(WebGPUSphere), ecs_id(WebGPUCylinder), ecs_id(WebGPUGrid), ecs_id(WebGPUMesh) }
+
 /**
- * Get geometry buffers for a specific geometry type
+ * Get the WebGPUGeometry owned by the entity for a geometry type
  */
-static bool get_geometry_buffers(ecs_world_t *world,
-                                WebGPURenderer *renderer,
-                                ecs_id_t geometry_type,
-                                WGPUBuffer *vertex_buffer,
-                                WGPUBuffer *index_buffer,
-                                uint32_t *vertex_count,
-                                uint32_t *index_count) {
-    
+static WebGPUGeometry* get_geometry(ecs_world_t *world, ecs_id_t geometry_type) {
     if (geometry_type == ecs_id(EcsBox)) {
-        /* Box geometry from geometry.c */
-        extern const float box_vertices[];
-        extern const uint16_t box_indices[];
-        extern const uint32_t box_vertex_count;
-        extern const uint32_t box_index_count;
-        
-        *vertex_buffer = webgpu_create_buffer(renderer->device,
-            box_vertex_count * 8 * sizeof(float), /* pos(3) + normal(3) + uv(2) */
-            WGPUBufferUsage_Vertex, box_vertices);
-            
-        *index_buffer = webgpu_create_buffer(renderer->device,
-            box_index_count * sizeof(uint16_t),
-            WGPUBufferUsage_Index, box_indices);
-            
-        *vertex_count = box_vertex_count;
-        *index_count = box_index_count;
-        return true;
+        return ecs_get_mut(world, WebGPUBoxGeometry, WebGPUGeometry);
     }
     
     if (geometry_type == ecs_id(EcsRectangle)) {
-        /* Rectangle geometry from geometry.c */
-        extern const float rectangle_vertices[];
-        extern const uint16_t rectangle_indices[];
-        extern const uint32_t rectangle_vertex_count;
-        extern const uint32_t rectangle_index_count;
-        
-        *vertex_buffer = webgpu_create_buffer(renderer->device,
-            rectangle_vertex_count * 8 * sizeof(float),
-            WGPUBufferUsage_Vertex, rectangle_vertices);
-            
-        *index_buffer = webgpu_create_buffer(renderer->device,
-            rectangle_index_count * sizeof(uint16_t),
-            WGPUBufferUsage_Index, rectangle_indices);
-            
-        *vertex_count = rectangle_vertex_count;
-        *index_count = rectangle_index_count;
-        return true;
+        return ecs_get_mut(world, WebGPURectangleGeometry, WebGPUGeometry);
+    }
+    
+    if (geometry_type == ecs_id(WebGPUSphere)) {
+        return ecs_get_mut(world, WebGPUSphereGeometry, WebGPUGeometry);
+    }
+    
+    if (geometry_type == ecs_id(WebGPUCylinder)) {
+        return ecs_get_mut(world, WebGPUCylinderGeometry, WebGPUGeometry);
+    }
+    
+    if (geometry_type == ecs_id(WebGPUGrid)) {
+        return ecs_get_mut(world, WebGPUGridGeometry, WebGPUGeometry);
+    }
+    
+    if (geometry_type == ecs_id(WebGPUMesh)) {
+        return ecs_get_mut(world, WebGPUMeshGeometry, WebGPUGeometry);
     }
     
-    ecs_warn("WebGPU: Unsupported geometry type: %s", ecs_get_name(world, geometry_type));
-    return false;
+    return NULL;
 }
 
 /**
- * Create render pipeline for geometry type
+ * Prepare instance packing for all geometry types (single-threaded).
+ * Runs change detection and reserves staging slots so the pack system can
+ * write every range independently.
  */
-static WGPURenderPipeline create_geometry_pipeline(WebGPURenderer *renderer) {
-    /* Load embedded shaders */
-    extern const char *basic_vertex_shader_source;
-    extern const char *basic_fragment_shader_source;
-    
-    /* Create shader modules */
-    WGPUShaderModule vertex_shader = webgpu_create_shader_module(
-        renderer->device, basic_vertex_shader_source);
-    WGPUShaderModule fragment_shader = webgpu_create_shader_module(
-        renderer->device, basic_fragment_shader_source);
-    
-    if (!vertex_shader || !fragment_shader) {
-        ecs_err("WebGPU: Failed to create shader modules");
-        return NULL;
-    }
-    
-    /* Create pipeline */
-    WGPURenderPipeline pipeline = webgpu_create_geometry_pipeline(
-        renderer->device, vertex_shader, fragment_shader);
+void webgpu_prepare_instances(ecs_iter_t *it) {
+    WebGPURenderer *renderer = ecs_field(it, WebGPURenderer, 0);
+    ecs_id_t geometry_types[] = GEOMETRY_TYPES;
+    size_t num_geometry_types = sizeof(geometry_types) / sizeof(geometry_types[0]);
     
-    /* Cleanup shader modules */
-    wgpuShaderModuleRelease(vertex_shader);
-    wgpuShaderModuleRelease(fragment_shader);
+    for (int32_t r = 0; r < it->count; r++) {
+        /* Instances are packed and mesh files requested while the adapter
+         * and device requests are in flight, uploads wait until startup is
+         * done */
+        if (!renderer[r].materials || renderer[r].startup == WebGPUStartupFailed) {
+            continue;
+        }
+        bool ready = renderer[r].startup == WebGPUStartupReady;
+        
+        ecs_time_t stage_start = {0};
+        ecs_time_measure(&stage_start);
+        
+        /* Upload streamed mesh and texture data within the frame budget, so
+         * resources that became resident are drawn this frame */
+        if (ready) {
+            if (!renderer[r].mesh_registry) {
+                renderer[r].mesh_registry = webgpu_mesh_registry_create(renderer[r].resources);
+            }
+            uint64_t budget = renderer[r].stream_budget ? 
+                renderer[r].stream_budget : WEBGPU_STREAM_BUDGET;
+            renderer[r].mesh_bytes_streamed = webgpu_mesh_loader_update(renderer[r].mesh_loader,
+                renderer[r].mesh_registry, renderer[r].device, renderer[r].queue, budget);
+            
+            /* Textures share the budget with meshes */
+            uint64_t texture_budget = budget > renderer[r].mesh_bytes_streamed ?
+                budget - renderer[r].mesh_bytes_streamed : 0;
+            renderer[r].texture_bytes_streamed = webgpu_texture_cache_update(renderer[r].textures,
+                renderer[r].device, renderer[r].queue, texture_budget);
+            renderer[r].redraw |= renderer[r].texture_bytes_streamed != 0;
+        }
+        renderer[r].meshes_loading = renderer[r].mesh_loader ? 
+            renderer[r].mesh_loader->loading : 0;
+        renderer[r].textures_loading = renderer[r].textures ? 
+            renderer[r].textures->loading : 0;
+        webgpu_stage_time(&renderer[r], WebGPUStageUpload, &stage_start);
+        
+        /* CPU culling tests instances against the camera frustum while
+         * packing. Transparent instances are packed back to front along the
+         * view, LODs are picked by the projected size of instances. */
+        webgpu_frustum_t frustum;
+        webgpu_pack_view_t pack_view = {0};
+        renderer[r].instances_changed = false;
+        const webgpu_view_uniform_t *view = webgpu_uniforms_get_view(renderer[r].uniforms, 0);
+        if (view) {
+            /* Other views and shadow cascades see instances outside the
+             * renderer's frustum */
+            if (renderer[r].cpu_culling && !ecs_vec_count(&renderer[r].views) &&
+                !renderer[r].shadows) {
+                webgpu_frustum_from_matrix(&frustum, (vec4*)view->view_projection);
+                pack_view.frustum = &frustum;
+            }
+            webgpu_view_depth_plane(pack_view.depth_plane, (vec4*)view->view);
+            pack_view.pixel_scale = view->projection[1][1] * 0.5f * (float)renderer[r].height;
+        }
+        
+        for (size_t i = 0; i < num_geometry_types; i++) {
+            WebGPUGeometry *geometry = get_geometry(it->world, geometry_types[i]);
+            if (!geometry || !geometry->query) {
+                continue;
+            }
+            
+            /* Storage records carry the mesh ids of the LODs, so the meshes
+             * are uploaded before packing */
+            bool storage = renderer[r].storage_instancing;
+            uint32_t storage_tag = storage ? webgpu_storage_tag(
+                webgpu_upload_geometry_mesh(&renderer[r], geometry), 0) : 0;
+            WebGPUInstanceFormat format = webgpu_draw_instance_format(&renderer[r]);
+            bool gpu_transforms = storage && renderer[r].gpu_transforms;
+            
+            /* A layout change invalidates every packed range */
+            if (geometry->instance_format != format ||
+                geometry->storage_instances != storage ||
+                geometry->storage_tag != storage_tag ||
+                geometry->gpu_transforms != gpu_transforms) {
+                geometry->instance_format = format;
+                geometry->storage_instances = storage;
+                geometry->storage_tag = storage_tag;
+                geometry->gpu_transforms = gpu_transforms;
+                ecs_vec_clear(&geometry->table_ranges);
+            }
+            
+            renderer[r].redraw |= webgpu_prepare_geometry_instances(geometry, geometry->query,
+                view ? &pack_view : NULL, renderer[r].materials, renderer[r].mesh_loader);
+            renderer[r].instances_changed |= geometry->instances_changed;
+        }
+        
+        webgpu_stage_time(&renderer[r], WebGPUStageGather, &stage_start);
+        ecs_os_get_time(&renderer[r].pack_start);
+    }
+}
+
+/**
+ * Pack instance ranges (multi_threaded).
+ * Matches the pack task entities, so each worker packs the ranges of the
+ * tasks it was handed, straight into their reserved staging slots.
+ */
+void webgpu_pack_instances(ecs_iter_t *it) {
+    WebGPUPackTask *tasks = ecs_field(it, WebGPUPackTask, 0);
+    ecs_id_t geometry_types[] = GEOMETRY_TYPES;
+    size_t num_geometry_types = sizeof(geometry_types) / sizeof(geometry_types[0]);
     
-    return pipeline;
+    for (size_t i = 0; i < num_geometry_types; i++) {
+        WebGPUGeometry *geometry = get_geometry(it->world, geometry_types[i]);
+        if (!geometry) {
+            continue;
+        }
+        
+        for (int32_t t = 0; t < it->count; t++) {
+            webgpu_pack_geometry_instances(it->world, geometry, 
+                tasks[t].index, WEBGPU_PACK_TASKS, &tasks[t].scratch);
+        }
+    }
 }
 
 /**
@@ -160,246 +281,448 @@ void webgpu_gather_geometry_batches(ecs_world_t *world,
     
     /* Clear previous batches */
     ecs_vec_clear(&renderer->render_batches);
+    renderer->instance_bytes_uploaded = 0;
+    renderer->instance_bytes_skipped = 0;
+    renderer->instances_visible = 0;
+    renderer->instances_culled = 0;
+    renderer->instances_transparent = 0;
+    renderer->draw_calls = 0;
+    renderer->state_changes = 0;
+    renderer->bundles_recorded = 0;
+    renderer->bundles_replayed = 0;
+    
+    ecs_time_t stage_start = {0};
+    ecs_time_measure(&stage_start);
+    
+    /* Opaque and transparent geometry each share one pipeline variant */
+    webgpu_pipeline_key_t pipeline_key;
+    webgpu_pipeline_key_init(&pipeline_key, renderer);
+    uint32_t opaque_id = 0, transparent_id = 0;
+    WGPURenderPipeline opaque_pipeline = webgpu_pipeline_cache_get(
+        renderer->pipeline_cache, &pipeline_key, &opaque_id);
+    webgpu_pipeline_key_transparent(&pipeline_key);
+    WGPURenderPipeline transparent_pipeline = webgpu_pipeline_cache_get(
+        renderer->pipeline_cache, &pipeline_key, &transparent_id);
+    
+    /* Batches of a variant that is still compiling aren't drawn, so the
+     * next frame is needed even if nothing changes */
+    if (!opaque_pipeline || !transparent_pipeline) {
+        renderer->redraw = true;
+    }
+    
+    /* Batches are ordered by the view depth of their ranges */
+    float sort_plane[4] = {0};
+    const webgpu_view_uniform_t *view = webgpu_uniforms_get_view(renderer->uniforms, 0);
+    if (view) {
+        webgpu_view_depth_plane(sort_plane, (vec4*)view->view);
+    }
+    WGPUBindGroupLayout material_layout = renderer->pipeline_cache ?
+        renderer->pipeline_cache->material_layout : NULL;
+    if (renderer->materials) {
+        renderer->materials->writes = 0;
+    }
     
     /* Iterate through geometry components */
-    ecs_id_t geometry_types[] = { ecs_id(EcsBox), ecs_id(EcsRectangle) };
+    ecs_id_t geometry_types[] = GEOMETRY_TYPES;
     size_t num_geometry_types = sizeof(geometry_types) / sizeof(geometry_types[0]);
+    WebGPUGeometry *geometries[sizeof(geometry_types) / sizeof(geometry_types[0])];
+    
+    /* Finish packing first, so the shared instance storage can be laid out
+     * and reserved before any geometry uploads into it */
+    webgpu_instance_storage_t *storage = renderer->instance_storage;
+    uint64_t storage_size = 0, expanded_size = 0;
+    uint32_t storage_count = 0;
     
     for (size_t i = 0; i < num_geometry_types; i++) {
-        ecs_id_t geometry_type = geometry_types[i];
-        
-        /* Create dynamic query for this geometry type */
-        ecs_query_t *geometry_query = ecs_query(world, {
-            .terms = {
-                { .id = ecs_id(EcsTransform3), .inout = EcsIn },
-                { .id = ecs_id(EcsRgb), .inout = EcsIn, .oper = EcsOptional },
-                { .id = geometry_type, .inout = EcsIn }
-            }
-        });
-        
-        if (!geometry_query) {
+        /* Geometry entities own a cached query for their component */
+        WebGPUGeometry *geometry = geometries[i] = get_geometry(world, geometry_types[i]);
+        if (!geometry || !geometry->query) {
+            ecs_warn("WebGPU: No geometry entity for type: %s",
+                    ecs_get_name(world, geometry_types[i]));
+            geometries[i] = NULL;
             continue;
         }
         
-        /* Count entities for this geometry type */
-        uint32_t entity_count = 0;
-        ecs_iter_t count_it = ecs_query_iter(world, geometry_query);
-        while (ecs_query_next(&count_it)) {
-            entity_count += count_it.count;
+        /* Instances were packed by the prepare and pack systems */
+        webgpu_finish_geometry_instances(geometry);
+        renderer->instances_visible += geometry->instance_count;
+        renderer->instances_culled += geometry->culled_count;
+        
+        /* Every geometry packs records of the renderer's layout, so record
+         * offsets are the same in all geometries */
+        geometry->first_instance = storage ? storage_count : 0;
+        storage_count += geometry->instance_count;
+        storage_size += (uint64_t)geometry->instance_count * webgpu_geometry_upload_stride(geometry);
+        if (geometry->gpu_transforms) {
+            expanded_size += (uint64_t)geometry->instance_count * webgpu_geometry_stride(geometry);
+        }
+    }
+    
+    if (storage && storage_size) {
+        uint32_t slot = renderer->frame_index % WEBGPU_FRAMES_IN_FLIGHT;
+        webgpu_stage_time(renderer, WebGPUStageGather, &stage_start);
+        webgpu_instance_storage_reserve(storage, renderer->device, (int32_t)slot, storage_size);
+        if (expanded_size) {
+            webgpu_instance_storage_reserve(storage, renderer->device,
+                WEBGPU_INSTANCE_STORAGE_EXPANDED, expanded_size);
+        }
+        webgpu_stage_time(renderer, WebGPUStageUpload, &stage_start);
+    }
+    
+    for (size_t i = 0; i < num_geometry_types; i++) {
+        ecs_id_t geometry_type = geometry_types[i];
+        WebGPUGeometry *geometry = geometries[i];
+        if (!geometry) {
+            continue;
         }
         
+        uint32_t entity_count = geometry->instance_count;
         if (entity_count == 0) {
-            ecs_query_fini(geometry_query);
             continue;
         }
         
-        /* Allocate batch data */
-        EcsTransform3 *transforms = ecs_os_malloc(entity_count * sizeof(EcsTransform3));
-        EcsRgb *colors = ecs_os_malloc(entity_count * sizeof(EcsRgb));
-        
-        /* Gather entity data */
-        uint32_t entity_index = 0;
-        ecs_iter_t gather_it = ecs_query_iter(world, geometry_query);
-        while (ecs_query_next(&gather_it)) {
-            EcsTransform3 *batch_transforms = ecs_field(&gather_it, EcsTransform3, 0);
-            EcsRgb *batch_colors = ecs_field(&gather_it, EcsRgb, 1);
-            
-            for (int j = 0; j < gather_it.count; j++) {
-                /* Copy transform */
-                transforms[entity_index] = batch_transforms[j];
-                
-                /* Copy color or use default */
-                if (batch_colors) {
-                    colors[entity_index] = batch_colors[j];
-                } else {
-                    colors[entity_index] = (EcsRgb){ .r = 1.0f, .g = 1.0f, .b = 1.0f };
-                }
-                
-                entity_index++;
-            }
+        /* Meshes are uploaded once, batches only reference their range.
+         * Streamed geometry looks up the mesh of every range. */
+        webgpu_upload_geometry_mesh(renderer, geometry);
+        const webgpu_mesh_t *meshes[WEBGPU_MAX_LODS] = {0};
+        bool meshes_ready = geometry->lod_count > 0;
+        for (uint32_t l = 0; !geometry->streamed && l < geometry->lod_count; l++) {
+            meshes[l] = webgpu_mesh_registry_get(renderer->mesh_registry, geometry->lod_mesh_ids[l]);
+            meshes_ready &= meshes[l] != NULL;
         }
-        
-        /* Create render batch */
-        webgpu_render_batch_t *batch = ecs_vec_append_t(
-            renderer->allocator, &renderer->render_batches, webgpu_render_batch_t);
-        
-        batch->geometry_type = geometry_type;
-        batch->instance_count = entity_count;
-        batch->transforms = transforms;
-        batch->colors = colors;
-        
-        /* Get geometry buffers */
-        if (!get_geometry_buffers(world, renderer, geometry_type,
-                                 &batch->vertex_buffer, &batch->index_buffer,
-                                 &batch->vertex_count, &batch->index_count)) {
-            ecs_warn("WebGPU: Failed to get geometry buffers for type: %s", 
+        if (!meshes_ready) {
+            ecs_warn("WebGPU: Failed to get geometry mesh for type: %s", 
                     ecs_get_name(world, geometry_type));
             continue;
         }
         
-        /* Create instance buffer */
-        batch->instance_buffer = create_instance_buffer(
-            renderer->device, transforms, colors, entity_count);
+        /* Upload instance data into the persistent instance buffer ring */
+        webgpu_stage_time(renderer, WebGPUStageGather, &stage_start);
+        uint64_t bytes_uploaded = renderer->instance_bytes_uploaded;
+        WGPUBuffer instance_buffer = write_instance_buffer(renderer, geometry);
+        webgpu_stage_time(renderer, WebGPUStageUpload, &stage_start);
         
-        /* Create pipeline if needed */
-        if (!renderer->default_pipeline) {
-            renderer->default_pipeline = create_geometry_pipeline(renderer);
+        /* Position/rotation/scale records are drawn from their expansion */
+        if (instance_buffer && geometry->gpu_transforms) {
+            instance_buffer = webgpu_transform_expander_add(renderer, geometry,
+                renderer->instance_bytes_uploaded != bytes_uploaded);
         }
-        batch->pipeline = renderer->default_pipeline;
         
-        ecs_query_fini(geometry_query);
+        /* One batch per run of opaque ranges with the same material and LOD.
+         * Ranges are packed back to back and grouped by material, and store
+         * their records grouped by LOD, so a run continues while the next
+         * range starts with the LOD the previous one ended with. Transparent
+         * ranges are sorted by themselves and packed at a single LOD, so they
+         * get one batch ordered back to front. */
+        webgpu_table_range_t *ranges = ecs_vec_first_t(&geometry->table_ranges, webgpu_table_range_t);
+        int32_t range_count = ecs_vec_count(&geometry->table_ranges);
+        webgpu_render_batch_t *batch = NULL;
+        uint32_t batch_mesh = 0;
+        float batch_depth = 0.0f;
         
-        ecs_trace("WebGPU: Created batch for %s with %d instances",
+        for (int32_t r = 0; r < range_count; r++) {
+            webgpu_table_range_t *range = &ranges[r];
+            if (!range->count) {
+                continue;
+            }
+            
+            float depth = webgpu_view_depth(sort_plane, range->center);
+            uint32_t first = geometry->first_instance + range->offset;
+            
+            for (uint32_t l = 0; l < geometry->lod_count; l++) {
+                uint32_t count = range->lod_counts[l];
+                if (!count) {
+                    continue;
+                }
+                
+                const webgpu_mesh_t *mesh = meshes[l];
+                uint32_t mesh_id = geometry->lod_mesh_ids[l];
+                if (geometry->streamed) {
+                    mesh_id = range->mesh_id;
+                    mesh = webgpu_mesh_registry_get(renderer->mesh_registry, mesh_id);
+                    if (!mesh || !mesh->resident) {
+                        continue;
+                    }
+                }
+                
+                /* Opaque batches are keyed by their nearest range */
+                if (batch && !batch->transparent && !range->transparent &&
+                    batch->material == range->material && batch_mesh == mesh_id &&
+                    batch->first_instance + batch->instance_count == first) {
+                    batch->instance_count += count;
+                    if (depth < batch_depth) {
+                        batch_depth = depth;
+                        batch->sort_key = webgpu_sort_key(WebGPUQueueOpaque, opaque_id,
+                            range->material, mesh_id, webgpu_sort_depth(depth));
+                    }
+                    first += count;
+                    continue;
+                }
+                
+                batch = ecs_vec_append_t(
+                    renderer->allocator, &renderer->render_batches, webgpu_render_batch_t);
+                ecs_os_memset_t(batch, 0, webgpu_render_batch_t);
+                
+                batch->geometry_type = geometry_type;
+                batch->geometry = geometry;
+                batch->base_vertex = mesh->base_vertex;
+                batch->first_index = mesh->first_index;
+                batch->vertex_count = mesh->vertex_count;
+                batch->index_count = mesh->index_count;
+                batch->index_format = mesh->index_format;
+                memcpy(batch->bounds, mesh->bounds, sizeof(batch->bounds));
+                
+                batch->instance_buffer = instance_buffer;
+                batch->instance_offset = geometry->instance_offset;
+                batch->first_instance = first;
+                batch->instance_count = count;
+                
+                /* NULL while the variant compiles, the batch is skipped until then */
+                batch->transparent = range->transparent;
+                batch->pipeline = range->transparent ? transparent_pipeline : opaque_pipeline;
+                batch->material = range->material;
+                batch->bind_group = webgpu_material_cache_bind_group(renderer->materials, world,
+                    renderer->device, renderer->queue, material_layout, renderer->textures,
+                    range->material, &batch->material_offset);
+                batch->sort_key = webgpu_sort_key(
+                    range->transparent ? WebGPUQueueTransparent : WebGPUQueueOpaque,
+                    range->transparent ? transparent_id : opaque_id,
+                    range->material, mesh_id, webgpu_sort_depth(depth));
+                batch_mesh = mesh_id;
+                batch_depth = depth;
+                first += count;
+            }
+            
+            if (range->transparent) {
+                renderer->instances_transparent += range->count;
+            }
+        }
+        
+        ecs_trace("WebGPU: Created batches for %s with %d instances",
                  ecs_get_name(world, geometry_type), entity_count);
     }
-}
-
-/**
- * Update camera uniform buffer with view/projection matrices
- */
-static void update_camera_uniforms(WebGPURenderer *renderer) {
-    if (!renderer->camera_uniform_buffer || !renderer->device || !renderer->queue) {
-        return;
-    }
     
-    /* Create camera matrices */
-    mat4 view_matrix;
-    mat4 projection_matrix;
-    mat4 view_projection_matrix;
-    
-    /* Simple camera setup - looking at origin from distance */
-    glm_mat4_identity(view_matrix);
-    glm_translate(view_matrix, (vec3){0.0f, 0.0f, -5.0f}); /* Move back 5 units */
-    
-    /* Perspective projection */
-    float aspect = (float)renderer->width / (float)renderer->height;
-    glm_perspective(glm_rad(45.0f), aspect, 0.1f, 100.0f, projection_matrix);
-    
-    /* Combine view and projection */
-    glm_mat4_mul(projection_matrix, view_matrix, view_projection_matrix);
-    
-    /* Pack matrices into buffer layout: view, projection, view_projection */
-    float camera_data[48]; /* 3 mat4 matrices = 3 * 16 floats */
-    memcpy(&camera_data[0], view_matrix, 16 * sizeof(float));
-    memcpy(&camera_data[16], projection_matrix, 16 * sizeof(float));
-    memcpy(&camera_data[32], view_projection_matrix, 16 * sizeof(float));
+    if (renderer->materials) {
+        renderer->uniform_writes += renderer->materials->writes;
+    }
     
-    /* Upload to GPU */
-    webgpu_update_buffer(renderer->device, renderer->queue, renderer->camera_uniform_buffer, 
-                        camera_data, sizeof(camera_data), 0);
-}
-
-/**
- * Update light uniform buffer with directional lighting data
- */
-static void update_light_uniforms(WebGPURenderer *renderer) {
-    if (!renderer->light_uniform_buffer || !renderer->device || !renderer->queue) {
-        return;
+    /* Sort the batches into the render queue */
+    ecs_vec_clear(&renderer->render_queue);
+    webgpu_render_batch_t *batches = ecs_vec_first_t(&renderer->render_batches, webgpu_render_batch_t);
+    for (int32_t b = 0; b < ecs_vec_count(&renderer->render_batches); b++) {
+        webgpu_draw_item_t *item = ecs_vec_append_t(
+            renderer->allocator, &renderer->render_queue, webgpu_draw_item_t);
+        item->key = batches[b].sort_key;
+        item->batch = b;
     }
+    webgpu_render_queue_sort(renderer->allocator, &renderer->render_queue, 
+        &renderer->render_queue_scratch);
     
-    /* Light data matching our 40-byte shader struct */
-    struct {
-        float direction_x;      // 4 bytes
-        float direction_y;      // 4 bytes  
-        float direction_z;      // 4 bytes
-        float intensity;        // 4 bytes
-        float color_x;          // 4 bytes
-        float color_y;          // 4 bytes
-        float color_z;          // 4 bytes
-        float ambient_strength; // 4 bytes
-        float ambient_x;        // 4 bytes (ambient_xy.x)
-        float ambient_y;        // 4 bytes (ambient_xy.y)
-    } light_data = {
-        .direction_x = -0.5f,
-        .direction_y = -1.0f,
-        .direction_z = -0.3f,
-        .intensity = 1.0f,
-        .color_x = 1.0f,
-        .color_y = 1.0f,
-        .color_z = 1.0f,
-        .ambient_strength = 0.3f,
-        .ambient_x = 0.1f,
-        .ambient_y = 0.1f,
-    };
-    
-    /* Upload to GPU */
-    webgpu_update_buffer(renderer->device, renderer->queue, renderer->light_uniform_buffer, 
-                        &light_data, sizeof(light_data), 0);
+    webgpu_stage_time(renderer, WebGPUStageGather, &stage_start);
 }
 
 /**
- * Execute all gathered render batches
+ * Execute all gathered render batches in render queue order. Pipelines, bind
+ * groups and vertex buffers are only set when they differ from the previous
+ * draw, which the sort keys make rare. With render bundles, runs of settled
+ * batches are replayed between the direct draws. View 0 is the renderer's
+ * canvas, other views draw the same batches with their camera block and
+ * without GPU culling, which only culled for view 0. Batches are kept until
+ * the next gather, so every view of a frame can execute them.
  */
 void webgpu_execute_render_batches(WebGPURenderer *renderer, 
-                                  WGPURenderPassEncoder render_pass) {
-    if (!renderer || !render_pass) {
+                                  WGPURenderPassEncoder render_pass,
+                                  uint32_t view,
+                                  const webgpu_frame_targets_t *targets) {
+    if (!renderer || !render_pass || view >= WEBGPU_MAX_VIEWS) {
         return;
     }
     
-    /* Update uniform buffers with current frame data */
-    update_camera_uniforms(renderer);
-    update_light_uniforms(renderer);
-    
-    int32_t batch_count = ecs_vec_count(&renderer->render_batches);
+    int32_t item_count = ecs_vec_count(&renderer->render_queue);
+    webgpu_draw_item_t *items = ecs_vec_first_t(&renderer->render_queue, webgpu_draw_item_t);
     webgpu_render_batch_t *batches = ecs_vec_first(&renderer->render_batches);
     
-    for (int32_t i = 0; i < batch_count; i++) {
-        webgpu_render_batch_t *batch = &batches[i];
+    webgpu_mesh_registry_t *meshes = renderer->mesh_registry;
+    if (item_count && (!meshes || !meshes->vertex_buffer)) {
+        ecs_warn("WebGPU: Skipping frame, mesh buffers not uploaded");
+        item_count = 0;
+    }
+    
+    /* Blocks of the uniform ring this pass renders with */
+    uint32_t view_offset = webgpu_view_uniform_offset(view);
+    uint32_t light_offset = webgpu_light_uniform_offset(0);
+    
+    /* Batches that draw like they did the last time their ring slot was used
+     * in this view are replayed from render bundles */
+    webgpu_bundle_cache_t *bundles = renderer->bundles;
+    uint32_t slot = renderer->frame_index % WEBGPU_FRAMES_IN_FLIGHT + view * WEBGPU_FRAMES_IN_FLIGHT;
+    if (!view) {
+        webgpu_bundle_cache_begin(bundles, renderer->frame_index);
+    }
+    
+    webgpu_instance_storage_t *storage = renderer->instance_storage;
+    bool shared_bound = false;
+    WGPURenderPipeline bound_pipeline = NULL;
+    WGPUBindGroup bound_material = NULL;
+    uint32_t bound_material_offset = 0;
+    WGPUBuffer bound_instances = NULL;
+    uint64_t bound_instance_offset = 0;
+    uint32_t bound_index_format = WGPUIndexFormat_Undefined;
+    
+    for (int32_t i = 0; i < item_count; i++) {
+        webgpu_render_batch_t *batch = &batches[items[i].batch];
+        WGPUBuffer instance_buffer = batch->instance_buffer;
+        uint64_t instance_offset = batch->instance_offset;
+        WGPUBuffer indirect_buffer = batch->indirect_buffer;
+        if (view && indirect_buffer) {
+            instance_buffer = batch->unculled_buffer;
+            instance_offset = batch->unculled_offset;
+            indirect_buffer = NULL;
+        }
         
-        if (!batch->pipeline || !batch->vertex_buffer || 
-            !batch->index_buffer || !batch->instance_buffer) {
+        if (!batch->pipeline || !batch->bind_group || !batch->index_count || !instance_buffer) {
             ecs_warn("WebGPU: Skipping invalid batch for geometry type: %llu",
                     batch->geometry_type);
             continue;
         }
         
-        /* Set pipeline */
-        wgpuRenderPassEncoderSetPipeline(render_pass, batch->pipeline);
-        
-        /* Bind uniform buffer bind groups */
-        if (renderer->camera_bind_group) {
-            wgpuRenderPassEncoderSetBindGroup(render_pass, 0, renderer->camera_bind_group, 0, NULL);
+        WGPUBuffer index_buffer = webgpu_mesh_registry_index_buffer(meshes, batch->index_format);
+        if (!index_buffer) {
+            continue;
         }
-        if (renderer->light_bind_group) {
-            wgpuRenderPassEncoderSetBindGroup(render_pass, 1, renderer->light_bind_group, 0, NULL);
+        
+        /* Instances: the storage buffer as group 3, else a vertex buffer */
+        WGPUBindGroup instances = NULL;
+        if (storage) {
+            instances = webgpu_instance_storage_bind_group(storage,
+                renderer->device, renderer->pipeline_cache->instance_layout,
+                instance_buffer, instance_offset);
+            if (!instances) {
+                continue;
+            }
         }
         
-        /* Bind vertex buffers */
-        wgpuRenderPassEncoderSetVertexBuffer(render_pass, 0, 
-            batch->vertex_buffer, 0, WGPU_WHOLE_SIZE);
-        wgpuRenderPassEncoderSetVertexBuffer(render_pass, 1,
-            batch->instance_buffer, 0, WGPU_WHOLE_SIZE);
+        if (bundles && renderer->camera_bind_group && renderer->light_bind_group) {
+            webgpu_bundle_state_t state;
+            ecs_os_memset_t(&state, 0, webgpu_bundle_state_t);
+            state.pipeline = batch->pipeline;
+            state.camera = renderer->camera_bind_group;
+            state.camera_offset = view_offset;
+            state.light = renderer->light_bind_group;
+            state.light_offset = light_offset;
+            state.material = batch->bind_group;
+            state.material_offset = batch->material_offset;
+            state.instance_group = instances;
+            state.instance_buffer = instances ? NULL : instance_buffer;
+            state.instance_offset = instances ? 0 : instance_offset;
+            state.vertex_buffer = meshes->vertex_buffer;
+            state.index_buffer = index_buffer;
+            state.index_format = batch->index_format;
+            state.index_count = batch->index_count;
+            state.instance_count = batch->instance_count;
+            state.first_index = batch->first_index;
+            state.base_vertex = batch->base_vertex;
+            state.first_instance = batch->first_instance;
+            state.indirect_buffer = indirect_buffer;
+            state.indirect_offset = indirect_buffer ? batch->indirect_offset : 0;
+            state.color_format = renderer->surface_format;
+            state.depth_format = targets && targets->depth ?
+                WEBGPU_DEPTH_FORMAT : WGPUTextureFormat_Undefined;
+            state.samples = targets && targets->samples ? targets->samples : 1;
             
-        /* Bind index buffer */
-        wgpuRenderPassEncoderSetIndexBuffer(render_pass, batch->index_buffer,
-            WGPUIndexFormat_Uint16, 0, WGPU_WHOLE_SIZE);
+            if (webgpu_bundle_cache_draw(bundles, renderer->device,
+                webgpu_bundle_key(batch, slot), &state))
+            {
+                renderer->draw_calls++;
+                continue;
+            }
+        }
         
-        /* Draw indexed with instancing */
-        wgpuRenderPassEncoderDrawIndexed(render_pass,
-            batch->index_count, batch->instance_count, 0, 0, 0);
+        /* Bundles reset the pass state, bind everything again after them */
+        if (webgpu_bundle_cache_execute(bundles, render_pass)) {
+            shared_bound = false;
+            bound_pipeline = NULL;
+            bound_material = NULL;
+            bound_instances = NULL;
+            bound_index_format = WGPUIndexFormat_Undefined;
+        }
+        
+        /* All meshes share one vertex buffer, bound once with the camera and
+         * light blocks. Index arenas are bound by format, meshes with uint32
+         * indices have their own. */
+        if (!shared_bound) {
+            wgpuRenderPassEncoderSetVertexBuffer(render_pass, 0, 
+                meshes->vertex_buffer, 0, WGPU_WHOLE_SIZE);
+            if (renderer->camera_bind_group) {
+                wgpuRenderPassEncoderSetBindGroup(render_pass, 0, renderer->camera_bind_group, 1, &view_offset);
+            }
+            if (renderer->light_bind_group) {
+                wgpuRenderPassEncoderSetBindGroup(render_pass, 1, renderer->light_bind_group, 1, &light_offset);
+            }
+            shared_bound = true;
+        }
+        
+        if (batch->index_format != bound_index_format) {
+            wgpuRenderPassEncoderSetIndexBuffer(render_pass, index_buffer,
+                batch->index_format, 0, WGPU_WHOLE_SIZE);
+            bound_index_format = batch->index_format;
+            renderer->state_changes++;
+        }
+        
+        if (batch->pipeline != bound_pipeline) {
+            wgpuRenderPassEncoderSetPipeline(render_pass, batch->pipeline);
+            bound_pipeline = batch->pipeline;
+            renderer->state_changes++;
+        }
+        
+        if (batch->bind_group != bound_material || batch->material_offset != bound_material_offset) {
+            wgpuRenderPassEncoderSetBindGroup(render_pass, 2, batch->bind_group, 1, &batch->material_offset);
+            bound_material = batch->bind_group;
+            bound_material_offset = batch->material_offset;
+            renderer->state_changes++;
+        }
+        
+        if (instance_buffer != bound_instances || instance_offset != bound_instance_offset) {
+            if (instances) {
+                wgpuRenderPassEncoderSetBindGroup(render_pass, 3, instances, 0, NULL);
+            } else {
+                wgpuRenderPassEncoderSetVertexBuffer(render_pass, 1,
+                    instance_buffer, instance_offset, WGPU_WHOLE_SIZE);
+            }
+            bound_instances = instance_buffer;
+            bound_instance_offset = instance_offset;
+            renderer->state_changes++;
+        }
+        
+        /* Culled batches take their visible instance count from the GPU */
+        if (indirect_buffer) {
+            wgpuRenderPassEncoderDrawIndexedIndirect(render_pass, 
+                indirect_buffer, batch->indirect_offset);
+        } else {
+            /* Draw the batch's mesh range with instancing */
+            wgpuRenderPassEncoderDrawIndexed(render_pass,
+                batch->index_count, batch->instance_count,
+                batch->first_index, batch->base_vertex, batch->first_instance);
+        }
+        renderer->draw_calls++;
         
         ecs_trace("WebGPU: Rendered batch with %d instances, %d indices",
                  batch->instance_count, batch->index_count);
     }
     
-    /* Cleanup batch data */
-    for (int32_t i = 0; i < batch_count; i++) {
-        webgpu_render_batch_t *batch = &batches[i];
-        
-        ecs_os_free(batch->transforms);
-        ecs_os_free(batch->colors);
-        
-        /* GPU resources will be cleaned up by renderer destructor */
+    /* Bundles queued after the last direct draw */
+    webgpu_bundle_cache_execute(bundles, render_pass);
+    if (bundles) {
+        renderer->bundles_recorded = bundles->recorded;
+        renderer->bundles_replayed = bundles->replayed;
     }
-    
-    ecs_vec_clear(&renderer->render_batches);
 }
 
 /**
- * Import material subsystem (simplified)
+ * Import the material subsystem. Materials are shared through IsA, so the
+ * component is inherited by instances of a material entity.
  */
 void webgpu_material_import(ecs_world_t *world) {
-    /* Simplified implementation - just register default material components */
-    (void)world;
-    ecs_trace("WebGPU: Material subsystem imported (simplified)");
-}
\ No newline at end of file
+    ecs_add_pair(world, ecs_id(WebGPUMaterial), EcsOnInstantiate, EcsInherit);
+    ecs_trace("WebGPU: Material subsystem imported");
+}
@@ -0,0 +1,214 @@
+/**
+ * @file rendering/render_targets.c
+ * @brief Pooled render targets and the attachments of the main pass.
+ *
+ * Targets are requested every frame by key (size, format, sample count,
+ * usage) and reused while the key stays the same, so a steady frame
+ * allocates nothing. A target that was not requested for more frames than
+ * can be in flight goes to the resource pool, which destroys it once the
+ * GPU finished the frames that used it.
+ *
+ * Attachments match the size of the back buffer. While a canvas is resized
+ * the renderer configures its surface at the canvas size rounded up to
+ * WEBGPU_TARGET_BUCKET pixels, until the size settled for
+ * WEBGPU_RESIZE_DEBOUNCE_FRAMES, so a resize drag reuses a few bucket sized
+ * attachments rather than allocating new ones for every pixel of change.
+ */
+
+#include "../private_api.h"
+
+/**
+ * Create an empty render target pool
+ */
+webgpu_render_target_pool_t* webgpu_render_target_pool_create(webgpu_resource_pool_t *resources) {
+    webgpu_render_target_pool_t *pool = ecs_os_calloc_t(webgpu_render_target_pool_t);
+    pool->resources = resources;
+    ecs_vec_init_t(NULL, &pool->targets, webgpu_render_target_t, 0);
+    return pool;
+}
+
+/**
+ * Release the texture of a target to a resource pool, or destroy it right
+ * away without one
+ */
+static void target_release(webgpu_render_target_t *target, webgpu_resource_pool_t *resources) {
+    webgpu_release_texture_view(resources, target->view);
+    webgpu_release_texture(resources, target->texture);
+}
+
+/**
+ * Destroy all targets of a pool
+ */
+void webgpu_render_target_pool_destroy(webgpu_render_target_pool_t *pool) {
+    if (!pool) {
+        return;
+    }
+
+    webgpu_render_target_t *targets = ecs_vec_first_t(&pool->targets, webgpu_render_target_t);
+    for (int32_t i = 0; i < ecs_vec_count(&pool->targets); i++) {
+        target_release(&targets[i], NULL);
+    }
+
+    ecs_vec_fini_t(NULL, &pool->targets, webgpu_render_target_t);
+    ecs_os_free(pool);
+}
+
+/**
+ * Start a frame: releases the targets that were not used recently
+ */
+void webgpu_render_target_pool_begin(webgpu_render_target_pool_t *pool) {
+    if (!pool) {
+        return;
+    }
+
+    pool->frame++;
+
+    webgpu_render_target_t *targets = ecs_vec_first_t(&pool->targets, webgpu_render_target_t);
+    for (int32_t i = ecs_vec_count(&pool->targets) - 1; i >= 0; i--) {
+        if (pool->frame - targets[i].last_used <= WEBGPU_FRAMES_IN_FLIGHT) {
+            continue;
+        }
+
+        ecs_trace("WebGPU: Released %ux%u render target (format %d, %u samples)",
+            targets[i].width, targets[i].height, targets[i].format, targets[i].samples);
+        target_release(&targets[i], pool->resources);
+        ecs_vec_remove_t(&pool->targets, webgpu_render_target_t, i);
+    }
+}
+
+/**
+ * Get a target for this frame, creating it when no unused one matches.
+ * Each target is handed out once per frame. Returns its view, and its
+ * texture in texture when not NULL.
+ */
+WGPUTextureView webgpu_render_target_acquire(webgpu_render_target_pool_t *pool,
+                                             WGPUDevice device,
+                                             uint32_t width,
+                                             uint32_t height,
+                                             WGPUTextureFormat format,
+                                             uint32_t samples,
+                                             WGPUTextureUsage usage,
+                                             WGPUTexture *texture) {
+    if (!pool || !device || !width || !height) {
+        return NULL;
+    }
+
+    webgpu_render_target_t *targets = ecs_vec_first_t(&pool->targets, webgpu_render_target_t);
+    for (int32_t i = 0; i < ecs_vec_count(&pool->targets); i++) {
+        webgpu_render_target_t *target = &targets[i];
+        if (target->last_used == pool->frame || target->width != width ||
+            target->height != height || target->format != format ||
+            target->samples != samples || target->usage != usage) {
+            continue;
+        }
+
+        target->last_used = pool->frame;
+        if (texture) {
+            *texture = target->texture;
+        }
+        return target->view;
+    }
+
+    WGPUTextureDescriptor texture_desc = {
+        .label = "Pooled Render Target",
+        .usage = usage,
+        .dimension = WGPUTextureDimension_2D,
+        .size = {
+            .width = width,
+            .height = height,
+            .depthOrArrayLayers = 1,
+        },
+        .format = format,
+        .mipLevelCount = 1,
+        .sampleCount = samples,
+    };
+
+    WGPUTexture created = wgpuDeviceCreateTexture(device, &texture_desc);
+    if (!created) {
+        ecs_err("WebGPU: Failed to create %ux%u render target", width, height);
+        return NULL;
+    }
+
+    WGPUTextureView view = wgpuTextureCreateView(created, NULL);
+    if (!view) {
+        ecs_err("WebGPU: Failed to create render target view");
+        wgpuTextureDestroy(created);
+        wgpuTextureRelease(created);
+        return NULL;
+    }
+
+    webgpu_render_target_t *target = ecs_vec_append_t(NULL, &pool->targets, webgpu_render_target_t);
+    *target = (webgpu_render_target_t){
+        .texture = created,
+        .view = view,
+        .width = width,
+        .height = height,
+        .format = format,
+        .samples = samples,
+        .usage = usage,
+        .last_used = pool->frame,
+    };
+
+    ecs_trace("WebGPU: Created %ux%u render target (format %d, %u samples)",
+        width, height, format, samples);
+
+    if (texture) {
+        *texture = created;
+    }
+    return view;
+}
+
+/**
+ * Round a size up to the resize bucket
+ */
+uint32_t webgpu_target_bucket(uint32_t size) {
+    return (size + WEBGPU_TARGET_BUCKET - 1) / WEBGPU_TARGET_BUCKET * WEBGPU_TARGET_BUCKET;
+}
+
+/**
+ * Get the attachments of the main pass for this frame. Multisampled color
+ * and depth are not stored, only the resolved color is kept.
+ */
+bool webgpu_frame_targets_acquire(WebGPURenderer *renderer,
+                                  WGPUTexture back_buffer,
+                                  WGPUTextureView back_buffer_view,
+                                  webgpu_frame_targets_t *targets) {
+    ecs_os_memset_t(targets, 0, webgpu_frame_targets_t);
+    if (!back_buffer || !back_buffer_view) {
+        return false;
+    }
+
+    uint32_t width = wgpuTextureGetWidth(back_buffer);
+    uint32_t height = wgpuTextureGetHeight(back_buffer);
+
+    webgpu_render_target_pool_t *pool = renderer->targets;
+    WGPUDevice device = renderer->device;
+    WGPUTextureFormat format = renderer->surface_format;
+    uint32_t samples = renderer->sample_count > 1 ? renderer->sample_count : 1;
+
+    targets->width = width;
+    targets->height = height;
+    targets->samples = samples;
+
+    if (samples > 1) {
+        targets->resolve = back_buffer_view;
+        targets->color = webgpu_render_target_acquire(pool, device, width, height,
+            format, samples, WGPUTextureUsage_RenderAttachment, NULL);
+        if (!targets->color) {
+            return false;
+        }
+    } else {
+        targets->color = back_buffer_view;
+    }
+
+    /* Occlusion culling reads the depth into the next frame's HiZ */
+    WGPUTextureUsage depth_usage = WGPUTextureUsage_RenderAttachment;
+    if (renderer->occlusion_culling && renderer->hiz && samples == 1) {
+        depth_usage |= WGPUTextureUsage_TextureBinding;
+        targets->depth_sampled = true;
+    }
+
+    targets->depth = webgpu_render_target_acquire(pool, device, width, height,
+        WEBGPU_DEPTH_FORMAT, samples, depth_usage, NULL);
+    return true;
+}
@@ -0,0 +1,497 @@
+/**
+ * @file rendering/shadows.c
+ * @brief Cascaded shadow maps of the directional light.
+ *
+ * The camera's view depth up to the shadow distance is split into cascades,
+ * logarithmically near the camera and evenly further out. Each cascade is
+ * fitted with an orthographic camera along the light around the bounding
+ * sphere of its slice of the view, with the center snapped to whole texels
+ * so shadows don't shimmer while the camera moves. Cascade cameras are
+ * blocks of the uniform ring, only written when the camera, the light or
+ * the resolution changed.
+ *
+ * All cascades are drawn in one depth only pass into the tiles of an atlas,
+ * from the same batches, instance records and mesh arenas as the main pass.
+ * The atlas is a transient texture of the frame graph, sized by
+ * webgpu_shadow_atlas_size. With GPU culling each cascade draws the records
+ * its own frustum kept, through its own indirect arguments. The atlas, the
+ * cascades and a comparison sampler are part of the light bind group, which
+ * is recreated when the graph hands out another atlas.
+ */
+
+#include "../private_api.h"
+
+/**
+ * Texels per cascade side, two cascades side by side must fit the default
+ * maxTextureDimension2D
+ */
+static uint32_t shadow_resolution(const WebGPURenderer *renderer) {
+    uint32_t resolution = renderer->shadow_resolution ?
+        renderer->shadow_resolution : WEBGPU_SHADOW_RESOLUTION;
+    if (resolution < 256) {
+        return 256;
+    }
+    return resolution > 4096 ? 4096 : resolution;
+}
+
+/**
+ * Orthographic projection with clip z in [0, 1], as the cull shader and the
+ * depth attachment expect
+ */
+static void ortho_zo(float left, float right, float bottom, float top,
+                     float near_, float far_, mat4 dest) {
+    glm_mat4_zero(dest);
+    dest[0][0] = 2.0f / (right - left);
+    dest[1][1] = 2.0f / (top - bottom);
+    dest[2][2] = -1.0f / (far_ - near_);
+    dest[3][0] = -(right + left) / (right - left);
+    dest[3][1] = -(top + bottom) / (top - bottom);
+    dest[3][2] = -near_ / (far_ - near_);
+    dest[3][3] = 1.0f;
+}
+
+/**
+ * Fit the cascades to the renderer's view and light
+ */
+static void fit_cascades(const WebGPURenderer *renderer,
+                         const webgpu_view_uniform_t *view,
+                         const EcsDirectionalLight *light,
+                         webgpu_shadow_uniform_t *uniform,
+                         mat4 *views,
+                         mat4 *projections) {
+    const EcsCamera *camera = &view->camera;
+    uint32_t count = renderer->shadows->cascades;
+    uint32_t resolution = shadow_resolution(renderer);
+    uint32_t columns = count > 1 ? 2 : 1;
+    uint32_t rows = (count + 1) / 2;
+
+    float near_ = camera->near_ > 0.01f ? camera->near_ : 0.01f;
+    float far_ = camera->far_ > near_ ? camera->far_ : near_ + 1.0f;
+    if (renderer->shadow_distance > near_ && renderer->shadow_distance < far_) {
+        far_ = renderer->shadow_distance;
+    }
+
+    /* Half extents of the view at depth 1, or of an orthographic camera */
+    float aspect = view->height ? (float)view->width / (float)view->height : 1.0f;
+    float tan_half = tanf(glm_rad(camera->fov) * 0.5f);
+    float ortho_half = glm_vec3_distance(
+        (float*)camera->position, (float*)camera->lookat) * tan_half;
+
+    mat4 camera_world;
+    glm_mat4_inv((vec4*)view->view, camera_world);
+
+    /* One light rotation for all cascades, snapping happens in its space */
+    vec3 direction = {light->direction[0], light->direction[1], light->direction[2]};
+    if (glm_vec3_norm(direction) < 1e-6f) {
+        glm_vec3_copy((vec3){0.0f, -1.0f, 0.0f}, direction);
+    }
+    glm_vec3_normalize(direction);
+    vec3 up = {0.0f, 1.0f, 0.0f};
+    if (fabsf(direction[1]) > 0.99f) {
+        glm_vec3_copy((vec3){0.0f, 0.0f, 1.0f}, up);
+    }
+    mat4 light_view;
+    glm_lookat((vec3){0.0f, 0.0f, 0.0f}, direction, up, light_view);
+
+    float slice_near = near_;
+    for (uint32_t c = 0; c < count; c++) {
+        float t = (float)(c + 1) / (float)count;
+        float split = WEBGPU_SHADOW_SPLIT_LAMBDA * near_ * powf(far_ / near_, t) +
+            (1.0f - WEBGPU_SHADOW_SPLIT_LAMBDA) * (near_ + (far_ - near_) * t);
+
+        /* Bounding sphere of the corners of the slice */
+        vec3 corners[8];
+        vec3 center = {0.0f, 0.0f, 0.0f};
+        for (int32_t i = 0; i < 8; i++) {
+            float depth = i & 4 ? split : slice_near;
+            float half_height = camera->ortho ? ortho_half : depth * tan_half;
+            float half_width = half_height * aspect;
+            vec4 local = {
+                i & 1 ? half_width : -half_width,
+                i & 2 ? half_height : -half_height,
+                -depth,
+                1.0f
+            };
+            vec4 world;
+            glm_mat4_mulv(camera_world, local, world);
+            glm_vec3_copy(world, corners[i]);
+            glm_vec3_add(center, corners[i], center);
+        }
+        glm_vec3_scale(center, 1.0f / 8.0f, center);
+
+        float radius = 0.0f;
+        for (int32_t i = 0; i < 8; i++) {
+            float distance = glm_vec3_distance(center, corners[i]);
+            radius = distance > radius ? distance : radius;
+        }
+
+        /* A radius that changes in steps keeps the texel size steady */
+        radius = ceilf(radius * 16.0f) / 16.0f;
+        float texel = 2.0f * radius / (float)resolution;
+        vec3 light_center;
+        glm_mat4_mulv3(light_view, center, 1.0f, light_center);
+        light_center[0] = floorf(light_center[0] / texel) * texel;
+        light_center[1] = floorf(light_center[1] / texel) * texel;
+
+        /* Casters between the light and the slice are kept by reaching back
+         * the whole shadow distance */
+        ortho_zo(light_center[0] - radius, light_center[0] + radius,
+            light_center[1] - radius, light_center[1] + radius,
+            -(light_center[2] + radius + far_), -(light_center[2] - radius),
+            projections[c]);
+        glm_mat4_copy(light_view, views[c]);
+
+        mat4 view_projection;
+        glm_mat4_mul(projections[c], light_view, view_projection);
+        memcpy(uniform->view_projection[c], view_projection, sizeof(mat4));
+
+        uniform->tiles[c][0] = 1.0f / (float)columns;
+        uniform->tiles[c][1] = 1.0f / (float)rows;
+        uniform->tiles[c][2] = (float)(c % 2) / (float)columns;
+        uniform->tiles[c][3] = (float)(c / 2) / (float)rows;
+        uniform->splits[c] = split;
+        slice_near = split;
+    }
+
+    uniform->cascades = count;
+    webgpu_view_depth_plane(uniform->view_plane, (vec4*)view->view);
+    uniform->bias = WEBGPU_SHADOW_DEPTH_BIAS;
+    uniform->texel_size[0] = 1.0f / (float)(resolution * columns);
+    uniform->texel_size[1] = 1.0f / (float)(resolution * rows);
+}
+
+/**
+ * Create the shadow state of a renderer with cascades shadow cascades
+ */
+webgpu_shadows_t* webgpu_shadows_create(WGPUDevice device, uint32_t cascades) {
+    if (!device || cascades < 2 || cascades > WEBGPU_MAX_SHADOW_CASCADES) {
+        return NULL;
+    }
+
+    WGPUSampler sampler = wgpuDeviceCreateSampler(device, &(WGPUSamplerDescriptor){
+        .label = "Shadow Sampler",
+        .addressModeU = WGPUAddressMode_ClampToEdge,
+        .addressModeV = WGPUAddressMode_ClampToEdge,
+        .addressModeW = WGPUAddressMode_ClampToEdge,
+        .magFilter = WGPUFilterMode_Linear,
+        .minFilter = WGPUFilterMode_Linear,
+        .mipmapFilter = WGPUMipmapFilterMode_Nearest,
+        .lodMinClamp = 0.0f,
+        .lodMaxClamp = 32.0f,
+        .compare = WGPUCompareFunction_LessEqual,
+        .maxAnisotropy = 1,
+    });
+    if (!sampler) {
+        ecs_err("WebGPU: Failed to create shadow sampler");
+        return NULL;
+    }
+
+    webgpu_shadows_t *shadows = ecs_os_calloc_t(webgpu_shadows_t);
+    shadows->cascades = cascades;
+    shadows->sampler = sampler;
+    return shadows;
+}
+
+/**
+ * Release the sampler and bind groups. The atlas belongs to the render
+ * target pool, the light bind group to the renderer.
+ */
+void webgpu_shadows_destroy(webgpu_shadows_t *shadows) {
+    if (!shadows) {
+        return;
+    }
+
+    if (shadows->empty_group) {
+        wgpuBindGroupRelease(shadows->empty_group);
+    }
+
+    if (shadows->sampler) {
+        wgpuSamplerRelease(shadows->sampler);
+    }
+
+    ecs_os_free(shadows);
+}
+
+/**
+ * Upload the cascade camera blocks and the shadow block if the renderer's
+ * camera, light or shadow settings changed. Must run after the view and
+ * light blocks were updated.
+ */
+void webgpu_update_shadows(WebGPURenderer *renderer) {
+    webgpu_shadows_t *shadows = renderer->shadows;
+    webgpu_uniforms_t *uniforms = renderer->uniforms;
+    if (!shadows || !uniforms) {
+        return;
+    }
+
+    /* Zeroed, so blocks compare with memcmp */
+    webgpu_shadow_uniform_t uniform;
+    ecs_os_memset_t(&uniform, 0, webgpu_shadow_uniform_t);
+    mat4 views[WEBGPU_MAX_SHADOW_CASCADES];
+    mat4 projections[WEBGPU_MAX_SHADOW_CASCADES];
+
+    const webgpu_view_uniform_t *view = webgpu_uniforms_get_view(uniforms, 0);
+    const webgpu_light_state_t *light = &uniforms->lights[0];
+    if (view && light->valid) {
+        fit_cascades(renderer, view, &light->light, &uniform, views, projections);
+    }
+
+    if (shadows->valid && !memcmp(&shadows->uniform, &uniform, sizeof(uniform))) {
+        return;
+    }
+
+    shadows->uniform = uniform;
+    shadows->valid = true;
+
+    /* view, projection, view_projection, matching the Camera struct */
+    for (uint32_t c = 0; c < uniform.cascades; c++) {
+        float camera_data[48];
+        memcpy(&camera_data[0], views[c], sizeof(mat4));
+        memcpy(&camera_data[16], projections[c], sizeof(mat4));
+        memcpy(&camera_data[32], uniform.view_projection[c], sizeof(mat4));
+        wgpuQueueWriteBuffer(renderer->queue, uniforms->buffer,
+            webgpu_cascade_uniform_offset(c), camera_data, sizeof(camera_data));
+    }
+
+    wgpuQueueWriteBuffer(renderer->queue, uniforms->buffer,
+        webgpu_shadow_uniform_offset(), &uniform, sizeof(uniform));
+    uniforms->writes += uniform.cascades + 1;
+}
+
+/**
+ * Get the block a cascade's visible records of a geometry are compacted
+ * into. Storage instancing compacts all geometries into one block per
+ * cascade, at the records' offsets in the instance storage.
+ */
+const WebGPUBufferBlock* webgpu_shadow_visible_block(WebGPURenderer *renderer,
+                                                     WebGPUGeometry *geometry,
+                                                     uint32_t cascade) {
+    if (cascade >= WEBGPU_MAX_SHADOW_CASCADES) {
+        return NULL;
+    }
+
+    if (renderer->instance_storage) {
+        return &renderer->instance_storage->blocks[WEBGPU_INSTANCE_STORAGE_SHADOW + cascade];
+    }
+
+    return &geometry->shadow_visible[cascade];
+}
+
+/**
+ * Get the size of the shadow atlas: the tiles of the cascades, two per row
+ */
+void webgpu_shadow_atlas_size(const WebGPURenderer *renderer,
+                              uint32_t *width,
+                              uint32_t *height) {
+    uint32_t cascades = renderer->shadows ? renderer->shadows->cascades : 0;
+    uint32_t resolution = shadow_resolution(renderer);
+    *width = resolution * (cascades > 1 ? 2 : 1);
+    *height = resolution * ((cascades + 1) / 2);
+}
+
+/**
+ * Point the light bind group at an atlas. The previous group may still be
+ * used by a submitted frame, so it goes through the resource pool.
+ */
+static bool bind_atlas(WebGPURenderer *renderer, WGPUTextureView atlas) {
+    webgpu_shadows_t *shadows = renderer->shadows;
+    if (renderer->light_bind_group && shadows->atlas_view == atlas) {
+        return true;
+    }
+
+    WGPUBindGroupEntry entries[] = {
+        { .binding = 0, .buffer = renderer->uniforms->buffer,
+          .offset = 0, .size = WEBGPU_LIGHT_UNIFORM_SIZE },
+        { .binding = 1, .buffer = renderer->uniforms->buffer,
+          .offset = webgpu_shadow_uniform_offset(), .size = WEBGPU_SHADOW_UNIFORM_SIZE },
+        { .binding = 2, .textureView = atlas },
+        { .binding = 3, .sampler = shadows->sampler },
+    };
+
+    WGPUBindGroupDescriptor bind_group_desc = {
+        .label = "Shadow Light Bind Group",
+        .layout = renderer->light_layout,
+        .entryCount = 4,
+        .entries = entries,
+    };
+
+    WGPUBindGroup bind_group = wgpuDeviceCreateBindGroup(renderer->device, &bind_group_desc);
+    if (!bind_group) {
+        ecs_err("WebGPU: Failed to create shadow light bind group");
+        return false;
+    }
+
+    if (renderer->light_bind_group) {
+        webgpu_release_bind_group(renderer->resources, renderer->light_bind_group);
+    }
+    renderer->light_bind_group = bind_group;
+    shadows->atlas_view = atlas;
+    return true;
+}
+
+/**
+ * Draw the opaque batches into one cascade's tile. Transparent geometry
+ * doesn't cast shadows.
+ */
+static void draw_cascade(WebGPURenderer *renderer,
+                         WGPURenderPassEncoder render_pass,
+                         uint32_t cascade) {
+    webgpu_shadows_t *shadows = renderer->shadows;
+    webgpu_instance_storage_t *storage = renderer->instance_storage;
+    webgpu_mesh_registry_t *meshes = renderer->mesh_registry;
+    int32_t item_count = ecs_vec_count(&renderer->render_queue);
+    webgpu_draw_item_t *items = ecs_vec_first_t(&renderer->render_queue, webgpu_draw_item_t);
+    webgpu_render_batch_t *batches = ecs_vec_first_t(
+        &renderer->render_batches, webgpu_render_batch_t);
+
+    WGPUBuffer bound_instances = NULL;
+    uint64_t bound_instance_offset = 0;
+    uint32_t bound_index_format = WGPUIndexFormat_Undefined;
+
+    for (int32_t i = 0; i < item_count; i++) {
+        webgpu_render_batch_t *batch = &batches[items[i].batch];
+        if (batch->transparent || !batch->index_count) {
+            continue;
+        }
+
+        /* Batches culled for the camera were culled for every cascade, the
+         * rest draw all of their records */
+        bool indirect = batch->indirect_buffer && shadows->culled;
+        WGPUBuffer instance_buffer = batch->indirect_buffer ?
+            batch->unculled_buffer : batch->instance_buffer;
+        uint64_t instance_offset = batch->indirect_buffer ?
+            batch->unculled_offset : batch->instance_offset;
+        if (indirect) {
+            const WebGPUBufferBlock *visible = webgpu_shadow_visible_block(
+                renderer, batch->geometry, cascade);
+            instance_buffer = visible->buffer;
+            instance_offset = visible->offset;
+        }
+
+        WGPUBuffer index_buffer = webgpu_mesh_registry_index_buffer(meshes, batch->index_format);
+        if (!instance_buffer || !index_buffer) {
+            continue;
+        }
+
+        if (batch->index_format != bound_index_format) {
+            wgpuRenderPassEncoderSetIndexBuffer(render_pass, index_buffer,
+                batch->index_format, 0, WGPU_WHOLE_SIZE);
+            bound_index_format = batch->index_format;
+        }
+
+        if (instance_buffer != bound_instances || instance_offset != bound_instance_offset) {
+            if (storage) {
+                WGPUBindGroup instances = webgpu_instance_storage_bind_group(storage,
+                    renderer->device, renderer->pipeline_cache->instance_layout,
+                    instance_buffer, instance_offset);
+                if (!instances) {
+                    continue;
+                }
+                wgpuRenderPassEncoderSetBindGroup(render_pass, 3, instances, 0, NULL);
+            } else {
+                wgpuRenderPassEncoderSetVertexBuffer(render_pass, 1,
+                    instance_buffer, instance_offset, WGPU_WHOLE_SIZE);
+            }
+            bound_instances = instance_buffer;
+            bound_instance_offset = instance_offset;
+        }
+
+        if (indirect) {
+            wgpuRenderPassEncoderDrawIndexedIndirect(render_pass, batch->indirect_buffer,
+                batch->indirect_offset + (cascade + 1) * shadows->args_stride);
+        } else {
+            wgpuRenderPassEncoderDrawIndexed(render_pass,
+                batch->index_count, batch->instance_count,
+                batch->first_index, batch->base_vertex, batch->first_instance);
+        }
+        renderer->shadow_draws++;
+    }
+}
+
+/**
+ * Record the shadow pass: every cascade into its tile of this frame's atlas.
+ * Must be called after the batches were culled and before the main pass,
+ * which samples the atlas. The atlas is cleared even when nothing casts,
+ * without one the main pass keeps the last light bind group.
+ */
+void webgpu_render_shadows(WebGPURenderer *renderer,
+                           WGPUCommandEncoder encoder,
+                           WGPUTextureView atlas) {
+    webgpu_shadows_t *shadows = renderer->shadows;
+    renderer->shadow_draws = 0;
+    if (!shadows || !renderer->uniforms || !renderer->pipeline_cache) {
+        return;
+    }
+
+    if (!atlas || !bind_atlas(renderer, atlas)) {
+        ecs_warn("WebGPU: No shadow atlas, drawing without shadows");
+        return;
+    }
+
+    uint32_t resolution = shadow_resolution(renderer);
+
+    WGPURenderPassDepthStencilAttachment depth_attachment = {
+        .view = atlas,
+        .depthClearValue = 1.0f,
+        .depthLoadOp = WGPULoadOp_Clear,
+        .depthStoreOp = WGPUStoreOp_Store,
+        .stencilLoadOp = WGPULoadOp_Undefined,
+        .stencilStoreOp = WGPUStoreOp_Undefined,
+    };
+
+    WGPURenderPassDescriptor pass_desc = {
+        .label = "Shadow Cascade Pass",
+        .colorAttachmentCount = 0,
+        .depthStencilAttachment = &depth_attachment,
+        .timestampWrites = webgpu_profile_render_pass(renderer, WebGPUPassShadow),
+    };
+    WGPURenderPassEncoder render_pass = wgpuCommandEncoderBeginRenderPass(encoder, &pass_desc);
+
+    webgpu_pipeline_key_t key;
+    webgpu_pipeline_key_init(&key, renderer);
+    webgpu_pipeline_key_shadow_caster(&key);
+    WGPURenderPipeline pipeline = webgpu_pipeline_cache_get(renderer->pipeline_cache, &key, NULL);
+
+    /* Storage casters bind empty groups between the camera and the records */
+    webgpu_instance_storage_t *storage = renderer->instance_storage;
+    if (storage && !shadows->empty_group) {
+        WGPUBindGroupDescriptor empty_desc = {
+            .label = "Empty Bind Group",
+            .layout = renderer->pipeline_cache->empty_layout,
+            .entryCount = 0,
+        };
+        shadows->empty_group = wgpuDeviceCreateBindGroup(renderer->device, &empty_desc);
+    }
+
+    uint32_t cascades = shadows->uniform.cascades;
+    webgpu_mesh_registry_t *meshes = renderer->mesh_registry;
+    if (!pipeline || !meshes || !meshes->vertex_buffer || !renderer->camera_bind_group ||
+        (storage && !shadows->empty_group)) {
+        /* The caster variant is still compiling, draw again once it's ready */
+        renderer->redraw |= !pipeline && cascades;
+        cascades = 0;
+    }
+
+    if (cascades) {
+        wgpuRenderPassEncoderSetPipeline(render_pass, pipeline);
+        wgpuRenderPassEncoderSetVertexBuffer(render_pass, 0,
+            meshes->vertex_buffer, 0, WGPU_WHOLE_SIZE);
+        if (storage) {
+            wgpuRenderPassEncoderSetBindGroup(render_pass, 1, shadows->empty_group, 0, NULL);
+            wgpuRenderPassEncoderSetBindGroup(render_pass, 2, shadows->empty_group, 0, NULL);
+        }
+    }
+
+    for (uint32_t c = 0; c < cascades; c++) {
+        wgpuRenderPassEncoderSetViewport(render_pass,
+            (float)((c % 2) * resolution), (float)((c / 2) * resolution),
+            (float)resolution, (float)resolution, 0.0f, 1.0f);
+        uint32_t camera_offset = webgpu_cascade_uniform_offset(c);
+        wgpuRenderPassEncoderSetBindGroup(render_pass, 0, renderer->camera_bind_group,
+            1, &camera_offset);
+        draw_cascade(renderer, render_pass, c);
+    }
+
+    wgpuRenderPassEncoderEnd(render_pass);
+    wgpuRenderPassEncoderRelease(render_pass);
+}
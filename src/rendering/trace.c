@@ -0,0 +1,84 @@
+/**
+ * @file rendering/trace.c
+ * @brief Leveled trace events with a ring buffer that can be dumped on demand.
+ *
+ * Events are forwarded to the Flecs log and kept in a fixed size ring, so the
+ * last WEBGPU_TRACE_RING_SIZE events can be printed after the fact without
+ * logging every frame. Events are recorded from the main thread only.
+ */
+
+#include "../private_api.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#if WEBGPU_TRACE_LEVEL > WEBGPU_TRACE_OFF
+
+#define TRACE_MESSAGE_SIZE 120
+
+typedef struct {
+    uint32_t frame;
+    int32_t level;
+    char message[TRACE_MESSAGE_SIZE];
+} webgpu_trace_event_t;
+
+static webgpu_trace_event_t trace_ring[WEBGPU_TRACE_RING_SIZE];
+static uint32_t trace_count = 0;
+static uint32_t trace_frame = 0;
+
+static const char *trace_level_names[] = {
+    [WEBGPU_TRACE_ERROR] = "error",
+    [WEBGPU_TRACE_INFO] = "info",
+    [WEBGPU_TRACE_TRACE] = "trace",
+};
+
+/**
+ * Set the frame number recorded with subsequent events
+ */
+void webgpu_trace_set_frame(uint32_t frame) {
+    trace_frame = frame;
+}
+
+/**
+ * Record an event and forward it to the Flecs log. Use the webgpu_error,
+ * webgpu_info and webgpu_trace macros, which compile out by level.
+ */
+void webgpu_trace_(int32_t level, const char *file, int32_t line, const char *fmt, ...) {
+    webgpu_trace_event_t *event = &trace_ring[trace_count % WEBGPU_TRACE_RING_SIZE];
+    trace_count++;
+
+    event->frame = trace_frame;
+    event->level = level;
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(event->message, TRACE_MESSAGE_SIZE, fmt, args);
+    va_end(args);
+
+    /* Errors always reach the log, the rest only at Flecs trace levels */
+    if (level == WEBGPU_TRACE_ERROR) {
+        ecs_err_(file, line, "%s", event->message);
+    } else {
+        ecs_log_(level - WEBGPU_TRACE_INFO, file, line, "%s", event->message);
+    }
+}
+
+void webgpu_trace_dump(void) {
+    uint32_t count = trace_count < WEBGPU_TRACE_RING_SIZE ? trace_count : WEBGPU_TRACE_RING_SIZE;
+    uint32_t first = trace_count - count;
+
+    ecs_print(0, "WebGPU: %u trace events (%u dropped)", count, first);
+    for (uint32_t i = first; i < trace_count; i++) {
+        const webgpu_trace_event_t *event = &trace_ring[i % WEBGPU_TRACE_RING_SIZE];
+        ecs_print(0, "[%u] %-5s %s", event->frame,
+            trace_level_names[event->level], event->message);
+    }
+}
+
+#else
+
+void webgpu_trace_dump(void) {
+    ecs_print(0, "WebGPU: tracing is compiled out (WEBGPU_TRACE_LEVEL=0)");
+}
+
+#endif
@@ -0,0 +1,242 @@
+/**
+ * @file rendering/transform_expand.c
+ * @brief Expansion of position/rotation/scale records into instance matrices.
+ *
+ * With gpu_transforms, instances are packed as position, euler rotation and
+ * scale (WEBGPU_BYTES_PER_INSTANCE_TRS) instead of a matrix computed by
+ * flecs.systems.transform, with the geometry dimensions folded into the
+ * scale. A compute pass expands them into the compact records of the
+ * expanded storage buffer, which GPU culling and the geometry shaders read
+ * like any other instance storage.
+ *
+ * The expanded buffer isn't part of the ring, so records are only expanded
+ * again when their geometry uploaded or moved this frame: the ring slot
+ * uploaded to then holds the latest records of every range.
+ */
+
+#include "../private_api.h"
+
+/* Uniforms of the transform shader, must match TransformParams */
+typedef struct {
+    uint32_t first_instance;
+    uint32_t instance_count;
+    uint32_t source_words;
+    uint32_t dest_words;
+} webgpu_transform_params_t;
+
+/**
+ * Create the expansion pipeline and its uniform buffer
+ */
+webgpu_transform_expander_t* webgpu_transform_expander_create(WGPUDevice device) {
+    if (!device) {
+        return NULL;
+    }
+
+    webgpu_transform_expander_t *expander = ecs_os_calloc_t(webgpu_transform_expander_t);
+
+    WGPUBindGroupLayoutEntry entries[] = {
+        /* Params */
+        {
+            .binding = 0,
+            .visibility = WGPUShaderStage_Compute,
+            .buffer = {
+                .type = WGPUBufferBindingType_Uniform,
+                .minBindingSize = sizeof(webgpu_transform_params_t),
+            },
+        },
+        /* Position/rotation/scale records */
+        {
+            .binding = 1,
+            .visibility = WGPUShaderStage_Compute,
+            .buffer = {
+                .type = WGPUBufferBindingType_ReadOnlyStorage,
+            },
+        },
+        /* Expanded records */
+        {
+            .binding = 2,
+            .visibility = WGPUShaderStage_Compute,
+            .buffer = {
+                .type = WGPUBufferBindingType_Storage,
+            },
+        }
+    };
+
+    WGPUBindGroupLayoutDescriptor layout_desc = {
+        .label = "Transform Bind Group Layout",
+        .entryCount = 3,
+        .entries = entries,
+    };
+
+    expander->layout = wgpuDeviceCreateBindGroupLayout(device, &layout_desc);
+    if (!expander->layout) {
+        ecs_err("WebGPU: Failed to create transform bind group layout");
+        webgpu_transform_expander_destroy(expander);
+        return NULL;
+    }
+
+    WGPUPipelineLayoutDescriptor pipeline_layout_desc = {
+        .label = "Transform Pipeline Layout",
+        .bindGroupLayoutCount = 1,
+        .bindGroupLayouts = &expander->layout,
+    };
+
+    WGPUPipelineLayout pipeline_layout = wgpuDeviceCreatePipelineLayout(device, &pipeline_layout_desc);
+
+    WGPUShaderModule shader = webgpu_create_shader_module(device, transform_shader_source);
+    if (shader) {
+        WGPUComputePipelineDescriptor pipeline_desc = {
+            .label = "Transform Expand Pipeline",
+            .layout = pipeline_layout,
+            .compute = {
+                .module = shader,
+                .entryPoint = "cs_main",
+            },
+        };
+
+        expander->pipeline = wgpuDeviceCreateComputePipeline(device, &pipeline_desc);
+        wgpuShaderModuleRelease(shader);
+    }
+    wgpuPipelineLayoutRelease(pipeline_layout);
+
+    expander->params = webgpu_create_buffer(device, sizeof(webgpu_transform_params_t),
+        WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst, NULL);
+
+    if (!expander->pipeline || !expander->params) {
+        ecs_err("WebGPU: Failed to create transform expand pipeline");
+        webgpu_transform_expander_destroy(expander);
+        return NULL;
+    }
+
+    return expander;
+}
+
+/**
+ * Release the pipeline, its layout and uniform buffer
+ */
+void webgpu_transform_expander_destroy(webgpu_transform_expander_t *expander) {
+    if (!expander) {
+        return;
+    }
+
+    if (expander->params) {
+        wgpuBufferRelease(expander->params);
+    }
+
+    if (expander->pipeline) {
+        wgpuComputePipelineRelease(expander->pipeline);
+    }
+
+    if (expander->layout) {
+        wgpuBindGroupLayoutRelease(expander->layout);
+    }
+
+    ecs_os_free(expander);
+}
+
+/**
+ * Point a geometry's batches at its expanded records. The records are
+ * expanded this frame if they were uploaded, the geometry moved in the
+ * storage or the expanded buffer lost its contents. Must be called after
+ * the geometry's records were written to this frame's ring slot. Returns
+ * the buffer batches draw from, NULL if there is no room for the records.
+ */
+WGPUBuffer webgpu_transform_expander_add(WebGPURenderer *renderer,
+                                         WebGPUGeometry *geometry,
+                                         bool uploaded) {
+    webgpu_transform_expander_t *expander = renderer->transform_expander;
+    webgpu_instance_storage_t *storage = renderer->instance_storage;
+    if (!expander || !storage) {
+        return NULL;
+    }
+
+    const WebGPUBufferBlock *expanded = &storage->blocks[WEBGPU_INSTANCE_STORAGE_EXPANDED];
+    uint32_t first = geometry->first_instance;
+    uint32_t end = first + geometry->instance_count;
+    if (!expanded->buffer || expanded->size < (uint64_t)end * webgpu_geometry_stride(geometry)) {
+        return NULL;
+    }
+
+    if (uploaded || storage->reallocated[WEBGPU_INSTANCE_STORAGE_EXPANDED] ||
+        geometry->expanded_first != first) {
+        if (expander->first == expander->end) {
+            expander->first = first;
+            expander->end = end;
+        } else {
+            expander->first = first < expander->first ? first : expander->first;
+            expander->end = end > expander->end ? end : expander->end;
+        }
+
+        /* All geometries write the same ring slot in a frame */
+        expander->source = geometry->instance_buffer;
+        expander->source_offset = geometry->instance_offset;
+    }
+
+    geometry->expanded_first = first;
+    geometry->instance_buffer = expanded->buffer;
+    geometry->instance_offset = expanded->offset;
+    return expanded->buffer;
+}
+
+/**
+ * Record the expansion pass for the records added this frame. Must be
+ * called after the batches are gathered and before they are culled.
+ */
+void webgpu_expand_transforms(WebGPURenderer *renderer, WGPUCommandEncoder encoder) {
+    webgpu_transform_expander_t *expander = renderer->transform_expander;
+    if (!expander || expander->first == expander->end || !renderer->instance_storage) {
+        return;
+    }
+
+    uint32_t first = expander->first;
+    uint32_t count = expander->end - first;
+    expander->first = expander->end = 0;
+
+    webgpu_transform_params_t params = {
+        .first_instance = first,
+        .instance_count = count,
+        .source_words = (WEBGPU_BYTES_PER_INSTANCE_TRS + WEBGPU_BYTES_PER_STORAGE_TAG) / sizeof(uint32_t),
+        .dest_words = (WEBGPU_BYTES_PER_INSTANCE_COMPACT + WEBGPU_BYTES_PER_STORAGE_TAG) / sizeof(uint32_t),
+    };
+    wgpuQueueWriteBuffer(renderer->queue, expander->params, 0, &params, sizeof(params));
+
+    /* Blocks are bound from their start, records are indexed from first_instance */
+    const WebGPUBufferBlock *expanded =
+        &renderer->instance_storage->blocks[WEBGPU_INSTANCE_STORAGE_EXPANDED];
+    uint64_t end = (uint64_t)first + count;
+    WGPUBindGroupEntry entries[] = {
+        { .binding = 0, .buffer = expander->params, .offset = 0, .size = sizeof(params) },
+        { .binding = 1, .buffer = expander->source, .offset = expander->source_offset,
+          .size = end * params.source_words * sizeof(uint32_t) },
+        { .binding = 2, .buffer = expanded->buffer, .offset = expanded->offset,
+          .size = end * params.dest_words * sizeof(uint32_t) },
+    };
+
+    WGPUBindGroupDescriptor bind_group_desc = {
+        .label = "Transform Bind Group",
+        .layout = expander->layout,
+        .entryCount = 3,
+        .entries = entries,
+    };
+
+    WGPUBindGroup bind_group = wgpuDeviceCreateBindGroup(renderer->device, &bind_group_desc);
+    if (!bind_group) {
+        ecs_warn("WebGPU: Failed to create transform bind group");
+        return;
+    }
+
+    WGPUComputePassDescriptor pass_desc = {
+        .label = "Transform Expand Pass",
+        .timestampWrites = webgpu_profile_compute_pass(renderer, WebGPUPassTransforms),
+    };
+    WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &pass_desc);
+    wgpuComputePassEncoderSetPipeline(pass, expander->pipeline);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, bind_group, 0, NULL);
+    wgpuComputePassEncoderDispatchWorkgroups(pass,
+        (count + WEBGPU_TRANSFORM_WORKGROUP_SIZE - 1) / WEBGPU_TRANSFORM_WORKGROUP_SIZE, 1, 1);
+    wgpuComputePassEncoderEnd(pass);
+    wgpuComputePassEncoderRelease(pass);
+
+    /* Encoded commands keep the bind group alive */
+    wgpuBindGroupRelease(bind_group);
+}
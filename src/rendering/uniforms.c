@@ -0,0 +1,255 @@
+/**
+ * @file rendering/uniforms.c
+ * @brief Camera and light uniforms sourced from ECS components.
+ *
+ * All view and light blocks live in one uniform buffer and are selected with
+ * dynamic offsets. A block is written only when its source components or the
+ * canvas aspect changed since the last upload, so a static scene does no
+ * uniform queue writes at all.
+ */
+
+#include "../private_api.h"
+
+/* Used when the canvas has no camera entity */
+static const EcsCamera default_camera = {
+    .position = {0.0f, 0.0f, 5.0f},
+    .lookat = {0.0f, 0.0f, 0.0f},
+    .up = {0.0f, 1.0f, 0.0f},
+    .fov = 45.0f,
+    .near_ = 0.1f,
+    .far_ = 100.0f,
+    .ortho = false,
+};
+
+/* Used when the canvas has no directional light entity */
+static const EcsDirectionalLight default_light = {
+    .direction = {-0.5f, -1.0f, -0.3f},
+    .color = {1.0f, 1.0f, 1.0f},
+    .intensity = 1.0f,
+};
+
+static const EcsRgb default_ambient = {0.1f, 0.1f, 0.3f};
+
+/* Light block, must match the 40-byte Light struct in the shader */
+typedef struct {
+    float direction[3];
+    float intensity;
+    float color[3];
+    float ambient_b;                  /* ambient_strength */
+    float ambient_rg[2];              /* ambient_xy */
+} webgpu_light_uniform_t;
+
+/**
+ * Compute view, projection and view projection matrices of a camera
+ */
+static void compute_view_matrices(webgpu_view_uniform_t *view,
+                                  const EcsCamera *camera,
+                                  uint32_t width,
+                                  uint32_t height) {
+    glm_lookat((float*)camera->position, (float*)camera->lookat, (float*)camera->up, view->view);
+
+    float aspect = height ? (float)width / (float)height : 1.0f;
+    float fov = glm_rad(camera->fov);
+    if (camera->ortho) {
+        /* Match the perspective frustum size at the look at distance */
+        float distance = glm_vec3_distance((float*)camera->position, (float*)camera->lookat);
+        float half_height = distance * tanf(fov * 0.5f);
+        float half_width = half_height * aspect;
+        glm_ortho(-half_width, half_width, -half_height, half_height,
+            camera->near_, camera->far_, view->projection);
+    } else {
+        glm_perspective(fov, aspect, camera->near_, camera->far_, view->projection);
+    }
+
+    glm_mat4_mul(view->projection, view->view, view->view_projection);
+}
+
+/**
+ * Upload a view block if its camera or the canvas size changed
+ */
+static void update_view(webgpu_uniforms_t *uniforms,
+                        WGPUQueue queue,
+                        uint32_t index,
+                        const EcsCamera *camera,
+                        uint32_t width,
+                        uint32_t height) {
+    webgpu_view_uniform_t *view = &uniforms->views[index];
+    if (view->valid && view->width == width && view->height == height &&
+        !memcmp(&view->camera, camera, sizeof(EcsCamera))) {
+        return;
+    }
+
+    memcpy(&view->camera, camera, sizeof(EcsCamera));
+    view->width = width;
+    view->height = height;
+    view->valid = true;
+    compute_view_matrices(view, camera, width, height);
+
+    /* view, projection, view_projection, matching the Camera struct */
+    float camera_data[48];
+    memcpy(&camera_data[0], view->view, sizeof(mat4));
+    memcpy(&camera_data[16], view->projection, sizeof(mat4));
+    memcpy(&camera_data[32], view->view_projection, sizeof(mat4));
+
+    wgpuQueueWriteBuffer(queue, uniforms->buffer,
+        webgpu_view_uniform_offset(index), camera_data, sizeof(camera_data));
+    uniforms->writes++;
+}
+
+/**
+ * Upload a light block if its light or the ambient color changed
+ */
+static void update_light(webgpu_uniforms_t *uniforms,
+                         WGPUQueue queue,
+                         uint32_t index,
+                         const EcsDirectionalLight *light,
+                         const EcsRgb *ambient) {
+    webgpu_light_state_t *state = &uniforms->lights[index];
+    if (state->valid && !memcmp(&state->light, light, sizeof(EcsDirectionalLight)) &&
+        !memcmp(&state->ambient, ambient, sizeof(EcsRgb))) {
+        return;
+    }
+
+    memcpy(&state->light, light, sizeof(EcsDirectionalLight));
+    memcpy(&state->ambient, ambient, sizeof(EcsRgb));
+    state->valid = true;
+
+    webgpu_light_uniform_t data = {
+        .direction = {light->direction[0], light->direction[1], light->direction[2]},
+        .intensity = light->intensity,
+        .color = {light->color[0], light->color[1], light->color[2]},
+        .ambient_b = ambient->b,
+        .ambient_rg = {ambient->r, ambient->g},
+    };
+
+    wgpuQueueWriteBuffer(queue, uniforms->buffer,
+        webgpu_light_uniform_offset(index), &data, sizeof(data));
+    uniforms->writes++;
+}
+
+/**
+ * Create the uniform buffer holding all view, light and shadow blocks
+ */
+webgpu_uniforms_t* webgpu_uniforms_create(WGPUDevice device) {
+    WGPUBuffer buffer = webgpu_create_buffer(device,
+        webgpu_shadow_uniform_offset() + WEBGPU_SHADOW_UNIFORM_SIZE,
+        WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst, NULL);
+    if (!buffer) {
+        ecs_err("webgpu_uniforms_create: Failed to create uniform buffer");
+        return NULL;
+    }
+
+    webgpu_uniforms_t *uniforms = ecs_os_calloc_t(webgpu_uniforms_t);
+    uniforms->buffer = buffer;
+    return uniforms;
+}
+
+/**
+ * Release the uniform buffer
+ */
+void webgpu_uniforms_destroy(webgpu_uniforms_t *uniforms) {
+    if (!uniforms) {
+        return;
+    }
+
+    if (uniforms->buffer) {
+        wgpuBufferRelease(uniforms->buffer);
+    }
+
+    ecs_os_free(uniforms);
+}
+
+/**
+ * Get the CPU copy of a view's matrices, NULL before the first upload
+ */
+const webgpu_view_uniform_t* webgpu_uniforms_get_view(const webgpu_uniforms_t *uniforms,
+                                                      uint32_t index) {
+    if (!uniforms || index >= WEBGPU_MAX_VIEWS || !uniforms->views[index].valid) {
+        return NULL;
+    }
+
+    return &uniforms->views[index];
+}
+
+/**
+ * Get the camera of a canvas, NULL if it has none
+ */
+static const EcsCamera* canvas_camera(const ecs_world_t *world, const EcsCanvas *canvas) {
+    return canvas && canvas->camera ? ecs_get(world, canvas->camera, EcsCamera) : NULL;
+}
+
+/**
+ * Upload the camera blocks of a renderer's views and collect the views drawn
+ * this frame. View i uses block i + 1, views past the last block are skipped.
+ */
+static void update_views(const ecs_world_t *world, WebGPURenderer *renderer) {
+    ecs_vec_clear(&renderer->views);
+    if (!renderer->view_query) {
+        return;
+    }
+
+    ecs_iter_t it = ecs_query_iter(world, renderer->view_query);
+    while (ecs_query_next(&it)) {
+        const WebGPUView *views = ecs_field(&it, WebGPUView, 0);
+        const EcsCanvas *canvases = ecs_field(&it, EcsCanvas, 1);
+        for (int32_t i = 0; i < it.count; i++) {
+            uint32_t index = (uint32_t)ecs_vec_count(&renderer->views) + 1;
+            if (index >= WEBGPU_MAX_VIEWS ||
+                (views[i].renderer && views[i].renderer != renderer->canvas_entity)) {
+                continue;
+            }
+
+            const EcsCamera *camera = canvas_camera(world, &canvases[i]);
+            update_view(renderer->uniforms, renderer->queue, index,
+                camera ? camera : &default_camera,
+                (uint32_t)canvases[i].width, (uint32_t)canvases[i].height);
+            ecs_vec_append_t(renderer->allocator, &renderer->views, ecs_entity_t)[0] = it.entities[i];
+        }
+    }
+}
+
+/**
+ * Update the camera, light, shadow cascade and view uniforms. Runs before
+ * packing, so culling sees this frame's cameras.
+ */
+void webgpu_update_uniforms(ecs_iter_t *it) {
+    WebGPURenderer *renderer = ecs_field(it, WebGPURenderer, 0);
+
+    for (int32_t r = 0; r < it->count; r++) {
+        webgpu_uniforms_t *uniforms = renderer[r].uniforms;
+        if (!uniforms || !renderer[r].queue) {
+            continue;
+        }
+
+        uniforms->writes = 0;
+
+        ecs_time_t stage_start = {0};
+        ecs_time_measure(&stage_start);
+
+        const EcsCamera *camera = NULL;
+        const EcsDirectionalLight *light = NULL;
+        const EcsRgb *ambient = &default_ambient;
+
+        const EcsCanvas *canvas = ecs_get(it->world, renderer[r].canvas_entity, EcsCanvas);
+        if (canvas) {
+            camera = canvas_camera(it->world, canvas);
+            if (canvas->directional_light) {
+                light = ecs_get(it->world, canvas->directional_light, EcsDirectionalLight);
+                if (light) {
+                    ambient = &canvas->ambient_light;
+                }
+            }
+        }
+
+        update_view(uniforms, renderer[r].queue, 0,
+            camera ? camera : &default_camera, renderer[r].width, renderer[r].height);
+        update_light(uniforms, renderer[r].queue, 0,
+            light ? light : &default_light, ambient);
+        webgpu_update_shadows(&renderer[r]);
+        update_views(it->world, &renderer[r]);
+
+        renderer[r].uniform_writes = uniforms->writes;
+        renderer[r].redraw |= uniforms->writes != 0;
+        webgpu_stage_time(&renderer[r], WebGPUStageUpload, &stage_start);
+    }
+}
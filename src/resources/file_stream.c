@@ -0,0 +1,236 @@
+/**
+ * @file resources/file_stream.c
+ * @brief Files read into memory while they arrive, for streamed resources.
+ *
+ * On the web a file is fetched with a streaming reader, so its bytes become
+ * available chunk by chunk while the download is in progress; natively the
+ * file is memory mapped and all bytes are available at once. Owners poll
+ * received and done, and close the stream once they no longer need it.
+ */
+
+#include "../private_api.h"
+
+#include <stdio.h>
+
+#ifndef __EMSCRIPTEN__
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#endif
+
+/**
+ * Release the data of a stream
+ */
+static void stream_release_data(webgpu_file_stream_t *stream) {
+    if (!stream->data) {
+        return;
+    }
+
+#if !defined(__EMSCRIPTEN__) && !defined(_WIN32)
+    if (stream->mapped) {
+        munmap(stream->data, (size_t)stream->received);
+        stream->data = NULL;
+        return;
+    }
+#endif
+
+    ecs_os_free(stream->data);
+    stream->data = NULL;
+}
+
+/**
+ * Free a stream and its data
+ */
+static void stream_free(webgpu_file_stream_t *stream) {
+    stream_release_data(stream);
+    ecs_os_free(stream->path);
+    ecs_os_free(stream);
+}
+
+/**
+ * Mark a stream as failed
+ */
+static void stream_fail(webgpu_file_stream_t *stream, const char *reason) {
+    ecs_err("WebGPU: Failed to load %s: %s", stream->path, reason);
+    stream->failed = true;
+    stream->done = true;
+}
+
+#ifdef __EMSCRIPTEN__
+
+/**
+ * Make room for a fetched chunk, returns where to write it. Called from the
+ * fetch reader; returns NULL when the stream was closed or failed, which
+ * stops the reader.
+ */
+EMSCRIPTEN_KEEPALIVE
+uint8_t* webgpu_file_stream_reserve(webgpu_file_stream_t *stream, uint32_t size, double total) {
+    if (stream->cancelled || stream->failed) {
+        return NULL;
+    }
+
+    /* Content-Length, when the server sent one, sizes the buffer once */
+    uint64_t required = stream->received + size;
+    if (required > stream->capacity) {
+        uint64_t capacity = stream->capacity ? stream->capacity * 2 : 64 * 1024;
+        if ((uint64_t)total > capacity) {
+            capacity = (uint64_t)total;
+        }
+        while (capacity < required) {
+            capacity *= 2;
+        }
+
+        /* The received bytes stay valid when the buffer can't grow */
+        uint8_t *data = ecs_os_realloc(stream->data, (ecs_size_t)capacity);
+        if (!data) {
+            stream_fail(stream, "out of memory");
+            return NULL;
+        }
+        stream->data = data;
+        stream->capacity = capacity;
+    }
+
+    return stream->data + stream->received;
+}
+
+/**
+ * Commit a chunk written to the pointer returned by webgpu_file_stream_reserve
+ */
+EMSCRIPTEN_KEEPALIVE
+void webgpu_file_stream_commit(webgpu_file_stream_t *stream, uint32_t size) {
+    stream->received += size;
+}
+
+/**
+ * End of a fetch. Streams closed during the fetch are freed here.
+ */
+EMSCRIPTEN_KEEPALIVE
+void webgpu_file_stream_end(webgpu_file_stream_t *stream, int32_t ok) {
+    stream->fetching = false;
+    if (stream->cancelled) {
+        stream_free(stream);
+        return;
+    }
+
+    stream->done = true;
+    if (!ok) {
+        stream_fail(stream, "fetch failed");
+    }
+}
+
+/* Fetch a file with a streaming reader, handing chunks to the stream as
+ * they arrive */
+EM_JS(void, file_stream_fetch, (const char *url, webgpu_file_stream_t *stream), {
+    fetch(UTF8ToString(url)).then(async (response) => {
+        if (!response.ok || !response.body) {
+            _webgpu_file_stream_end(stream, 0);
+            return;
+        }
+        const total = Number(response.headers.get('Content-Length')) || 0;
+        const reader = response.body.getReader();
+        for (;;) {
+            const { done, value } = await reader.read();
+            if (done) {
+                break;
+            }
+            const ptr = _webgpu_file_stream_reserve(stream, value.length, total);
+            if (!ptr) {
+                reader.cancel();
+                break;
+            }
+            HEAPU8.set(value, ptr);
+            _webgpu_file_stream_commit(stream, value.length);
+        }
+        _webgpu_file_stream_end(stream, 1);
+    }).catch(() => _webgpu_file_stream_end(stream, 0));
+});
+
+/**
+ * Start fetching the file of a stream
+ */
+static void stream_read(webgpu_file_stream_t *stream) {
+    stream->fetching = true;
+    file_stream_fetch(stream->path, stream);
+}
+
+#else
+
+/**
+ * Map the file of a stream, all bytes are available at once
+ */
+static void stream_read(webgpu_file_stream_t *stream) {
+    const char *path = stream->path;
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        stream_fail(stream, "can't open file");
+        return;
+    }
+
+    struct stat st;
+    void *data = MAP_FAILED;
+    if (!fstat(fd, &st) && st.st_size > 0) {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        stream_fail(stream, "can't map file");
+        return;
+    }
+
+    stream->data = data;
+    stream->mapped = true;
+    stream->received = (uint64_t)st.st_size;
+#else
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        stream_fail(stream, "can't open file");
+        return;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size > 0) {
+        stream->data = ecs_os_malloc((ecs_size_t)size);
+        stream->received = fread(stream->data, 1, (size_t)size, file);
+    }
+    fclose(file);
+#endif
+
+    stream->done = true;
+}
+
+#endif
+
+/**
+ * Start reading a file. Never returns NULL, a file that can't be read is
+ * reported through the stream's failed flag.
+ */
+webgpu_file_stream_t* webgpu_file_stream_open(const char *path) {
+    webgpu_file_stream_t *stream = ecs_os_calloc_t(webgpu_file_stream_t);
+    stream->path = ecs_os_strdup(path);
+    stream_read(stream);
+    return stream;
+}
+
+/**
+ * Close a stream and release its data. A stream with a fetch in flight is
+ * freed when the fetch ends.
+ */
+void webgpu_file_stream_close(webgpu_file_stream_t *stream) {
+    if (!stream) {
+        return;
+    }
+
+    if (stream->fetching) {
+        stream->cancelled = true;
+        return;
+    }
+
+    stream_free(stream);
+}
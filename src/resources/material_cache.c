@@ -0,0 +1,308 @@
+/**
+ * @file resources/material_cache.c
+ * @brief Material ids and bind groups, cached by material entity.
+ *
+ * Every material entity gets a small id the first time a table using it is
+ * packed, which goes into sort keys and storage instance records. The id is
+ * also the material's slot in a shared uniform buffer, bound with a dynamic
+ * offset. A block is only written when the WebGPUMaterial component (or the
+ * residency of its diffuse texture) changed.
+ *
+ * Bind groups are created per texture array rather than per material: all
+ * materials whose diffuse texture is a layer of the same array, or that have
+ * no texture, draw with the same bind group at different offsets.
+ */
+
+#include "../private_api.h"
+
+/* Material blocks allocated when the buffer is first created */
+#define MATERIAL_INITIAL_BLOCKS 64
+
+/* Properties of entities without a material */
+static const webgpu_material_uniform_t default_material = {
+    .base_color = {1.0f, 1.0f, 1.0f, 1.0f},
+    .roughness = 1.0f,
+};
+
+/**
+ * Group tables of geometry queries by the material they inherit, so that
+ * ranges sharing a material are packed next to each other.
+ */
+uint64_t webgpu_material_group(ecs_world_t *world, ecs_table_t *table, ecs_id_t id, void *ctx) {
+    (void)ctx;
+    ecs_entity_t material = 0;
+    if (ecs_search_relation(world, table, 0, id, EcsIsA, EcsUp, &material, NULL, NULL) == -1) {
+        return 0;
+    }
+    return material;
+}
+
+/**
+ * Create a material cache with the default material as id 0
+ */
+webgpu_material_cache_t* webgpu_material_cache_create(webgpu_resource_pool_t *resources) {
+    webgpu_material_cache_t *cache = ecs_os_calloc_t(webgpu_material_cache_t);
+    cache->resources = resources;
+    ecs_vec_init_t(NULL, &cache->entries, webgpu_material_entry_t, 1);
+    ecs_vec_init_t(NULL, &cache->bind_groups, webgpu_material_bind_group_t, 1);
+    ecs_map_init(&cache->ids, NULL);
+
+    webgpu_material_entry_t *entry = ecs_vec_append_t(NULL, &cache->entries, webgpu_material_entry_t);
+    ecs_os_memset_t(entry, 0, webgpu_material_entry_t);
+
+    return cache;
+}
+
+/**
+ * Release the bind groups of all texture arrays to a resource pool, or
+ * right away without one
+ */
+static void release_bind_groups(webgpu_material_cache_t *cache,
+                                webgpu_resource_pool_t *resources) {
+    webgpu_material_bind_group_t *bind_groups = ecs_vec_first_t(
+        &cache->bind_groups, webgpu_material_bind_group_t);
+    for (int32_t i = 0; i < ecs_vec_count(&cache->bind_groups); i++) {
+        webgpu_release_bind_group(resources, bind_groups[i].bind_group);
+        bind_groups[i].bind_group = NULL;
+    }
+}
+
+/**
+ * Release the uniform buffer and bind groups of all materials
+ */
+void webgpu_material_cache_destroy(webgpu_material_cache_t *cache) {
+    if (!cache) {
+        return;
+    }
+
+    release_bind_groups(cache, NULL);
+    webgpu_buffer_free(cache->resources, &cache->block);
+
+    ecs_vec_fini_t(NULL, &cache->bind_groups, webgpu_material_bind_group_t);
+    ecs_vec_fini_t(NULL, &cache->entries, webgpu_material_entry_t);
+    ecs_map_fini(&cache->ids);
+    ecs_os_free(cache);
+}
+
+/**
+ * Get the id of a material entity, adding it on first use. Entity 0 (no
+ * material) is the default material. Does not touch the GPU, so it can be
+ * called while packing.
+ */
+uint32_t webgpu_material_cache_id(webgpu_material_cache_t *cache, ecs_entity_t material) {
+    if (!cache || !material) {
+        return 0;
+    }
+
+    ecs_map_val_t *id = ecs_map_get(&cache->ids, material);
+    if (id) {
+        return (uint32_t)*id;
+    }
+
+    int32_t count = ecs_vec_count(&cache->entries);
+    if (count >= WEBGPU_MAX_MATERIALS) {
+        if (!cache->full_warned) {
+            ecs_warn("WebGPU: Material cache full (%d materials), using the default material",
+                    WEBGPU_MAX_MATERIALS);
+            cache->full_warned = true;
+        }
+        return 0;
+    }
+
+    webgpu_material_entry_t *entry = ecs_vec_append_t(NULL, &cache->entries, webgpu_material_entry_t);
+    ecs_os_memset_t(entry, 0, webgpu_material_entry_t);
+    entry->entity = material;
+    ecs_map_insert(&cache->ids, material, (ecs_map_val_t)count);
+
+    return (uint32_t)count;
+}
+
+/**
+ * Make sure the uniform buffer block has a slot for a material id. A block
+ * that had to grow lost its contents, so all slots are written again and all
+ * bind groups are recreated.
+ */
+static bool ensure_blocks(webgpu_material_cache_t *cache, WGPUDevice device, uint32_t id) {
+    uint64_t size = ((uint64_t)id + 1) * WEBGPU_UNIFORM_ALIGNMENT;
+    if (cache->block.buffer && cache->block.size >= size) {
+        return true;
+    }
+
+    if (!cache->block.buffer && size < MATERIAL_INITIAL_BLOCKS * WEBGPU_UNIFORM_ALIGNMENT) {
+        size = MATERIAL_INITIAL_BLOCKS * WEBGPU_UNIFORM_ALIGNMENT;
+    }
+
+    if (!webgpu_ensure_buffer_capacity(device, cache->resources, &cache->block,
+            size, WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst)) {
+        ecs_err("WebGPU: Failed to create material uniform buffer");
+        return false;
+    }
+
+    webgpu_material_entry_t *entries = ecs_vec_first_t(&cache->entries, webgpu_material_entry_t);
+    for (int32_t i = 0; i < ecs_vec_count(&cache->entries); i++) {
+        entries[i].valid = false;
+    }
+    release_bind_groups(cache, cache->resources);
+    return true;
+}
+
+/**
+ * Get the bind group of a texture array, creating it on first use and after
+ * the array or the uniform buffer was reallocated
+ */
+static WGPUBindGroup array_bind_group(webgpu_material_cache_t *cache,
+                                      WGPUDevice device,
+                                      WGPUBindGroupLayout layout,
+                                      const webgpu_texture_cache_t *textures,
+                                      int32_t index) {
+    const webgpu_texture_array_t *array = webgpu_texture_cache_array(textures, index);
+    if (!array) {
+        return NULL;
+    }
+
+    while (ecs_vec_count(&cache->bind_groups) <= index) {
+        webgpu_material_bind_group_t *bind_group = ecs_vec_append_t(
+            NULL, &cache->bind_groups, webgpu_material_bind_group_t);
+        ecs_os_memset_t(bind_group, 0, webgpu_material_bind_group_t);
+    }
+
+    webgpu_material_bind_group_t *bind_group = ecs_vec_get_t(
+        &cache->bind_groups, webgpu_material_bind_group_t, index);
+    if (bind_group->bind_group && bind_group->version == array->version) {
+        return bind_group->bind_group;
+    }
+
+    /* Frames in flight may still bind the old one */
+    webgpu_release_bind_group(cache->resources, bind_group->bind_group);
+
+    WGPUBindGroupEntry entries[] = {
+        {
+            .binding = 0,
+            .buffer = cache->block.buffer,
+            .offset = cache->block.offset,
+            .size = sizeof(webgpu_material_uniform_t),
+        },
+        {
+            .binding = 1,
+            .textureView = array->view,
+        },
+        {
+            .binding = 2,
+            .sampler = textures->sampler,
+        },
+    };
+
+    WGPUBindGroupDescriptor bind_group_desc = {
+        .label = "Material Bind Group",
+        .layout = layout,
+        .entryCount = 3,
+        .entries = entries,
+    };
+
+    bind_group->bind_group = wgpuDeviceCreateBindGroup(device, &bind_group_desc);
+    bind_group->version = array->version;
+    if (!bind_group->bind_group) {
+        ecs_err("WebGPU: Failed to create material bind group");
+    }
+    return bind_group->bind_group;
+}
+
+/**
+ * Build the uniform block of a material entry from its WebGPUMaterial.
+ * Returns the texture array of its diffuse texture.
+ */
+static int32_t material_uniform(const webgpu_material_entry_t *entry,
+                                const ecs_world_t *world,
+                                webgpu_texture_cache_t *textures,
+                                webgpu_material_uniform_t *uniform) {
+    *uniform = default_material;
+    if (!entry->entity) {
+        return 0;
+    }
+
+    const WebGPUMaterial *material = ecs_is_alive(world, entry->entity) ?
+        ecs_get(world, entry->entity, WebGPUMaterial) : NULL;
+    if (!material) {
+        return 0;
+    }
+
+    memcpy(uniform->base_color, material->base_color, sizeof(uniform->base_color));
+    uniform->metallic = material->metallic;
+    uniform->roughness = material->roughness;
+    uniform->emissive_factor = material->emissive_factor;
+
+    int32_t texture_array = 0;
+    if (!webgpu_texture_cache_get(textures, world, material->diffuse_texture,
+            &texture_array, &uniform->diffuse_layer)) {
+        texture_array = 0;
+        uniform->diffuse_layer = 0;
+    }
+    return texture_array;
+}
+
+/**
+ * Get the bind group and dynamic offset of a material. Writes the material's
+ * block when its properties differ from the last upload. Until its diffuse
+ * texture is resident a material samples the white texel of array 0.
+ */
+WGPUBindGroup webgpu_material_cache_bind_group(webgpu_material_cache_t *cache,
+                                               const ecs_world_t *world,
+                                               WGPUDevice device,
+                                               WGPUQueue queue,
+                                               WGPUBindGroupLayout layout,
+                                               webgpu_texture_cache_t *textures,
+                                               uint32_t id,
+                                               uint32_t *offset) {
+    if (!cache || !layout || !textures || id >= (uint32_t)ecs_vec_count(&cache->entries)) {
+        return NULL;
+    }
+
+    if (!ensure_blocks(cache, device, id)) {
+        return NULL;
+    }
+
+    webgpu_material_entry_t *entry = ecs_vec_get_t(&cache->entries, webgpu_material_entry_t, (int32_t)id);
+
+    webgpu_material_uniform_t uniform;
+    int32_t texture_array = material_uniform(entry, world, textures, &uniform);
+
+    /* Only write the slot when the material changed. The dynamic offset is
+     * relative to the block, which is bound at its own offset. */
+    *offset = id * WEBGPU_UNIFORM_ALIGNMENT;
+    if (!entry->valid || memcmp(&entry->uniform, &uniform, sizeof(uniform))) {
+        wgpuQueueWriteBuffer(queue, cache->block.buffer, cache->block.offset + *offset,
+            &uniform, sizeof(uniform));
+        entry->uniform = uniform;
+        entry->valid = true;
+        cache->writes++;
+    }
+
+    return array_bind_group(cache, device, layout, textures, texture_array);
+}
+
+/**
+ * Check whether a material changed since its block was last written, without
+ * writing it. Used by on-demand renderers to decide whether to draw.
+ */
+bool webgpu_material_cache_changed(const webgpu_material_cache_t *cache,
+                                   const ecs_world_t *world,
+                                   webgpu_texture_cache_t *textures) {
+    if (!cache || !textures) {
+        return false;
+    }
+
+    const webgpu_material_entry_t *entries = ecs_vec_first_t(&cache->entries, webgpu_material_entry_t);
+    for (int32_t i = 0; i < ecs_vec_count(&cache->entries); i++) {
+        if (!entries[i].valid) {
+            continue;
+        }
+
+        webgpu_material_uniform_t uniform;
+        material_uniform(&entries[i], world, textures, &uniform);
+        if (memcmp(&entries[i].uniform, &uniform, sizeof(uniform))) {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,543 @@
+/**
+ * @file resources/pipeline_cache.c
+ * @brief Render pipeline cache with shared layouts and async compilation.
+ *
+ * Pipelines are looked up by a hashed key of everything that changes the
+ * pipeline descriptor. A miss starts wgpuDeviceCreateRenderPipelineAsync and
+ * returns NULL, so a new variant is skipped for a few frames instead of
+ * stalling one. Bind group and pipeline layouts are created once and shared
+ * by every variant, shader modules once per shader variant. With shadows the
+ * light group also holds the cascades and their depth atlas, and shadow
+ * casters get layouts of their own, as they only run the vertex stage.
+ */
+
+#include "../private_api.h"
+
+/**
+ * FNV-1a hash of a pipeline key
+ */
+static uint64_t pipeline_key_hash(const webgpu_pipeline_key_t *key) {
+    const uint8_t *bytes = (const uint8_t*)key;
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < sizeof(webgpu_pipeline_key_t); i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Create a bind group layout with a single dynamic offset uniform binding
+ */
+static WGPUBindGroupLayout create_uniform_layout(WGPUDevice device,
+                                                 const char *label,
+                                                 WGPUShaderStageFlags visibility,
+                                                 uint64_t min_binding_size) {
+    WGPUBindGroupLayoutEntry entry = {
+        .binding = 0,
+        .visibility = visibility,
+        .buffer = {
+            .type = WGPUBufferBindingType_Uniform,
+            .hasDynamicOffset = true, /* Blocks in the uniform ring */
+            .minBindingSize = min_binding_size,
+        },
+    };
+
+    WGPUBindGroupLayoutDescriptor layout_desc = {
+        .label = label,
+        .entryCount = 1,
+        .entries = &entry,
+    };
+
+    return wgpuDeviceCreateBindGroupLayout(device, &layout_desc);
+}
+
+/**
+ * Called when an async pipeline compile completes. Entries of a destroyed
+ * cache are orphaned while compiling and freed here.
+ */
+static void pipeline_compiled(WGPUCreatePipelineAsyncStatus status,
+                              WGPURenderPipeline pipeline,
+                              const char *message,
+                              void *userdata) {
+    webgpu_shader_cache_entry_t *entry = userdata;
+    entry->pending = false;
+
+    if (status != WGPUCreatePipelineAsyncStatus_Success || !pipeline) {
+        ecs_err("WebGPU: Failed to compile pipeline variant %016llx: %s",
+                (unsigned long long)entry->hash, message ? message : "Unknown error");
+        entry->failed = true;
+    }
+
+    if (!entry->cache) {
+        if (pipeline) {
+            wgpuRenderPipelineRelease(pipeline);
+        }
+        ecs_os_free(entry);
+        return;
+    }
+
+    entry->pipeline = entry->failed ? NULL : pipeline;
+
+    ecs_trace("WebGPU: Compiled pipeline variant %016llx", (unsigned long long)entry->hash);
+}
+
+/**
+ * Get the compiled module of a shader variant. Modules are compiled once and
+ * shared by all pipelines of the variant.
+ */
+static WGPUShaderModule shader_module_get(webgpu_pipeline_cache_t *cache, uint32_t variant) {
+    webgpu_shader_module_entry_t *modules = ecs_vec_first_t(
+        &cache->modules, webgpu_shader_module_entry_t);
+    int32_t count = ecs_vec_count(&cache->modules);
+    for (int32_t i = 0; i < count; i++) {
+        if (modules[i].variant == variant) {
+            return modules[i].module;
+        }
+    }
+
+    if (variant >= webgpu_shader_variant_count) {
+        ecs_err("WebGPU: Shader variant %u was not precompiled", variant);
+        return NULL;
+    }
+
+    WGPUShaderModule module = webgpu_create_shader_module(
+        cache->device, webgpu_shader_variant_sources[variant]);
+    if (!module) {
+        return NULL;
+    }
+
+    webgpu_shader_module_entry_t *entry = ecs_vec_append_t(
+        NULL, &cache->modules, webgpu_shader_module_entry_t);
+    entry->variant = variant;
+    entry->module = module;
+
+    ecs_trace("WebGPU: Compiled shader variant %u", variant);
+
+    return module;
+}
+
+/**
+ * Start compiling the pipeline for an entry's key
+ */
+static bool pipeline_compile(webgpu_pipeline_cache_t *cache,
+                             webgpu_shader_cache_entry_t *entry) {
+    WGPUShaderModule module = shader_module_get(cache, entry->key.shader_variant);
+    if (!module) {
+        ecs_err("WebGPU: Failed to create shader module for pipeline variant");
+        return false;
+    }
+
+    /* Storage instancing variants read instances from bind group 3 */
+    bool storage = entry->key.shader_variant & WebGPUShaderStorageInstances;
+    WGPUPipelineLayout layout = storage ? cache->storage_layout : cache->geometry_layout;
+    if (entry->key.depth_only) {
+        layout = storage ? cache->caster_storage_layout : cache->caster_layout;
+    }
+    if (!layout) {
+        ecs_err("WebGPU: No pipeline layout for pipeline variant");
+        return false;
+    }
+
+    entry->pending = true;
+    webgpu_create_geometry_pipeline(cache->device, layout,
+        module, module, &entry->key, pipeline_compiled, entry);
+
+    return true;
+}
+
+/**
+ * Create the light group of a renderer with shadows: the light block, the
+ * shadow block, the cascade atlas and its comparison sampler
+ */
+static WGPUBindGroupLayout create_shadow_light_layout(WGPUDevice device) {
+    WGPUBindGroupLayoutEntry entries[] = {
+        {
+            .binding = 0,
+            .visibility = WGPUShaderStage_Fragment,
+            .buffer = {
+                .type = WGPUBufferBindingType_Uniform,
+                .hasDynamicOffset = true,
+                .minBindingSize = WEBGPU_LIGHT_UNIFORM_SIZE,
+            },
+        },
+        {
+            .binding = 1,
+            .visibility = WGPUShaderStage_Fragment,
+            .buffer = {
+                .type = WGPUBufferBindingType_Uniform,
+                .minBindingSize = WEBGPU_SHADOW_UNIFORM_SIZE,
+            },
+        },
+        {
+            .binding = 2,
+            .visibility = WGPUShaderStage_Fragment,
+            .texture = {
+                .sampleType = WGPUTextureSampleType_Depth,
+                .viewDimension = WGPUTextureViewDimension_2D,
+            },
+        },
+        {
+            .binding = 3,
+            .visibility = WGPUShaderStage_Fragment,
+            .sampler = {
+                .type = WGPUSamplerBindingType_Comparison,
+            },
+        },
+    };
+
+    WGPUBindGroupLayoutDescriptor layout_desc = {
+        .label = "Shadow Light Bind Group Layout",
+        .entryCount = 4,
+        .entries = entries,
+    };
+
+    return wgpuDeviceCreateBindGroupLayout(device, &layout_desc);
+}
+
+/**
+ * Create the layouts of shadow casters. They only bind the camera, and with
+ * storage instancing the instance records; the groups in between are empty.
+ */
+static bool create_caster_layouts(webgpu_pipeline_cache_t *cache) {
+    WGPUBindGroupLayoutDescriptor empty_desc = {
+        .label = "Empty Bind Group Layout",
+        .entryCount = 0,
+    };
+
+    cache->empty_layout = wgpuDeviceCreateBindGroupLayout(cache->device, &empty_desc);
+    if (!cache->empty_layout) {
+        return false;
+    }
+
+    WGPUPipelineLayoutDescriptor layout_desc = {
+        .label = "Shadow Caster Pipeline Layout",
+        .bindGroupLayoutCount = 1,
+        .bindGroupLayouts = &cache->camera_layout,
+    };
+
+    cache->caster_layout = wgpuDeviceCreatePipelineLayout(cache->device, &layout_desc);
+
+    WGPUBindGroupLayout storage_bind_group_layouts[] = {
+        cache->camera_layout,
+        cache->empty_layout,
+        cache->empty_layout,
+        cache->instance_layout
+    };
+
+    WGPUPipelineLayoutDescriptor storage_layout_desc = {
+        .label = "Shadow Caster Storage Pipeline Layout",
+        .bindGroupLayoutCount = 4,
+        .bindGroupLayouts = storage_bind_group_layouts,
+    };
+
+    cache->caster_storage_layout = wgpuDeviceCreatePipelineLayout(cache->device, &storage_layout_desc);
+
+    return cache->caster_layout && cache->caster_storage_layout;
+}
+
+/**
+ * Create a pipeline cache and the layouts shared by all pipeline variants.
+ * With shadows, the light layout holds the shadow bindings.
+ */
+webgpu_pipeline_cache_t* webgpu_pipeline_cache_create(WGPUDevice device, bool shadows) {
+    if (!device) {
+        ecs_err("webgpu_pipeline_cache_create: Invalid device");
+        return NULL;
+    }
+
+    webgpu_pipeline_cache_t *cache = ecs_os_calloc_t(webgpu_pipeline_cache_t);
+    cache->device = device;
+    ecs_vec_init_t(NULL, &cache->entries, webgpu_shader_cache_entry_t*, 0);
+    ecs_vec_init_t(NULL, &cache->modules, webgpu_shader_module_entry_t, 0);
+
+    cache->camera_layout = create_uniform_layout(device, "Camera Bind Group Layout",
+        WGPUShaderStage_Vertex, WEBGPU_CAMERA_UNIFORM_SIZE);
+
+    cache->light_layout = shadows ? create_shadow_light_layout(device) :
+        create_uniform_layout(device, "Light Bind Group Layout",
+            WGPUShaderStage_Fragment, WEBGPU_LIGHT_UNIFORM_SIZE);
+
+    /* Material blocks share one buffer and are selected with a dynamic
+     * offset, the diffuse texture is a layer of a texture array */
+    WGPUBindGroupLayoutEntry material_entries[] = {
+        {
+            .binding = 0,
+            .visibility = WGPUShaderStage_Fragment,
+            .buffer = {
+                .type = WGPUBufferBindingType_Uniform,
+                .hasDynamicOffset = true,
+                .minBindingSize = sizeof(webgpu_material_uniform_t),
+            },
+        },
+        {
+            .binding = 1,
+            .visibility = WGPUShaderStage_Fragment,
+            .texture = {
+                .sampleType = WGPUTextureSampleType_Float,
+                .viewDimension = WGPUTextureViewDimension_2DArray,
+            },
+        },
+        {
+            .binding = 2,
+            .visibility = WGPUShaderStage_Fragment,
+            .sampler = {
+                .type = WGPUSamplerBindingType_Filtering,
+            },
+        },
+    };
+
+    WGPUBindGroupLayoutDescriptor material_layout_desc = {
+        .label = "Material Bind Group Layout",
+        .entryCount = 3,
+        .entries = material_entries,
+    };
+
+    cache->material_layout = wgpuDeviceCreateBindGroupLayout(device, &material_layout_desc);
+
+    if (!cache->camera_layout || !cache->light_layout || !cache->material_layout) {
+        ecs_err("webgpu_pipeline_cache_create: Failed to create bind group layouts");
+        webgpu_pipeline_cache_destroy(cache);
+        return NULL;
+    }
+
+    WGPUBindGroupLayout bind_group_layouts[] = {
+        cache->camera_layout,
+        cache->light_layout,
+        cache->material_layout
+    };
+
+    WGPUPipelineLayoutDescriptor layout_desc = {
+        .label = "Geometry Pipeline Layout",
+        .bindGroupLayoutCount = 3,
+        .bindGroupLayouts = bind_group_layouts,
+    };
+
+    cache->geometry_layout = wgpuDeviceCreatePipelineLayout(device, &layout_desc);
+    if (!cache->geometry_layout) {
+        ecs_err("webgpu_pipeline_cache_create: Failed to create pipeline layout");
+        webgpu_pipeline_cache_destroy(cache);
+        return NULL;
+    }
+
+    /* Storage instancing: the shared instance records as group 3 */
+    WGPUBindGroupLayoutEntry instance_entry = {
+        .binding = 0,
+        .visibility = WGPUShaderStage_Vertex,
+        .buffer = {
+            .type = WGPUBufferBindingType_ReadOnlyStorage,
+        },
+    };
+
+    WGPUBindGroupLayoutDescriptor instance_layout_desc = {
+        .label = "Instance Storage Bind Group Layout",
+        .entryCount = 1,
+        .entries = &instance_entry,
+    };
+
+    cache->instance_layout = wgpuDeviceCreateBindGroupLayout(device, &instance_layout_desc);
+    if (!cache->instance_layout) {
+        ecs_err("webgpu_pipeline_cache_create: Failed to create instance storage layout");
+        webgpu_pipeline_cache_destroy(cache);
+        return NULL;
+    }
+
+    WGPUBindGroupLayout storage_bind_group_layouts[] = {
+        cache->camera_layout,
+        cache->light_layout,
+        cache->material_layout,
+        cache->instance_layout
+    };
+
+    WGPUPipelineLayoutDescriptor storage_layout_desc = {
+        .label = "Geometry Storage Pipeline Layout",
+        .bindGroupLayoutCount = 4,
+        .bindGroupLayouts = storage_bind_group_layouts,
+    };
+
+    cache->storage_layout = wgpuDeviceCreatePipelineLayout(device, &storage_layout_desc);
+    if (!cache->storage_layout) {
+        ecs_err("webgpu_pipeline_cache_create: Failed to create storage pipeline layout");
+        webgpu_pipeline_cache_destroy(cache);
+        return NULL;
+    }
+
+    if (shadows && !create_caster_layouts(cache)) {
+        ecs_err("webgpu_pipeline_cache_create: Failed to create shadow caster layouts");
+        webgpu_pipeline_cache_destroy(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+/**
+ * Release all cached pipelines and shared layouts
+ */
+void webgpu_pipeline_cache_destroy(webgpu_pipeline_cache_t *cache) {
+    if (!cache) {
+        return;
+    }
+
+    webgpu_shader_cache_entry_t **entries = ecs_vec_first_t(
+        &cache->entries, webgpu_shader_cache_entry_t*);
+    int32_t count = ecs_vec_count(&cache->entries);
+    for (int32_t i = 0; i < count; i++) {
+        webgpu_shader_cache_entry_t *entry = entries[i];
+        if (entry->pending) {
+            /* Freed by the compile callback */
+            entry->cache = NULL;
+            continue;
+        }
+
+        if (entry->pipeline) {
+            wgpuRenderPipelineRelease(entry->pipeline);
+        }
+        ecs_os_free(entry);
+    }
+    ecs_vec_fini_t(NULL, &cache->entries, webgpu_shader_cache_entry_t*);
+
+    webgpu_shader_module_entry_t *modules = ecs_vec_first_t(
+        &cache->modules, webgpu_shader_module_entry_t);
+    for (int32_t i = 0; i < ecs_vec_count(&cache->modules); i++) {
+        wgpuShaderModuleRelease(modules[i].module);
+    }
+    ecs_vec_fini_t(NULL, &cache->modules, webgpu_shader_module_entry_t);
+
+    if (cache->geometry_layout) {
+        wgpuPipelineLayoutRelease(cache->geometry_layout);
+    }
+
+    if (cache->storage_layout) {
+        wgpuPipelineLayoutRelease(cache->storage_layout);
+    }
+
+    if (cache->caster_layout) {
+        wgpuPipelineLayoutRelease(cache->caster_layout);
+    }
+
+    if (cache->caster_storage_layout) {
+        wgpuPipelineLayoutRelease(cache->caster_storage_layout);
+    }
+
+    if (cache->empty_layout) {
+        wgpuBindGroupLayoutRelease(cache->empty_layout);
+    }
+
+    if (cache->instance_layout) {
+        wgpuBindGroupLayoutRelease(cache->instance_layout);
+    }
+
+    if (cache->camera_layout) {
+        wgpuBindGroupLayoutRelease(cache->camera_layout);
+    }
+
+    if (cache->light_layout) {
+        wgpuBindGroupLayoutRelease(cache->light_layout);
+    }
+
+    if (cache->material_layout) {
+        wgpuBindGroupLayoutRelease(cache->material_layout);
+    }
+
+    ecs_os_free(cache);
+}
+
+/**
+ * Initialize a pipeline key with the renderer's default geometry state
+ */
+void webgpu_pipeline_key_init(webgpu_pipeline_key_t *key, const WebGPURenderer *renderer) {
+    ecs_os_memset_t(key, 0, webgpu_pipeline_key_t);
+    key->color_format = renderer->surface_format != WGPUTextureFormat_Undefined ?
+        renderer->surface_format : WGPUTextureFormat_BGRA8Unorm;
+    key->depth_format = WEBGPU_DEPTH_FORMAT;
+    key->blend_mode = WebGPUBlendOpaque;
+    key->cull_mode = WGPUCullMode_Back;
+    key->instance_format = webgpu_draw_instance_format(renderer);
+    key->shader_variant = key->instance_format != WebGPUInstanceFormatFull ?
+        WebGPUShaderCompactInstances : 0;
+    if (renderer->storage_instancing) {
+        key->shader_variant |= WebGPUShaderStorageInstances;
+    }
+    if (renderer->shadows) {
+        key->shader_variant |= WebGPUShaderShadows;
+    }
+    key->sample_count = renderer->sample_count > 1 ? renderer->sample_count : 1;
+}
+
+/**
+ * Turn a key into its transparent variant: alpha blended, without depth
+ * writes, with the shader outputting alpha
+ */
+void webgpu_pipeline_key_transparent(webgpu_pipeline_key_t *key) {
+    key->blend_mode = WebGPUBlendAlpha;
+    key->shader_variant |= WebGPUShaderAlpha;
+}
+
+/**
+ * Turn a key into its shadow caster variant: depth only into the single
+ * sampled atlas, without culling so flat meshes cast from both sides
+ */
+void webgpu_pipeline_key_shadow_caster(webgpu_pipeline_key_t *key) {
+    key->color_format = WGPUTextureFormat_Undefined;
+    key->depth_format = WEBGPU_DEPTH_FORMAT;
+    key->blend_mode = WebGPUBlendOpaque;
+    key->cull_mode = WGPUCullMode_None;
+    key->shader_variant &= ~(uint32_t)(WebGPUShaderAlpha | WebGPUShaderShadows);
+    key->sample_count = 1;
+    key->depth_only = 1;
+}
+
+/**
+ * Look up the pipeline for a key. On a miss the pipeline is compiled
+ * asynchronously; NULL is returned until it is ready, or if it failed.
+ * If id is not NULL it is set to the variant's position in the cache, which
+ * is stable and used in render queue sort keys.
+ */
+WGPURenderPipeline webgpu_pipeline_cache_get(webgpu_pipeline_cache_t *cache,
+                                             const webgpu_pipeline_key_t *key,
+                                             uint32_t *id) {
+    if (!cache || !key) {
+        return NULL;
+    }
+
+    uint64_t hash = pipeline_key_hash(key);
+
+    webgpu_shader_cache_entry_t **entries = ecs_vec_first_t(
+        &cache->entries, webgpu_shader_cache_entry_t*);
+    int32_t count = ecs_vec_count(&cache->entries);
+    for (int32_t i = 0; i < count; i++) {
+        webgpu_shader_cache_entry_t *entry = entries[i];
+        if (entry->hash == hash && !memcmp(&entry->key, key, sizeof(webgpu_pipeline_key_t))) {
+            if (id) {
+                *id = (uint32_t)i;
+            }
+            return entry->pipeline;
+        }
+    }
+
+    if (count >= WEBGPU_SHADER_CACHE_SIZE) {
+        if (!cache->full_warned) {
+            ecs_warn("WebGPU: Pipeline cache full (%d variants), not compiling new variants",
+                    WEBGPU_SHADER_CACHE_SIZE);
+            cache->full_warned = true;
+        }
+        return NULL;
+    }
+
+    /* Entries are heap allocated, the compile callback holds on to them */
+    webgpu_shader_cache_entry_t *entry = ecs_os_calloc_t(webgpu_shader_cache_entry_t);
+    entry->hash = hash;
+    entry->key = *key;
+    entry->cache = cache;
+    ecs_vec_append_t(NULL, &cache->entries, webgpu_shader_cache_entry_t*)[0] = entry;
+    if (id) {
+        *id = (uint32_t)count;
+    }
+
+    if (!pipeline_compile(cache, entry)) {
+        entry->failed = true;
+    }
+
+    return entry->pipeline;
+}
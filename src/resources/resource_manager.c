@@ -56,18 +56,94 @@ void webgpu_update_buffer(WGPUDevice device, WGPUQueue queue, WGPUBuffer buffer,
     wgpuQueueWriteBuffer(queue, buffer, offset, data, size);
 }
 
+/**
+ * Grow a persistent buffer block so it can hold at least size bytes.
+ * Capacity doubles on each reallocation so steady-state frames never
+ * allocate. Contents are not preserved across a grow, and the block may
+ * move to another buffer or offset. The old block is freed to the pool
+ * once the frames using it completed.
+ */
+bool webgpu_ensure_buffer_capacity(WGPUDevice device, webgpu_resource_pool_t *pool, WebGPUBufferBlock *block, uint64_t size, WGPUBufferUsage usage) {
+    if (!device || !block) {
+        ecs_err("webgpu_ensure_buffer_capacity: Invalid parameters");
+        return false;
+    }
+
+    if (block->buffer && block->size >= size) {
+        return true;
+    }
+
+    uint64_t new_capacity = block->size ? block->size : WEBGPU_MIN_INSTANCE_BUFFER_SIZE;
+    while (new_capacity < size) {
+        new_capacity *= 2;
+    }
+
+    WebGPUBufferBlock new_block;
+    if (!webgpu_buffer_alloc(pool, device, new_capacity, usage, &new_block)) {
+        return false;
+    }
+
+    ecs_trace("WebGPU: Grew buffer from %llu to %llu bytes",
+             (unsigned long long)block->size, (unsigned long long)new_block.size);
+
+    /* Frames in flight may still read the old block */
+    webgpu_buffer_free(pool, block);
+    *block = new_block;
+    return true;
+}
+
 /**
  * Create a 2D texture with specified format
  */
 WGPUTexture webgpu_create_texture_2d(WGPUDevice device, uint32_t width, uint32_t height, WGPUTextureFormat format) {
+    return webgpu_create_texture_array(device, width, height, 1, 1, format,
+        WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst);
+}
+
+/**
+ * Create a 2D texture with array layers and a mip chain
+ */
+WGPUTexture webgpu_create_texture_array(WGPUDevice device, uint32_t width, uint32_t height, uint32_t layers, uint32_t mip_levels, WGPUTextureFormat format, WGPUTextureUsage usage) {
+    if (!device || width == 0 || height == 0 || layers == 0 || mip_levels == 0) {
+        ecs_err("webgpu_create_texture_array: Invalid parameters");
+        return NULL;
+    }
+    
+    WGPUTextureDescriptor texture_desc = {
+        .label = layers > 1 ? "WebGPU Texture Array" : "WebGPU 2D Texture",
+        .usage = usage,
+        .dimension = WGPUTextureDimension_2D,
+        .size = {
+            .width = width,
+            .height = height,
+            .depthOrArrayLayers = layers,
+        },
+        .format = format,
+        .mipLevelCount = mip_levels,
+        .sampleCount = 1,
+    };
+    
+    WGPUTexture texture = wgpuDeviceCreateTexture(device, &texture_desc);
+    if (!texture) {
+        ecs_err("webgpu_create_texture_array: Failed to create texture");
+        return NULL;
+    }
+    
+    return texture;
+}
+
+/**
+ * Create an offscreen color target that can be read back
+ */
+WGPUTexture webgpu_create_color_target(WGPUDevice device, uint32_t width, uint32_t height, WGPUTextureFormat format) {
     if (!device || width == 0 || height == 0) {
-        ecs_err("webgpu_create_texture_2d: Invalid parameters");
+        ecs_err("webgpu_create_color_target: Invalid parameters");
         return (WGPUTexture){0};
     }
     
     WGPUTextureDescriptor texture_desc = {
-        .label = "WebGPU 2D Texture",
-        .usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst,
+        .label = "Offscreen Color Target",
+        .usage = WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_CopySrc,
         .dimension = WGPUTextureDimension_2D,
         .size = {
             .width = width,
@@ -81,7 +157,7 @@ WGPUTexture webgpu_create_texture_2d(WGPUDevice device, uint32_t width, uint32_t
     
     WGPUTexture texture = wgpuDeviceCreateTexture(device, &texture_desc);
     if (!texture) {
-        ecs_err("webgpu_create_texture_2d: Failed to create texture");
+        ecs_err("webgpu_create_color_target: Failed to create texture");
         return NULL;
     }
     
@@ -95,20 +171,10 @@ WGPUTexture webgpu_create_depth_texture(WGPUDevice device, uint32_t width, uint3
     if (!device || width == 0 || height == 0) {
         ecs_err("webgpu_create_depth_texture: Invalid parameters (device=%p, width=%u, height=%u)", 
                device, width, height);
-#ifdef __EMSCRIPTEN__
-        EM_ASM({
-            console.error('webgpu_create_depth_texture: Invalid parameters');
-            console.error('Device:', $0, 'Width:', $1, 'Height:', $2);
-        }, (uint32_t)(uintptr_t)device, width, height);
-#endif
         return (WGPUTexture){0};
     }
     
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('webgpu_create_depth_texture: Creating texture with dimensions:', $0, 'x', $1);
-    }, width, height);
-#endif
+    webgpu_trace("webgpu_create_depth_texture: Creating %ux%u depth texture", width, height);
     
     WGPUTextureDescriptor depth_texture_desc = {
         .label = "Depth Buffer Texture",
@@ -119,36 +185,19 @@ WGPUTexture webgpu_create_depth_texture(WGPUDevice device, uint32_t width, uint3
             .height = height > 0 ? height : 1,
             .depthOrArrayLayers = 1,
         },
-        .format = WGPUTextureFormat_Depth24Plus,
+        .format = WEBGPU_DEPTH_FORMAT,
         .mipLevelCount = 1,
         .sampleCount = 1,
     };
     
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('webgpu_create_depth_texture: Calling wgpuDeviceCreateTexture...');
-        console.log('Format: Depth24Plus, Usage: RenderAttachment|TextureBinding');
-    });
-#endif
-    
     WGPUTexture depth_texture = wgpuDeviceCreateTexture(device, &depth_texture_desc);
     
     if (!depth_texture) {
         ecs_err("webgpu_create_depth_texture: Failed to create depth texture");
-#ifdef __EMSCRIPTEN__
-        EM_ASM({
-            console.error('webgpu_create_depth_texture: wgpuDeviceCreateTexture returned NULL');
-        });
-#endif
         return NULL;
     }
     
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('webgpu_create_depth_texture: ✓ Successfully created depth texture');
-        console.log('Texture handle:', $0);
-    }, (uint32_t)(uintptr_t)depth_texture);
-#endif
+    webgpu_trace("webgpu_create_depth_texture: Created depth texture %p", (void*)depth_texture);
     
     return depth_texture;
 }
@@ -159,23 +208,12 @@ WGPUTexture webgpu_create_depth_texture(WGPUDevice device, uint32_t width, uint3
 WGPUTextureView webgpu_create_depth_texture_view(WGPUTexture depth_texture) {
     if (!depth_texture) {
         ecs_err("webgpu_create_depth_texture_view: Invalid depth texture (NULL)");
-#ifdef __EMSCRIPTEN__
-        EM_ASM({
-            console.error('webgpu_create_depth_texture_view: Invalid depth texture (NULL)');
-        });
-#endif
         return (WGPUTextureView){0};
     }
     
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('webgpu_create_depth_texture_view: Creating view for texture handle:', $0);
-    }, (uint32_t)(uintptr_t)depth_texture);
-#endif
-    
     WGPUTextureViewDescriptor depth_view_desc = {
         .label = "Depth Buffer View",
-        .format = WGPUTextureFormat_Depth24Plus,
+        .format = WEBGPU_DEPTH_FORMAT,
         .dimension = WGPUTextureViewDimension_2D,
         .baseMipLevel = 0,
         .mipLevelCount = 1,
@@ -184,31 +222,14 @@ WGPUTextureView webgpu_create_depth_texture_view(WGPUTexture depth_texture) {
         .aspect = WGPUTextureAspect_DepthOnly,
     };
     
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('webgpu_create_depth_texture_view: Calling wgpuTextureCreateView...');
-        console.log('Format: Depth24Plus, Dimension: 2D, Aspect: DepthOnly');
-    });
-#endif
-    
     WGPUTextureView depth_view = wgpuTextureCreateView(depth_texture, &depth_view_desc);
     
     if (!depth_view) {
         ecs_err("webgpu_create_depth_texture_view: Failed to create depth texture view");
-#ifdef __EMSCRIPTEN__
-        EM_ASM({
-            console.error('webgpu_create_depth_texture_view: wgpuTextureCreateView returned NULL');
-        });
-#endif
         return NULL;
     }
     
-#ifdef __EMSCRIPTEN__
-    EM_ASM({
-        console.log('webgpu_create_depth_texture_view: ✓ Successfully created depth texture view');
-        console.log('View handle:', $0);
-    }, (uint32_t)(uintptr_t)depth_view);
-#endif
+    webgpu_trace("webgpu_create_depth_texture_view: Created depth texture view %p", (void*)depth_view);
     
     return depth_view;
 }
@@ -245,68 +266,20 @@ WGPUShaderModule webgpu_create_shader_module(WGPUDevice device, const char *wgsl
 }
 
 /**
- * Create basic render pipeline for geometry rendering
+ * Create a geometry render pipeline for a pipeline key. The instance buffer
+ * layout follows key->instance_format; the vertex shader must be the matching
+ * variant (basic or compact). Depth only keys (shadow casters) have no
+ * fragment stage and a slope scaled depth bias. When callback is set the
+ * pipeline is compiled asynchronously, passed to callback and NULL is
+ * returned.
  */
-WGPURenderPipeline webgpu_create_geometry_pipeline(WGPUDevice device, WGPUShaderModule vertex_shader, WGPUShaderModule fragment_shader) {
-    if (!device || !vertex_shader || !fragment_shader) {
+WGPURenderPipeline webgpu_create_geometry_pipeline(WGPUDevice device, WGPUPipelineLayout pipeline_layout, WGPUShaderModule vertex_shader, WGPUShaderModule fragment_shader, const webgpu_pipeline_key_t *key, WGPUCreateRenderPipelineAsyncCallback callback, void *userdata) {
+    if (!device || !pipeline_layout || !vertex_shader || !fragment_shader || !key) {
         ecs_err("webgpu_create_geometry_pipeline: Invalid parameters");
         return NULL;
     }
     
-    /* Create bind group layouts for uniforms */
-    WGPUBindGroupLayoutEntry camera_layout_entries[] = {
-        {
-            .binding = 0,
-            .visibility = WGPUShaderStage_Vertex,
-            .buffer = {
-                .type = WGPUBufferBindingType_Uniform,
-                .hasDynamicOffset = false,
-                .minBindingSize = sizeof(mat4) * 3, /* view, projection, view_projection matrices */
-            },
-        }
-    };
-    
-    WGPUBindGroupLayoutDescriptor camera_layout_desc = {
-        .label = "Camera Bind Group Layout",
-        .entryCount = 1,
-        .entries = camera_layout_entries,
-    };
-    
-    WGPUBindGroupLayout camera_bind_group_layout = wgpuDeviceCreateBindGroupLayout(device, &camera_layout_desc);
-    
-    WGPUBindGroupLayoutEntry light_layout_entries[] = {
-        {
-            .binding = 0,
-            .visibility = WGPUShaderStage_Fragment,
-            .buffer = {
-                .type = WGPUBufferBindingType_Uniform,
-                .hasDynamicOffset = false,
-                .minBindingSize = sizeof(vec3) * 3 + sizeof(float), /* direction, color, ambient, intensity */
-            },
-        }
-    };
-    
-    WGPUBindGroupLayoutDescriptor light_layout_desc = {
-        .label = "Light Bind Group Layout",
-        .entryCount = 1,
-        .entries = light_layout_entries,
-    };
-    
-    WGPUBindGroupLayout light_bind_group_layout = wgpuDeviceCreateBindGroupLayout(device, &light_layout_desc);
-    
-    /* Create pipeline layout */
-    WGPUBindGroupLayout bind_group_layouts[] = {
-        camera_bind_group_layout,
-        light_bind_group_layout
-    };
-    
-    WGPUPipelineLayoutDescriptor layout_desc = {
-        .label = "Geometry Pipeline Layout",
-        .bindGroupLayoutCount = 2,
-        .bindGroupLayouts = bind_group_layouts,
-    };
-    
-    WGPUPipelineLayout pipeline_layout = wgpuDeviceCreatePipelineLayout(device, &layout_desc);
+    WebGPUInstanceFormat instance_format = (WebGPUInstanceFormat)key->instance_format;
     
     /* Define vertex attributes */
     WGPUVertexAttribute vertex_attributes[] = {
@@ -338,7 +311,7 @@ WGPURenderPipeline webgpu_create_geometry_pipeline(WGPUDevice device, WGPUShader
     };
     
     /* Define instance attributes */
-    WGPUVertexAttribute instance_attributes[] = {
+    WGPUVertexAttribute full_attributes[] = {
         /* Transform matrix row 0 */
         {
             .format = WGPUVertexFormat_Float32x4,
@@ -371,11 +344,46 @@ WGPURenderPipeline webgpu_create_geometry_pipeline(WGPUDevice device, WGPUShader
         }
     };
     
+    /* Compact layout: three affine rows and an RGBA8 color */
+    WGPUVertexFormat row_format = instance_format == WebGPUInstanceFormatCompactHalf ?
+        WGPUVertexFormat_Float16x4 : WGPUVertexFormat_Float32x4;
+    uint64_t row_size = instance_format == WebGPUInstanceFormatCompactHalf ?
+        4 * sizeof(uint16_t) : 4 * sizeof(float);
+    
+    WGPUVertexAttribute compact_attributes[] = {
+        /* Affine matrix row 0 */
+        {
+            .format = row_format,
+            .offset = 0,
+            .shaderLocation = 3,
+        },
+        /* Affine matrix row 1 */
+        {
+            .format = row_format,
+            .offset = row_size,
+            .shaderLocation = 4,
+        },
+        /* Affine matrix row 2 */
+        {
+            .format = row_format,
+            .offset = 2 * row_size,
+            .shaderLocation = 5,
+        },
+        /* Color */
+        {
+            .format = WGPUVertexFormat_Unorm8x4,
+            .offset = 3 * row_size,
+            .shaderLocation = 6,
+        }
+    };
+    
+    bool compact = instance_format != WebGPUInstanceFormatFull;
+    
     WGPUVertexBufferLayout instance_buffer_layout = {
-        .arrayStride = 19 * sizeof(float), /* mat4(16) + rgb(3) */
+        .arrayStride = webgpu_instance_stride(instance_format),
         .stepMode = WGPUVertexStepMode_Instance,
-        .attributeCount = 5,
-        .attributes = instance_attributes,
+        .attributeCount = compact ? 4 : 5,
+        .attributes = compact ? compact_attributes : full_attributes,
     };
     
     WGPUVertexBufferLayout vertex_layouts[] = {
@@ -383,22 +391,31 @@ WGPURenderPipeline webgpu_create_geometry_pipeline(WGPUDevice device, WGPUShader
         instance_buffer_layout
     };
     
+    /* Storage instancing decodes records in the shader, no instance buffer */
+    bool storage = key->shader_variant & WebGPUShaderStorageInstances;
+    WGPUConstantEntry instance_constant = {
+        .key = "instance_format",
+        .value = (double)instance_format,
+    };
+    
     /* Create render pipeline */
+    WGPUBlendState alpha_blend = {
+        .color = {
+            .operation = WGPUBlendOperation_Add,
+            .srcFactor = WGPUBlendFactor_SrcAlpha,
+            .dstFactor = WGPUBlendFactor_OneMinusSrcAlpha,
+        },
+        .alpha = {
+            .operation = WGPUBlendOperation_Add,
+            .srcFactor = WGPUBlendFactor_One,
+            .dstFactor = WGPUBlendFactor_OneMinusSrcAlpha,
+        },
+    };
+    
     WGPUColorTargetState color_target = {
-        .format = WGPUTextureFormat_BGRA8Unorm, /* Typical swap chain format */
+        .format = key->color_format, /* Must match the surface format */
         .writeMask = WGPUColorWriteMask_All,
-        .blend = &(WGPUBlendState){
-            .color = {
-                .operation = WGPUBlendOperation_Add,
-                .srcFactor = WGPUBlendFactor_SrcAlpha,
-                .dstFactor = WGPUBlendFactor_OneMinusSrcAlpha,
-            },
-            .alpha = {
-                .operation = WGPUBlendOperation_Add,
-                .srcFactor = WGPUBlendFactor_One,
-                .dstFactor = WGPUBlendFactor_OneMinusSrcAlpha,
-            },
-        },
+        .blend = key->blend_mode == WebGPUBlendAlpha ? &alpha_blend : NULL,
     };
     
     WGPUFragmentState fragment_state = {
@@ -409,41 +426,45 @@ WGPURenderPipeline webgpu_create_geometry_pipeline(WGPUDevice device, WGPUShader
     };
     
     WGPURenderPipelineDescriptor pipeline_desc = {
-        .label = "Geometry Render Pipeline",
+        .label = key->depth_only ? "Shadow Caster Pipeline" : "Geometry Render Pipeline",
         .layout = pipeline_layout,
         .vertex = {
             .module = vertex_shader,
             .entryPoint = "vs_main",
-            .bufferCount = 2,
+            .constantCount = storage ? 1 : 0,
+            .constants = storage ? &instance_constant : NULL,
+            .bufferCount = storage ? 1 : 2,
             .buffers = vertex_layouts,
         },
-        .fragment = &fragment_state,
+        .fragment = key->depth_only ? NULL : &fragment_state,
         .primitive = {
             .topology = WGPUPrimitiveTopology_TriangleList,
             .stripIndexFormat = WGPUIndexFormat_Undefined,
             .frontFace = WGPUFrontFace_CCW,
-            .cullMode = WGPUCullMode_Back,
+            .cullMode = (WGPUCullMode)key->cull_mode,
         },
         .depthStencil = &(WGPUDepthStencilState){
-            .format = WGPUTextureFormat_Depth24Plus,
-            .depthWriteEnabled = true,
+            .format = key->depth_format,
+            .depthWriteEnabled = key->blend_mode != WebGPUBlendAlpha,
             .depthCompare = WGPUCompareFunction_Less,
             .stencilReadMask = 0,
             .stencilWriteMask = 0,
+            .depthBias = key->depth_only ? 2 : 0,
+            .depthBiasSlopeScale = key->depth_only ? 2.0f : 0.0f,
         },
         .multisample = {
-            .count = 1,
+            .count = key->sample_count ? key->sample_count : 1,
             .mask = 0xFFFFFFFF,
             .alphaToCoverageEnabled = false,
         },
     };
     
-    WGPURenderPipeline pipeline = wgpuDeviceCreateRenderPipeline(device, &pipeline_desc);
+    if (callback) {
+        wgpuDeviceCreateRenderPipelineAsync(device, &pipeline_desc, callback, userdata);
+        return NULL;
+    }
     
-    /* Cleanup intermediate objects */
-    wgpuBindGroupLayoutRelease(camera_bind_group_layout);
-    wgpuBindGroupLayoutRelease(light_bind_group_layout);
-    wgpuPipelineLayoutRelease(pipeline_layout);
+    WGPURenderPipeline pipeline = wgpuDeviceCreateRenderPipeline(device, &pipeline_desc);
     
     if (!pipeline) {
         ecs_err("webgpu_create_geometry_pipeline: Failed to create render pipeline");
@@ -453,28 +474,6 @@ WGPURenderPipeline webgpu_create_geometry_pipeline(WGPUDevice device, WGPUShader
     return pipeline;
 }
 
-/**
- * Create uniform buffer with camera matrices
- */
-WGPUBuffer webgpu_create_camera_uniform_buffer(WGPUDevice device) {
-    /* Camera uniform buffer: view_matrix, projection_matrix, view_projection_matrix */
-    size_t buffer_size = sizeof(mat4) * 3;
-    
-    return webgpu_create_buffer(device, buffer_size, 
-        WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst, NULL);
-}
-
-/**
- * Create uniform buffer with light data
- */
-WGPUBuffer webgpu_create_light_uniform_buffer(WGPUDevice device) {
-    /* Light uniform buffer: matches our 40-byte shader struct exactly */
-    size_t buffer_size = 40; /* Exact size to match shader */
-    
-    return webgpu_create_buffer(device, buffer_size,
-        WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst, NULL);
-}
-
 /**
  * Create bind group for camera uniforms
  */
@@ -484,7 +483,7 @@ WGPUBindGroup webgpu_create_camera_bind_group(WGPUDevice device, WGPUBindGroupLa
             .binding = 0,
             .buffer = uniform_buffer,
             .offset = 0,
-            .size = sizeof(mat4) * 3,
+            .size = WEBGPU_CAMERA_UNIFORM_SIZE, /* One view block, selected by dynamic offset */
         }
     };
     
@@ -507,7 +506,7 @@ WGPUBindGroup webgpu_create_light_bind_group(WGPUDevice device, WGPUBindGroupLay
             .binding = 0,
             .buffer = uniform_buffer,
             .offset = 0,
-            .size = 40, /* Matches our 40-byte Light struct */
+            .size = WEBGPU_LIGHT_UNIFORM_SIZE, /* One light block, selected by dynamic offset */
         }
     };
     
@@ -0,0 +1,614 @@
+/**
+ * @file resources/resource_pool.c
+ * @brief Buffer sub-allocation, deferred release of GPU handles and the
+ * memory budget.
+ *
+ * Buffers are allocated as blocks: requests up to 1 << WEBGPU_SLAB_MAX_ORDER
+ * bytes are rounded up to a power of two and carved from a slab, one large
+ * buffer per usage class and block size, so many small instance and uniform
+ * buffers share a few driver allocations. Larger requests, and classes that
+ * can't share a buffer (mapped readback), get a dedicated buffer.
+ *
+ * A handle the renderer stops using may still be referenced by frames the
+ * GPU hasn't finished, so it is queued with the frame submitted next. Each
+ * submit registers a submitted-work-done callback, and at the start of a
+ * frame every handle whose frame completed is freed in bulk: blocks return
+ * to their slab, dedicated buffers to a pool of free buffers, everything
+ * else is destroyed. Free buffers and empty slabs that stay unused are
+ * destroyed, and all committed bytes are counted against the budget.
+ */
+
+#include "../private_api.h"
+
+/* Usage of the slabs of each class, a superset of what its blocks request */
+static const WGPUBufferUsage slab_usage[WebGPUBufferClassCount] = {
+    [WebGPUBufferClassVertex] = WGPUBufferUsage_Vertex | WGPUBufferUsage_Storage |
+        WGPUBufferUsage_CopyDst | WGPUBufferUsage_CopySrc,
+    [WebGPUBufferClassIndex] = WGPUBufferUsage_Index |
+        WGPUBufferUsage_CopyDst | WGPUBufferUsage_CopySrc,
+    [WebGPUBufferClassUniform] = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+    [WebGPUBufferClassStorage] = WGPUBufferUsage_Storage | WGPUBufferUsage_Indirect |
+        WGPUBufferUsage_CopyDst | WGPUBufferUsage_CopySrc,
+    [WebGPUBufferClassStaging] = 0,
+};
+
+/**
+ * Usage class of a buffer
+ */
+static WebGPUBufferClass buffer_class(WGPUBufferUsage usage) {
+    if (usage & (WGPUBufferUsage_MapRead | WGPUBufferUsage_MapWrite |
+                 WGPUBufferUsage_QueryResolve)) {
+        return WebGPUBufferClassStaging;
+    }
+    if (usage & WGPUBufferUsage_Index) {
+        return WebGPUBufferClassIndex;
+    }
+    if (usage & WGPUBufferUsage_Vertex) {
+        return WebGPUBufferClassVertex;
+    }
+    if (usage & WGPUBufferUsage_Uniform) {
+        return WebGPUBufferClassUniform;
+    }
+    return WebGPUBufferClassStorage;
+}
+
+/**
+ * Bytes committed by the pool over all classes
+ */
+static uint64_t pool_committed(const webgpu_resource_pool_t *pool) {
+    uint64_t committed = 0;
+    for (int32_t i = 0; i < WebGPUBufferClassCount; i++) {
+        committed += pool->committed[i];
+    }
+    return committed;
+}
+
+/**
+ * Destroy a handle right away
+ */
+static void release_now(webgpu_release_kind_t kind, void *handle) {
+    switch (kind) {
+    case WebGPUReleaseBuffer:
+        wgpuBufferDestroy(handle);
+        wgpuBufferRelease(handle);
+        break;
+    case WebGPUReleaseTexture:
+        wgpuTextureDestroy(handle);
+        wgpuTextureRelease(handle);
+        break;
+    case WebGPUReleaseTextureView:
+        wgpuTextureViewRelease(handle);
+        break;
+    case WebGPUReleaseBindGroup:
+        wgpuBindGroupRelease(handle);
+        break;
+    case WebGPUReleaseRenderPipeline:
+        wgpuRenderPipelineRelease(handle);
+        break;
+    case WebGPUReleaseRenderBundle:
+        wgpuRenderBundleRelease(handle);
+        break;
+    case WebGPUReleaseBlock:
+        /* A block is part of its slab's buffer */
+        break;
+    }
+}
+
+/**
+ * Destroy a pooled buffer or slab buffer and uncommit its bytes
+ */
+static void pool_destroy_buffer(webgpu_resource_pool_t *pool,
+                                WGPUBuffer buffer,
+                                WebGPUBufferClass buffer_class,
+                                uint64_t size) {
+    release_now(WebGPUReleaseBuffer, buffer);
+    pool->committed[buffer_class] -= size;
+}
+
+/**
+ * Destroy the free buffers of the pool, and its slabs without blocks that
+ * became empty at least min_frames ago
+ */
+static void pool_trim(webgpu_resource_pool_t *pool, uint32_t min_frames) {
+    webgpu_pooled_buffer_t *buffers = ecs_vec_first_t(&pool->buffers, webgpu_pooled_buffer_t);
+    for (int32_t i = ecs_vec_count(&pool->buffers) - 1; i >= 0; i--) {
+        if (pool->frame - buffers[i].frame < min_frames) {
+            continue;
+        }
+
+        pool->pooled_bytes -= buffers[i].size;
+        pool_destroy_buffer(pool, buffers[i].buffer, buffer_class(buffers[i].usage),
+            buffers[i].size);
+        ecs_vec_remove_t(&pool->buffers, webgpu_pooled_buffer_t, i);
+    }
+
+    webgpu_slab_t **slabs = ecs_vec_first_t(&pool->slabs, webgpu_slab_t*);
+    for (int32_t i = ecs_vec_count(&pool->slabs) - 1; i >= 0; i--) {
+        webgpu_slab_t *slab = slabs[i];
+        if (slab->used_count || pool->frame - slab->frame < min_frames) {
+            continue;
+        }
+
+        pool_destroy_buffer(pool, slab->buffer, slab->buffer_class, WEBGPU_SLAB_SIZE);
+        ecs_os_free(slab);
+        ecs_vec_remove_t(&pool->slabs, webgpu_slab_t*, i);
+    }
+}
+
+/**
+ * Account for a new GPU buffer of size bytes. When the budget would be
+ * exceeded, free pooled memory is given back first; fails if that wasn't
+ * enough.
+ */
+static bool pool_commit(webgpu_resource_pool_t *pool, WebGPUBufferClass buffer_class, uint64_t size) {
+    if (pool->budget && pool_committed(pool) + size > pool->budget) {
+        pool_trim(pool, 0);
+        if (pool_committed(pool) + size > pool->budget) {
+            if (!pool->budget_warned) {
+                ecs_warn("WebGPU: Memory budget of %llu bytes exceeded, %llu byte allocation refused",
+                    (unsigned long long)pool->budget, (unsigned long long)size);
+                pool->budget_warned = true;
+            }
+            pool->failed++;
+            return false;
+        }
+    }
+
+    pool->budget_warned = false;
+    pool->committed[buffer_class] += size;
+    return true;
+}
+
+/**
+ * Create an empty resource pool
+ */
+webgpu_resource_pool_t* webgpu_create_resource_pool(ecs_allocator_t *allocator) {
+    webgpu_resource_pool_t *pool = ecs_os_calloc_t(webgpu_resource_pool_t);
+    pool->allocator = allocator;
+    ecs_vec_init_t(allocator, &pool->slabs, webgpu_slab_t*, 0);
+    ecs_vec_init_t(allocator, &pool->buffers, webgpu_pooled_buffer_t, 0);
+    ecs_vec_init_t(allocator, &pool->pending, webgpu_pending_release_t, 0);
+    return pool;
+}
+
+/**
+ * Free a pool that was destroyed once nothing refers to it anymore
+ */
+static void pool_free(webgpu_resource_pool_t *pool) {
+    if (pool->destroyed && !pool->waiting && !pool->refs) {
+        ecs_os_free(pool);
+    }
+}
+
+/**
+ * Free all slabs, pooled and pending handles. Called when the device goes
+ * away, so nothing waits for the GPU anymore. Blocks still held by
+ * geometries are freed with their slab; the struct itself lives until the
+ * last callback and geometry let go of it.
+ */
+void webgpu_destroy_resource_pool(webgpu_resource_pool_t *pool) {
+    if (!pool) {
+        return;
+    }
+
+    webgpu_pending_release_t *pending = ecs_vec_first_t(&pool->pending, webgpu_pending_release_t);
+    for (int32_t i = 0; i < ecs_vec_count(&pool->pending); i++) {
+        if (pending[i].kind != WebGPUReleaseBlock) {
+            release_now(pending[i].kind, pending[i].handle);
+        }
+    }
+
+    webgpu_pooled_buffer_t *buffers = ecs_vec_first_t(&pool->buffers, webgpu_pooled_buffer_t);
+    for (int32_t i = 0; i < ecs_vec_count(&pool->buffers); i++) {
+        release_now(WebGPUReleaseBuffer, buffers[i].buffer);
+    }
+
+    webgpu_slab_t **slabs = ecs_vec_first_t(&pool->slabs, webgpu_slab_t*);
+    for (int32_t i = 0; i < ecs_vec_count(&pool->slabs); i++) {
+        release_now(WebGPUReleaseBuffer, slabs[i]->buffer);
+        ecs_os_free(slabs[i]);
+    }
+
+    ecs_vec_fini_t(pool->allocator, &pool->pending, webgpu_pending_release_t);
+    ecs_vec_fini_t(pool->allocator, &pool->buffers, webgpu_pooled_buffer_t);
+    ecs_vec_fini_t(pool->allocator, &pool->slabs, webgpu_slab_t*);
+
+    pool->destroyed = true;
+    pool_free(pool);
+}
+
+/**
+ * Keep a destroyed pool's struct alive for an owner of blocks, so it can
+ * still free them
+ */
+void webgpu_resource_pool_keep(webgpu_resource_pool_t *pool) {
+    if (pool) {
+        pool->refs++;
+    }
+}
+
+/**
+ * Let go of a pool kept with webgpu_resource_pool_keep
+ */
+void webgpu_resource_pool_drop(webgpu_resource_pool_t *pool) {
+    if (pool) {
+        pool->refs--;
+        pool_free(pool);
+    }
+}
+
+/**
+ * Return a buffer whose frames completed to the pool, or destroy it when
+ * the pool is full
+ */
+static void pool_return_buffer(webgpu_resource_pool_t *pool, const webgpu_pending_release_t *release) {
+    WebGPUBufferClass buffer_class_ = buffer_class(release->usage);
+    pool->used[buffer_class_] -= release->size;
+
+    if (pool->pooled_bytes + release->size > WEBGPU_BUFFER_POOL_BYTES) {
+        pool_destroy_buffer(pool, release->handle, buffer_class_, release->size);
+        return;
+    }
+
+    webgpu_pooled_buffer_t *pooled = ecs_vec_append_t(pool->allocator, &pool->buffers,
+        webgpu_pooled_buffer_t);
+    *pooled = (webgpu_pooled_buffer_t){
+        .buffer = release->handle,
+        .size = release->size,
+        .usage = release->usage,
+        .frame = pool->frame,
+    };
+    pool->pooled_bytes += release->size;
+}
+
+/**
+ * Return a block whose frames completed to its slab
+ */
+static void pool_return_block(webgpu_resource_pool_t *pool, const webgpu_pending_release_t *release) {
+    webgpu_slab_t *slab = release->handle;
+    uint32_t index = (uint32_t)(release->offset >> slab->order);
+    slab->used[index / 64] &= ~((uint64_t)1 << (index % 64));
+    slab->used_count--;
+    slab->frame = pool->frame;
+    pool->used[slab->buffer_class] -= release->size;
+}
+
+/**
+ * Start a frame: frees the handles of completed frames and destroys free
+ * buffers and empty slabs that were not reused for WEBGPU_BUFFER_POOL_FRAMES
+ */
+void webgpu_resource_pool_begin(webgpu_resource_pool_t *pool) {
+    if (!pool) {
+        return;
+    }
+
+    /* Releases are in frame order, so stop at the first one still in use */
+    webgpu_pending_release_t *pending = ecs_vec_first_t(&pool->pending, webgpu_pending_release_t);
+    int32_t count = ecs_vec_count(&pool->pending), freed = 0;
+    while (freed < count && pending[freed].frame < pool->completed) {
+        if (pending[freed].kind == WebGPUReleaseBuffer) {
+            pool_return_buffer(pool, &pending[freed]);
+        } else if (pending[freed].kind == WebGPUReleaseBlock) {
+            pool_return_block(pool, &pending[freed]);
+        } else {
+            release_now(pending[freed].kind, pending[freed].handle);
+        }
+        freed++;
+    }
+
+    if (freed) {
+        memmove(pending, &pending[freed], (size_t)(count - freed) * sizeof(*pending));
+        ecs_vec_set_count_t(pool->allocator, &pool->pending, webgpu_pending_release_t,
+            count - freed);
+    }
+
+    pool_trim(pool, WEBGPU_BUFFER_POOL_FRAMES);
+}
+
+/**
+ * Submitted work of a frame completed
+ */
+static void pool_work_done(WGPUQueueWorkDoneStatus status, void *userdata) {
+    webgpu_work_done_t *work_done = userdata;
+    webgpu_resource_pool_t *pool = work_done->pool;
+    work_done->waiting = false;
+    pool->waiting--;
+
+    if (pool->destroyed) {
+        pool_free(pool);
+        return;
+    }
+
+    /* A lost device won't use its handles anymore either */
+    if (status != WGPUQueueWorkDoneStatus_Success) {
+        ecs_warn("WebGPU: Submitted work failed (status %d)", status);
+    }
+
+    if (work_done->frame + 1 > pool->completed) {
+        pool->completed = work_done->frame + 1;
+    }
+}
+
+/**
+ * Track the work of a frame after its last submit. Handles released from
+ * now on belong to the next frame. When all callbacks are still waiting the
+ * frame is not tracked, the next tracked frame completes it as well.
+ */
+void webgpu_resource_pool_submitted(webgpu_resource_pool_t *pool, WGPUQueue queue, uint32_t frame) {
+    if (!pool) {
+        return;
+    }
+
+    for (int32_t i = 0; i < WEBGPU_FRAMES_IN_FLIGHT + 1; i++) {
+        webgpu_work_done_t *work_done = &pool->work_done[i];
+        if (work_done->waiting) {
+            continue;
+        }
+
+        work_done->pool = pool;
+        work_done->frame = frame;
+        work_done->waiting = true;
+        pool->waiting++;
+        wgpuQueueOnSubmittedWorkDone(queue, pool_work_done, work_done);
+        break;
+    }
+
+    pool->frame = frame + 1;
+}
+
+/**
+ * Get a dedicated buffer of exactly size bytes and usage, from the free
+ * buffers if the pool holds one. Contents of a pooled buffer are undefined.
+ * Returns NULL when the buffer can't be created or exceeds the budget.
+ */
+WGPUBuffer webgpu_resource_pool_buffer(webgpu_resource_pool_t *pool,
+                                       WGPUDevice device,
+                                       uint64_t size,
+                                       WGPUBufferUsage usage) {
+    if (!pool) {
+        return webgpu_create_buffer(device, (size_t)size, usage, NULL);
+    }
+
+    WebGPUBufferClass buffer_class_ = buffer_class(usage);
+    webgpu_pooled_buffer_t *buffers = ecs_vec_first_t(&pool->buffers, webgpu_pooled_buffer_t);
+    for (int32_t i = 0; i < ecs_vec_count(&pool->buffers); i++) {
+        if (buffers[i].size != size || buffers[i].usage != usage) {
+            continue;
+        }
+
+        WGPUBuffer buffer = buffers[i].buffer;
+        pool->pooled_bytes -= size;
+        pool->used[buffer_class_] += size;
+        ecs_vec_remove_t(&pool->buffers, webgpu_pooled_buffer_t, i);
+        return buffer;
+    }
+
+    if (!pool_commit(pool, buffer_class_, size)) {
+        return NULL;
+    }
+
+    WGPUBuffer buffer = webgpu_create_buffer(device, (size_t)size, usage, NULL);
+    if (!buffer) {
+        pool->committed[buffer_class_] -= size;
+        return NULL;
+    }
+
+    pool->used[buffer_class_] += size;
+    return buffer;
+}
+
+/**
+ * Take a free block of a slab
+ */
+static uint64_t slab_take_block(webgpu_slab_t *slab) {
+    for (uint32_t word = 0; word < WEBGPU_SLAB_WORDS; word++) {
+        uint64_t used = slab->used[word];
+        if (used == UINT64_MAX) {
+            continue;
+        }
+
+        uint32_t bit = 0;
+        while (used & ((uint64_t)1 << bit)) {
+            bit++;
+        }
+
+        slab->used[word] |= (uint64_t)1 << bit;
+        slab->used_count++;
+        return (uint64_t)(word * 64 + bit) << slab->order;
+    }
+
+    return 0;
+}
+
+/**
+ * Find a slab of a class and block size with a free block, creating one
+ * when all are full
+ */
+static webgpu_slab_t* pool_slab(webgpu_resource_pool_t *pool,
+                                WGPUDevice device,
+                                WebGPUBufferClass buffer_class_,
+                                uint32_t order) {
+    webgpu_slab_t **slabs = ecs_vec_first_t(&pool->slabs, webgpu_slab_t*);
+    for (int32_t i = 0; i < ecs_vec_count(&pool->slabs); i++) {
+        webgpu_slab_t *slab = slabs[i];
+        if (slab->buffer_class == buffer_class_ && slab->order == order &&
+            slab->used_count < slab->block_count) {
+            return slab;
+        }
+    }
+
+    if (!pool_commit(pool, buffer_class_, WEBGPU_SLAB_SIZE)) {
+        return NULL;
+    }
+
+    WGPUBuffer buffer = webgpu_create_buffer(device, WEBGPU_SLAB_SIZE,
+        slab_usage[buffer_class_], NULL);
+    if (!buffer) {
+        pool->committed[buffer_class_] -= WEBGPU_SLAB_SIZE;
+        return NULL;
+    }
+
+    webgpu_slab_t *slab = ecs_os_calloc_t(webgpu_slab_t);
+    slab->buffer = buffer;
+    slab->buffer_class = buffer_class_;
+    slab->order = order;
+    slab->block_count = WEBGPU_SLAB_SIZE >> order;
+    *ecs_vec_append_t(pool->allocator, &pool->slabs, webgpu_slab_t*) = slab;
+
+    /* Bits past the last block are never handed out */
+    uint32_t block_count = slab->block_count;
+    for (uint32_t word = (block_count + 63) / 64; word < WEBGPU_SLAB_WORDS; word++) {
+        slab->used[word] = UINT64_MAX;
+    }
+    if (block_count % 64) {
+        slab->used[block_count / 64] = UINT64_MAX << (block_count % 64);
+    }
+
+    ecs_trace("WebGPU: Created slab for %u byte blocks (class %d)", 1u << order, buffer_class_);
+    return slab;
+}
+
+/**
+ * Allocate a block of at least size bytes with usage. Small blocks are
+ * carved from a shared slab, so a block must be bound and written at its
+ * offset. Without a pool the block is a dedicated buffer. Returns false
+ * when the allocation failed or exceeds the budget.
+ */
+bool webgpu_buffer_alloc(webgpu_resource_pool_t *pool,
+                         WGPUDevice device,
+                         uint64_t size,
+                         WGPUBufferUsage usage,
+                         WebGPUBufferBlock *block) {
+    ecs_os_memset_t(block, 0, WebGPUBufferBlock);
+
+    uint32_t order = WEBGPU_SLAB_MIN_ORDER;
+    while (order <= WEBGPU_SLAB_MAX_ORDER && ((uint64_t)1 << order) < size) {
+        order++;
+    }
+
+    WebGPUBufferClass buffer_class_ = buffer_class(usage);
+    if (!pool || order > WEBGPU_SLAB_MAX_ORDER || (usage & ~slab_usage[buffer_class_])) {
+        WGPUBuffer buffer = webgpu_resource_pool_buffer(pool, device, size, usage);
+        if (!buffer) {
+            return false;
+        }
+
+        *block = (WebGPUBufferBlock){
+            .buffer = buffer,
+            .size = size,
+            .usage = usage,
+        };
+        return true;
+    }
+
+    webgpu_slab_t *slab = pool_slab(pool, device, buffer_class_, order);
+    if (!slab) {
+        return false;
+    }
+
+    uint64_t block_size = (uint64_t)1 << order;
+    *block = (WebGPUBufferBlock){
+        .buffer = slab->buffer,
+        .offset = slab_take_block(slab),
+        .size = block_size,
+        .usage = usage,
+        .slab = slab,
+    };
+    pool->used[buffer_class_] += block_size;
+    return true;
+}
+
+/**
+ * Queue a handle until the frames that may use it completed. Without a pool
+ * the handle is released right away.
+ */
+static void pool_release(webgpu_resource_pool_t *pool,
+                         webgpu_release_kind_t kind,
+                         void *handle,
+                         uint64_t offset,
+                         uint64_t size,
+                         WGPUBufferUsage usage) {
+    if (!handle) {
+        return;
+    }
+
+    if (!pool || pool->destroyed) {
+        release_now(kind, handle);
+        return;
+    }
+
+    webgpu_pending_release_t *release = ecs_vec_append_t(pool->allocator, &pool->pending,
+        webgpu_pending_release_t);
+    *release = (webgpu_pending_release_t){
+        .handle = handle,
+        .kind = kind,
+        .frame = pool->frame,
+        .offset = offset,
+        .size = size,
+        .usage = usage,
+    };
+}
+
+/**
+ * Free a block once the frames that may use it completed. Blocks of a
+ * destroyed pool went away with their slab.
+ */
+void webgpu_buffer_free(webgpu_resource_pool_t *pool, WebGPUBufferBlock *block) {
+    if (!block->buffer) {
+        return;
+    }
+
+    if (!block->slab) {
+        webgpu_release_buffer(pool, block->buffer, block->size, block->usage);
+    } else if (pool && !pool->destroyed) {
+        pool_release(pool, WebGPUReleaseBlock, block->slab, block->offset,
+            block->size, block->usage);
+    }
+
+    ecs_os_memset_t(block, 0, WebGPUBufferBlock);
+}
+
+/**
+ * Release a buffer of size bytes, it returns to the pool once unused
+ */
+void webgpu_release_buffer(webgpu_resource_pool_t *pool,
+                           WGPUBuffer buffer,
+                           uint64_t size,
+                           WGPUBufferUsage usage) {
+    pool_release(pool, WebGPUReleaseBuffer, buffer, 0, size, usage);
+}
+
+/**
+ * Release a texture, it is destroyed once unused
+ */
+void webgpu_release_texture(webgpu_resource_pool_t *pool, WGPUTexture texture) {
+    pool_release(pool, WebGPUReleaseTexture, texture, 0, 0, 0);
+}
+
+/**
+ * Release a texture view once unused
+ */
+void webgpu_release_texture_view(webgpu_resource_pool_t *pool, WGPUTextureView view) {
+    pool_release(pool, WebGPUReleaseTextureView, view, 0, 0, 0);
+}
+
+/**
+ * Release a bind group once unused
+ */
+void webgpu_release_bind_group(webgpu_resource_pool_t *pool, WGPUBindGroup bind_group) {
+    pool_release(pool, WebGPUReleaseBindGroup, bind_group, 0, 0, 0);
+}
+
+/**
+ * Release a render pipeline once unused
+ */
+void webgpu_release_render_pipeline(webgpu_resource_pool_t *pool, WGPURenderPipeline pipeline) {
+    pool_release(pool, WebGPUReleaseRenderPipeline, pipeline, 0, 0, 0);
+}
+
+/**
+ * Release a render bundle once unused
+ */
+void webgpu_release_render_bundle(webgpu_resource_pool_t *pool, WGPURenderBundle bundle) {
+    pool_release(pool, WebGPUReleaseRenderBundle, bundle, 0, 0, 0);
+}
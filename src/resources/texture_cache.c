@@ -0,0 +1,766 @@
+/**
+ * @file resources/texture_cache.c
+ * @brief WebGPUTexture files loaded into shared texture arrays.
+ *
+ * Textures with the same format, size and mip count are layers of one
+ * texture_2d_array, so materials sampling them share a bind group and only
+ * differ in the layer index of their uniform block. Files are KTX2
+ * containers: block compressed data (BC, ETC2, ASTC) is uploaded as is when
+ * the device has the format's feature, and a {format} in a texture path is
+ * replaced by the best compression the device supports. Uncompressed
+ * textures without a mip chain get one rendered on the GPU after upload.
+ *
+ * An array that runs out of layers is reallocated with twice the layers and
+ * its contents are copied on the GPU. This bumps the array's version, so
+ * bind groups created for it know to be recreated.
+ */
+
+#include "../private_api.h"
+
+/* Identifier at the start of every KTX2 file */
+static const uint8_t ktx2_identifier[12] = {
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+/* Texture format of a KTX2 vkFormat */
+typedef struct {
+    uint32_t vk_format;
+    WGPUTextureFormat format;
+    WGPUFeatureName feature;          /* Required device feature, Undefined for none */
+    uint32_t block_bytes;             /* Bytes of a block (of a texel if uncompressed) */
+    uint32_t block_size;              /* Texels along a block side, 1 if uncompressed */
+} texture_format_t;
+
+static const texture_format_t texture_formats[] = {
+    { 37, WGPUTextureFormat_RGBA8Unorm, WGPUFeatureName_Undefined, 4, 1 },
+    { 43, WGPUTextureFormat_RGBA8UnormSrgb, WGPUFeatureName_Undefined, 4, 1 },
+    { 133, WGPUTextureFormat_BC1RGBAUnorm, WGPUFeatureName_TextureCompressionBC, 8, 4 },
+    { 134, WGPUTextureFormat_BC1RGBAUnormSrgb, WGPUFeatureName_TextureCompressionBC, 8, 4 },
+    { 137, WGPUTextureFormat_BC3RGBAUnorm, WGPUFeatureName_TextureCompressionBC, 16, 4 },
+    { 138, WGPUTextureFormat_BC3RGBAUnormSrgb, WGPUFeatureName_TextureCompressionBC, 16, 4 },
+    { 145, WGPUTextureFormat_BC7RGBAUnorm, WGPUFeatureName_TextureCompressionBC, 16, 4 },
+    { 146, WGPUTextureFormat_BC7RGBAUnormSrgb, WGPUFeatureName_TextureCompressionBC, 16, 4 },
+    { 147, WGPUTextureFormat_ETC2RGB8Unorm, WGPUFeatureName_TextureCompressionETC2, 8, 4 },
+    { 148, WGPUTextureFormat_ETC2RGB8UnormSrgb, WGPUFeatureName_TextureCompressionETC2, 8, 4 },
+    { 151, WGPUTextureFormat_ETC2RGBA8Unorm, WGPUFeatureName_TextureCompressionETC2, 16, 4 },
+    { 152, WGPUTextureFormat_ETC2RGBA8UnormSrgb, WGPUFeatureName_TextureCompressionETC2, 16, 4 },
+    { 157, WGPUTextureFormat_ASTC4x4Unorm, WGPUFeatureName_TextureCompressionASTC, 16, 4 },
+    { 158, WGPUTextureFormat_ASTC4x4UnormSrgb, WGPUFeatureName_TextureCompressionASTC, 16, 4 },
+};
+
+/**
+ * Look up the texture format of a vkFormat, NULL if it isn't supported
+ */
+static const texture_format_t* texture_format_get(uint32_t vk_format) {
+    int32_t count = (int32_t)(sizeof(texture_formats) / sizeof(texture_formats[0]));
+    for (int32_t i = 0; i < count; i++) {
+        if (texture_formats[i].vk_format == vk_format) {
+            return &texture_formats[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Number of levels in a full mip chain
+ */
+static uint32_t mip_chain_length(uint32_t width, uint32_t height) {
+    uint32_t size = width > height ? width : height;
+    uint32_t levels = 1;
+    while (size > 1) {
+        size >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+/**
+ * Size of a mip level, rounded up to whole blocks
+ */
+static uint32_t mip_size(uint32_t size, uint32_t level, uint32_t block_size) {
+    size = size >> level ? size >> level : 1;
+    return (size + block_size - 1) / block_size * block_size;
+}
+
+/**
+ * Allocate the texture and view of an array with capacity layers
+ */
+static bool array_alloc(webgpu_texture_array_t *array, WGPUDevice device, uint32_t capacity) {
+    WGPUTextureUsage usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst |
+        WGPUTextureUsage_CopySrc;
+    if (array->generate_mips) {
+        usage |= WGPUTextureUsage_RenderAttachment;
+    }
+
+    WGPUTexture texture = webgpu_create_texture_array(device, array->width, array->height,
+        capacity, array->mip_levels, array->format, usage);
+    if (!texture) {
+        return false;
+    }
+
+    WGPUTextureViewDescriptor view_desc = {
+        .label = "Texture Array View",
+        .format = array->format,
+        .dimension = WGPUTextureViewDimension_2DArray,
+        .baseMipLevel = 0,
+        .mipLevelCount = array->mip_levels,
+        .baseArrayLayer = 0,
+        .arrayLayerCount = capacity,
+        .aspect = WGPUTextureAspect_All,
+    };
+
+    WGPUTextureView view = wgpuTextureCreateView(texture, &view_desc);
+    if (!view) {
+        wgpuTextureRelease(texture);
+        return false;
+    }
+
+    array->texture = texture;
+    array->view = view;
+    array->capacity = capacity;
+    return true;
+}
+
+/**
+ * Double the layers of an array, copying the used layers on the GPU
+ */
+static bool array_grow(webgpu_texture_cache_t *cache,
+                       webgpu_texture_array_t *array,
+                       WGPUDevice device,
+                       WGPUCommandEncoder encoder,
+                       uint32_t block_size) {
+    WGPUTexture previous = array->texture;
+    WGPUTextureView previous_view = array->view;
+    uint32_t capacity = array->capacity * 2;
+    if (capacity > WEBGPU_MAX_TEXTURE_LAYERS) {
+        capacity = WEBGPU_MAX_TEXTURE_LAYERS;
+    }
+
+    if (!array_alloc(array, device, capacity)) {
+        array->texture = previous;
+        array->view = previous_view;
+        return false;
+    }
+
+    for (uint32_t level = 0; level < array->mip_levels; level++) {
+        WGPUImageCopyTexture source = {
+            .texture = previous,
+            .mipLevel = level,
+            .aspect = WGPUTextureAspect_All,
+        };
+        WGPUImageCopyTexture destination = {
+            .texture = array->texture,
+            .mipLevel = level,
+            .aspect = WGPUTextureAspect_All,
+        };
+        WGPUExtent3D size = {
+            .width = mip_size(array->width, level, block_size),
+            .height = mip_size(array->height, level, block_size),
+            .depthOrArrayLayers = array->layers,
+        };
+        wgpuCommandEncoderCopyTextureToTexture(encoder, &source, &destination, &size);
+    }
+
+    /* Frames in flight may still sample the old array */
+    webgpu_release_texture_view(cache->resources, previous_view);
+    webgpu_release_texture(cache->resources, previous);
+    array->version++;
+
+    ecs_trace("WebGPU: Grew texture array %ux%u to %u layers",
+        array->width, array->height, capacity);
+    return true;
+}
+
+/**
+ * Find a free layer in an array of matching textures, adding an array when
+ * none has room. Returns the array index, or -1 if it could not be created.
+ */
+static int32_t array_add_layer(webgpu_texture_cache_t *cache,
+                               WGPUDevice device,
+                               WGPUCommandEncoder *encoder,
+                               const webgpu_texture_array_t *desc,
+                               uint32_t block_size,
+                               uint32_t *layer) {
+    webgpu_texture_array_t *arrays = ecs_vec_first_t(&cache->arrays, webgpu_texture_array_t);
+    int32_t count = ecs_vec_count(&cache->arrays);
+
+    for (int32_t i = 0; i < count; i++) {
+        webgpu_texture_array_t *array = &arrays[i];
+        if (array->format != desc->format || array->width != desc->width ||
+            array->height != desc->height || array->mip_levels != desc->mip_levels ||
+            array->generate_mips != desc->generate_mips) {
+            continue;
+        }
+
+        if (array->layers == array->capacity) {
+            if (array->capacity >= WEBGPU_MAX_TEXTURE_LAYERS) {
+                continue;
+            }
+            if (!*encoder) {
+                *encoder = wgpuDeviceCreateCommandEncoder(device,
+                    &(WGPUCommandEncoderDescriptor){ .label = "Texture Upload Encoder" });
+            }
+            if (!array_grow(cache, array, device, *encoder, block_size)) {
+                continue;
+            }
+        }
+
+        *layer = array->layers++;
+        return i;
+    }
+
+    webgpu_texture_array_t array = *desc;
+    array.layers = 0;
+    array.version = 0;
+    if (!array_alloc(&array, device, 1)) {
+        return -1;
+    }
+
+    array.layers = 1;
+    *layer = 0;
+    *ecs_vec_append_t(NULL, &cache->arrays, webgpu_texture_array_t) = array;
+    return count;
+}
+
+/**
+ * Get the mip generation pipeline of a format, created on first use
+ */
+static WGPURenderPipeline mip_pipeline(webgpu_texture_cache_t *cache,
+                                       WGPUDevice device,
+                                       WGPUTextureFormat format) {
+    int32_t slot = format == WGPUTextureFormat_RGBA8UnormSrgb ? 1 : 0;
+    if (cache->mip_pipelines[slot]) {
+        return cache->mip_pipelines[slot];
+    }
+
+    if (!cache->mip_module) {
+        cache->mip_module = webgpu_create_shader_module(device, mip_shader_source);
+        if (!cache->mip_module) {
+            return NULL;
+        }
+    }
+
+    if (!cache->mip_layout) {
+        WGPUBindGroupLayoutEntry entries[] = {
+            {
+                .binding = 0,
+                .visibility = WGPUShaderStage_Fragment,
+                .sampler = { .type = WGPUSamplerBindingType_Filtering },
+            },
+            {
+                .binding = 1,
+                .visibility = WGPUShaderStage_Fragment,
+                .texture = {
+                    .sampleType = WGPUTextureSampleType_Float,
+                    .viewDimension = WGPUTextureViewDimension_2D,
+                },
+            },
+        };
+
+        WGPUBindGroupLayoutDescriptor layout_desc = {
+            .label = "Mip Bind Group Layout",
+            .entryCount = 2,
+            .entries = entries,
+        };
+
+        cache->mip_layout = wgpuDeviceCreateBindGroupLayout(device, &layout_desc);
+        if (!cache->mip_layout) {
+            ecs_err("WebGPU: Failed to create mip generation layout");
+            return NULL;
+        }
+    }
+
+    WGPUPipelineLayout layout = wgpuDeviceCreatePipelineLayout(device,
+        &(WGPUPipelineLayoutDescriptor){
+            .label = "Mip Pipeline Layout",
+            .bindGroupLayoutCount = 1,
+            .bindGroupLayouts = &cache->mip_layout,
+        });
+
+    WGPUColorTargetState target = {
+        .format = format,
+        .writeMask = WGPUColorWriteMask_All,
+    };
+
+    WGPUFragmentState fragment = {
+        .module = cache->mip_module,
+        .entryPoint = "fs_main",
+        .targetCount = 1,
+        .targets = &target,
+    };
+
+    WGPURenderPipelineDescriptor pipeline_desc = {
+        .label = "Mip Pipeline",
+        .layout = layout,
+        .vertex = {
+            .module = cache->mip_module,
+            .entryPoint = "vs_main",
+        },
+        .fragment = &fragment,
+        .primitive = {
+            .topology = WGPUPrimitiveTopology_TriangleList,
+            .cullMode = WGPUCullMode_None,
+        },
+        .multisample = {
+            .count = 1,
+            .mask = 0xFFFFFFFF,
+        },
+    };
+
+    cache->mip_pipelines[slot] = wgpuDeviceCreateRenderPipeline(device, &pipeline_desc);
+    wgpuPipelineLayoutRelease(layout);
+    if (!cache->mip_pipelines[slot]) {
+        ecs_err("WebGPU: Failed to create mip generation pipeline");
+    }
+    return cache->mip_pipelines[slot];
+}
+
+/**
+ * View of one level of one layer
+ */
+static WGPUTextureView layer_view(const webgpu_texture_array_t *array,
+                                  uint32_t level,
+                                  uint32_t layer) {
+    WGPUTextureViewDescriptor view_desc = {
+        .label = "Mip Level View",
+        .format = array->format,
+        .dimension = WGPUTextureViewDimension_2D,
+        .baseMipLevel = level,
+        .mipLevelCount = 1,
+        .baseArrayLayer = layer,
+        .arrayLayerCount = 1,
+        .aspect = WGPUTextureAspect_All,
+    };
+    return wgpuTextureCreateView(array->texture, &view_desc);
+}
+
+/**
+ * Render the mip chain of a layer, each level filtered from the one above
+ */
+static void generate_mips(webgpu_texture_cache_t *cache,
+                          WGPUDevice device,
+                          WGPUCommandEncoder encoder,
+                          const webgpu_texture_array_t *array,
+                          uint32_t layer) {
+    WGPURenderPipeline pipeline = mip_pipeline(cache, device, array->format);
+    if (!pipeline) {
+        return;
+    }
+
+    WGPUTextureView source = layer_view(array, 0, layer);
+    for (uint32_t level = 1; level < array->mip_levels; level++) {
+        WGPUTextureView target = layer_view(array, level, layer);
+
+        WGPUBindGroupEntry entries[] = {
+            { .binding = 0, .sampler = cache->mip_sampler },
+            { .binding = 1, .textureView = source },
+        };
+
+        WGPUBindGroup bind_group = wgpuDeviceCreateBindGroup(device,
+            &(WGPUBindGroupDescriptor){
+                .label = "Mip Bind Group",
+                .layout = cache->mip_layout,
+                .entryCount = 2,
+                .entries = entries,
+            });
+
+        WGPURenderPassColorAttachment attachment = {
+            .view = target,
+            .loadOp = WGPULoadOp_Clear,
+            .storeOp = WGPUStoreOp_Store,
+            .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
+        };
+
+        WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(encoder,
+            &(WGPURenderPassDescriptor){
+                .label = "Mip Pass",
+                .colorAttachmentCount = 1,
+                .colorAttachments = &attachment,
+            });
+        wgpuRenderPassEncoderSetPipeline(pass, pipeline);
+        wgpuRenderPassEncoderSetBindGroup(pass, 0, bind_group, 0, NULL);
+        wgpuRenderPassEncoderDraw(pass, 3, 1, 0, 0);
+        wgpuRenderPassEncoderEnd(pass);
+        wgpuRenderPassEncoderRelease(pass);
+
+        wgpuBindGroupRelease(bind_group);
+        wgpuTextureViewRelease(source);
+        source = target;
+    }
+    wgpuTextureViewRelease(source);
+}
+
+/**
+ * Create a texture cache. Array 0 is a white texel, sampled by materials
+ * without a texture or with a texture that is still loading.
+ */
+webgpu_texture_cache_t* webgpu_texture_cache_create(WGPUDevice device,
+                                                    WGPUQueue queue,
+                                                    webgpu_resource_pool_t *resources) {
+    webgpu_texture_cache_t *cache = ecs_os_calloc_t(webgpu_texture_cache_t);
+    cache->resources = resources;
+    ecs_vec_init_t(NULL, &cache->arrays, webgpu_texture_array_t, 1);
+    ecs_vec_init_t(NULL, &cache->textures, webgpu_texture_entry_t*, 0);
+    ecs_map_init(&cache->ids, NULL);
+
+    /* The most compact format the device can sample */
+    if (wgpuDeviceHasFeature(device, WGPUFeatureName_TextureCompressionBC)) {
+        cache->compression = "bc7";
+    } else if (wgpuDeviceHasFeature(device, WGPUFeatureName_TextureCompressionASTC)) {
+        cache->compression = "astc";
+    } else if (wgpuDeviceHasFeature(device, WGPUFeatureName_TextureCompressionETC2)) {
+        cache->compression = "etc2";
+    } else {
+        cache->compression = "rgba8";
+    }
+
+    cache->sampler = wgpuDeviceCreateSampler(device, &(WGPUSamplerDescriptor){
+        .label = "Material Sampler",
+        .addressModeU = WGPUAddressMode_Repeat,
+        .addressModeV = WGPUAddressMode_Repeat,
+        .addressModeW = WGPUAddressMode_Repeat,
+        .magFilter = WGPUFilterMode_Linear,
+        .minFilter = WGPUFilterMode_Linear,
+        .mipmapFilter = WGPUMipmapFilterMode_Linear,
+        .lodMinClamp = 0.0f,
+        .lodMaxClamp = 32.0f,
+        .maxAnisotropy = 4,
+    });
+
+    cache->mip_sampler = wgpuDeviceCreateSampler(device, &(WGPUSamplerDescriptor){
+        .label = "Mip Sampler",
+        .addressModeU = WGPUAddressMode_ClampToEdge,
+        .addressModeV = WGPUAddressMode_ClampToEdge,
+        .addressModeW = WGPUAddressMode_ClampToEdge,
+        .magFilter = WGPUFilterMode_Linear,
+        .minFilter = WGPUFilterMode_Linear,
+        .mipmapFilter = WGPUMipmapFilterMode_Nearest,
+        .lodMinClamp = 0.0f,
+        .lodMaxClamp = 32.0f,
+        .maxAnisotropy = 1,
+    });
+
+    webgpu_texture_array_t white = {
+        .format = WGPUTextureFormat_RGBA8Unorm,
+        .width = 1,
+        .height = 1,
+        .mip_levels = 1,
+    };
+
+    if (!cache->sampler || !cache->mip_sampler || !array_alloc(&white, device, 1)) {
+        ecs_err("WebGPU: Failed to create texture cache");
+        webgpu_texture_cache_destroy(cache);
+        return NULL;
+    }
+
+    static const uint8_t texel[4] = {255, 255, 255, 255};
+    wgpuQueueWriteTexture(queue,
+        &(WGPUImageCopyTexture){ .texture = white.texture, .aspect = WGPUTextureAspect_All },
+        texel, sizeof(texel),
+        &(WGPUTextureDataLayout){ .bytesPerRow = sizeof(texel), .rowsPerImage = 1 },
+        &(WGPUExtent3D){ 1, 1, 1 });
+
+    white.layers = 1;
+    *ecs_vec_append_t(NULL, &cache->arrays, webgpu_texture_array_t) = white;
+
+    ecs_trace("WebGPU: Texture cache created, preferring %s textures", cache->compression);
+    return cache;
+}
+
+/**
+ * Release the texture arrays and close the files of loading textures
+ */
+void webgpu_texture_cache_destroy(webgpu_texture_cache_t *cache) {
+    if (!cache) {
+        return;
+    }
+
+    webgpu_texture_entry_t **textures = ecs_vec_first_t(&cache->textures, webgpu_texture_entry_t*);
+    for (int32_t i = 0; i < ecs_vec_count(&cache->textures); i++) {
+        webgpu_file_stream_close(textures[i]->file);
+        ecs_os_free(textures[i]);
+    }
+
+    webgpu_texture_array_t *arrays = ecs_vec_first_t(&cache->arrays, webgpu_texture_array_t);
+    for (int32_t i = 0; i < ecs_vec_count(&cache->arrays); i++) {
+        wgpuTextureViewRelease(arrays[i].view);
+        wgpuTextureRelease(arrays[i].texture);
+    }
+
+    for (int32_t i = 0; i < 2; i++) {
+        if (cache->mip_pipelines[i]) {
+            wgpuRenderPipelineRelease(cache->mip_pipelines[i]);
+        }
+    }
+
+    if (cache->mip_layout) {
+        wgpuBindGroupLayoutRelease(cache->mip_layout);
+    }
+
+    if (cache->mip_module) {
+        wgpuShaderModuleRelease(cache->mip_module);
+    }
+
+    if (cache->mip_sampler) {
+        wgpuSamplerRelease(cache->mip_sampler);
+    }
+
+    if (cache->sampler) {
+        wgpuSamplerRelease(cache->sampler);
+    }
+
+    ecs_vec_fini_t(NULL, &cache->textures, webgpu_texture_entry_t*);
+    ecs_vec_fini_t(NULL, &cache->arrays, webgpu_texture_array_t);
+    ecs_map_fini(&cache->ids);
+    ecs_os_free(cache);
+}
+
+/**
+ * Mark a texture as failed and close its file
+ */
+static void texture_fail(webgpu_texture_entry_t *entry, const char *reason) {
+    if (reason) {
+        ecs_err("WebGPU: Failed to load texture %s: %s",
+            entry->file ? entry->file->path : "(no path)", reason);
+    }
+    entry->state = WebGPUTextureFailed;
+    webgpu_file_stream_close(entry->file);
+    entry->file = NULL;
+}
+
+/**
+ * Get the array and layer of a WebGPUTexture entity, starting to load its
+ * file on first use. Returns false while the texture is loading or if it
+ * failed to load.
+ */
+bool webgpu_texture_cache_get(webgpu_texture_cache_t *cache,
+                              const ecs_world_t *world,
+                              ecs_entity_t texture,
+                              int32_t *array,
+                              uint32_t *layer) {
+    if (!cache || !texture) {
+        return false;
+    }
+
+    webgpu_texture_entry_t *entry;
+    ecs_map_val_t *index = ecs_map_get(&cache->ids, texture);
+    if (index) {
+        entry = *ecs_vec_get_t(&cache->textures, webgpu_texture_entry_t*, (int32_t)*index);
+    } else {
+        entry = ecs_os_calloc_t(webgpu_texture_entry_t);
+        entry->entity = texture;
+        ecs_map_insert(&cache->ids, texture,
+            (ecs_map_val_t)ecs_vec_count(&cache->textures));
+        *ecs_vec_append_t(NULL, &cache->textures, webgpu_texture_entry_t*) = entry;
+
+        /* The file is loaded once, later path changes are not picked up */
+        const WebGPUTexture *component = ecs_is_alive(world, texture) ?
+            ecs_get(world, texture, WebGPUTexture) : NULL;
+        if (component && component->path) {
+            const char *format = strstr(component->path, "{format}");
+            char *path = format ? flecs_asprintf("%.*s%s%s",
+                (int)(format - component->path), component->path,
+                cache->compression, format + 8) : ecs_os_strdup(component->path);
+            ecs_trace("WebGPU: Loading texture %s", path);
+            entry->file = webgpu_file_stream_open(path);
+            ecs_os_free(path);
+        } else {
+            texture_fail(entry, "no path");
+        }
+    }
+
+    if (entry->state != WebGPUTextureResident) {
+        return false;
+    }
+
+    *array = entry->array;
+    *layer = entry->layer;
+    return true;
+}
+
+/**
+ * Get a texture array by index
+ */
+const webgpu_texture_array_t* webgpu_texture_cache_array(const webgpu_texture_cache_t *cache,
+                                                         int32_t array) {
+    if (!cache || array < 0 || array >= ecs_vec_count(&cache->arrays)) {
+        return NULL;
+    }
+    return ecs_vec_get_t(&cache->arrays, webgpu_texture_array_t, array);
+}
+
+/**
+ * Parse the KTX2 file of a texture and upload its levels into a free array
+ * layer. Returns the number of bytes uploaded, 0 if the file was rejected.
+ */
+static uint64_t texture_upload(webgpu_texture_cache_t *cache,
+                               WGPUDevice device,
+                               WGPUQueue queue,
+                               WGPUCommandEncoder *encoder,
+                               webgpu_texture_entry_t *entry) {
+    webgpu_file_stream_t *file = entry->file;
+    webgpu_ktx2_header_t header;
+    if (file->received < sizeof(header)) {
+        texture_fail(entry, "not a KTX2 file");
+        return 0;
+    }
+
+    memcpy(&header, file->data, sizeof(header));
+    if (memcmp(header.identifier, ktx2_identifier, sizeof(ktx2_identifier))) {
+        texture_fail(entry, "not a KTX2 file");
+        return 0;
+    }
+
+    /* Basis Universal data needs a transcoder, which is not part of the engine */
+    if (header.supercompression || !header.vk_format) {
+        texture_fail(entry, "supercompressed data, store raw BC/ETC2/ASTC/RGBA8 blocks");
+        return 0;
+    }
+
+    if (!header.width || !header.height || header.depth > 1 ||
+        header.layer_count > 1 || header.face_count != 1) {
+        texture_fail(entry, "only single 2D textures are supported");
+        return 0;
+    }
+
+    const texture_format_t *format = texture_format_get(header.vk_format);
+    if (!format) {
+        texture_fail(entry, "unsupported format");
+        return 0;
+    }
+
+    if (format->feature != WGPUFeatureName_Undefined &&
+        !wgpuDeviceHasFeature(device, format->feature)) {
+        texture_fail(entry, "format not supported by the device");
+        return 0;
+    }
+
+    /* Uncompressed textures with a single level get a generated chain */
+    uint32_t chain = mip_chain_length(header.width, header.height);
+    uint32_t levels = header.level_count ? header.level_count : 1;
+    levels = levels < chain ? levels : chain;
+
+    webgpu_texture_array_t desc = {
+        .format = format->format,
+        .width = header.width,
+        .height = header.height,
+        .generate_mips = levels == 1 && chain > 1 && format->block_size == 1,
+    };
+    desc.mip_levels = desc.generate_mips ? chain : levels;
+
+    /* Validate all levels before taking a layer */
+    const webgpu_ktx2_level_t *level_index = (const webgpu_ktx2_level_t*)
+        (file->data + sizeof(header));
+    if (file->received < sizeof(header) + levels * sizeof(webgpu_ktx2_level_t)) {
+        texture_fail(entry, "truncated file");
+        return 0;
+    }
+
+    for (uint32_t level = 0; level < levels; level++) {
+        uint64_t blocks_x = mip_size(header.width, level, format->block_size) / format->block_size;
+        uint64_t blocks_y = mip_size(header.height, level, format->block_size) / format->block_size;
+        uint64_t size = blocks_x * blocks_y * format->block_bytes;
+        if (level_index[level].length < size ||
+            level_index[level].offset + size > file->received) {
+            texture_fail(entry, "truncated file");
+            return 0;
+        }
+    }
+
+    uint32_t layer = 0;
+    int32_t array_index = array_add_layer(cache, device, encoder, &desc,
+        format->block_size, &layer);
+    if (array_index < 0) {
+        texture_fail(entry, "out of texture memory");
+        return 0;
+    }
+
+    const webgpu_texture_array_t *array = webgpu_texture_cache_array(cache, array_index);
+    uint64_t uploaded = 0;
+    for (uint32_t level = 0; level < levels; level++) {
+        uint32_t width = mip_size(header.width, level, format->block_size);
+        uint32_t height = mip_size(header.height, level, format->block_size);
+        uint32_t bytes_per_row = width / format->block_size * format->block_bytes;
+        uint32_t rows = height / format->block_size;
+
+        wgpuQueueWriteTexture(queue,
+            &(WGPUImageCopyTexture){
+                .texture = array->texture,
+                .mipLevel = level,
+                .origin = { 0, 0, layer },
+                .aspect = WGPUTextureAspect_All,
+            },
+            file->data + level_index[level].offset, (size_t)bytes_per_row * rows,
+            &(WGPUTextureDataLayout){ .bytesPerRow = bytes_per_row, .rowsPerImage = rows },
+            &(WGPUExtent3D){ width, height, 1 });
+        uploaded += (uint64_t)bytes_per_row * rows;
+    }
+
+    if (array->generate_mips) {
+        if (!*encoder) {
+            *encoder = wgpuDeviceCreateCommandEncoder(device,
+                &(WGPUCommandEncoderDescriptor){ .label = "Texture Upload Encoder" });
+        }
+        generate_mips(cache, device, *encoder, array, layer);
+    }
+
+    entry->array = array_index;
+    entry->layer = layer;
+    entry->state = WebGPUTextureResident;
+    webgpu_file_stream_close(file);
+    entry->file = NULL;
+    return uploaded;
+}
+
+/**
+ * Upload the textures whose files arrived, at most budget bytes per frame
+ * (at least one texture, so large files don't stall). Array growth and mip
+ * generation are submitted before the frame's own commands. Returns the
+ * number of bytes uploaded.
+ */
+uint64_t webgpu_texture_cache_update(webgpu_texture_cache_t *cache,
+                                     WGPUDevice device,
+                                     WGPUQueue queue,
+                                     uint64_t budget) {
+    if (!cache) {
+        return 0;
+    }
+
+    WGPUCommandEncoder encoder = NULL;
+    uint64_t uploaded = 0;
+    uint32_t loading = 0;
+    webgpu_texture_entry_t **textures = ecs_vec_first_t(&cache->textures, webgpu_texture_entry_t*);
+
+    for (int32_t i = 0; i < ecs_vec_count(&cache->textures); i++) {
+        webgpu_texture_entry_t *entry = textures[i];
+        if (entry->state != WebGPUTextureLoading) {
+            continue;
+        }
+
+        if (entry->file->failed) {
+            /* The file stream reported why */
+            texture_fail(entry, NULL);
+            continue;
+        }
+
+        /* The container's level index can point anywhere in the file, so
+         * textures are uploaded once the whole file arrived */
+        if (!entry->file->done || uploaded >= budget) {
+            loading++;
+            continue;
+        }
+
+        uploaded += texture_upload(cache, device, queue, &encoder, entry);
+    }
+
+    if (encoder) {
+        WGPUCommandBuffer commands = wgpuCommandEncoderFinish(encoder,
+            &(WGPUCommandBufferDescriptor){ .label = "Texture Upload Commands" });
+        wgpuQueueSubmit(queue, 1, &commands);
+        wgpuCommandBufferRelease(commands);
+        wgpuCommandEncoderRelease(encoder);
+    }
+
+    cache->loading = loading;
+    return uploaded;
+}
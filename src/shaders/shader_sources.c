@@ -1,104 +1,310 @@
 /**
  * @file shaders/shader_sources.c
  * @brief Embedded WGSL shader sources.
+ *
+ * Geometry shaders are generated from shaders/geometry.wgsl into
+ * shader_variants.c, this file holds the compute shaders.
  */
 
 #include "../private_api.h"
 
-const char *basic_vertex_shader_source = R"(
-struct VertexInput {
-    @location(0) position: vec3<f32>,
-    @location(1) normal: vec3<f32>,
-    @location(2) uv: vec2<f32>,
+/* Frustum culling: tests each instance's bounding sphere against the camera
+ * frustum and appends visible instance records to a compacted buffer. The
+ * visible count is accumulated into DrawIndexedIndirect arguments. Records
+ * are read and written from first_instance, so batches can share buffers.
+ * With occlusion, spheres are projected with the previous frame's camera
+ * and rejected if they are behind the farthest depth of the HiZ texels
+ * they cover. */
+const char *cull_compute_shader_source = R"(
+struct Camera {
+    view: mat4x4<f32>,
+    projection: mat4x4<f32>,
+    view_projection: mat4x4<f32>,
 }
 
-struct InstanceInput {
-    @location(3) model_matrix_0: vec4<f32>,
-    @location(4) model_matrix_1: vec4<f32>,
-    @location(5) model_matrix_2: vec4<f32>,
-    @location(6) model_matrix_3: vec4<f32>,
-    @location(7) color: vec3<f32>,
+struct CullParams {
+    bounds: vec4<f32>,      // Mesh bounding sphere (center, radius)
+    instance_count: u32,
+    stride_words: u32,      // Instance record size in 32-bit words
+    format: u32,            // 0 = full, 1 = compact, 2 = compact half
+    first_instance: u32,    // First record of the batch in both buffers
+    occlusion_view_projection: mat4x4<f32>, // Camera the HiZ was built with
+    region: vec2<f32>,      // Drawn region of the HiZ frame, in depth texels
+    hiz_levels: u32,
+    occlusion: u32,         // 1 to test against the HiZ
+    margin: f32,            // Sphere growth covering the camera's movement since
+                            // the HiZ frame
 }
 
-struct VertexOutput {
-    @builtin(position) clip_position: vec4<f32>,
-    @location(0) world_position: vec3<f32>,
-    @location(1) world_normal: vec3<f32>,
-    @location(2) uv: vec2<f32>,
-    @location(3) color: vec3<f32>,
+struct DrawArgs {
+    index_count: u32,
+    instance_count: atomic<u32>,
+    first_index: u32,
+    base_vertex: i32,
+    first_instance: u32,
 }
 
-struct Camera {
-    view: mat4x4<f32>,
-    projection: mat4x4<f32>,
-    view_projection: mat4x4<f32>,
+@group(0) @binding(0) var<uniform> camera: Camera;
+@group(0) @binding(1) var<uniform> params: CullParams;
+@group(0) @binding(2) var<storage, read> instances: array<u32>;
+@group(0) @binding(3) var<storage, read_write> visible: array<u32>;
+@group(0) @binding(4) var<storage, read_write> draw: DrawArgs;
+@group(0) @binding(5) var hiz: texture_2d<f32>;
+
+// Element (row, column) of an instance's model matrix
+fn model_element(base: u32, row: u32, col: u32) -> f32 {
+    if (params.format == 0u) {
+        return bitcast<f32>(instances[base + col * 4u + row]);
+    }
+    
+    let index = row * 4u + col;
+    if (params.format == 1u) {
+        return bitcast<f32>(instances[base + index]);
+    }
+    
+    let pair = unpack2x16float(instances[base + index / 2u]);
+    return select(pair.x, pair.y, (index & 1u) == 1u);
 }
 
-@group(0) @binding(0)
-var<uniform> camera: Camera;
+// Whether a sphere is hidden behind the previous frame's depth. Spheres that
+// cross the near plane or leave the previous view are never hidden.
+fn occluded(center: vec3<f32>, radius: f32) -> bool {
+    var uv_min = vec2<f32>(1.0);
+    var uv_max = vec2<f32>(0.0);
+    var nearest = 1.0;
+    for (var i = 0u; i < 8u; i++) {
+        let corner = center + radius * vec3<f32>(
+            select(-1.0, 1.0, (i & 1u) != 0u),
+            select(-1.0, 1.0, (i & 2u) != 0u),
+            select(-1.0, 1.0, (i & 4u) != 0u),
+        );
+        let clip = params.occlusion_view_projection * vec4<f32>(corner, 1.0);
+        if (clip.w <= 0.0) {
+            return false;
+        }
+        let ndc = clip.xyz / clip.w;
+        let uv = vec2<f32>(ndc.x * 0.5 + 0.5, 0.5 - ndc.y * 0.5);
+        uv_min = min(uv_min, uv);
+        uv_max = max(uv_max, uv);
+        nearest = min(nearest, ndc.z);
+    }
+    
+    if (nearest <= 0.0 || any(uv_min < vec2<f32>(0.0)) || any(uv_max > vec2<f32>(1.0))) {
+        return false;
+    }
+    
+    // Depth texels covered, and the level at which they span at most 2x2
+    let last = vec2<u32>(params.region) - vec2<u32>(1u);
+    let p0 = min(vec2<u32>(uv_min * params.region), last);
+    let p1 = min(vec2<u32>(uv_max * params.region), last);
+    let span = max(p1.x - p0.x, p1.y - p0.y);
+    var level = 0u;
+    if (span > 0u) {
+        level = min(firstLeadingBit(span), params.hiz_levels - 1u);
+    }
+    
+    // Level 0 is half the depth resolution
+    let size = textureDimensions(hiz, level) - vec2<u32>(1u);
+    let t0 = min(p0 >> vec2<u32>(level + 1u), size);
+    let t1 = min(p1 >> vec2<u32>(level + 1u), size);
+    let farthest = max(
+        max(textureLoad(hiz, vec2<u32>(t0.x, t0.y), level).r, textureLoad(hiz, vec2<u32>(t1.x, t0.y), level).r),
+        max(textureLoad(hiz, vec2<u32>(t0.x, t1.y), level).r, textureLoad(hiz, vec2<u32>(t1.x, t1.y), level).r),
+    );
+    return nearest > farthest;
+}
 
-@vertex
-fn vs_main(vertex: VertexInput, instance: InstanceInput) -> VertexOutput {
-    let model_matrix = mat4x4<f32>(
-        instance.model_matrix_0,
-        instance.model_matrix_1,
-        instance.model_matrix_2,
-        instance.model_matrix_3,
+@compute @workgroup_size(64)
+fn cs_main(@builtin(global_invocation_id) id: vec3<u32>) {
+    let index = id.x;
+    if (index >= params.instance_count) {
+        return;
+    }
+    
+    // Transform the bounding sphere to world space
+    let base = (params.first_instance + index) * params.stride_words;
+    var center = vec3<f32>(
+        model_element(base, 0u, 3u),
+        model_element(base, 1u, 3u),
+        model_element(base, 2u, 3u),
     );
+    var max_scale_sq = 0.0;
+    for (var col = 0u; col < 3u; col++) {
+        let axis = vec3<f32>(
+            model_element(base, 0u, col),
+            model_element(base, 1u, col),
+            model_element(base, 2u, col),
+        );
+        center += axis * params.bounds[col];
+        max_scale_sq = max(max_scale_sq, dot(axis, axis));
+    }
+    let radius = params.bounds.w * sqrt(max_scale_sq);
     
-    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);
-    let world_normal = normalize((model_matrix * vec4<f32>(vertex.normal, 0.0)).xyz);
+    // Frustum planes from the view projection rows (clip z in [0, w])
+    let m = camera.view_projection;
+    let row_0 = vec4<f32>(m[0].x, m[1].x, m[2].x, m[3].x);
+    let row_1 = vec4<f32>(m[0].y, m[1].y, m[2].y, m[3].y);
+    let row_2 = vec4<f32>(m[0].z, m[1].z, m[2].z, m[3].z);
+    let row_3 = vec4<f32>(m[0].w, m[1].w, m[2].w, m[3].w);
+    var planes = array<vec4<f32>, 6>(
+        row_3 + row_0, row_3 - row_0,
+        row_3 + row_1, row_3 - row_1,
+        row_2, row_3 - row_2,
+    );
     
-    var out: VertexOutput;
-    out.clip_position = camera.view_projection * world_position;
-    out.world_position = world_position.xyz;
-    out.world_normal = world_normal;
-    out.uv = vertex.uv;
-    out.color = instance.color;
+    for (var i = 0u; i < 6u; i++) {
+        let plane = planes[i];
+        if (dot(plane.xyz, center) + plane.w < -radius * length(plane.xyz)) {
+            return;
+        }
+    }
     
-    return out;
+    if (params.occlusion != 0u && occluded(center, radius + params.margin)) {
+        return;
+    }
+    
+    // Append the instance record to the visible list
+    let slot = atomicAdd(&draw.instance_count, 1u);
+    let dst = (params.first_instance + slot) * params.stride_words;
+    for (var w = 0u; w < params.stride_words; w++) {
+        visible[dst + w] = instances[base + w];
+    }
 }
 )";
 
-const char *basic_fragment_shader_source = R"(
+/* Mip generation: a fullscreen triangle that filters the level above into
+ * the bound level. Linear sampling at the center of each target texel
+ * averages the 2x2 source texels it covers. */
+const char *mip_shader_source = R"(
 struct VertexOutput {
-    @builtin(position) clip_position: vec4<f32>,
-    @location(0) world_position: vec3<f32>,
-    @location(1) world_normal: vec3<f32>,
-    @location(2) uv: vec2<f32>,
-    @location(3) color: vec3<f32>,
+    @builtin(position) position: vec4<f32>,
+    @location(0) uv: vec2<f32>,
 }
 
-struct Light {
-    direction_x: f32,
-    direction_y: f32,
-    direction_z: f32,
-    intensity: f32,
-    color_x: f32,
-    color_y: f32,
-    color_z: f32,
-    ambient_strength: f32,
-    ambient_xy: vec2<f32>,
-}
+@group(0) @binding(0) var source_sampler: sampler;
+@group(0) @binding(1) var source: texture_2d<f32>;
 
-@group(1) @binding(0)
-var<uniform> light: Light;
+@vertex
+fn vs_main(@builtin(vertex_index) index: u32) -> VertexOutput {
+    let uv = vec2<f32>(f32((index << 1u) & 2u), f32(index & 2u));
+    var out: VertexOutput;
+    out.position = vec4<f32>(uv.x * 2.0 - 1.0, 1.0 - uv.y * 2.0, 0.0, 1.0);
+    out.uv = uv;
+    return out;
+}
 
 @fragment
 fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {
-    let normal = normalize(in.world_normal);
-    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);
-    let light_dir = normalize(-light_direction);
+    return textureSample(source, source_sampler, in.uv);
+}
+)";
+
+/* HiZ pyramid: cs_depth reduces the depth buffer into level 0 at half its
+ * resolution (rounded up), cs_reduce each level into the next. Every texel
+ * keeps the farthest depth of the 2x2 texels below it. Mip sizes round
+ * down, so the last texel of a row or column below an odd sized level also
+ * covers the texel left over. */
+const char *hiz_shader_source = R"(
+@group(0) @binding(0) var source: texture_2d<f32>;
+@group(0) @binding(1) var destination: texture_storage_2d<r32float, write>;
+@group(0) @binding(2) var depth: texture_depth_2d;
+
+fn load_depth(coords: vec2<u32>) -> f32 {
+    return textureLoad(depth, min(coords, textureDimensions(depth) - vec2<u32>(1u)), 0);
+}
+
+fn load_source(coords: vec2<u32>) -> f32 {
+    return textureLoad(source, min(coords, textureDimensions(source) - vec2<u32>(1u)), 0).r;
+}
+
+@compute @workgroup_size(8, 8)
+fn cs_depth(@builtin(global_invocation_id) id: vec3<u32>) {
+    if (any(id.xy >= textureDimensions(destination))) {
+        return;
+    }
     
-    // Lambertian diffuse lighting
-    let ndotl = max(dot(normal, light_dir), 0.0);
-    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);
-    let diffuse = light_color * light.intensity * ndotl;
+    let base = id.xy * 2u;
+    let farthest = max(
+        max(load_depth(base), load_depth(base + vec2<u32>(1u, 0u))),
+        max(load_depth(base + vec2<u32>(0u, 1u)), load_depth(base + vec2<u32>(1u, 1u))),
+    );
+    textureStore(destination, id.xy, vec4<f32>(farthest, 0.0, 0.0, 0.0));
+}
+
+@compute @workgroup_size(8, 8)
+fn cs_reduce(@builtin(global_invocation_id) id: vec3<u32>) {
+    if (any(id.xy >= textureDimensions(destination))) {
+        return;
+    }
     
-    // Combine lighting with material color
-    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);
-    let final_color = in.color * (ambient_color + diffuse);
+    let base = id.xy * 2u;
+    let last = id.xy == textureDimensions(destination) - vec2<u32>(1u);
+    let extent = select(vec2<u32>(2u), textureDimensions(source) - base, last);
+    var farthest = 0.0;
+    for (var y = 0u; y < extent.y; y++) {
+        for (var x = 0u; x < extent.x; x++) {
+            farthest = max(farthest, load_source(base + vec2<u32>(x, y)));
+        }
+    }
+    textureStore(destination, id.xy, vec4<f32>(farthest, 0.0, 0.0, 0.0));
+}
+)";
+
+/* Transform expansion: turns position, euler rotation and scale records
+ * (gpu_transforms) into the affine compact records the geometry shaders
+ * read, composed as T * Rx * Ry * Rz * S like flecs.systems.transform. The
+ * color and storage tag words are copied. Records are read and written at
+ * the same index in both buffers. */
+const char *transform_shader_source = R"(
+struct TransformParams {
+    first_instance: u32,    // First record to expand
+    instance_count: u32,
+    source_words: u32,      // Position/rotation/scale record size in 32-bit words
+    dest_words: u32,        // Compact record size in 32-bit words
+}
+
+@group(0) @binding(0) var<uniform> params: TransformParams;
+@group(0) @binding(1) var<storage, read> source: array<u32>;
+@group(0) @binding(2) var<storage, read_write> expanded: array<u32>;
+
+fn store_row(offset: u32, row: vec4<f32>) {
+    expanded[offset] = bitcast<u32>(row.x);
+    expanded[offset + 1u] = bitcast<u32>(row.y);
+    expanded[offset + 2u] = bitcast<u32>(row.z);
+    expanded[offset + 3u] = bitcast<u32>(row.w);
+}
+
+@compute @workgroup_size(64)
+fn cs_main(@builtin(global_invocation_id) id: vec3<u32>) {
+    if (id.x >= params.instance_count) {
+        return;
+    }
+    
+    let record = params.first_instance + id.x;
+    let src = record * params.source_words;
+    let dst = record * params.dest_words;
     
-    return vec4<f32>(final_color, 1.0);
+    let position = vec3<f32>(
+        bitcast<f32>(source[src]),
+        bitcast<f32>(source[src + 1u]),
+        bitcast<f32>(source[src + 2u]));
+    let rotation_xy = unpack2x16float(source[src + 3u]);
+    let rotation_z_scale_x = unpack2x16float(source[src + 4u]);
+    let scale_yz = unpack2x16float(source[src + 5u]);
+    let angles = vec3<f32>(rotation_xy, rotation_z_scale_x.x);
+    let scale = vec3<f32>(rotation_z_scale_x.y, scale_yz);
+    let s = sin(angles);
+    let c = cos(angles);
+    
+    // Columns of Rx * Ry * Rz, scaled
+    let x_axis = vec3<f32>(c.y * c.z, c.x * s.z + s.x * s.y * c.z, s.x * s.z - c.x * s.y * c.z) * scale.x;
+    let y_axis = vec3<f32>(-c.y * s.z, c.x * c.z - s.x * s.y * s.z, s.x * c.z + c.x * s.y * s.z) * scale.y;
+    let z_axis = vec3<f32>(s.y, -s.x * c.y, c.x * c.y) * scale.z;
+    
+    store_row(dst, vec4<f32>(x_axis.x, y_axis.x, z_axis.x, position.x));
+    store_row(dst + 4u, vec4<f32>(x_axis.y, y_axis.y, z_axis.y, position.y));
+    store_row(dst + 8u, vec4<f32>(x_axis.z, y_axis.z, z_axis.z, position.z));
+    expanded[dst + 12u] = source[src + 6u];
+    expanded[dst + 13u] = source[src + 7u];
 }
-)";
\ No newline at end of file
+)";
@@ -0,0 +1,2534 @@
+/**
+ * @file shaders/shader_variants.c
+ * @brief Precompiled WGSL shader permutations.
+ *
+ * Generated by tools/wgsl_variants.c from shaders/geometry.wgsl, do not edit.
+ */
+
+#include <stdint.h>
+
+const uint32_t webgpu_shader_variant_count = 16;
+
+/* Indexed by webgpu_shader_feature_t flags */
+const char *webgpu_shader_variant_sources[] = {
+    /* (none) */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "struct InstanceInput {\n"
+    "    @location(3) model_matrix_0: vec4<f32>,\n"
+    "    @location(4) model_matrix_1: vec4<f32>,\n"
+    "    @location(5) model_matrix_2: vec4<f32>,\n"
+    "    @location(6) model_matrix_3: vec4<f32>,\n"
+    "    @location(7) color: vec3<f32>,\n"
+    "}\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, instance: InstanceInput) -> VertexOutput {\n"
+    "    let model_matrix = mat4x4<f32>(\n"
+    "        instance.model_matrix_0,\n"
+    "        instance.model_matrix_1,\n"
+    "        instance.model_matrix_2,\n"
+    "        instance.model_matrix_3,\n"
+    "    );\n"
+    "    \n"
+    "    let world_position = (model_matrix * vec4<f32>(vertex.position, 1.0)).xyz;\n"
+    "    let world_normal = normalize((model_matrix * vec4<f32>(vertex.normal, 0.0)).xyz);\n"
+    "    let color = vec4<f32>(instance.color, 1.0);\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl;\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, 1.0);\n"
+    "}\n",
+
+    /* COMPACT_INSTANCES */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "struct InstanceInput {\n"
+    "    @location(3) model_row_0: vec4<f32>,\n"
+    "    @location(4) model_row_1: vec4<f32>,\n"
+    "    @location(5) model_row_2: vec4<f32>,\n"
+    "    @location(6) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, instance: InstanceInput) -> VertexOutput {\n"
+    "    let model_matrix = transpose(mat3x4<f32>(\n"
+    "        instance.model_row_0,\n"
+    "        instance.model_row_1,\n"
+    "        instance.model_row_2,\n"
+    "    ));\n"
+    "    \n"
+    "    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);\n"
+    "    let world_normal = normalize(model_matrix * vec4<f32>(vertex.normal, 0.0));\n"
+    "    let color = instance.color;\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl;\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, 1.0);\n"
+    "}\n",
+
+    /* ALPHA */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "struct InstanceInput {\n"
+    "    @location(3) model_matrix_0: vec4<f32>,\n"
+    "    @location(4) model_matrix_1: vec4<f32>,\n"
+    "    @location(5) model_matrix_2: vec4<f32>,\n"
+    "    @location(6) model_matrix_3: vec4<f32>,\n"
+    "    @location(7) color: vec3<f32>,\n"
+    "}\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, instance: InstanceInput) -> VertexOutput {\n"
+    "    let model_matrix = mat4x4<f32>(\n"
+    "        instance.model_matrix_0,\n"
+    "        instance.model_matrix_1,\n"
+    "        instance.model_matrix_2,\n"
+    "        instance.model_matrix_3,\n"
+    "    );\n"
+    "    \n"
+    "    let world_position = (model_matrix * vec4<f32>(vertex.position, 1.0)).xyz;\n"
+    "    let world_normal = normalize((model_matrix * vec4<f32>(vertex.normal, 0.0)).xyz);\n"
+    "    let color = vec4<f32>(instance.color, 1.0);\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl;\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, in.color.a * material.base_color.a * texel.a);\n"
+    "}\n",
+
+    /* COMPACT_INSTANCES ALPHA */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "struct InstanceInput {\n"
+    "    @location(3) model_row_0: vec4<f32>,\n"
+    "    @location(4) model_row_1: vec4<f32>,\n"
+    "    @location(5) model_row_2: vec4<f32>,\n"
+    "    @location(6) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, instance: InstanceInput) -> VertexOutput {\n"
+    "    let model_matrix = transpose(mat3x4<f32>(\n"
+    "        instance.model_row_0,\n"
+    "        instance.model_row_1,\n"
+    "        instance.model_row_2,\n"
+    "    ));\n"
+    "    \n"
+    "    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);\n"
+    "    let world_normal = normalize(model_matrix * vec4<f32>(vertex.normal, 0.0));\n"
+    "    let color = instance.color;\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl;\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, in.color.a * material.base_color.a * texel.a);\n"
+    "}\n",
+
+    /* STORAGE_INSTANCES */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "override instance_format: u32 = 0u;\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@group(3) @binding(0)\n"
+    "var<storage, read> instance_words: array<u32>;\n"
+    "\n"
+    "fn instance_stride() -> u32 {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return 20u;\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return 14u;\n"
+    "    }\n"
+    "    return 8u;\n"
+    "}\n"
+    "\n"
+    "fn instance_rows(base: u32) -> mat3x4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        var columns: array<vec4<f32>, 4>;\n"
+    "        for (var c = 0u; c < 4u; c++) {\n"
+    "            columns[c] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + c * 4u],\n"
+    "                instance_words[base + c * 4u + 1u],\n"
+    "                instance_words[base + c * 4u + 2u],\n"
+    "                instance_words[base + c * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return transpose(mat4x3<f32>(columns[0].xyz, columns[1].xyz, columns[2].xyz, columns[3].xyz));\n"
+    "    }\n"
+    "    \n"
+    "    if (instance_format == 1u) {\n"
+    "        var rows: array<vec4<f32>, 3>;\n"
+    "        for (var r = 0u; r < 3u; r++) {\n"
+    "            rows[r] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + r * 4u],\n"
+    "                instance_words[base + r * 4u + 1u],\n"
+    "                instance_words[base + r * 4u + 2u],\n"
+    "                instance_words[base + r * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "    }\n"
+    "    \n"
+    "    var rows: array<vec4<f32>, 3>;\n"
+    "    for (var r = 0u; r < 3u; r++) {\n"
+    "        rows[r] = vec4<f32>(\n"
+    "            unpack2x16float(instance_words[base + r * 2u]),\n"
+    "            unpack2x16float(instance_words[base + r * 2u + 1u]),\n"
+    "        );\n"
+    "    }\n"
+    "    return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "}\n"
+    "\n"
+    "fn instance_color(base: u32) -> vec4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return vec4<f32>(bitcast<vec3<f32>>(vec3<u32>(\n"
+    "            instance_words[base + 16u],\n"
+    "            instance_words[base + 17u],\n"
+    "            instance_words[base + 18u],\n"
+    "        )), 1.0);\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return unpack4x8unorm(instance_words[base + 12u]);\n"
+    "    }\n"
+    "    return unpack4x8unorm(instance_words[base + 6u]);\n"
+    "}\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {\n"
+    "    let base = instance_index * instance_stride();\n"
+    "    let model_matrix = transpose(instance_rows(base));\n"
+    "    \n"
+    "    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);\n"
+    "    let world_normal = normalize(model_matrix * vec4<f32>(vertex.normal, 0.0));\n"
+    "    let color = instance_color(base);\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl;\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, 1.0);\n"
+    "}\n",
+
+    /* COMPACT_INSTANCES STORAGE_INSTANCES */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "override instance_format: u32 = 0u;\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@group(3) @binding(0)\n"
+    "var<storage, read> instance_words: array<u32>;\n"
+    "\n"
+    "fn instance_stride() -> u32 {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return 20u;\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return 14u;\n"
+    "    }\n"
+    "    return 8u;\n"
+    "}\n"
+    "\n"
+    "fn instance_rows(base: u32) -> mat3x4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        var columns: array<vec4<f32>, 4>;\n"
+    "        for (var c = 0u; c < 4u; c++) {\n"
+    "            columns[c] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + c * 4u],\n"
+    "                instance_words[base + c * 4u + 1u],\n"
+    "                instance_words[base + c * 4u + 2u],\n"
+    "                instance_words[base + c * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return transpose(mat4x3<f32>(columns[0].xyz, columns[1].xyz, columns[2].xyz, columns[3].xyz));\n"
+    "    }\n"
+    "    \n"
+    "    if (instance_format == 1u) {\n"
+    "        var rows: array<vec4<f32>, 3>;\n"
+    "        for (var r = 0u; r < 3u; r++) {\n"
+    "            rows[r] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + r * 4u],\n"
+    "                instance_words[base + r * 4u + 1u],\n"
+    "                instance_words[base + r * 4u + 2u],\n"
+    "                instance_words[base + r * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "    }\n"
+    "    \n"
+    "    var rows: array<vec4<f32>, 3>;\n"
+    "    for (var r = 0u; r < 3u; r++) {\n"
+    "        rows[r] = vec4<f32>(\n"
+    "            unpack2x16float(instance_words[base + r * 2u]),\n"
+    "            unpack2x16float(instance_words[base + r * 2u + 1u]),\n"
+    "        );\n"
+    "    }\n"
+    "    return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "}\n"
+    "\n"
+    "fn instance_color(base: u32) -> vec4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return vec4<f32>(bitcast<vec3<f32>>(vec3<u32>(\n"
+    "            instance_words[base + 16u],\n"
+    "            instance_words[base + 17u],\n"
+    "            instance_words[base + 18u],\n"
+    "        )), 1.0);\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return unpack4x8unorm(instance_words[base + 12u]);\n"
+    "    }\n"
+    "    return unpack4x8unorm(instance_words[base + 6u]);\n"
+    "}\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {\n"
+    "    let base = instance_index * instance_stride();\n"
+    "    let model_matrix = transpose(instance_rows(base));\n"
+    "    \n"
+    "    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);\n"
+    "    let world_normal = normalize(model_matrix * vec4<f32>(vertex.normal, 0.0));\n"
+    "    let color = instance_color(base);\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl;\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, 1.0);\n"
+    "}\n",
+
+    /* ALPHA STORAGE_INSTANCES */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "override instance_format: u32 = 0u;\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@group(3) @binding(0)\n"
+    "var<storage, read> instance_words: array<u32>;\n"
+    "\n"
+    "fn instance_stride() -> u32 {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return 20u;\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return 14u;\n"
+    "    }\n"
+    "    return 8u;\n"
+    "}\n"
+    "\n"
+    "fn instance_rows(base: u32) -> mat3x4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        var columns: array<vec4<f32>, 4>;\n"
+    "        for (var c = 0u; c < 4u; c++) {\n"
+    "            columns[c] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + c * 4u],\n"
+    "                instance_words[base + c * 4u + 1u],\n"
+    "                instance_words[base + c * 4u + 2u],\n"
+    "                instance_words[base + c * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return transpose(mat4x3<f32>(columns[0].xyz, columns[1].xyz, columns[2].xyz, columns[3].xyz));\n"
+    "    }\n"
+    "    \n"
+    "    if (instance_format == 1u) {\n"
+    "        var rows: array<vec4<f32>, 3>;\n"
+    "        for (var r = 0u; r < 3u; r++) {\n"
+    "            rows[r] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + r * 4u],\n"
+    "                instance_words[base + r * 4u + 1u],\n"
+    "                instance_words[base + r * 4u + 2u],\n"
+    "                instance_words[base + r * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "    }\n"
+    "    \n"
+    "    var rows: array<vec4<f32>, 3>;\n"
+    "    for (var r = 0u; r < 3u; r++) {\n"
+    "        rows[r] = vec4<f32>(\n"
+    "            unpack2x16float(instance_words[base + r * 2u]),\n"
+    "            unpack2x16float(instance_words[base + r * 2u + 1u]),\n"
+    "        );\n"
+    "    }\n"
+    "    return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "}\n"
+    "\n"
+    "fn instance_color(base: u32) -> vec4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return vec4<f32>(bitcast<vec3<f32>>(vec3<u32>(\n"
+    "            instance_words[base + 16u],\n"
+    "            instance_words[base + 17u],\n"
+    "            instance_words[base + 18u],\n"
+    "        )), 1.0);\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return unpack4x8unorm(instance_words[base + 12u]);\n"
+    "    }\n"
+    "    return unpack4x8unorm(instance_words[base + 6u]);\n"
+    "}\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {\n"
+    "    let base = instance_index * instance_stride();\n"
+    "    let model_matrix = transpose(instance_rows(base));\n"
+    "    \n"
+    "    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);\n"
+    "    let world_normal = normalize(model_matrix * vec4<f32>(vertex.normal, 0.0));\n"
+    "    let color = instance_color(base);\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl;\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, in.color.a * material.base_color.a * texel.a);\n"
+    "}\n",
+
+    /* COMPACT_INSTANCES ALPHA STORAGE_INSTANCES */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "override instance_format: u32 = 0u;\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@group(3) @binding(0)\n"
+    "var<storage, read> instance_words: array<u32>;\n"
+    "\n"
+    "fn instance_stride() -> u32 {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return 20u;\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return 14u;\n"
+    "    }\n"
+    "    return 8u;\n"
+    "}\n"
+    "\n"
+    "fn instance_rows(base: u32) -> mat3x4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        var columns: array<vec4<f32>, 4>;\n"
+    "        for (var c = 0u; c < 4u; c++) {\n"
+    "            columns[c] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + c * 4u],\n"
+    "                instance_words[base + c * 4u + 1u],\n"
+    "                instance_words[base + c * 4u + 2u],\n"
+    "                instance_words[base + c * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return transpose(mat4x3<f32>(columns[0].xyz, columns[1].xyz, columns[2].xyz, columns[3].xyz));\n"
+    "    }\n"
+    "    \n"
+    "    if (instance_format == 1u) {\n"
+    "        var rows: array<vec4<f32>, 3>;\n"
+    "        for (var r = 0u; r < 3u; r++) {\n"
+    "            rows[r] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + r * 4u],\n"
+    "                instance_words[base + r * 4u + 1u],\n"
+    "                instance_words[base + r * 4u + 2u],\n"
+    "                instance_words[base + r * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "    }\n"
+    "    \n"
+    "    var rows: array<vec4<f32>, 3>;\n"
+    "    for (var r = 0u; r < 3u; r++) {\n"
+    "        rows[r] = vec4<f32>(\n"
+    "            unpack2x16float(instance_words[base + r * 2u]),\n"
+    "            unpack2x16float(instance_words[base + r * 2u + 1u]),\n"
+    "        );\n"
+    "    }\n"
+    "    return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "}\n"
+    "\n"
+    "fn instance_color(base: u32) -> vec4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return vec4<f32>(bitcast<vec3<f32>>(vec3<u32>(\n"
+    "            instance_words[base + 16u],\n"
+    "            instance_words[base + 17u],\n"
+    "            instance_words[base + 18u],\n"
+    "        )), 1.0);\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return unpack4x8unorm(instance_words[base + 12u]);\n"
+    "    }\n"
+    "    return unpack4x8unorm(instance_words[base + 6u]);\n"
+    "}\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {\n"
+    "    let base = instance_index * instance_stride();\n"
+    "    let model_matrix = transpose(instance_rows(base));\n"
+    "    \n"
+    "    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);\n"
+    "    let world_normal = normalize(model_matrix * vec4<f32>(vertex.normal, 0.0));\n"
+    "    let color = instance_color(base);\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl;\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, in.color.a * material.base_color.a * texel.a);\n"
+    "}\n",
+
+    /* SHADOWS */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "struct InstanceInput {\n"
+    "    @location(3) model_matrix_0: vec4<f32>,\n"
+    "    @location(4) model_matrix_1: vec4<f32>,\n"
+    "    @location(5) model_matrix_2: vec4<f32>,\n"
+    "    @location(6) model_matrix_3: vec4<f32>,\n"
+    "    @location(7) color: vec3<f32>,\n"
+    "}\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "struct Shadows {\n"
+    "    view_projection: array<mat4x4<f32>, 4>,\n"
+    "    tiles: array<vec4<f32>, 4>,      // Atlas uv scale (xy) and offset (zw) of each cascade\n"
+    "    splits: vec4<f32>,               // Far view depth of each cascade\n"
+    "    view_plane: vec4<f32>,           // View depth of a world position\n"
+    "    cascades: u32,                   // 0 while there is no camera to fit them to\n"
+    "    bias: f32,\n"
+    "    texel_size: vec2<f32>,           // Atlas texel in uv\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(1)\n"
+    "var<uniform> shadows: Shadows;\n"
+    "\n"
+    "@group(1) @binding(2)\n"
+    "var shadow_atlas: texture_depth_2d;\n"
+    "\n"
+    "@group(1) @binding(3)\n"
+    "var shadow_sampler: sampler_comparison;\n"
+    "\n"
+    "fn shadow_factor(world_position: vec3<f32>) -> f32 {\n"
+    "    let depth = dot(shadows.view_plane.xyz, world_position) + shadows.view_plane.w;\n"
+    "    var cascade = 0u;\n"
+    "    while (cascade < shadows.cascades && depth > shadows.splits[cascade]) {\n"
+    "        cascade++;\n"
+    "    }\n"
+    "    if (cascade >= shadows.cascades) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let clip = shadows.view_projection[cascade] * vec4<f32>(world_position, 1.0);\n"
+    "    let uv = clip.xy * vec2<f32>(0.5, -0.5) + vec2<f32>(0.5);\n"
+    "    if (any(uv < vec2<f32>(0.0)) || any(uv > vec2<f32>(1.0)) || clip.z > 1.0) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let tile = shadows.tiles[cascade];\n"
+    "    let margin = shadows.texel_size * 1.5;\n"
+    "    let center = clamp(tile.zw + uv * tile.xy, tile.zw + margin, tile.zw + tile.xy - margin);\n"
+    "    let reference = clip.z - shadows.bias;\n"
+    "    var lit = 0.0;\n"
+    "    for (var y = -1; y <= 1; y++) {\n"
+    "        for (var x = -1; x <= 1; x++) {\n"
+    "            let offset = vec2<f32>(f32(x), f32(y)) * shadows.texel_size;\n"
+    "            lit += textureSampleCompareLevel(shadow_atlas, shadow_sampler, center + offset, reference);\n"
+    "        }\n"
+    "    }\n"
+    "    return lit / 9.0;\n"
+    "}\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, instance: InstanceInput) -> VertexOutput {\n"
+    "    let model_matrix = mat4x4<f32>(\n"
+    "        instance.model_matrix_0,\n"
+    "        instance.model_matrix_1,\n"
+    "        instance.model_matrix_2,\n"
+    "        instance.model_matrix_3,\n"
+    "    );\n"
+    "    \n"
+    "    let world_position = (model_matrix * vec4<f32>(vertex.position, 1.0)).xyz;\n"
+    "    let world_normal = normalize((model_matrix * vec4<f32>(vertex.normal, 0.0)).xyz);\n"
+    "    let color = vec4<f32>(instance.color, 1.0);\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl * shadow_factor(in.world_position);\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, 1.0);\n"
+    "}\n",
+
+    /* COMPACT_INSTANCES SHADOWS */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "struct InstanceInput {\n"
+    "    @location(3) model_row_0: vec4<f32>,\n"
+    "    @location(4) model_row_1: vec4<f32>,\n"
+    "    @location(5) model_row_2: vec4<f32>,\n"
+    "    @location(6) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "struct Shadows {\n"
+    "    view_projection: array<mat4x4<f32>, 4>,\n"
+    "    tiles: array<vec4<f32>, 4>,      // Atlas uv scale (xy) and offset (zw) of each cascade\n"
+    "    splits: vec4<f32>,               // Far view depth of each cascade\n"
+    "    view_plane: vec4<f32>,           // View depth of a world position\n"
+    "    cascades: u32,                   // 0 while there is no camera to fit them to\n"
+    "    bias: f32,\n"
+    "    texel_size: vec2<f32>,           // Atlas texel in uv\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(1)\n"
+    "var<uniform> shadows: Shadows;\n"
+    "\n"
+    "@group(1) @binding(2)\n"
+    "var shadow_atlas: texture_depth_2d;\n"
+    "\n"
+    "@group(1) @binding(3)\n"
+    "var shadow_sampler: sampler_comparison;\n"
+    "\n"
+    "fn shadow_factor(world_position: vec3<f32>) -> f32 {\n"
+    "    let depth = dot(shadows.view_plane.xyz, world_position) + shadows.view_plane.w;\n"
+    "    var cascade = 0u;\n"
+    "    while (cascade < shadows.cascades && depth > shadows.splits[cascade]) {\n"
+    "        cascade++;\n"
+    "    }\n"
+    "    if (cascade >= shadows.cascades) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let clip = shadows.view_projection[cascade] * vec4<f32>(world_position, 1.0);\n"
+    "    let uv = clip.xy * vec2<f32>(0.5, -0.5) + vec2<f32>(0.5);\n"
+    "    if (any(uv < vec2<f32>(0.0)) || any(uv > vec2<f32>(1.0)) || clip.z > 1.0) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let tile = shadows.tiles[cascade];\n"
+    "    let margin = shadows.texel_size * 1.5;\n"
+    "    let center = clamp(tile.zw + uv * tile.xy, tile.zw + margin, tile.zw + tile.xy - margin);\n"
+    "    let reference = clip.z - shadows.bias;\n"
+    "    var lit = 0.0;\n"
+    "    for (var y = -1; y <= 1; y++) {\n"
+    "        for (var x = -1; x <= 1; x++) {\n"
+    "            let offset = vec2<f32>(f32(x), f32(y)) * shadows.texel_size;\n"
+    "            lit += textureSampleCompareLevel(shadow_atlas, shadow_sampler, center + offset, reference);\n"
+    "        }\n"
+    "    }\n"
+    "    return lit / 9.0;\n"
+    "}\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, instance: InstanceInput) -> VertexOutput {\n"
+    "    let model_matrix = transpose(mat3x4<f32>(\n"
+    "        instance.model_row_0,\n"
+    "        instance.model_row_1,\n"
+    "        instance.model_row_2,\n"
+    "    ));\n"
+    "    \n"
+    "    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);\n"
+    "    let world_normal = normalize(model_matrix * vec4<f32>(vertex.normal, 0.0));\n"
+    "    let color = instance.color;\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl * shadow_factor(in.world_position);\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, 1.0);\n"
+    "}\n",
+
+    /* ALPHA SHADOWS */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "struct InstanceInput {\n"
+    "    @location(3) model_matrix_0: vec4<f32>,\n"
+    "    @location(4) model_matrix_1: vec4<f32>,\n"
+    "    @location(5) model_matrix_2: vec4<f32>,\n"
+    "    @location(6) model_matrix_3: vec4<f32>,\n"
+    "    @location(7) color: vec3<f32>,\n"
+    "}\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "struct Shadows {\n"
+    "    view_projection: array<mat4x4<f32>, 4>,\n"
+    "    tiles: array<vec4<f32>, 4>,      // Atlas uv scale (xy) and offset (zw) of each cascade\n"
+    "    splits: vec4<f32>,               // Far view depth of each cascade\n"
+    "    view_plane: vec4<f32>,           // View depth of a world position\n"
+    "    cascades: u32,                   // 0 while there is no camera to fit them to\n"
+    "    bias: f32,\n"
+    "    texel_size: vec2<f32>,           // Atlas texel in uv\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(1)\n"
+    "var<uniform> shadows: Shadows;\n"
+    "\n"
+    "@group(1) @binding(2)\n"
+    "var shadow_atlas: texture_depth_2d;\n"
+    "\n"
+    "@group(1) @binding(3)\n"
+    "var shadow_sampler: sampler_comparison;\n"
+    "\n"
+    "fn shadow_factor(world_position: vec3<f32>) -> f32 {\n"
+    "    let depth = dot(shadows.view_plane.xyz, world_position) + shadows.view_plane.w;\n"
+    "    var cascade = 0u;\n"
+    "    while (cascade < shadows.cascades && depth > shadows.splits[cascade]) {\n"
+    "        cascade++;\n"
+    "    }\n"
+    "    if (cascade >= shadows.cascades) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let clip = shadows.view_projection[cascade] * vec4<f32>(world_position, 1.0);\n"
+    "    let uv = clip.xy * vec2<f32>(0.5, -0.5) + vec2<f32>(0.5);\n"
+    "    if (any(uv < vec2<f32>(0.0)) || any(uv > vec2<f32>(1.0)) || clip.z > 1.0) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let tile = shadows.tiles[cascade];\n"
+    "    let margin = shadows.texel_size * 1.5;\n"
+    "    let center = clamp(tile.zw + uv * tile.xy, tile.zw + margin, tile.zw + tile.xy - margin);\n"
+    "    let reference = clip.z - shadows.bias;\n"
+    "    var lit = 0.0;\n"
+    "    for (var y = -1; y <= 1; y++) {\n"
+    "        for (var x = -1; x <= 1; x++) {\n"
+    "            let offset = vec2<f32>(f32(x), f32(y)) * shadows.texel_size;\n"
+    "            lit += textureSampleCompareLevel(shadow_atlas, shadow_sampler, center + offset, reference);\n"
+    "        }\n"
+    "    }\n"
+    "    return lit / 9.0;\n"
+    "}\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, instance: InstanceInput) -> VertexOutput {\n"
+    "    let model_matrix = mat4x4<f32>(\n"
+    "        instance.model_matrix_0,\n"
+    "        instance.model_matrix_1,\n"
+    "        instance.model_matrix_2,\n"
+    "        instance.model_matrix_3,\n"
+    "    );\n"
+    "    \n"
+    "    let world_position = (model_matrix * vec4<f32>(vertex.position, 1.0)).xyz;\n"
+    "    let world_normal = normalize((model_matrix * vec4<f32>(vertex.normal, 0.0)).xyz);\n"
+    "    let color = vec4<f32>(instance.color, 1.0);\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl * shadow_factor(in.world_position);\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, in.color.a * material.base_color.a * texel.a);\n"
+    "}\n",
+
+    /* COMPACT_INSTANCES ALPHA SHADOWS */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "struct InstanceInput {\n"
+    "    @location(3) model_row_0: vec4<f32>,\n"
+    "    @location(4) model_row_1: vec4<f32>,\n"
+    "    @location(5) model_row_2: vec4<f32>,\n"
+    "    @location(6) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "struct Shadows {\n"
+    "    view_projection: array<mat4x4<f32>, 4>,\n"
+    "    tiles: array<vec4<f32>, 4>,      // Atlas uv scale (xy) and offset (zw) of each cascade\n"
+    "    splits: vec4<f32>,               // Far view depth of each cascade\n"
+    "    view_plane: vec4<f32>,           // View depth of a world position\n"
+    "    cascades: u32,                   // 0 while there is no camera to fit them to\n"
+    "    bias: f32,\n"
+    "    texel_size: vec2<f32>,           // Atlas texel in uv\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(1)\n"
+    "var<uniform> shadows: Shadows;\n"
+    "\n"
+    "@group(1) @binding(2)\n"
+    "var shadow_atlas: texture_depth_2d;\n"
+    "\n"
+    "@group(1) @binding(3)\n"
+    "var shadow_sampler: sampler_comparison;\n"
+    "\n"
+    "fn shadow_factor(world_position: vec3<f32>) -> f32 {\n"
+    "    let depth = dot(shadows.view_plane.xyz, world_position) + shadows.view_plane.w;\n"
+    "    var cascade = 0u;\n"
+    "    while (cascade < shadows.cascades && depth > shadows.splits[cascade]) {\n"
+    "        cascade++;\n"
+    "    }\n"
+    "    if (cascade >= shadows.cascades) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let clip = shadows.view_projection[cascade] * vec4<f32>(world_position, 1.0);\n"
+    "    let uv = clip.xy * vec2<f32>(0.5, -0.5) + vec2<f32>(0.5);\n"
+    "    if (any(uv < vec2<f32>(0.0)) || any(uv > vec2<f32>(1.0)) || clip.z > 1.0) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let tile = shadows.tiles[cascade];\n"
+    "    let margin = shadows.texel_size * 1.5;\n"
+    "    let center = clamp(tile.zw + uv * tile.xy, tile.zw + margin, tile.zw + tile.xy - margin);\n"
+    "    let reference = clip.z - shadows.bias;\n"
+    "    var lit = 0.0;\n"
+    "    for (var y = -1; y <= 1; y++) {\n"
+    "        for (var x = -1; x <= 1; x++) {\n"
+    "            let offset = vec2<f32>(f32(x), f32(y)) * shadows.texel_size;\n"
+    "            lit += textureSampleCompareLevel(shadow_atlas, shadow_sampler, center + offset, reference);\n"
+    "        }\n"
+    "    }\n"
+    "    return lit / 9.0;\n"
+    "}\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, instance: InstanceInput) -> VertexOutput {\n"
+    "    let model_matrix = transpose(mat3x4<f32>(\n"
+    "        instance.model_row_0,\n"
+    "        instance.model_row_1,\n"
+    "        instance.model_row_2,\n"
+    "    ));\n"
+    "    \n"
+    "    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);\n"
+    "    let world_normal = normalize(model_matrix * vec4<f32>(vertex.normal, 0.0));\n"
+    "    let color = instance.color;\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl * shadow_factor(in.world_position);\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, in.color.a * material.base_color.a * texel.a);\n"
+    "}\n",
+
+    /* STORAGE_INSTANCES SHADOWS */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "override instance_format: u32 = 0u;\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "struct Shadows {\n"
+    "    view_projection: array<mat4x4<f32>, 4>,\n"
+    "    tiles: array<vec4<f32>, 4>,      // Atlas uv scale (xy) and offset (zw) of each cascade\n"
+    "    splits: vec4<f32>,               // Far view depth of each cascade\n"
+    "    view_plane: vec4<f32>,           // View depth of a world position\n"
+    "    cascades: u32,                   // 0 while there is no camera to fit them to\n"
+    "    bias: f32,\n"
+    "    texel_size: vec2<f32>,           // Atlas texel in uv\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(1)\n"
+    "var<uniform> shadows: Shadows;\n"
+    "\n"
+    "@group(1) @binding(2)\n"
+    "var shadow_atlas: texture_depth_2d;\n"
+    "\n"
+    "@group(1) @binding(3)\n"
+    "var shadow_sampler: sampler_comparison;\n"
+    "\n"
+    "fn shadow_factor(world_position: vec3<f32>) -> f32 {\n"
+    "    let depth = dot(shadows.view_plane.xyz, world_position) + shadows.view_plane.w;\n"
+    "    var cascade = 0u;\n"
+    "    while (cascade < shadows.cascades && depth > shadows.splits[cascade]) {\n"
+    "        cascade++;\n"
+    "    }\n"
+    "    if (cascade >= shadows.cascades) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let clip = shadows.view_projection[cascade] * vec4<f32>(world_position, 1.0);\n"
+    "    let uv = clip.xy * vec2<f32>(0.5, -0.5) + vec2<f32>(0.5);\n"
+    "    if (any(uv < vec2<f32>(0.0)) || any(uv > vec2<f32>(1.0)) || clip.z > 1.0) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let tile = shadows.tiles[cascade];\n"
+    "    let margin = shadows.texel_size * 1.5;\n"
+    "    let center = clamp(tile.zw + uv * tile.xy, tile.zw + margin, tile.zw + tile.xy - margin);\n"
+    "    let reference = clip.z - shadows.bias;\n"
+    "    var lit = 0.0;\n"
+    "    for (var y = -1; y <= 1; y++) {\n"
+    "        for (var x = -1; x <= 1; x++) {\n"
+    "            let offset = vec2<f32>(f32(x), f32(y)) * shadows.texel_size;\n"
+    "            lit += textureSampleCompareLevel(shadow_atlas, shadow_sampler, center + offset, reference);\n"
+    "        }\n"
+    "    }\n"
+    "    return lit / 9.0;\n"
+    "}\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@group(3) @binding(0)\n"
+    "var<storage, read> instance_words: array<u32>;\n"
+    "\n"
+    "fn instance_stride() -> u32 {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return 20u;\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return 14u;\n"
+    "    }\n"
+    "    return 8u;\n"
+    "}\n"
+    "\n"
+    "fn instance_rows(base: u32) -> mat3x4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        var columns: array<vec4<f32>, 4>;\n"
+    "        for (var c = 0u; c < 4u; c++) {\n"
+    "            columns[c] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + c * 4u],\n"
+    "                instance_words[base + c * 4u + 1u],\n"
+    "                instance_words[base + c * 4u + 2u],\n"
+    "                instance_words[base + c * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return transpose(mat4x3<f32>(columns[0].xyz, columns[1].xyz, columns[2].xyz, columns[3].xyz));\n"
+    "    }\n"
+    "    \n"
+    "    if (instance_format == 1u) {\n"
+    "        var rows: array<vec4<f32>, 3>;\n"
+    "        for (var r = 0u; r < 3u; r++) {\n"
+    "            rows[r] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + r * 4u],\n"
+    "                instance_words[base + r * 4u + 1u],\n"
+    "                instance_words[base + r * 4u + 2u],\n"
+    "                instance_words[base + r * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "    }\n"
+    "    \n"
+    "    var rows: array<vec4<f32>, 3>;\n"
+    "    for (var r = 0u; r < 3u; r++) {\n"
+    "        rows[r] = vec4<f32>(\n"
+    "            unpack2x16float(instance_words[base + r * 2u]),\n"
+    "            unpack2x16float(instance_words[base + r * 2u + 1u]),\n"
+    "        );\n"
+    "    }\n"
+    "    return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "}\n"
+    "\n"
+    "fn instance_color(base: u32) -> vec4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return vec4<f32>(bitcast<vec3<f32>>(vec3<u32>(\n"
+    "            instance_words[base + 16u],\n"
+    "            instance_words[base + 17u],\n"
+    "            instance_words[base + 18u],\n"
+    "        )), 1.0);\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return unpack4x8unorm(instance_words[base + 12u]);\n"
+    "    }\n"
+    "    return unpack4x8unorm(instance_words[base + 6u]);\n"
+    "}\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {\n"
+    "    let base = instance_index * instance_stride();\n"
+    "    let model_matrix = transpose(instance_rows(base));\n"
+    "    \n"
+    "    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);\n"
+    "    let world_normal = normalize(model_matrix * vec4<f32>(vertex.normal, 0.0));\n"
+    "    let color = instance_color(base);\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl * shadow_factor(in.world_position);\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, 1.0);\n"
+    "}\n",
+
+    /* COMPACT_INSTANCES STORAGE_INSTANCES SHADOWS */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "override instance_format: u32 = 0u;\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "struct Shadows {\n"
+    "    view_projection: array<mat4x4<f32>, 4>,\n"
+    "    tiles: array<vec4<f32>, 4>,      // Atlas uv scale (xy) and offset (zw) of each cascade\n"
+    "    splits: vec4<f32>,               // Far view depth of each cascade\n"
+    "    view_plane: vec4<f32>,           // View depth of a world position\n"
+    "    cascades: u32,                   // 0 while there is no camera to fit them to\n"
+    "    bias: f32,\n"
+    "    texel_size: vec2<f32>,           // Atlas texel in uv\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(1)\n"
+    "var<uniform> shadows: Shadows;\n"
+    "\n"
+    "@group(1) @binding(2)\n"
+    "var shadow_atlas: texture_depth_2d;\n"
+    "\n"
+    "@group(1) @binding(3)\n"
+    "var shadow_sampler: sampler_comparison;\n"
+    "\n"
+    "fn shadow_factor(world_position: vec3<f32>) -> f32 {\n"
+    "    let depth = dot(shadows.view_plane.xyz, world_position) + shadows.view_plane.w;\n"
+    "    var cascade = 0u;\n"
+    "    while (cascade < shadows.cascades && depth > shadows.splits[cascade]) {\n"
+    "        cascade++;\n"
+    "    }\n"
+    "    if (cascade >= shadows.cascades) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let clip = shadows.view_projection[cascade] * vec4<f32>(world_position, 1.0);\n"
+    "    let uv = clip.xy * vec2<f32>(0.5, -0.5) + vec2<f32>(0.5);\n"
+    "    if (any(uv < vec2<f32>(0.0)) || any(uv > vec2<f32>(1.0)) || clip.z > 1.0) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let tile = shadows.tiles[cascade];\n"
+    "    let margin = shadows.texel_size * 1.5;\n"
+    "    let center = clamp(tile.zw + uv * tile.xy, tile.zw + margin, tile.zw + tile.xy - margin);\n"
+    "    let reference = clip.z - shadows.bias;\n"
+    "    var lit = 0.0;\n"
+    "    for (var y = -1; y <= 1; y++) {\n"
+    "        for (var x = -1; x <= 1; x++) {\n"
+    "            let offset = vec2<f32>(f32(x), f32(y)) * shadows.texel_size;\n"
+    "            lit += textureSampleCompareLevel(shadow_atlas, shadow_sampler, center + offset, reference);\n"
+    "        }\n"
+    "    }\n"
+    "    return lit / 9.0;\n"
+    "}\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@group(3) @binding(0)\n"
+    "var<storage, read> instance_words: array<u32>;\n"
+    "\n"
+    "fn instance_stride() -> u32 {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return 20u;\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return 14u;\n"
+    "    }\n"
+    "    return 8u;\n"
+    "}\n"
+    "\n"
+    "fn instance_rows(base: u32) -> mat3x4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        var columns: array<vec4<f32>, 4>;\n"
+    "        for (var c = 0u; c < 4u; c++) {\n"
+    "            columns[c] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + c * 4u],\n"
+    "                instance_words[base + c * 4u + 1u],\n"
+    "                instance_words[base + c * 4u + 2u],\n"
+    "                instance_words[base + c * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return transpose(mat4x3<f32>(columns[0].xyz, columns[1].xyz, columns[2].xyz, columns[3].xyz));\n"
+    "    }\n"
+    "    \n"
+    "    if (instance_format == 1u) {\n"
+    "        var rows: array<vec4<f32>, 3>;\n"
+    "        for (var r = 0u; r < 3u; r++) {\n"
+    "            rows[r] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + r * 4u],\n"
+    "                instance_words[base + r * 4u + 1u],\n"
+    "                instance_words[base + r * 4u + 2u],\n"
+    "                instance_words[base + r * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "    }\n"
+    "    \n"
+    "    var rows: array<vec4<f32>, 3>;\n"
+    "    for (var r = 0u; r < 3u; r++) {\n"
+    "        rows[r] = vec4<f32>(\n"
+    "            unpack2x16float(instance_words[base + r * 2u]),\n"
+    "            unpack2x16float(instance_words[base + r * 2u + 1u]),\n"
+    "        );\n"
+    "    }\n"
+    "    return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "}\n"
+    "\n"
+    "fn instance_color(base: u32) -> vec4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return vec4<f32>(bitcast<vec3<f32>>(vec3<u32>(\n"
+    "            instance_words[base + 16u],\n"
+    "            instance_words[base + 17u],\n"
+    "            instance_words[base + 18u],\n"
+    "        )), 1.0);\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return unpack4x8unorm(instance_words[base + 12u]);\n"
+    "    }\n"
+    "    return unpack4x8unorm(instance_words[base + 6u]);\n"
+    "}\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {\n"
+    "    let base = instance_index * instance_stride();\n"
+    "    let model_matrix = transpose(instance_rows(base));\n"
+    "    \n"
+    "    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);\n"
+    "    let world_normal = normalize(model_matrix * vec4<f32>(vertex.normal, 0.0));\n"
+    "    let color = instance_color(base);\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl * shadow_factor(in.world_position);\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, 1.0);\n"
+    "}\n",
+
+    /* ALPHA STORAGE_INSTANCES SHADOWS */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "override instance_format: u32 = 0u;\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "struct Shadows {\n"
+    "    view_projection: array<mat4x4<f32>, 4>,\n"
+    "    tiles: array<vec4<f32>, 4>,      // Atlas uv scale (xy) and offset (zw) of each cascade\n"
+    "    splits: vec4<f32>,               // Far view depth of each cascade\n"
+    "    view_plane: vec4<f32>,           // View depth of a world position\n"
+    "    cascades: u32,                   // 0 while there is no camera to fit them to\n"
+    "    bias: f32,\n"
+    "    texel_size: vec2<f32>,           // Atlas texel in uv\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(1)\n"
+    "var<uniform> shadows: Shadows;\n"
+    "\n"
+    "@group(1) @binding(2)\n"
+    "var shadow_atlas: texture_depth_2d;\n"
+    "\n"
+    "@group(1) @binding(3)\n"
+    "var shadow_sampler: sampler_comparison;\n"
+    "\n"
+    "fn shadow_factor(world_position: vec3<f32>) -> f32 {\n"
+    "    let depth = dot(shadows.view_plane.xyz, world_position) + shadows.view_plane.w;\n"
+    "    var cascade = 0u;\n"
+    "    while (cascade < shadows.cascades && depth > shadows.splits[cascade]) {\n"
+    "        cascade++;\n"
+    "    }\n"
+    "    if (cascade >= shadows.cascades) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let clip = shadows.view_projection[cascade] * vec4<f32>(world_position, 1.0);\n"
+    "    let uv = clip.xy * vec2<f32>(0.5, -0.5) + vec2<f32>(0.5);\n"
+    "    if (any(uv < vec2<f32>(0.0)) || any(uv > vec2<f32>(1.0)) || clip.z > 1.0) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let tile = shadows.tiles[cascade];\n"
+    "    let margin = shadows.texel_size * 1.5;\n"
+    "    let center = clamp(tile.zw + uv * tile.xy, tile.zw + margin, tile.zw + tile.xy - margin);\n"
+    "    let reference = clip.z - shadows.bias;\n"
+    "    var lit = 0.0;\n"
+    "    for (var y = -1; y <= 1; y++) {\n"
+    "        for (var x = -1; x <= 1; x++) {\n"
+    "            let offset = vec2<f32>(f32(x), f32(y)) * shadows.texel_size;\n"
+    "            lit += textureSampleCompareLevel(shadow_atlas, shadow_sampler, center + offset, reference);\n"
+    "        }\n"
+    "    }\n"
+    "    return lit / 9.0;\n"
+    "}\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@group(3) @binding(0)\n"
+    "var<storage, read> instance_words: array<u32>;\n"
+    "\n"
+    "fn instance_stride() -> u32 {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return 20u;\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return 14u;\n"
+    "    }\n"
+    "    return 8u;\n"
+    "}\n"
+    "\n"
+    "fn instance_rows(base: u32) -> mat3x4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        var columns: array<vec4<f32>, 4>;\n"
+    "        for (var c = 0u; c < 4u; c++) {\n"
+    "            columns[c] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + c * 4u],\n"
+    "                instance_words[base + c * 4u + 1u],\n"
+    "                instance_words[base + c * 4u + 2u],\n"
+    "                instance_words[base + c * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return transpose(mat4x3<f32>(columns[0].xyz, columns[1].xyz, columns[2].xyz, columns[3].xyz));\n"
+    "    }\n"
+    "    \n"
+    "    if (instance_format == 1u) {\n"
+    "        var rows: array<vec4<f32>, 3>;\n"
+    "        for (var r = 0u; r < 3u; r++) {\n"
+    "            rows[r] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + r * 4u],\n"
+    "                instance_words[base + r * 4u + 1u],\n"
+    "                instance_words[base + r * 4u + 2u],\n"
+    "                instance_words[base + r * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "    }\n"
+    "    \n"
+    "    var rows: array<vec4<f32>, 3>;\n"
+    "    for (var r = 0u; r < 3u; r++) {\n"
+    "        rows[r] = vec4<f32>(\n"
+    "            unpack2x16float(instance_words[base + r * 2u]),\n"
+    "            unpack2x16float(instance_words[base + r * 2u + 1u]),\n"
+    "        );\n"
+    "    }\n"
+    "    return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "}\n"
+    "\n"
+    "fn instance_color(base: u32) -> vec4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return vec4<f32>(bitcast<vec3<f32>>(vec3<u32>(\n"
+    "            instance_words[base + 16u],\n"
+    "            instance_words[base + 17u],\n"
+    "            instance_words[base + 18u],\n"
+    "        )), 1.0);\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return unpack4x8unorm(instance_words[base + 12u]);\n"
+    "    }\n"
+    "    return unpack4x8unorm(instance_words[base + 6u]);\n"
+    "}\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {\n"
+    "    let base = instance_index * instance_stride();\n"
+    "    let model_matrix = transpose(instance_rows(base));\n"
+    "    \n"
+    "    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);\n"
+    "    let world_normal = normalize(model_matrix * vec4<f32>(vertex.normal, 0.0));\n"
+    "    let color = instance_color(base);\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl * shadow_factor(in.world_position);\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, in.color.a * material.base_color.a * texel.a);\n"
+    "}\n",
+
+    /* COMPACT_INSTANCES ALPHA STORAGE_INSTANCES SHADOWS */
+    "\n"
+    "struct VertexInput {\n"
+    "    @location(0) position: vec3<f32>,\n"
+    "    @location(1) normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "override instance_format: u32 = 0u;\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) clip_position: vec4<f32>,\n"
+    "    @location(0) world_position: vec3<f32>,\n"
+    "    @location(1) world_normal: vec3<f32>,\n"
+    "    @location(2) uv: vec2<f32>,\n"
+    "    @location(3) color: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Camera {\n"
+    "    view: mat4x4<f32>,\n"
+    "    projection: mat4x4<f32>,\n"
+    "    view_projection: mat4x4<f32>,\n"
+    "}\n"
+    "\n"
+    "struct Light {\n"
+    "    direction_x: f32,\n"
+    "    direction_y: f32,\n"
+    "    direction_z: f32,\n"
+    "    intensity: f32,\n"
+    "    color_x: f32,\n"
+    "    color_y: f32,\n"
+    "    color_z: f32,\n"
+    "    ambient_strength: f32,\n"
+    "    ambient_xy: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0)\n"
+    "var<uniform> camera: Camera;\n"
+    "\n"
+    "struct Material {\n"
+    "    base_color: vec4<f32>,\n"
+    "    metallic: f32,\n"
+    "    roughness: f32,\n"
+    "    emissive: f32,\n"
+    "    diffuse_layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(0)\n"
+    "var<uniform> light: Light;\n"
+    "\n"
+    "struct Shadows {\n"
+    "    view_projection: array<mat4x4<f32>, 4>,\n"
+    "    tiles: array<vec4<f32>, 4>,      // Atlas uv scale (xy) and offset (zw) of each cascade\n"
+    "    splits: vec4<f32>,               // Far view depth of each cascade\n"
+    "    view_plane: vec4<f32>,           // View depth of a world position\n"
+    "    cascades: u32,                   // 0 while there is no camera to fit them to\n"
+    "    bias: f32,\n"
+    "    texel_size: vec2<f32>,           // Atlas texel in uv\n"
+    "}\n"
+    "\n"
+    "@group(1) @binding(1)\n"
+    "var<uniform> shadows: Shadows;\n"
+    "\n"
+    "@group(1) @binding(2)\n"
+    "var shadow_atlas: texture_depth_2d;\n"
+    "\n"
+    "@group(1) @binding(3)\n"
+    "var shadow_sampler: sampler_comparison;\n"
+    "\n"
+    "fn shadow_factor(world_position: vec3<f32>) -> f32 {\n"
+    "    let depth = dot(shadows.view_plane.xyz, world_position) + shadows.view_plane.w;\n"
+    "    var cascade = 0u;\n"
+    "    while (cascade < shadows.cascades && depth > shadows.splits[cascade]) {\n"
+    "        cascade++;\n"
+    "    }\n"
+    "    if (cascade >= shadows.cascades) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let clip = shadows.view_projection[cascade] * vec4<f32>(world_position, 1.0);\n"
+    "    let uv = clip.xy * vec2<f32>(0.5, -0.5) + vec2<f32>(0.5);\n"
+    "    if (any(uv < vec2<f32>(0.0)) || any(uv > vec2<f32>(1.0)) || clip.z > 1.0) {\n"
+    "        return 1.0;\n"
+    "    }\n"
+    "    \n"
+    "    let tile = shadows.tiles[cascade];\n"
+    "    let margin = shadows.texel_size * 1.5;\n"
+    "    let center = clamp(tile.zw + uv * tile.xy, tile.zw + margin, tile.zw + tile.xy - margin);\n"
+    "    let reference = clip.z - shadows.bias;\n"
+    "    var lit = 0.0;\n"
+    "    for (var y = -1; y <= 1; y++) {\n"
+    "        for (var x = -1; x <= 1; x++) {\n"
+    "            let offset = vec2<f32>(f32(x), f32(y)) * shadows.texel_size;\n"
+    "            lit += textureSampleCompareLevel(shadow_atlas, shadow_sampler, center + offset, reference);\n"
+    "        }\n"
+    "    }\n"
+    "    return lit / 9.0;\n"
+    "}\n"
+    "\n"
+    "@group(2) @binding(0)\n"
+    "var<uniform> material: Material;\n"
+    "\n"
+    "@group(2) @binding(1)\n"
+    "var diffuse_maps: texture_2d_array<f32>;\n"
+    "\n"
+    "@group(2) @binding(2)\n"
+    "var diffuse_sampler: sampler;\n"
+    "\n"
+    "@group(3) @binding(0)\n"
+    "var<storage, read> instance_words: array<u32>;\n"
+    "\n"
+    "fn instance_stride() -> u32 {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return 20u;\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return 14u;\n"
+    "    }\n"
+    "    return 8u;\n"
+    "}\n"
+    "\n"
+    "fn instance_rows(base: u32) -> mat3x4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        var columns: array<vec4<f32>, 4>;\n"
+    "        for (var c = 0u; c < 4u; c++) {\n"
+    "            columns[c] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + c * 4u],\n"
+    "                instance_words[base + c * 4u + 1u],\n"
+    "                instance_words[base + c * 4u + 2u],\n"
+    "                instance_words[base + c * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return transpose(mat4x3<f32>(columns[0].xyz, columns[1].xyz, columns[2].xyz, columns[3].xyz));\n"
+    "    }\n"
+    "    \n"
+    "    if (instance_format == 1u) {\n"
+    "        var rows: array<vec4<f32>, 3>;\n"
+    "        for (var r = 0u; r < 3u; r++) {\n"
+    "            rows[r] = bitcast<vec4<f32>>(vec4<u32>(\n"
+    "                instance_words[base + r * 4u],\n"
+    "                instance_words[base + r * 4u + 1u],\n"
+    "                instance_words[base + r * 4u + 2u],\n"
+    "                instance_words[base + r * 4u + 3u],\n"
+    "            ));\n"
+    "        }\n"
+    "        return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "    }\n"
+    "    \n"
+    "    var rows: array<vec4<f32>, 3>;\n"
+    "    for (var r = 0u; r < 3u; r++) {\n"
+    "        rows[r] = vec4<f32>(\n"
+    "            unpack2x16float(instance_words[base + r * 2u]),\n"
+    "            unpack2x16float(instance_words[base + r * 2u + 1u]),\n"
+    "        );\n"
+    "    }\n"
+    "    return mat3x4<f32>(rows[0], rows[1], rows[2]);\n"
+    "}\n"
+    "\n"
+    "fn instance_color(base: u32) -> vec4<f32> {\n"
+    "    if (instance_format == 0u) {\n"
+    "        return vec4<f32>(bitcast<vec3<f32>>(vec3<u32>(\n"
+    "            instance_words[base + 16u],\n"
+    "            instance_words[base + 17u],\n"
+    "            instance_words[base + 18u],\n"
+    "        )), 1.0);\n"
+    "    }\n"
+    "    if (instance_format == 1u) {\n"
+    "        return unpack4x8unorm(instance_words[base + 12u]);\n"
+    "    }\n"
+    "    return unpack4x8unorm(instance_words[base + 6u]);\n"
+    "}\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(vertex: VertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {\n"
+    "    let base = instance_index * instance_stride();\n"
+    "    let model_matrix = transpose(instance_rows(base));\n"
+    "    \n"
+    "    let world_position = model_matrix * vec4<f32>(vertex.position, 1.0);\n"
+    "    let world_normal = normalize(model_matrix * vec4<f32>(vertex.normal, 0.0));\n"
+    "    let color = instance_color(base);\n"
+    "    \n"
+    "    var out: VertexOutput;\n"
+    "    out.clip_position = camera.view_projection * vec4<f32>(world_position, 1.0);\n"
+    "    out.world_position = world_position;\n"
+    "    out.world_normal = world_normal;\n"
+    "    out.uv = vertex.uv;\n"
+    "    out.color = color;\n"
+    "    \n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    let normal = normalize(in.world_normal);\n"
+    "    let light_direction = vec3<f32>(light.direction_x, light.direction_y, light.direction_z);\n"
+    "    let light_dir = normalize(-light_direction);\n"
+    "    \n"
+    "    let ndotl = max(dot(normal, light_dir), 0.0);\n"
+    "    let light_color = vec3<f32>(light.color_x, light.color_y, light.color_z);\n"
+    "    let diffuse = light_color * light.intensity * ndotl * shadow_factor(in.world_position);\n"
+    "    \n"
+    "    let ambient_color = vec3<f32>(light.ambient_xy.x, light.ambient_xy.y, light.ambient_strength);\n"
+    "    let texel = textureSample(diffuse_maps, diffuse_sampler, in.uv, material.diffuse_layer);\n"
+    "    let albedo = in.color.rgb * material.base_color.rgb * texel.rgb;\n"
+    "    let final_color = albedo * (ambient_color + diffuse) + albedo * material.emissive;\n"
+    "    \n"
+    "    return vec4<f32>(final_color, in.color.a * material.base_color.a * texel.a);\n"
+    "}\n",
+
+};
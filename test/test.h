@@ -0,0 +1,89 @@
+/**
+ * @file test/test.h
+ * @brief Assertions and the fake WebGPU device shared by the unit tests.
+ *
+ * Each test is one executable that links the modules it exercises with
+ * test/webgpu_fake.c, which implements the WebGPU calls of those modules
+ * without a GPU. Handles are counters, queue writes are recorded so tests
+ * can check what would have been uploaded, and submitted-work-done
+ * callbacks run when the test completes the GPU's work.
+ */
+
+#ifndef WEBGPU_TEST_H
+#define WEBGPU_TEST_H
+
+#include "private_api.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#define FAKE_MAX_WRITES 64
+#define FAKE_WRITE_BYTES 16             /* Leading bytes kept of each write */
+
+/* Queue write recorded by the fake queue */
+typedef struct {
+    WGPUBuffer buffer;
+    uint64_t offset;
+    size_t size;
+    uint8_t data[FAKE_WRITE_BYTES];
+} fake_write_t;
+
+/* What the fake device did since the last fake_webgpu_reset */
+typedef struct {
+    int32_t buffers_created;
+    int32_t buffers_released;
+    int32_t textures_created;
+    int32_t textures_released;
+    int32_t submits;
+    int32_t write_count;
+    fake_write_t writes[FAKE_MAX_WRITES];
+} fake_webgpu_t;
+
+extern fake_webgpu_t fake_webgpu;
+
+WGPUDevice fake_device(void);
+WGPUQueue fake_queue(void);
+void fake_webgpu_reset(void);
+void fake_webgpu_complete(void);
+
+static int test_failures;
+
+#define test_assert(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: assert failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#define test_int(actual, expected) \
+    do { \
+        long long test_a_ = (long long)(actual), test_e_ = (long long)(expected); \
+        if (test_a_ != test_e_) { \
+            printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, \
+                #actual, test_a_, test_e_); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#define test_flt(actual, expected) \
+    do { \
+        double test_a_ = (double)(actual), test_e_ = (double)(expected); \
+        if (fabs(test_a_ - test_e_) > 1e-5 * (1.0 + fabs(test_e_))) { \
+            printf("%s:%d: %s is %g, expected %g\n", __FILE__, __LINE__, \
+                #actual, test_a_, test_e_); \
+            test_failures++; \
+        } \
+    } while (0)
+
+/* Exit code of a test executable */
+static inline int test_result(const char *name) {
+    if (test_failures) {
+        printf("%s: %d failed\n", name, test_failures);
+        return 1;
+    }
+    printf("%s: passed\n", name);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,243 @@
+/**
+ * @file test/test_frame_graph.c
+ * @brief Frame graph pass ordering, culling and transient aliasing.
+ */
+
+#include "test.h"
+
+static webgpu_resource_pool_t *pool;
+static webgpu_frame_graph_t *graph;
+static WebGPURenderer renderer;
+
+static void setup(void) {
+    pool = webgpu_create_resource_pool(NULL);
+    graph = webgpu_frame_graph_create(pool);
+    renderer = (WebGPURenderer){
+        .device = fake_device(),
+        .queue = fake_queue(),
+        .resources = pool,
+        .frame_graph = graph,
+    };
+    webgpu_frame_graph_begin(graph);
+}
+
+static void teardown(void) {
+    webgpu_frame_graph_destroy(graph);
+    webgpu_destroy_resource_pool(pool);
+}
+
+/* A reader added before the pass writing what it reads runs after it */
+static void test_read_after_write(void) {
+    setup();
+    int32_t records = webgpu_frame_graph_import_buffer(graph, "Records", NULL);
+    int32_t color = webgpu_frame_graph_import_texture(graph, "Color", NULL, NULL);
+    webgpu_frame_graph_output(graph, color);
+
+    int32_t draw = webgpu_frame_graph_pass(graph, "Draw", NULL, NULL);
+    webgpu_frame_graph_read(graph, draw, records);
+    webgpu_frame_graph_write(graph, draw, color);
+
+    int32_t fill = webgpu_frame_graph_pass(graph, "Fill", NULL, NULL);
+    webgpu_frame_graph_write(graph, fill, records);
+
+    test_assert(webgpu_frame_graph_compile(&renderer, graph));
+    test_int(graph->order_count, 2);
+    test_int(graph->order[0], fill);
+    test_int(graph->order[1], draw);
+    teardown();
+}
+
+/* A pass overwriting a resource waits for the readers of what it replaces */
+static void test_write_after_read(void) {
+    setup();
+    int32_t data = webgpu_frame_graph_import_buffer(graph, "Data", NULL);
+    int32_t first_out = webgpu_frame_graph_import_buffer(graph, "First", NULL);
+    int32_t second_out = webgpu_frame_graph_import_buffer(graph, "Second", NULL);
+    webgpu_frame_graph_output(graph, first_out);
+    webgpu_frame_graph_output(graph, second_out);
+
+    int32_t write_first = webgpu_frame_graph_pass(graph, "Write First", NULL, NULL);
+    webgpu_frame_graph_write(graph, write_first, data);
+
+    int32_t read_first = webgpu_frame_graph_pass(graph, "Read First", NULL, NULL);
+    webgpu_frame_graph_read(graph, read_first, data);
+    webgpu_frame_graph_write(graph, read_first, first_out);
+
+    int32_t write_second = webgpu_frame_graph_pass(graph, "Write Second", NULL, NULL);
+    webgpu_frame_graph_write(graph, write_second, data);
+
+    int32_t read_second = webgpu_frame_graph_pass(graph, "Read Second", NULL, NULL);
+    webgpu_frame_graph_read(graph, read_second, data);
+    webgpu_frame_graph_write(graph, read_second, second_out);
+
+    test_assert(webgpu_frame_graph_compile(&renderer, graph));
+    test_int(graph->order_count, 4);
+    test_int(graph->order[0], write_first);
+    test_int(graph->order[1], read_first);
+    test_int(graph->order[2], write_second);
+    test_int(graph->order[3], read_second);
+    teardown();
+}
+
+/* History reads see the previous frame, so they don't wait for the writer */
+static void test_history_read(void) {
+    setup();
+    int32_t hiz = webgpu_frame_graph_import_texture(graph, "HiZ", NULL, NULL);
+    int32_t draws = webgpu_frame_graph_import_buffer(graph, "Draws", NULL);
+    webgpu_frame_graph_output(graph, hiz);
+    webgpu_frame_graph_output(graph, draws);
+
+    int32_t build = webgpu_frame_graph_pass(graph, "Build", NULL, NULL);
+    webgpu_frame_graph_write(graph, build, hiz);
+
+    int32_t cull = webgpu_frame_graph_pass(graph, "Cull", NULL, NULL);
+    webgpu_frame_graph_read_history(graph, cull, hiz);
+    webgpu_frame_graph_write(graph, cull, draws);
+
+    /* Added after the builder, so only the add order puts it second */
+    test_assert(webgpu_frame_graph_compile(&renderer, graph));
+    test_int(graph->order_count, 2);
+    test_int(graph->order[0], build);
+    test_int(graph->order[1], cull);
+    teardown();
+}
+
+/* Passes whose writes nothing uses are dropped, unless they have side effects */
+static void test_cull(void) {
+    setup();
+    int32_t color = webgpu_frame_graph_import_texture(graph, "Color", NULL, NULL);
+    int32_t unused = webgpu_frame_graph_import_buffer(graph, "Unused", NULL);
+    webgpu_frame_graph_output(graph, color);
+
+    int32_t draw = webgpu_frame_graph_pass(graph, "Draw", NULL, NULL);
+    webgpu_frame_graph_write(graph, draw, color);
+
+    int32_t dead = webgpu_frame_graph_pass(graph, "Dead", NULL, NULL);
+    webgpu_frame_graph_write(graph, dead, unused);
+
+    int32_t present = webgpu_frame_graph_pass(graph, "Present", NULL, NULL);
+    webgpu_frame_graph_side_effects(graph, present);
+
+    test_assert(webgpu_frame_graph_compile(&renderer, graph));
+    test_int(graph->order_count, 2);
+    test_int(graph->order[0], draw);
+    test_int(graph->order[1], present);
+    test_assert(graph->passes[dead].culled);
+    test_int(renderer.passes_recorded, 2);
+    test_int(renderer.passes_culled, 1);
+    teardown();
+}
+
+/* Passes reading each other's writes can't be ordered */
+static void test_cycle(void) {
+    setup();
+    int32_t a = webgpu_frame_graph_import_buffer(graph, "A", NULL);
+    int32_t b = webgpu_frame_graph_import_buffer(graph, "B", NULL);
+    webgpu_frame_graph_output(graph, a);
+    webgpu_frame_graph_output(graph, b);
+
+    int32_t first = webgpu_frame_graph_pass(graph, "First", NULL, NULL);
+    webgpu_frame_graph_read(graph, first, a);
+    webgpu_frame_graph_write(graph, first, b);
+
+    int32_t second = webgpu_frame_graph_pass(graph, "Second", NULL, NULL);
+    webgpu_frame_graph_read(graph, second, b);
+    webgpu_frame_graph_write(graph, second, a);
+
+    test_assert(!webgpu_frame_graph_compile(&renderer, graph));
+    test_assert(!graph->compiled);
+    teardown();
+}
+
+/**
+ * Declare a transient written by one pass and read by the next, which
+ * writes an output. Returns the transient.
+ */
+static int32_t transient_pair(const char *name, int32_t output) {
+    int32_t transient = webgpu_frame_graph_buffer(graph, name, 1024,
+        WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst);
+    int32_t producer = webgpu_frame_graph_pass(graph, "Produce", NULL, NULL);
+    webgpu_frame_graph_write(graph, producer, transient);
+    int32_t consumer = webgpu_frame_graph_pass(graph, "Consume", NULL, NULL);
+    webgpu_frame_graph_read(graph, consumer, transient);
+    webgpu_frame_graph_write(graph, consumer, output);
+    return transient;
+}
+
+/* Transients whose lifetimes don't overlap share one buffer */
+static void test_alias_disjoint(void) {
+    setup();
+    int32_t first_out = webgpu_frame_graph_import_buffer(graph, "First", NULL);
+    int32_t second_out = webgpu_frame_graph_import_buffer(graph, "Second", NULL);
+    webgpu_frame_graph_output(graph, first_out);
+    webgpu_frame_graph_output(graph, second_out);
+    int32_t first = transient_pair("First Scratch", first_out);
+    int32_t second = transient_pair("Second Scratch", second_out);
+
+    test_assert(webgpu_frame_graph_compile(&renderer, graph));
+    test_int(graph->physical_count, 1);
+    test_int(renderer.transients_aliased, 1);
+    test_int(graph->resources[first].physical, graph->resources[second].physical);
+
+    const WebGPUBufferBlock *a = webgpu_frame_graph_block(graph, first);
+    const WebGPUBufferBlock *b = webgpu_frame_graph_block(graph, second);
+    test_assert(a && b && a->buffer);
+    test_assert(a->buffer == b->buffer && a->offset == b->offset);
+    teardown();
+}
+
+/* Transients used by the same pass get buffers of their own */
+static void test_alias_overlapping(void) {
+    setup();
+    int32_t first_out = webgpu_frame_graph_import_buffer(graph, "First", NULL);
+    int32_t second_out = webgpu_frame_graph_import_buffer(graph, "Second", NULL);
+    webgpu_frame_graph_output(graph, first_out);
+    webgpu_frame_graph_output(graph, second_out);
+    int32_t first = transient_pair("First Scratch", first_out);
+    int32_t second = transient_pair("Second Scratch", second_out);
+
+    /* Keeps the first transient alive past the start of the second */
+    int32_t late = webgpu_frame_graph_pass(graph, "Late", NULL, NULL);
+    webgpu_frame_graph_read(graph, late, first);
+    webgpu_frame_graph_write(graph, late, second_out);
+
+    test_assert(webgpu_frame_graph_compile(&renderer, graph));
+    test_int(graph->physical_count, 2);
+    test_int(renderer.transients_aliased, 0);
+    test_assert(graph->resources[first].physical != graph->resources[second].physical);
+
+    const WebGPUBufferBlock *a = webgpu_frame_graph_block(graph, first);
+    const WebGPUBufferBlock *b = webgpu_frame_graph_block(graph, second);
+    test_assert(a && b);
+    test_assert(a->buffer != b->buffer || a->offset != b->offset);
+    teardown();
+}
+
+/* Transients of culled passes aren't created */
+static void test_alias_culled(void) {
+    setup();
+    int32_t out = webgpu_frame_graph_import_buffer(graph, "Out", NULL);
+    int32_t scratch = webgpu_frame_graph_buffer(graph, "Scratch", 1024, WGPUBufferUsage_Storage);
+    int32_t dead = webgpu_frame_graph_pass(graph, "Dead", NULL, NULL);
+    webgpu_frame_graph_write(graph, dead, scratch);
+    webgpu_frame_graph_write(graph, dead, out);
+
+    test_assert(webgpu_frame_graph_compile(&renderer, graph));
+    test_int(graph->order_count, 0);
+    test_int(graph->physical_count, 0);
+    test_int(graph->resources[scratch].physical, -1);
+    teardown();
+}
+
+int main(void) {
+    ecs_os_set_api_defaults();
+    test_read_after_write();
+    test_write_after_read();
+    test_history_read();
+    test_cull();
+    test_cycle();
+    test_alias_disjoint();
+    test_alias_overlapping();
+    test_alias_culled();
+    return test_result("frame_graph");
+}
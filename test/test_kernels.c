@@ -0,0 +1,149 @@
+/**
+ * @file test/test_kernels.c
+ * @brief The SIMD batch kernels against their scalar reference versions.
+ */
+
+#include "test.h"
+
+/* Not a multiple of four, so the SIMD loops leave a tail */
+#define COUNT 37
+#define STRIDE 80                       /* Records with a gap after them */
+#define KERNEL_BYTES (COUNT * STRIDE)
+
+static EcsTransform3 transforms[COUNT];
+static float scales[COUNT * 3];
+static EcsRgb colors[COUNT];
+static int32_t rows[COUNT];
+
+/* Deterministic pseudo random numbers in [lo, hi) */
+static uint32_t random_state = 54321;
+
+static float random_float(float lo, float hi) {
+    random_state = random_state * 1664525u + 1013904223u;
+    return lo + (hi - lo) * (float)(random_state >> 8) / (float)(1u << 24);
+}
+
+/* Random transforms, scales and colors, visited in a shuffled order */
+static void setup(void) {
+    for (int32_t i = 0; i < COUNT; i++) {
+        float *m = &transforms[i].value[0][0];
+        for (int32_t k = 0; k < 16; k++) {
+            m[k] = random_float(-4.0f, 4.0f);
+        }
+        m[3] = m[7] = m[11] = 0.0f;
+        m[15] = 1.0f;
+        for (int32_t k = 0; k < 3; k++) {
+            scales[i * 3 + k] = random_float(0.1f, 10.0f);
+        }
+        /* Partly outside [0, 1] to exercise the clamping */
+        colors[i] = (EcsRgb){
+            random_float(-0.5f, 1.5f),
+            random_float(0.0f, 1.0f),
+            random_float(-0.5f, 1.5f)
+        };
+        rows[i] = (i * 11) % COUNT;
+    }
+}
+
+/* Sphere centers are the translations, radii scale by the longest axis */
+static void test_transform_spheres(void) {
+    float radius[COUNT];
+    float x[COUNT], y[COUNT], z[COUNT], r[COUNT];
+    float sx[COUNT], sy[COUNT], sz[COUNT], sr[COUNT];
+    for (int32_t i = 0; i < COUNT; i++) {
+        radius[i] = random_float(0.5f, 2.0f);
+    }
+
+    webgpu_transform_spheres(transforms, radius, COUNT, x, y, z, r);
+    webgpu_transform_spheres_scalar(transforms, radius, COUNT, sx, sy, sz, sr);
+    for (int32_t i = 0; i < COUNT; i++) {
+        test_flt(x[i], sx[i]);
+        test_flt(y[i], sy[i]);
+        test_flt(z[i], sz[i]);
+        test_flt(r[i], sr[i]);
+    }
+
+    /* The outputs may alias the radii */
+    webgpu_transform_spheres(transforms, radius, COUNT, x, y, z, radius);
+    for (int32_t i = 0; i < COUNT; i++) {
+        test_flt(radius[i], sr[i]);
+    }
+}
+
+/**
+ * Compare the records a kernel and its reference wrote. The bytes between
+ * records are poisoned and must stay untouched.
+ */
+static void check_records(const uint8_t *simd, const uint8_t *scalar, size_t record_size) {
+    for (int32_t i = 0; i < COUNT; i++) {
+        const uint8_t *a = simd + (size_t)i * STRIDE;
+        const uint8_t *b = scalar + (size_t)i * STRIDE;
+        test_assert(!memcmp(a, b, record_size));
+        for (size_t k = record_size; k < STRIDE; k++) {
+            test_int(a[k], 0xAB);
+        }
+    }
+}
+
+/* Full matrices with the scales folded into the first three columns */
+static void test_pack_matrices(void) {
+    uint8_t simd[KERNEL_BYTES], scalar[KERNEL_BYTES];
+    memset(simd, 0xAB, sizeof(simd));
+    memset(scalar, 0xAB, sizeof(scalar));
+
+    webgpu_pack_matrices(simd, STRIDE, transforms, scales, rows, COUNT);
+    webgpu_pack_matrices_scalar(scalar, STRIDE, transforms, scales, rows, COUNT);
+    check_records(simd, scalar, 16 * sizeof(float));
+
+    /* Record 1 is row 11 */
+    const float *m = &transforms[11].value[0][0];
+    const float *record = (const float*)(simd + STRIDE);
+    test_flt(record[4], m[4] * scales[11 * 3 + 1]);
+    test_flt(record[13], m[13]);
+}
+
+/* The three affine rows, as floats and as half floats */
+static void test_pack_affine(void) {
+    uint8_t simd[KERNEL_BYTES], scalar[KERNEL_BYTES];
+    memset(simd, 0xAB, sizeof(simd));
+    memset(scalar, 0xAB, sizeof(scalar));
+
+    webgpu_pack_affine(simd, STRIDE, transforms, scales, rows, COUNT, false);
+    webgpu_pack_affine_scalar(scalar, STRIDE, transforms, scales, rows, COUNT, false);
+    check_records(simd, scalar, 12 * sizeof(float));
+
+    /* Rows of the matrix are its columns transposed */
+    const float *m = &transforms[11].value[0][0];
+    const float *record = (const float*)(simd + STRIDE);
+    test_flt(record[1], m[4] * scales[11 * 3 + 1]);
+    test_flt(record[7], m[13]);
+
+    memset(simd, 0xAB, sizeof(simd));
+    memset(scalar, 0xAB, sizeof(scalar));
+    webgpu_pack_affine(simd, STRIDE, transforms, scales, rows, COUNT, true);
+    webgpu_pack_affine_scalar(scalar, STRIDE, transforms, scales, rows, COUNT, true);
+    check_records(simd, scalar, 12 * sizeof(uint16_t));
+}
+
+/* Clamped, rounded colors with opaque alpha */
+static void test_pack_rgba8(void) {
+    uint8_t simd[KERNEL_BYTES], scalar[KERNEL_BYTES];
+    memset(simd, 0xAB, sizeof(simd));
+    memset(scalar, 0xAB, sizeof(scalar));
+
+    webgpu_pack_rgba8(simd, STRIDE, colors, rows, COUNT);
+    webgpu_pack_rgba8_scalar(scalar, STRIDE, colors, rows, COUNT);
+    check_records(simd, scalar, sizeof(uint32_t));
+    for (int32_t i = 0; i < COUNT; i++) {
+        test_int(simd[(size_t)i * STRIDE + 3], 255);
+    }
+}
+
+int main(void) {
+    setup();
+    test_transform_spheres();
+    test_pack_matrices();
+    test_pack_affine();
+    test_pack_rgba8();
+    return test_result("kernels");
+}
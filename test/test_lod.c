@@ -0,0 +1,80 @@
+/**
+ * @file test/test_lod.c
+ * @brief LOD selection by projected size and its hysteresis.
+ */
+
+#include "test.h"
+
+/* LOD 0 from 100 pixels, LOD 1 from 50, LOD 2 below */
+static const float pixels[] = { 100.0f, 50.0f, 25.0f };
+
+#define UNSET 0xFF
+
+static uint32_t pick(float size, uint8_t *state) {
+    return webgpu_select_instance_lod(pixels, 3, size, state);
+}
+
+/* Without a previous LOD the thresholds apply as they are */
+static void test_unset(void) {
+    uint8_t state = UNSET;
+    test_int(pick(120.0f, &state), 0);
+    test_int(state, 0);
+
+    state = UNSET;
+    test_int(pick(99.0f, &state), 1);
+    test_int(state, 1);
+
+    state = UNSET;
+    test_int(pick(10.0f, &state), 2);
+    test_int(state, 2);
+}
+
+/* Shrinking past a threshold by less than the margin keeps the finer LOD */
+static void test_coarser(void) {
+    uint8_t state = 0;
+    test_int(pick(100.0f * (1.0f - WEBGPU_LOD_HYSTERESIS) + 1.0f, &state), 0);
+    test_int(pick(100.0f * (1.0f - WEBGPU_LOD_HYSTERESIS) - 1.0f, &state), 1);
+    test_int(state, 1);
+}
+
+/* Growing past a threshold by less than the margin keeps the coarser LOD */
+static void test_finer(void) {
+    uint8_t state = 1;
+    test_int(pick(100.0f * (1.0f + WEBGPU_LOD_HYSTERESIS) - 1.0f, &state), 1);
+    test_int(pick(100.0f * (1.0f + WEBGPU_LOD_HYSTERESIS) + 1.0f, &state), 0);
+    test_int(state, 0);
+}
+
+/* A large change of size skips the LODs in between */
+static void test_jump(void) {
+    uint8_t state = 2;
+    test_int(pick(500.0f, &state), 0);
+    test_int(pick(1.0f, &state), 2);
+}
+
+/* Sizes oscillating around a threshold within the margin never switch */
+static void test_oscillate(void) {
+    uint8_t state = UNSET;
+    uint32_t first = pick(102.0f, &state);
+    for (int32_t i = 0; i < 100; i++) {
+        float size = 50.0f * (2.0f + (i & 1 ? 0.1f : -0.1f) * (1.0f + (i % 5) * 0.2f));
+        test_int(pick(size, &state), first);
+    }
+}
+
+/* A single LOD is always picked */
+static void test_single(void) {
+    uint8_t state = UNSET;
+    test_int(webgpu_select_instance_lod(pixels, 1, 1.0f, &state), 0);
+    test_int(webgpu_select_instance_lod(pixels, 1, 1000.0f, &state), 0);
+}
+
+int main(void) {
+    test_unset();
+    test_coarser();
+    test_finer();
+    test_jump();
+    test_oscillate();
+    test_single();
+    return test_result("lod");
+}
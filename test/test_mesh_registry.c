@@ -0,0 +1,181 @@
+/**
+ * @file test/test_mesh_registry.c
+ * @brief Mesh arena layout and how chunked writes are split into uploads.
+ */
+
+#include "test.h"
+
+#define VERTEX_COUNT 3
+#define VERTEX_BYTES (VERTEX_COUNT * WEBGPU_BYTES_PER_VERTEX)
+#define MESH_BYTES (VERTEX_BYTES + 3 * sizeof(uint16_t))
+
+static webgpu_resource_pool_t *pool;
+static webgpu_mesh_registry_t *registry;
+
+/* A triangle in mesh file layout: the vertices, then three uint16 indices */
+static struct {
+    float vertices[VERTEX_COUNT * WEBGPU_FLOATS_PER_VERTEX];
+    uint16_t indices[3];
+} triangle;
+
+static void setup(void) {
+    fake_webgpu_reset();
+    pool = webgpu_create_resource_pool(NULL);
+    registry = webgpu_mesh_registry_create(pool);
+    for (int32_t i = 0; i < VERTEX_COUNT * WEBGPU_FLOATS_PER_VERTEX; i++) {
+        triangle.vertices[i] = (float)i;
+    }
+    triangle.indices[0] = 0x0102;
+    triangle.indices[1] = 0x0304;
+    triangle.indices[2] = 0x0506;
+}
+
+static void teardown(void) {
+    webgpu_mesh_registry_destroy(registry);
+    webgpu_destroy_resource_pool(pool);
+    fake_webgpu_complete();
+}
+
+static uint32_t reserve(uint32_t vertex_count, uint32_t index_count, WGPUIndexFormat format) {
+    return webgpu_mesh_registry_reserve(registry, fake_device(), fake_queue(),
+        vertex_count, index_count, format);
+}
+
+static bool write_chunk(uint32_t mesh_id, uint64_t offset, size_t size) {
+    return webgpu_mesh_registry_write(registry, fake_queue(), mesh_id, offset,
+        (const uint8_t*)&triangle + offset, size);
+}
+
+/* Meshes are appended to the arenas, index ranges start 4-byte aligned */
+static void test_reserve(void) {
+    setup();
+    uint32_t first = reserve(VERTEX_COUNT, 3, WGPUIndexFormat_Uint16);
+    uint32_t second = reserve(VERTEX_COUNT, 3, WGPUIndexFormat_Uint16);
+    uint32_t wide = reserve(VERTEX_COUNT, 3, WGPUIndexFormat_Uint32);
+    test_int(first, 1);
+    test_int(second, 2);
+    test_int(wide, 3);
+
+    const webgpu_mesh_t *mesh = webgpu_mesh_registry_get(registry, second);
+    test_int(mesh->base_vertex, VERTEX_COUNT);
+    test_int(mesh->first_index, 4);
+    test_assert(!mesh->resident);
+
+    mesh = webgpu_mesh_registry_get(registry, wide);
+    test_int(mesh->base_vertex, 2 * VERTEX_COUNT);
+    test_int(mesh->first_index, 0);
+    test_assert(registry->index32_buffer != NULL);
+    test_assert(registry->index32_buffer != registry->index_buffer);
+
+    test_assert(webgpu_mesh_registry_get(registry, 0) == NULL);
+    test_assert(webgpu_mesh_registry_get(registry, 4) == NULL);
+    teardown();
+}
+
+/* A write over the end of the vertices continues in the index arena, the
+ * unaligned tail is padded to a whole word */
+static void test_write_split(void) {
+    setup();
+    reserve(VERTEX_COUNT, 3, WGPUIndexFormat_Uint16);
+    uint32_t mesh_id = reserve(VERTEX_COUNT, 3, WGPUIndexFormat_Uint16);
+    fake_webgpu_reset();
+
+    test_assert(write_chunk(mesh_id, 0, MESH_BYTES));
+    test_int(fake_webgpu.write_count, 3);
+
+    fake_write_t *vertices = &fake_webgpu.writes[0];
+    test_assert(vertices->buffer == registry->vertex_buffer);
+    test_int(vertices->offset, VERTEX_BYTES);
+    test_int(vertices->size, VERTEX_BYTES);
+
+    /* Second mesh, its indices start at the aligned index 4 */
+    fake_write_t *indices = &fake_webgpu.writes[1];
+    test_assert(indices->buffer == registry->index_buffer);
+    test_int(indices->offset, 4 * sizeof(uint16_t));
+    test_int(indices->size, 4);
+    test_assert(!memcmp(indices->data, triangle.indices, 4));
+
+    fake_write_t *tail = &fake_webgpu.writes[2];
+    test_assert(tail->buffer == registry->index_buffer);
+    test_int(tail->offset, 4 * sizeof(uint16_t) + 4);
+    test_int(tail->size, 4);
+    uint8_t padded[4] = { 0x06, 0x05, 0, 0 };
+    test_assert(!memcmp(tail->data, padded, 4));
+    teardown();
+}
+
+/* Chunks land at their offset in the mesh data, wherever they split */
+static void test_write_chunks(void) {
+    setup();
+    uint32_t mesh_id = reserve(VERTEX_COUNT, 3, WGPUIndexFormat_Uint16);
+    fake_webgpu_reset();
+
+    size_t first = VERTEX_BYTES - 8;
+    test_assert(write_chunk(mesh_id, 0, first));
+    test_assert(write_chunk(mesh_id, first, 12));
+    test_assert(write_chunk(mesh_id, first + 12, MESH_BYTES - first - 12));
+    test_int(fake_webgpu.write_count, 4);
+
+    test_int(fake_webgpu.writes[0].offset, 0);
+    test_int(fake_webgpu.writes[0].size, first);
+
+    /* The middle chunk is the last 8 vertex bytes and the first 2 indices */
+    test_assert(fake_webgpu.writes[1].buffer == registry->vertex_buffer);
+    test_int(fake_webgpu.writes[1].offset, first);
+    test_int(fake_webgpu.writes[1].size, 8);
+    test_assert(fake_webgpu.writes[2].buffer == registry->index_buffer);
+    test_int(fake_webgpu.writes[2].offset, 0);
+    test_int(fake_webgpu.writes[2].size, 4);
+
+    /* The last index, padded */
+    test_assert(fake_webgpu.writes[3].buffer == registry->index_buffer);
+    test_int(fake_webgpu.writes[3].offset, 4);
+    test_int(fake_webgpu.writes[3].size, 4);
+    test_int(fake_webgpu.writes[3].data[0], 0x06);
+    test_int(fake_webgpu.writes[3].data[2], 0);
+    teardown();
+}
+
+/* Unaligned chunk starts and writes past the mesh are refused */
+static void test_write_invalid(void) {
+    setup();
+    uint32_t mesh_id = reserve(VERTEX_COUNT, 3, WGPUIndexFormat_Uint16);
+    fake_webgpu_reset();
+
+    test_assert(!write_chunk(mesh_id, 2, 4));
+    test_assert(!webgpu_mesh_registry_write(registry, fake_queue(), mesh_id,
+        VERTEX_BYTES, triangle.indices, 8));
+    test_assert(!write_chunk(mesh_id + 1, 0, 4));
+    test_int(fake_webgpu.write_count, 0);
+    teardown();
+}
+
+/* Finishing a mesh makes it resident with the bounds of its vertices */
+static void test_finish(void) {
+    setup();
+    float vertices[VERTEX_COUNT * WEBGPU_FLOATS_PER_VERTEX] = {0};
+    vertices[0 * WEBGPU_FLOATS_PER_VERTEX + 0] = -1.0f;
+    vertices[1 * WEBGPU_FLOATS_PER_VERTEX + 0] = 3.0f;
+    vertices[2 * WEBGPU_FLOATS_PER_VERTEX + 1] = 2.0f;
+    uint16_t indices[3] = { 0, 1, 2 };
+
+    uint32_t mesh_id = webgpu_mesh_registry_add(registry, fake_device(), fake_queue(),
+        vertices, VERTEX_COUNT, indices, 3);
+    const webgpu_mesh_t *mesh = webgpu_mesh_registry_get(registry, mesh_id);
+    test_assert(mesh && mesh->resident);
+    test_flt(mesh->bounds[0], 1.0f);
+    test_flt(mesh->bounds[1], 1.0f);
+    test_flt(mesh->bounds[2], 0.0f);
+    test_flt(mesh->bounds[3], sqrtf(5.0f));
+    teardown();
+}
+
+int main(void) {
+    ecs_os_set_api_defaults();
+    test_reserve();
+    test_write_split();
+    test_write_chunks();
+    test_write_invalid();
+    test_finish();
+    return test_result("mesh_registry");
+}
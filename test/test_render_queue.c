@@ -0,0 +1,124 @@
+/**
+ * @file test/test_render_queue.c
+ * @brief Render queue sort keys and the radix sort.
+ */
+
+#include "test.h"
+
+/* Deterministic pseudo random numbers */
+static uint32_t random_state = 12345;
+
+static uint32_t random_u32(void) {
+    random_state = random_state * 1664525u + 1013904223u;
+    return random_state;
+}
+
+/**
+ * Sort a queue of count items whose keys keep the bits of mask, checking the
+ * result is ordered and stable
+ */
+static void sort_and_check(int32_t count, uint64_t mask) {
+    ecs_vec_t queue, scratch;
+    ecs_vec_init_t(NULL, &queue, webgpu_draw_item_t, count);
+    ecs_vec_init_t(NULL, &scratch, webgpu_draw_item_t, 0);
+    for (int32_t i = 0; i < count; i++) {
+        uint64_t key = ((uint64_t)random_u32() << 32 | random_u32()) & mask;
+        *ecs_vec_append_t(NULL, &queue, webgpu_draw_item_t) = (webgpu_draw_item_t){
+            .key = key,
+            .batch = i,
+        };
+    }
+
+    webgpu_render_queue_sort(NULL, &queue, &scratch);
+
+    test_int(ecs_vec_count(&queue), count);
+    webgpu_draw_item_t *items = ecs_vec_first_t(&queue, webgpu_draw_item_t);
+    int32_t seen = 0;
+    for (int32_t i = 1; i < count; i++) {
+        test_assert(items[i - 1].key <= items[i].key);
+        if (items[i - 1].key == items[i].key) {
+            test_assert(items[i - 1].batch < items[i].batch);
+        }
+    }
+    for (int32_t i = 0; i < count; i++) {
+        seen += items[i].batch;
+    }
+    test_int(seen, count * (count - 1) / 2);
+
+    ecs_vec_fini_t(NULL, &scratch, webgpu_draw_item_t);
+    ecs_vec_fini_t(NULL, &queue, webgpu_draw_item_t);
+}
+
+/* Keys over all bytes, with many duplicates when few bits vary */
+static void test_sort(void) {
+    sort_and_check(1000, UINT64_MAX);
+    sort_and_check(1000, 0x0F0F000000000F0FULL);
+    sort_and_check(2, UINT64_MAX);
+    sort_and_check(1, UINT64_MAX);
+}
+
+/* One varying byte sorts in one pass, the result is copied back */
+static void test_sort_odd_passes(void) {
+    sort_and_check(300, 0xFFULL << 40);
+    sort_and_check(300, 0xFFFFULL << 40);
+    sort_and_check(300, 0xFFFFFFULL);
+}
+
+/* Equal keys skip every pass and keep their order */
+static void test_sort_equal(void) {
+    sort_and_check(100, 0);
+}
+
+/* Opaque draws sort by state, then near to far */
+static void test_opaque_keys(void) {
+    uint32_t near = webgpu_sort_depth(1.0f), far = webgpu_sort_depth(100.0f);
+    uint64_t a = webgpu_sort_key(WebGPUQueueOpaque, 1, 0, 0, far);
+    uint64_t b = webgpu_sort_key(WebGPUQueueOpaque, 2, 0, 0, near);
+    test_assert(a < b);
+
+    a = webgpu_sort_key(WebGPUQueueOpaque, 1, 3, 4, near);
+    b = webgpu_sort_key(WebGPUQueueOpaque, 1, 3, 4, far);
+    test_assert(a < b);
+
+    a = webgpu_sort_key(WebGPUQueueOpaque, 1, 3, 9, far);
+    b = webgpu_sort_key(WebGPUQueueOpaque, 1, 4, 0, near);
+    test_assert(a < b);
+}
+
+/* Transparent draws sort after all opaque ones, far to near before state */
+static void test_transparent_keys(void) {
+    uint32_t near = webgpu_sort_depth(1.0f), far = webgpu_sort_depth(100.0f);
+    uint64_t opaque = webgpu_sort_key(WebGPUQueueOpaque, 0xFFF, 0xFFFF, 0xFFFF, 0xFFFF);
+    uint64_t a = webgpu_sort_key(WebGPUQueueTransparent, 0, 0, 0, 0);
+    test_assert(opaque < a);
+
+    a = webgpu_sort_key(WebGPUQueueTransparent, 7, 0, 0, far);
+    uint64_t b = webgpu_sort_key(WebGPUQueueTransparent, 1, 0, 0, near);
+    test_assert(a < b);
+}
+
+/* Quantized depths keep the order of the depths */
+static void test_sort_depth(void) {
+    test_int(webgpu_sort_depth(0.0f), 0);
+    test_int(webgpu_sort_depth(-5.0f), 0);
+    test_int(webgpu_sort_depth(NAN), 0);
+
+    uint32_t previous = 0;
+    for (float depth = 0.01f; depth < 10000.0f; depth *= 1.5f) {
+        uint32_t quantized = webgpu_sort_depth(depth);
+        test_assert(quantized > previous);
+        test_assert(quantized <= 0xFFFF);
+        previous = quantized;
+    }
+}
+
+int main(void) {
+    ecs_os_set_api_defaults();
+    test_sort();
+    test_sort_odd_passes();
+    test_sort_equal();
+    test_opaque_keys();
+    test_transparent_keys();
+    test_sort_depth();
+    return test_result("render_queue");
+}
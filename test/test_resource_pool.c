@@ -0,0 +1,213 @@
+/**
+ * @file test/test_resource_pool.c
+ * @brief Slab sub-allocation, deferred release and the memory budget.
+ */
+
+#include "test.h"
+
+#define STORAGE (WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst)
+
+static webgpu_resource_pool_t *pool;
+static uint32_t frame;
+
+static void setup(void) {
+    fake_webgpu_reset();
+    pool = webgpu_create_resource_pool(NULL);
+    frame = 0;
+}
+
+static void teardown(void) {
+    webgpu_destroy_resource_pool(pool);
+    fake_webgpu_complete();
+}
+
+/* Submit a frame, let the GPU finish it and start the next */
+static void next_frame(void) {
+    webgpu_resource_pool_submitted(pool, fake_queue(), frame++);
+    fake_webgpu_complete();
+    webgpu_resource_pool_begin(pool);
+}
+
+/* Small blocks are rounded up to a power of two and share one slab */
+static void test_slab_blocks(void) {
+    setup();
+    WebGPUBufferBlock a, b;
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), 300, STORAGE, &a));
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), 400, STORAGE, &b));
+
+    test_assert(a.slab != NULL);
+    test_assert(a.slab == b.slab && a.buffer == b.buffer);
+    test_int(a.size, 512);
+    test_assert(a.offset != b.offset);
+    test_int(a.offset % (1u << WEBGPU_SLAB_MIN_ORDER), 0);
+    test_int(b.offset % (1u << WEBGPU_SLAB_MIN_ORDER), 0);
+    test_int(fake_webgpu.buffers_created, 1);
+    test_int(ecs_vec_count(&pool->slabs), 1);
+    test_int(pool->committed[WebGPUBufferClassStorage], WEBGPU_SLAB_SIZE);
+    test_int(pool->used[WebGPUBufferClassStorage], 1024);
+
+    /* Another block size or class gets a slab of its own */
+    WebGPUBufferBlock c, d;
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), 2048, STORAGE, &c));
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), 300,
+        WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst, &d));
+    test_assert(c.slab != a.slab && d.slab != a.slab && c.slab != d.slab);
+    test_int(ecs_vec_count(&pool->slabs), 3);
+    test_int(pool->committed[WebGPUBufferClassUniform], WEBGPU_SLAB_SIZE);
+    teardown();
+}
+
+/* A full slab is followed by a new one for the same block size */
+static void test_slab_full(void) {
+    setup();
+    uint64_t size = (uint64_t)1 << WEBGPU_SLAB_MAX_ORDER;
+    int32_t blocks = (int32_t)(WEBGPU_SLAB_SIZE / size);
+    WebGPUBufferBlock block;
+    for (int32_t i = 0; i < blocks; i++) {
+        test_assert(webgpu_buffer_alloc(pool, fake_device(), size, STORAGE, &block));
+        test_int(block.offset, (uint64_t)i * size);
+    }
+    test_int(ecs_vec_count(&pool->slabs), 1);
+
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), size, STORAGE, &block));
+    test_int(block.offset, 0);
+    test_int(ecs_vec_count(&pool->slabs), 2);
+    teardown();
+}
+
+/* Large and mapped buffers get a dedicated buffer of their exact size */
+static void test_dedicated(void) {
+    setup();
+    WebGPUBufferBlock large, mapped;
+    uint64_t size = ((uint64_t)1 << WEBGPU_SLAB_MAX_ORDER) + 4;
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), size, STORAGE, &large));
+    test_assert(large.slab == NULL);
+    test_int(large.offset, 0);
+    test_int(large.size, size);
+
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), 64,
+        WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst, &mapped));
+    test_assert(mapped.slab == NULL);
+    test_int(mapped.size, 64);
+    test_int(ecs_vec_count(&pool->slabs), 0);
+    test_int(fake_webgpu.buffers_created, 2);
+    teardown();
+}
+
+/* Freed blocks stay allocated until the frames that used them finished */
+static void test_deferred_free(void) {
+    setup();
+    WebGPUBufferBlock a, b;
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), 256, STORAGE, &a));
+    uint64_t offset = a.offset;
+    webgpu_buffer_free(pool, &a);
+    test_assert(a.buffer == NULL);
+    test_int(pool->used[WebGPUBufferClassStorage], 256);
+
+    /* Still pending: the next block may not overlap the freed one */
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), 256, STORAGE, &b));
+    test_assert(b.offset != offset);
+    webgpu_buffer_free(pool, &b);
+
+    /* Submitted but not finished */
+    webgpu_resource_pool_submitted(pool, fake_queue(), frame++);
+    webgpu_resource_pool_begin(pool);
+    test_int(pool->used[WebGPUBufferClassStorage], 512);
+
+    fake_webgpu_complete();
+    webgpu_resource_pool_begin(pool);
+    test_int(pool->used[WebGPUBufferClassStorage], 0);
+
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), 256, STORAGE, &a));
+    test_int(a.offset, offset);
+    test_int(fake_webgpu.buffers_created, 1);
+    teardown();
+}
+
+/* Released dedicated buffers are reused, unused ones destroyed eventually */
+static void test_buffer_reuse(void) {
+    setup();
+    uint64_t size = (uint64_t)1 << (WEBGPU_SLAB_MAX_ORDER + 1);
+    WebGPUBufferBlock block;
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), size, STORAGE, &block));
+    WGPUBuffer buffer = block.buffer;
+    webgpu_buffer_free(pool, &block);
+    next_frame();
+    test_int(pool->pooled_bytes, size);
+
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), size, STORAGE, &block));
+    test_assert(block.buffer == buffer);
+    test_int(pool->pooled_bytes, 0);
+    test_int(fake_webgpu.buffers_created, 1);
+
+    webgpu_buffer_free(pool, &block);
+    for (int32_t i = 0; i <= WEBGPU_BUFFER_POOL_FRAMES; i++) {
+        next_frame();
+    }
+    test_int(pool->pooled_bytes, 0);
+    test_int(pool->committed[WebGPUBufferClassStorage], 0);
+    test_int(fake_webgpu.buffers_released, 1);
+    teardown();
+}
+
+/* Slabs without blocks are destroyed once they stayed empty long enough */
+static void test_slab_trim(void) {
+    setup();
+    WebGPUBufferBlock block;
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), 256, STORAGE, &block));
+    webgpu_buffer_free(pool, &block);
+    next_frame();
+    test_int(ecs_vec_count(&pool->slabs), 1);
+
+    for (int32_t i = 0; i < WEBGPU_BUFFER_POOL_FRAMES; i++) {
+        next_frame();
+    }
+    test_int(ecs_vec_count(&pool->slabs), 0);
+    test_int(pool->committed[WebGPUBufferClassStorage], 0);
+    test_int(fake_webgpu.buffers_released, 1);
+    teardown();
+}
+
+/* Allocations past the budget fail, after free memory was given back */
+static void test_budget(void) {
+    setup();
+    pool->budget = WEBGPU_SLAB_SIZE + 4096;
+
+    WebGPUBufferBlock a, b, c;
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), 256, STORAGE, &a));
+    test_assert(!webgpu_buffer_alloc(pool, fake_device(), 256, WGPUBufferUsage_Uniform, &b));
+    test_int(pool->failed, 1);
+    test_assert(b.buffer == NULL);
+
+    /* Fits next to the slab */
+    uint64_t size = 4096;
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), size,
+        WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst, &b));
+    test_assert(!webgpu_buffer_alloc(pool, fake_device(), size,
+        WGPUBufferUsage_MapWrite | WGPUBufferUsage_CopySrc, &c));
+    test_int(pool->failed, 2);
+
+    /* The pooled buffer is destroyed to make room */
+    webgpu_buffer_free(pool, &b);
+    next_frame();
+    test_int(pool->pooled_bytes, size);
+    test_assert(webgpu_buffer_alloc(pool, fake_device(), size,
+        WGPUBufferUsage_MapWrite | WGPUBufferUsage_CopySrc, &c));
+    test_int(pool->pooled_bytes, 0);
+    test_int(pool->failed, 2);
+    test_assert(pool->committed[WebGPUBufferClassStaging] +
+        pool->committed[WebGPUBufferClassStorage] <= pool->budget);
+    teardown();
+}
+
+int main(void) {
+    ecs_os_set_api_defaults();
+    test_slab_blocks();
+    test_slab_full();
+    test_dedicated();
+    test_deferred_free();
+    test_buffer_reuse();
+    test_slab_trim();
+    test_budget();
+    return test_result("resource_pool");
+}
@@ -0,0 +1,273 @@
+/**
+ * @file test/webgpu_fake.c
+ * @brief WebGPU calls of the tested modules, without a GPU.
+ */
+
+#include "test.h"
+
+fake_webgpu_t fake_webgpu;
+
+/* Handles are distinct non-NULL values that are never dereferenced */
+static uintptr_t fake_handles;
+
+#define FAKE_HANDLE(T) ((T)(++fake_handles))
+
+/* Submitted-work-done callbacks the GPU hasn't called yet */
+#define FAKE_MAX_CALLBACKS 16
+
+static struct {
+    WGPUQueueWorkDoneCallback callback;
+    void *userdata;
+} fake_callbacks[FAKE_MAX_CALLBACKS];
+static int32_t fake_callback_count;
+
+WGPUDevice fake_device(void) {
+    static WGPUDevice device;
+    if (!device) {
+        device = FAKE_HANDLE(WGPUDevice);
+    }
+    return device;
+}
+
+WGPUQueue fake_queue(void) {
+    static WGPUQueue queue;
+    if (!queue) {
+        queue = FAKE_HANDLE(WGPUQueue);
+    }
+    return queue;
+}
+
+/**
+ * Forget what the device did, callbacks that are still waiting are kept
+ */
+void fake_webgpu_reset(void) {
+    memset(&fake_webgpu, 0, sizeof(fake_webgpu));
+}
+
+/**
+ * Finish all submitted work, calling the waiting callbacks in submit order
+ */
+void fake_webgpu_complete(void) {
+    int32_t count = fake_callback_count;
+    fake_callback_count = 0;
+    for (int32_t i = 0; i < count; i++) {
+        fake_callbacks[i].callback(WGPUQueueWorkDoneStatus_Success, fake_callbacks[i].userdata);
+    }
+}
+
+WGPUBuffer wgpuDeviceCreateBuffer(WGPUDevice device, WGPUBufferDescriptor const *desc) {
+    (void)device;
+    (void)desc;
+    fake_webgpu.buffers_created++;
+    return FAKE_HANDLE(WGPUBuffer);
+}
+
+void wgpuBufferRelease(WGPUBuffer buffer) {
+    (void)buffer;
+    fake_webgpu.buffers_released++;
+}
+
+void wgpuBufferDestroy(WGPUBuffer buffer) {
+    (void)buffer;
+}
+
+void* wgpuBufferGetMappedRange(WGPUBuffer buffer, size_t offset, size_t size) {
+    (void)buffer;
+    (void)offset;
+    (void)size;
+    return NULL;
+}
+
+void const* wgpuBufferGetConstMappedRange(WGPUBuffer buffer, size_t offset, size_t size) {
+    (void)buffer;
+    (void)offset;
+    (void)size;
+    return NULL;
+}
+
+void wgpuBufferMapAsync(WGPUBuffer buffer, WGPUMapModeFlags mode, size_t offset, size_t size,
+                        WGPUBufferMapCallback callback, void *userdata) {
+    (void)buffer;
+    (void)mode;
+    (void)offset;
+    (void)size;
+    callback(WGPUBufferMapAsyncStatus_Unknown, userdata);
+}
+
+void wgpuBufferUnmap(WGPUBuffer buffer) {
+    (void)buffer;
+}
+
+WGPUTexture wgpuDeviceCreateTexture(WGPUDevice device, WGPUTextureDescriptor const *desc) {
+    (void)device;
+    (void)desc;
+    fake_webgpu.textures_created++;
+    return FAKE_HANDLE(WGPUTexture);
+}
+
+WGPUTextureView wgpuTextureCreateView(WGPUTexture texture, WGPUTextureViewDescriptor const *desc) {
+    (void)texture;
+    (void)desc;
+    return FAKE_HANDLE(WGPUTextureView);
+}
+
+uint32_t wgpuTextureGetWidth(WGPUTexture texture) {
+    (void)texture;
+    return 0;
+}
+
+uint32_t wgpuTextureGetHeight(WGPUTexture texture) {
+    (void)texture;
+    return 0;
+}
+
+void wgpuTextureDestroy(WGPUTexture texture) {
+    (void)texture;
+}
+
+void wgpuTextureRelease(WGPUTexture texture) {
+    (void)texture;
+    fake_webgpu.textures_released++;
+}
+
+void wgpuTextureViewRelease(WGPUTextureView view) {
+    (void)view;
+}
+
+WGPUBindGroup wgpuDeviceCreateBindGroup(WGPUDevice device, WGPUBindGroupDescriptor const *desc) {
+    (void)device;
+    (void)desc;
+    return FAKE_HANDLE(WGPUBindGroup);
+}
+
+void wgpuBindGroupRelease(WGPUBindGroup bind_group) {
+    (void)bind_group;
+}
+
+WGPUShaderModule wgpuDeviceCreateShaderModule(WGPUDevice device, WGPUShaderModuleDescriptor const *desc) {
+    (void)device;
+    (void)desc;
+    return FAKE_HANDLE(WGPUShaderModule);
+}
+
+WGPURenderPipeline wgpuDeviceCreateRenderPipeline(WGPUDevice device,
+                                                  WGPURenderPipelineDescriptor const *desc) {
+    (void)device;
+    (void)desc;
+    return FAKE_HANDLE(WGPURenderPipeline);
+}
+
+void wgpuDeviceCreateRenderPipelineAsync(WGPUDevice device,
+                                         WGPURenderPipelineDescriptor const *desc,
+                                         WGPUCreateRenderPipelineAsyncCallback callback,
+                                         void *userdata) {
+    (void)desc;
+    callback(WGPUCreatePipelineAsyncStatus_Success,
+        wgpuDeviceCreateRenderPipeline(device, desc), NULL, userdata);
+}
+
+void wgpuRenderPipelineRelease(WGPURenderPipeline pipeline) {
+    (void)pipeline;
+}
+
+void wgpuRenderBundleRelease(WGPURenderBundle bundle) {
+    (void)bundle;
+}
+
+WGPUBool wgpuDeviceHasFeature(WGPUDevice device, WGPUFeatureName feature) {
+    (void)device;
+    (void)feature;
+    return false;
+}
+
+WGPUQuerySet wgpuDeviceCreateQuerySet(WGPUDevice device, WGPUQuerySetDescriptor const *desc) {
+    (void)device;
+    (void)desc;
+    return FAKE_HANDLE(WGPUQuerySet);
+}
+
+void wgpuQuerySetRelease(WGPUQuerySet query_set) {
+    (void)query_set;
+}
+
+WGPUCommandEncoder wgpuDeviceCreateCommandEncoder(WGPUDevice device,
+                                                  WGPUCommandEncoderDescriptor const *desc) {
+    (void)device;
+    (void)desc;
+    return FAKE_HANDLE(WGPUCommandEncoder);
+}
+
+void wgpuCommandEncoderCopyBufferToBuffer(WGPUCommandEncoder encoder,
+                                          WGPUBuffer source, uint64_t source_offset,
+                                          WGPUBuffer destination, uint64_t destination_offset,
+                                          uint64_t size) {
+    (void)encoder;
+    (void)source;
+    (void)source_offset;
+    (void)destination;
+    (void)destination_offset;
+    (void)size;
+}
+
+void wgpuCommandEncoderResolveQuerySet(WGPUCommandEncoder encoder, WGPUQuerySet query_set,
+                                       uint32_t first_query, uint32_t query_count,
+                                       WGPUBuffer destination, uint64_t destination_offset) {
+    (void)encoder;
+    (void)query_set;
+    (void)first_query;
+    (void)query_count;
+    (void)destination;
+    (void)destination_offset;
+}
+
+WGPUCommandBuffer wgpuCommandEncoderFinish(WGPUCommandEncoder encoder,
+                                           WGPUCommandBufferDescriptor const *desc) {
+    (void)encoder;
+    (void)desc;
+    return FAKE_HANDLE(WGPUCommandBuffer);
+}
+
+void wgpuCommandEncoderRelease(WGPUCommandEncoder encoder) {
+    (void)encoder;
+}
+
+void wgpuCommandBufferRelease(WGPUCommandBuffer commands) {
+    (void)commands;
+}
+
+void wgpuQueueSubmit(WGPUQueue queue, size_t count, WGPUCommandBuffer const *commands) {
+    (void)queue;
+    (void)count;
+    (void)commands;
+    fake_webgpu.submits++;
+}
+
+void wgpuQueueWriteBuffer(WGPUQueue queue, WGPUBuffer buffer, uint64_t offset,
+                          void const *data, size_t size) {
+    (void)queue;
+    if (fake_webgpu.write_count >= FAKE_MAX_WRITES) {
+        return;
+    }
+
+    fake_write_t *write = &fake_webgpu.writes[fake_webgpu.write_count++];
+    write->buffer = buffer;
+    write->offset = offset;
+    write->size = size;
+    memcpy(write->data, data, size < FAKE_WRITE_BYTES ? size : FAKE_WRITE_BYTES);
+}
+
+void wgpuQueueOnSubmittedWorkDone(WGPUQueue queue, WGPUQueueWorkDoneCallback callback,
+                                  void *userdata) {
+    (void)queue;
+    if (fake_callback_count < FAKE_MAX_CALLBACKS) {
+        fake_callbacks[fake_callback_count].callback = callback;
+        fake_callbacks[fake_callback_count].userdata = userdata;
+        fake_callback_count++;
+    }
+}
+
+/* Profiling lives with the module's components, frames aren't timed here */
+void webgpu_profile_frame_end(WebGPURenderer *renderer, WGPUCommandEncoder encoder) {
+    (void)renderer;
+    (void)encoder;
+}
@@ -0,0 +1,301 @@
+/**
+ * @file tools/wgsl_variants.c
+ * @brief Build step that expands a WGSL template into its shader variants.
+ *
+ * The template uses a small line based preprocessor:
+ *
+ *   #define NAME
+ *   #ifdef NAME / #ifndef NAME
+ *   #else
+ *   #endif
+ *
+ * Every permutation of the feature flags is expanded and written as a C
+ * source with one string literal per variant, so the runtime only compiles
+ * modules and never generates WGSL. Whole line // comments are stripped.
+ *
+ * Usage: wgsl_variants <template.wgsl> <output.c>
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Bit order must match webgpu_shader_feature_t in src/private_api.h */
+static const char *feature_names[] = {
+    "COMPACT_INSTANCES",
+    "ALPHA",
+    "STORAGE_INSTANCES",
+    "SHADOWS",
+};
+
+#define FEATURE_COUNT ((int)(sizeof(feature_names) / sizeof(feature_names[0])))
+#define MAX_DEFINES 64
+#define MAX_NAME 64
+#define MAX_DEPTH 16
+
+typedef struct {
+    char names[MAX_DEFINES][MAX_NAME];
+    int count;
+} define_set_t;
+
+typedef struct {
+    bool parent_active;
+    bool active;
+    bool seen_else;
+} branch_t;
+
+static bool is_defined(const define_set_t *defines, const char *name) {
+    for (int i = 0; i < defines->count; i++) {
+        if (!strcmp(defines->names[i], name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool add_define(define_set_t *defines, const char *name) {
+    if (is_defined(defines, name)) {
+        return true;
+    }
+    if (defines->count == MAX_DEFINES || strlen(name) >= MAX_NAME) {
+        return false;
+    }
+    strcpy(defines->names[defines->count++], name);
+    return true;
+}
+
+/* Read a whitespace delimited word from [*cur, end) into out */
+static void read_word(const char **cur, const char *end, char *out, size_t size) {
+    const char *p = *cur;
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+
+    size_t len = 0;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r') {
+        if (len + 1 < size) {
+            out[len++] = *p;
+        }
+        p++;
+    }
+    out[len] = '\0';
+    *cur = p;
+}
+
+/**
+ * Preprocess a WGSL template with a set of defines.
+ * Returns a malloc'd string, or NULL with error set.
+ */
+static char* wgsl_preprocess(const char *source, define_set_t defines, char *error, size_t error_size) {
+    char *result = malloc(strlen(source) + 1);
+    char *out = result;
+    if (!result) {
+        snprintf(error, error_size, "out of memory");
+        return NULL;
+    }
+
+    branch_t stack[MAX_DEPTH];
+    int depth = 0;
+    bool active = true;
+    int line_number = 0;
+
+    const char *line = source;
+    while (*line) {
+        const char *eol = strchr(line, '\n');
+        const char *end = eol ? eol : line + strlen(line);
+        const char *next = eol ? eol + 1 : end;
+        line_number++;
+
+        const char *p = line;
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+
+        if (p == end || *p != '#') {
+            /* Whole line comments only document the template */
+            bool comment = end - p >= 2 && p[0] == '/' && p[1] == '/';
+            if (active && !comment) {
+                memcpy(out, line, (size_t)(next - line));
+                out += next - line;
+            }
+            line = next;
+            continue;
+        }
+
+        char directive[MAX_NAME], name[MAX_NAME];
+        p++;
+        read_word(&p, end, directive, sizeof(directive));
+        read_word(&p, end, name, sizeof(name));
+
+        if (!strcmp(directive, "ifdef") || !strcmp(directive, "ifndef")) {
+            if (depth == MAX_DEPTH || !name[0]) {
+                snprintf(error, error_size, "line %d: invalid #%s", line_number, directive);
+                goto error;
+            }
+            bool defined = is_defined(&defines, name);
+            stack[depth].parent_active = active;
+            stack[depth].active = directive[2] == 'd' ? defined : !defined;
+            stack[depth].seen_else = false;
+            active = active && stack[depth].active;
+            depth++;
+        } else if (!strcmp(directive, "else")) {
+            if (!depth || stack[depth - 1].seen_else) {
+                snprintf(error, error_size, "line %d: unexpected #else", line_number);
+                goto error;
+            }
+            branch_t *branch = &stack[depth - 1];
+            branch->seen_else = true;
+            branch->active = !branch->active;
+            active = branch->parent_active && branch->active;
+        } else if (!strcmp(directive, "endif")) {
+            if (!depth) {
+                snprintf(error, error_size, "line %d: unexpected #endif", line_number);
+                goto error;
+            }
+            depth--;
+            active = stack[depth].parent_active;
+        } else if (!strcmp(directive, "define")) {
+            if (active && (!name[0] || !add_define(&defines, name))) {
+                snprintf(error, error_size, "line %d: invalid #define", line_number);
+                goto error;
+            }
+        } else {
+            snprintf(error, error_size, "line %d: unknown directive #%s", line_number, directive);
+            goto error;
+        }
+
+        line = next;
+    }
+
+    if (depth) {
+        snprintf(error, error_size, "missing #endif");
+        goto error;
+    }
+
+    *out = '\0';
+    return result;
+error:
+    free(result);
+    return NULL;
+}
+
+static char* read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char *data = malloc((size_t)size + 1);
+    if (data && fread(data, 1, (size_t)size, f) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    if (data) {
+        data[size] = '\0';
+    }
+
+    fclose(f);
+    return data;
+}
+
+/* Write a string as a C literal, one source line per WGSL line */
+static void write_literal(FILE *out, const char *str) {
+    fputs("    \"", out);
+    for (const char *p = str; *p; p++) {
+        switch (*p) {
+        case '\\': fputs("\\\\", out); break;
+        case '"': fputs("\\\"", out); break;
+        case '\r': break;
+        case '\n':
+            if (p[1]) {
+                fputs("\\n\"\n    \"", out);
+            } else {
+                fputs("\\n", out);
+            }
+            break;
+        default: fputc(*p, out); break;
+        }
+    }
+    fputs("\"", out);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <template.wgsl> <output.c>\n", argv[0]);
+        return 1;
+    }
+
+    char *source = read_file(argv[1]);
+    if (!source) {
+        fprintf(stderr, "wgsl_variants: cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    FILE *out = fopen(argv[2], "w");
+    if (!out) {
+        fprintf(stderr, "wgsl_variants: cannot write %s\n", argv[2]);
+        free(source);
+        return 1;
+    }
+
+    const char *template_name = strrchr(argv[1], '/');
+    template_name = template_name ? template_name + 1 : argv[1];
+
+    fprintf(out,
+        "/**\n"
+        " * @file shaders/shader_variants.c\n"
+        " * @brief Precompiled WGSL shader permutations.\n"
+        " *\n"
+        " * Generated by tools/wgsl_variants.c from shaders/%s, do not edit.\n"
+        " */\n"
+        "\n"
+        "#include <stdint.h>\n"
+        "\n", template_name);
+
+    int variant_count = 1 << FEATURE_COUNT;
+    int result = 0;
+
+    fprintf(out, "const uint32_t webgpu_shader_variant_count = %d;\n\n", variant_count);
+    fprintf(out, "/* Indexed by webgpu_shader_feature_t flags */\n");
+    fprintf(out, "const char *webgpu_shader_variant_sources[] = {\n");
+
+    for (int variant = 0; variant < variant_count; variant++) {
+        define_set_t defines = {0};
+        fprintf(out, "    /* ");
+        for (int f = 0; f < FEATURE_COUNT; f++) {
+            if (variant & (1 << f)) {
+                add_define(&defines, feature_names[f]);
+                fprintf(out, "%s ", feature_names[f]);
+            }
+        }
+        fprintf(out, "%s*/\n", defines.count ? "" : "(none) ");
+
+        char error[256];
+        char *expanded = wgsl_preprocess(source, defines, error, sizeof(error));
+        if (!expanded) {
+            fprintf(stderr, "wgsl_variants: %s: %s\n", argv[1], error);
+            result = 1;
+            break;
+        }
+
+        write_literal(out, expanded);
+        fprintf(out, ",\n\n");
+        free(expanded);
+    }
+
+    fprintf(out, "};\n");
+    fclose(out);
+    free(source);
+
+    if (result) {
+        remove(argv[2]);
+    }
+
+    return result;
+}